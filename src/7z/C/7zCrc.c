@@ -1,9 +1,188 @@
 /* 7zCrc.c */
 
 #include "7zCrc.h"
+#include "CpuArch.h"
+
+#if defined(MY_CPU_X86_OR_AMD64) && defined(MY_CPU_INTRINSICS_TARGET)
+#define CRC_USE_PCLMUL
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#endif
 
 #define kCrcPoly 0xEDB88320
-UInt32 g_CrcTable[256];
+#define CRC_NUM_TABLES 8
+
+UInt32 g_CrcTable[256 * CRC_NUM_TABLES];
+
+typedef UInt32 (MY_FAST_CALL *CRC_FUNC)(UInt32 v, const void *data, size_t size);
+
+#ifdef LITTLE_ENDIAN_UNALIGN
+#define GetUi32(p) (*(const UInt32 *)(p))
+#else
+#define GetUi32(p) ((UInt32)((const Byte *)(p))[0] | \
+    ((UInt32)((const Byte *)(p))[1] << 8) | \
+    ((UInt32)((const Byte *)(p))[2] << 16) | \
+    ((UInt32)((const Byte *)(p))[3] << 24))
+#endif
+
+static UInt32 MY_FAST_CALL CrcUpdateT1(UInt32 v, const void *data, size_t size)
+{
+  const Byte *p = (const Byte *)data;
+  for (; size > 0 ; size--, p++) 
+    v = CRC_UPDATE_BYTE(v, *p);
+  return v;
+}
+
+/* slicing-by-8: g_CrcTable[k * 256 + i] is CRC of byte (i) followed by (k) zero bytes */
+
+static UInt32 MY_FAST_CALL CrcUpdateT8(UInt32 v, const void *data, size_t size)
+{
+  const Byte *p = (const Byte *)data;
+  const UInt32 *table = g_CrcTable;
+  for (; size > 0 && ((size_t)p & 3) != 0; size--, p++)
+    v = CRC_UPDATE_BYTE(v, *p);
+  for (; size >= 8; size -= 8, p += 8)
+  {
+    UInt32 d;
+    v ^= GetUi32(p);
+    d = GetUi32(p + 4);
+    v =
+        table[0x700 + (v & 0xFF)] ^
+        table[0x600 + ((v >> 8) & 0xFF)] ^
+        table[0x500 + ((v >> 16) & 0xFF)] ^
+        table[0x400 + ((v >> 24))] ^
+        table[0x300 + (d & 0xFF)] ^
+        table[0x200 + ((d >> 8) & 0xFF)] ^
+        table[0x100 + ((d >> 16) & 0xFF)] ^
+        table[0x000 + ((d >> 24))];
+  }
+  for (; size > 0; size--, p++)
+    v = CRC_UPDATE_BYTE(v, *p);
+  return v;
+}
+
+#ifdef CRC_USE_PCLMUL
+
+/*
+Folding with carry-less multiplication, as described in
+"Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction" (Intel, 2009).
+Constants are for bit-reflected kCrcPoly:
+  k1 = x^(4*128+32) mod P, k2 = x^(4*128-32) mod P  - fold by 4 blocks
+  k3 = x^(128+32) mod P,   k4 = x^(128-32) mod P    - fold by 1 block
+  k5 = x^64 mod P
+  P' and u (Barrett reduction)
+(size) must be multiple of 16 and (size >= 64).
+*/
+
+#define CLMUL(a, b, imm) _mm_clmulepi64_si128(a, b, imm)
+
+MY_CPU_TARGET("sse2,pclmul")
+static UInt32 CrcUpdatePclmulBlocks(UInt32 v, const Byte *p, size_t size)
+{
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+  const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+  x1 = _mm_loadu_si128((const __m128i *)(p + 0x00));
+  x2 = _mm_loadu_si128((const __m128i *)(p + 0x10));
+  x3 = _mm_loadu_si128((const __m128i *)(p + 0x20));
+  x4 = _mm_loadu_si128((const __m128i *)(p + 0x30));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)v));
+  p += 64;
+  size -= 64;
+
+  x0 = _mm_setr_epi32(0x54442bd4, 0x1, 0xc6e41596, 0x1); /* k1, k2 */
+  for (; size >= 64; p += 64, size -= 64)
+  {
+    x5 = CLMUL(x1, x0, 0x00);
+    x6 = CLMUL(x2, x0, 0x00);
+    x7 = CLMUL(x3, x0, 0x00);
+    x8 = CLMUL(x4, x0, 0x00);
+    x1 = _mm_xor_si128(CLMUL(x1, x0, 0x11), x5);
+    x2 = _mm_xor_si128(CLMUL(x2, x0, 0x11), x6);
+    x3 = _mm_xor_si128(CLMUL(x3, x0, 0x11), x7);
+    x4 = _mm_xor_si128(CLMUL(x4, x0, 0x11), x8);
+    x1 = _mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)(p + 0x00)));
+    x2 = _mm_xor_si128(x2, _mm_loadu_si128((const __m128i *)(p + 0x10)));
+    x3 = _mm_xor_si128(x3, _mm_loadu_si128((const __m128i *)(p + 0x20)));
+    x4 = _mm_xor_si128(x4, _mm_loadu_si128((const __m128i *)(p + 0x30)));
+  }
+
+  x0 = _mm_setr_epi32(0x751997d0, 0x1, 0xccaa009e, 0x0); /* k3, k4 */
+  x5 = CLMUL(x1, x0, 0x00);
+  x1 = _mm_xor_si128(_mm_xor_si128(CLMUL(x1, x0, 0x11), x5), x2);
+  x5 = CLMUL(x1, x0, 0x00);
+  x1 = _mm_xor_si128(_mm_xor_si128(CLMUL(x1, x0, 0x11), x5), x3);
+  x5 = CLMUL(x1, x0, 0x00);
+  x1 = _mm_xor_si128(_mm_xor_si128(CLMUL(x1, x0, 0x11), x5), x4);
+
+  for (; size >= 16; p += 16, size -= 16)
+  {
+    x5 = CLMUL(x1, x0, 0x00);
+    x1 = _mm_xor_si128(CLMUL(x1, x0, 0x11), x5);
+    x1 = _mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)p));
+  }
+
+  /* 128 bits -> 64 bits */
+  x2 = CLMUL(x1, x0, 0x10);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+  x0 = _mm_setr_epi32(0x63cd6124, 0x1, 0, 0); /* k5 */
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, mask32);
+  x1 = _mm_xor_si128(CLMUL(x1, x0, 0x00), x2);
+
+  /* Barrett reduction to 32 bits */
+  x0 = _mm_setr_epi32(0xdb710641, 0x1, 0xf7011641, 0x1); /* P', u */
+  x2 = _mm_and_si128(x1, mask32);
+  x2 = CLMUL(x2, x0, 0x10);
+  x2 = _mm_and_si128(x2, mask32);
+  x2 = CLMUL(x2, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  return (UInt32)_mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+}
+
+static UInt32 MY_FAST_CALL CrcUpdatePclmul(UInt32 v, const void *data, size_t size)
+{
+  const Byte *p = (const Byte *)data;
+  if (size >= 64)
+  {
+    size_t blocksSize = size & ~(size_t)15;
+    v = CrcUpdatePclmulBlocks(v, p, blocksSize);
+    p += blocksSize;
+    size -= blocksSize;
+  }
+  return CrcUpdateT8(v, p, size);
+}
+
+#endif
+
+static CRC_FUNC g_CrcUpdate = CrcUpdateT1;
+static int g_CrcImpl = CRC_IMPL_T1;
+
+int CrcGetImpl(void)
+{
+  return g_CrcImpl;
+}
+
+Bool CrcSetImpl(int impl)
+{
+  CRC_FUNC func;
+  switch (impl)
+  {
+    case CRC_IMPL_T1: func = CrcUpdateT1; break;
+    case CRC_IMPL_T8: func = CrcUpdateT8; break;
+    #ifdef CRC_USE_PCLMUL
+    case CRC_IMPL_PCLMUL:
+      if (!CPU_Is_Pclmul_Supported())
+        return False;
+      func = CrcUpdatePclmul;
+      break;
+    #endif
+    default: return False;
+  }
+  g_CrcUpdate = func;
+  g_CrcImpl = impl;
+  return True;
+}
 
 void MY_FAST_CALL CrcGenerateTable(void)
 {
@@ -16,17 +195,21 @@ void MY_FAST_CALL CrcGenerateTable(void)
       r = (r >> 1) ^ (kCrcPoly & ~((r & 1) - 1));
     g_CrcTable[i] = r;
   }
+  for (; i < 256 * CRC_NUM_TABLES; i++)
+  {
+    UInt32 r = g_CrcTable[i - 256];
+    g_CrcTable[i] = g_CrcTable[r & 0xFF] ^ (r >> 8);
+  }
+  if (!CrcSetImpl(CRC_IMPL_PCLMUL))
+    CrcSetImpl(CRC_IMPL_T8);
 }
 
 UInt32 MY_FAST_CALL CrcUpdate(UInt32 v, const void *data, size_t size)
 {
-  const Byte *p = (const Byte *)data;
-  for (; size > 0 ; size--, p++) 
-    v = CRC_UPDATE_BYTE(v, *p);
-  return v;
+  return g_CrcUpdate(v, data, size);
 }
 
 UInt32 MY_FAST_CALL CrcCalc(const void *data, size_t size)
 {
-  return CrcUpdate(CRC_INIT_VAL, data, size) ^ 0xFFFFFFFF;
+  return g_CrcUpdate(CRC_INIT_VAL, data, size) ^ 0xFFFFFFFF;
 }
@@ -9,6 +9,7 @@
 
 extern UInt32 g_CrcTable[];
 
+/* CrcGenerateTable also selects the fastest CrcUpdate implementation for current CPU */
 void MY_FAST_CALL CrcGenerateTable(void);
 
 #define CRC_INIT_VAL 0xFFFFFFFF
@@ -18,4 +19,15 @@ void MY_FAST_CALL CrcGenerateTable(void);
 UInt32 MY_FAST_CALL CrcUpdate(UInt32 crc, const void *data, size_t size);
 UInt32 MY_FAST_CALL CrcCalc(const void *data, size_t size);
 
+/* CRC implementations. CrcSetImpl is intended for tests and benchmarks:
+   it returns False, if (impl) is not supported by this build or CPU. */
+
+#define CRC_IMPL_T1     0
+#define CRC_IMPL_T8     1
+#define CRC_IMPL_PCLMUL 2
+#define CRC_NUM_IMPLS   3
+
+int CrcGetImpl(void);
+Bool CrcSetImpl(int impl);
+
 #endif
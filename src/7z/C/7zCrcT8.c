@@ -38,3 +38,13 @@ UInt32 MY_FAST_CALL CrcCalc(const void *data, size_t size)
 {
   return CrcUpdateT8(CRC_INIT_VAL, data, size, g_CrcTable) ^ 0xFFFFFFFF;
 }
+
+int CrcGetImpl(void)
+{
+  return CRC_IMPL_T8;
+}
+
+Bool CrcSetImpl(int impl)
+{
+  return (impl == CRC_IMPL_T8);
+}
@@ -5,6 +5,17 @@
 #endif
 #include <stdlib.h>
 
+#if !defined(_WIN32) && !defined(__linux__)
+#undef _7ZIP_LARGE_PAGES
+#endif
+
+#if !defined(_WIN32) && defined(_7ZIP_LARGE_PAGES)
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#endif
+
 #include "Alloc.h"
 
 /* #define _SZ_ALLOC_DEBUG */
@@ -116,4 +127,145 @@ void BigFree(void *address)
   VirtualFree(address, 0, MEM_RELEASE);
 }
 
+#else
+
+#ifdef _7ZIP_LARGE_PAGES
+
+/*
+Linux: BigAlloc uses hugetlbfs pages (MAP_HUGETLB), if the system has reserved
+huge pages. Otherwise it maps anonymous memory aligned to huge page size and
+asks for transparent huge pages with madvise(MADV_HUGEPAGE).
+munmap needs the size of mapping, so we keep the list of mapped blocks.
+*/
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+size_t g_LargePageSize = 0;
+int g_LargePageMode = LARGE_PAGE_MODE_NONE;
+
+#define kNumLargeBlocksMax 64
+
+static void *g_LargeBlocks[kNumLargeBlocksMax];
+static size_t g_LargeBlockSizes[kNumLargeBlocksMax];
+static pthread_mutex_t g_LargeBlocksMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t GetHugePageSize()
+{
+  size_t size = 0;
+  char line[256];
+  FILE *f = fopen("/proc/meminfo", "r");
+  if (f == 0)
+    return 0;
+  while (fgets(line, sizeof(line), f) != 0)
+  {
+    const char *kName = "Hugepagesize:";
+    if (strncmp(line, kName, strlen(kName)) == 0)
+    {
+      size = (size_t)strtoul(line + strlen(kName), 0, 10) << 10;
+      break;
+    }
+  }
+  fclose(f);
+  return size;
+}
+
+void SetLargePageSize()
+{
+  size_t size = GetHugePageSize();
+  if (size == 0 || (size & (size - 1)) != 0)
+    return;
+  g_LargePageSize = size;
+}
+
+static void *LargePageAlloc(size_t size)
+{
+  size_t mask = g_LargePageSize - 1;
+  size_t mapSize;
+  unsigned char *p, *aligned;
+  size = (size + mask) & ~mask;
+
+  #ifdef MAP_HUGETLB
+  p = (unsigned char *)mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (p != (unsigned char *)MAP_FAILED)
+  {
+    g_LargePageMode = LARGE_PAGE_MODE_HUGETLB;
+    return p;
+  }
+  #endif
+
+  mapSize = size + g_LargePageSize;
+  p = (unsigned char *)mmap(0, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == (unsigned char *)MAP_FAILED)
+    return 0;
+  aligned = (unsigned char *)(((size_t)p + mask) & ~mask);
+  if (aligned != p)
+    munmap(p, aligned - p);
+  if (p + mapSize != aligned + size)
+    munmap(aligned + size, (p + mapSize) - (aligned + size));
+  #ifdef MADV_HUGEPAGE
+  madvise(aligned, size, MADV_HUGEPAGE);
+  g_LargePageMode = LARGE_PAGE_MODE_MADVISE;
+  #endif
+  return aligned;
+}
+
+void *BigAlloc(size_t size)
+{
+  if (size == 0)
+    return 0;
+  #ifdef _SZ_ALLOC_DEBUG
+  fprintf(stderr, "\nAlloc_Big %10d bytes;  count = %10d", size, g_allocCountBig++);
+  #endif
+
+  if (g_LargePageSize != 0 && g_LargePageSize <= (1 << 30) && size >= (1 << 18))
+  {
+    void *res = LargePageAlloc(size);
+    if (res != 0)
+    {
+      int i;
+      pthread_mutex_lock(&g_LargeBlocksMutex);
+      for (i = 0; i < kNumLargeBlocksMax; i++)
+        if (g_LargeBlocks[i] == 0)
+        {
+          g_LargeBlocks[i] = res;
+          g_LargeBlockSizes[i] = (size + g_LargePageSize - 1) & ~(g_LargePageSize - 1);
+          break;
+        }
+      pthread_mutex_unlock(&g_LargeBlocksMutex);
+      if (i != kNumLargeBlocksMax)
+        return res;
+      munmap(res, (size + g_LargePageSize - 1) & ~(g_LargePageSize - 1));
+    }
+  }
+  return malloc(size);
+}
+
+void BigFree(void *address)
+{
+  int i;
+  #ifdef _SZ_ALLOC_DEBUG
+  if (address != 0)
+    fprintf(stderr, "\nFree_Big; count = %10d", --g_allocCountBig);
+  #endif
+
+  if (address == 0)
+    return;
+  pthread_mutex_lock(&g_LargeBlocksMutex);
+  for (i = 0; i < kNumLargeBlocksMax; i++)
+    if (g_LargeBlocks[i] == address)
+    {
+      size_t size = g_LargeBlockSizes[i];
+      g_LargeBlocks[i] = 0;
+      pthread_mutex_unlock(&g_LargeBlocksMutex);
+      munmap(address, size);
+      return;
+    }
+  pthread_mutex_unlock(&g_LargeBlocksMutex);
+  free(address);
+}
+
+#endif
+
 #endif
@@ -5,6 +5,10 @@
 
 #include <stddef.h>
 
+#if defined(_7ZIP_LARGE_PAGES) && (defined(_WIN32) || defined(__linux__))
+#define _7ZIP_LARGE_PAGES_SUPPORTED
+#endif
+
 void *MyAlloc(size_t size);
 void MyFree(void *address);
 
@@ -21,9 +25,28 @@ void BigFree(void *address);
 
 #define MidAlloc(size) MyAlloc(size)
 #define MidFree(address) MyFree(address)
+
+#ifdef _7ZIP_LARGE_PAGES_SUPPORTED
+
+#define LARGE_PAGE_MODE_NONE    0
+#define LARGE_PAGE_MODE_HUGETLB 1
+#define LARGE_PAGE_MODE_MADVISE 2
+
+extern size_t g_LargePageSize;
+extern int g_LargePageMode; /* how the last large page block was mapped */
+
+void SetLargePageSize();
+
+void *BigAlloc(size_t size);
+void BigFree(void *address);
+
+#else
+
 #define BigAlloc(size) MyAlloc(size)
 #define BigFree(address) MyFree(address)
 
 #endif
 
 #endif
+
+#endif
@@ -18,13 +18,6 @@
 
 #ifdef _LZMA_IN_CB
 
-typedef struct _CLzmaInCallbackImp
-{
-  ILzmaInCallback InCallback;
-  ISzInStream *InStream;
-  CFileSize Size;
-} CLzmaInCallbackImp;
-
 int LzmaReadImp(void *object, const unsigned char **buffer, SizeT *size)
 {
   CLzmaInCallbackImp *cb = (CLzmaInCallbackImp *)object;
@@ -79,7 +72,14 @@ SZ_RESULT SzDecodeLzma(CCoderInfo *coder, CFileSize inSize,
     return SZE_OUTOFMEMORY;
   
   #ifdef _LZMA_OUT_READ
-  if (state.Properties.DictionarySize == 0)
+  /* whole folder is decoded to outBuffer, so it can be the dictionary itself:
+     it never wraps and no second dictionary-sized window is allocated */
+  if (outSize != 0 && (UInt32)outSize == outSize)
+  {
+    state.Properties.DictionarySize = (UInt32)outSize;
+    state.Dictionary = outBuffer;
+  }
+  else if (state.Properties.DictionarySize == 0)
     state.Dictionary = 0;
   else
   {
@@ -102,7 +102,8 @@ SZ_RESULT SzDecodeLzma(CCoderInfo *coder, CFileSize inSize,
     outBuffer, (SizeT)outSize, &outSizeProcessedLoc);
   allocMain->Free(state.Probs);
   #ifdef _LZMA_OUT_READ
-  allocMain->Free(state.Dictionary);
+  if (state.Dictionary != outBuffer)
+    allocMain->Free(state.Dictionary);
   #endif
   if (result == LZMA_RESULT_DATA_ERROR)
     return SZE_DATA_ERROR;
@@ -339,3 +340,130 @@ SZ_RESULT SzDecode(const CFileSize *packSizes, const CFolder *folder,
     allocMain->Free(tempBuf[i]);
   return res;
 }
+
+#ifdef _SZ_DECODE_STREAM
+
+SZ_RESULT SzFolderDecoderInit(CSzFolderDecoder *p, const CFileSize *packSizes, const CFolder *folder,
+    ISzInStream *inStream, CFileSize startPos, ISzAlloc *allocMain)
+{
+  CCoderInfo *coder = &folder->Coders[0];
+  p->Lzma.Probs = 0;
+  p->Lzma.Dictionary = 0;
+  p->InStream = inStream;
+  RINOK(CheckSupportedFolder(folder));
+  if (folder->NumCoders == 4)
+    return SZE_NOTIMPL;
+  
+  p->IsBcj = (folder->NumCoders == 2);
+  x86_Convert_Init(p->BcjState);
+  p->BcjPos = 0;
+  p->BcjTailSize = 0;
+  
+  p->UnPackRem = folder->UnPackSizes[0];
+  p->IsLzma = (coder->MethodID == k_LZMA);
+  RINOK(inStream->Seek(inStream, startPos));
+  if (!p->IsLzma)
+    return (packSizes[0] == p->UnPackRem) ? SZ_OK : SZE_DATA_ERROR;
+
+  p->LzmaCallback.Size = packSizes[0];
+  p->LzmaCallback.InStream = inStream;
+  p->LzmaCallback.InCallback.Read = LzmaReadImp;
+  
+  if (LzmaDecodeProperties(&p->Lzma.Properties, coder->Properties.Items, 
+      (unsigned)coder->Properties.Capacity) != LZMA_RESULT_OK)
+    return SZE_FAIL;
+  
+  p->Lzma.Probs = (CProb *)allocMain->Alloc(LzmaGetNumProbs(&p->Lzma.Properties) * sizeof(CProb));
+  if (p->Lzma.Probs == 0)
+    return SZE_OUTOFMEMORY;
+
+  /* match distances can't be larger than unpack size, so small folders don't need full dictionary */
+  if (p->Lzma.Properties.DictionarySize > p->UnPackRem)
+    p->Lzma.Properties.DictionarySize = (UInt32)p->UnPackRem;
+  if (p->Lzma.Properties.DictionarySize != 0)
+  {
+    p->Lzma.Dictionary = (unsigned char *)allocMain->Alloc(p->Lzma.Properties.DictionarySize);
+    if (p->Lzma.Dictionary == 0)
+      return SZE_OUTOFMEMORY;
+  }
+  LzmaDecoderInit(&p->Lzma);
+  return SZ_OK;
+}
+
+static SZ_RESULT SzFolderDecoderReadMain(CSzFolderDecoder *p, Byte *data, size_t size, size_t *processedSize)
+{
+  *processedSize = 0;
+  if (size > p->UnPackRem)
+    size = (size_t)p->UnPackRem;
+  if (size == 0)
+    return SZ_OK;
+  if (p->IsLzma)
+  {
+    SizeT outProcessed;
+    int result;
+    if (size > ((UInt32)1 << 30))
+      size = ((UInt32)1 << 30);
+    result = LzmaDecode(&p->Lzma, &p->LzmaCallback.InCallback, data, (SizeT)size, &outProcessed);
+    if (result == LZMA_RESULT_DATA_ERROR)
+      return SZE_DATA_ERROR;
+    if (result != LZMA_RESULT_OK)
+      return SZE_FAIL;
+    if (outProcessed == 0)
+      return SZE_DATA_ERROR;
+    *processedSize = outProcessed;
+  }
+  else
+  {
+    void *inBuffer;
+    size_t processed;
+    RINOK(p->InStream->Read((void *)p->InStream, &inBuffer, size, &processed));
+    if (processed == 0)
+      return SZE_DATA_ERROR;
+    if (processed > size)
+      return SZE_FAIL;
+    memcpy(data, inBuffer, processed);
+    *processedSize = processed;
+  }
+  p->UnPackRem -= *processedSize;
+  return SZ_OK;
+}
+
+SZ_RESULT SzFolderDecoderRead(CSzFolderDecoder *p, Byte *data, size_t size, size_t *processedSize)
+{
+  size_t pos, cur, converted;
+  if (!p->IsBcj)
+    return SzFolderDecoderReadMain(p, data, size, processedSize);
+  
+  *processedSize = 0;
+  if (size < 5)
+    return SZE_INVALIDARG;
+  pos = p->BcjTailSize;
+  memcpy(data, p->BcjTail, pos);
+  do
+  {
+    RINOK(SzFolderDecoderReadMain(p, data + pos, size - pos, &cur));
+    pos += cur;
+  }
+  while (pos < 5 && p->UnPackRem != 0);
+  converted = x86_Convert(data, pos, p->BcjPos, &p->BcjState, 0);
+  if (p->UnPackRem == 0)
+  {
+    /* last bytes of stream are not converted */
+    converted = pos;
+  }
+  p->BcjPos += (UInt32)converted;
+  p->BcjTailSize = pos - converted;
+  memcpy(p->BcjTail, data + converted, p->BcjTailSize);
+  *processedSize = converted;
+  return SZ_OK;
+}
+
+void SzFolderDecoderFree(CSzFolderDecoder *p, ISzAlloc *allocMain)
+{
+  allocMain->Free(p->Lzma.Probs);
+  allocMain->Free(p->Lzma.Dictionary);
+  p->Lzma.Probs = 0;
+  p->Lzma.Dictionary = 0;
+}
+
+#endif
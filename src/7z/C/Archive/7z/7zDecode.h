@@ -7,6 +7,11 @@
 #include "7zAlloc.h"
 #ifdef _LZMA_IN_CB
 #include "7zIn.h"
+#ifdef _SZ_ONE_DIRECTORY
+#include "LzmaDecode.h"
+#else
+#include "../../Compress/Lzma/LzmaDecode.h"
+#endif
 #endif
 
 SZ_RESULT SzDecode(const CFileSize *packSizes, const CFolder *folder,
@@ -17,4 +22,54 @@ SZ_RESULT SzDecode(const CFileSize *packSizes, const CFolder *folder,
     #endif
     Byte *outBuffer, size_t outSize, ISzAlloc *allocMain);
 
+#ifdef _LZMA_IN_CB
+
+typedef struct _CLzmaInCallbackImp
+{
+  ILzmaInCallback InCallback;
+  ISzInStream *InStream;
+  CFileSize Size;
+} CLzmaInCallbackImp;
+
+#ifdef _LZMA_OUT_READ
+#define _SZ_DECODE_STREAM
+#endif
+
+#endif
+
+#ifdef _SZ_DECODE_STREAM
+
+/* 
+  CSzFolderDecoder decodes folder in parts: 
+  LZMA keeps only its dictionary (not larger than unpack size of folder) 
+  and BCJ keeps 4 bytes. BCJ2 folders are not supported (SZE_NOTIMPL). 
+  Stream must not be used by other code between SzFolderDecoderInit and 
+  last SzFolderDecoderRead call.
+*/
+
+typedef struct _CSzFolderDecoder
+{
+  ISzInStream *InStream;
+  CFileSize UnPackRem;
+  int IsLzma;
+  CLzmaInCallbackImp LzmaCallback;
+  CLzmaDecoderState Lzma;
+  int IsBcj;
+  UInt32 BcjState;
+  UInt32 BcjPos;
+  Byte BcjTail[4];
+  size_t BcjTailSize;
+} CSzFolderDecoder;
+
+SZ_RESULT SzFolderDecoderInit(CSzFolderDecoder *p, const CFileSize *packSizes, const CFolder *folder,
+    ISzInStream *inStream, CFileSize startPos, ISzAlloc *allocMain);
+
+/* size must be 5 or larger. 
+   *processedSize == 0 means end of folder. */
+SZ_RESULT SzFolderDecoderRead(CSzFolderDecoder *p, Byte *data, size_t size, size_t *processedSize);
+
+void SzFolderDecoderFree(CSzFolderDecoder *p, ISzAlloc *allocMain);
+
+#endif
+
 #endif
@@ -1,7 +1,6 @@
 /* 7zExtract.c */
 
 #include "7zExtract.h"
-#include "7zDecode.h"
 #include "../../7zCrc.h"
 
 SZ_RESULT SzExtract(
@@ -117,3 +116,99 @@ SZ_RESULT SzExtract(
   }
   return res;
 }
+
+#ifdef _SZ_DECODE_STREAM
+
+typedef struct _CSzExtractBuffer
+{
+  CSzFolderDecoder Decoder;
+  Byte *Buffer;
+  size_t Pos;
+  size_t Size;
+  UInt32 Crc;
+} CSzExtractBuffer;
+
+static SZ_RESULT SzExtractBufferFill(CSzExtractBuffer *p)
+{
+  p->Pos = 0;
+  RINOK(SzFolderDecoderRead(&p->Decoder, p->Buffer, kSzExtractBufferSize, &p->Size));
+  p->Crc = CrcUpdate(p->Crc, p->Buffer, p->Size);
+  return SZ_OK;
+}
+
+static SZ_RESULT SzExtractFolder2(CArchiveDatabaseEx *db, UInt32 folderIndex, 
+    ISzExtractCallback *callback, CSzExtractBuffer *buf)
+{
+  CFolder *folder = db->Database.Folders + folderIndex;
+  UInt32 fileIndex;
+  SZ_RESULT res = SZ_OK;
+  for (fileIndex = db->FolderStartFileIndex[folderIndex]; 
+      fileIndex < db->Database.NumFiles && 
+      db->FileIndexToFolderIndexMap[fileIndex] == folderIndex; fileIndex++)
+  {
+    CFileItem *fileItem = db->Database.Files + fileIndex;
+    CFileSize rem = fileItem->Size;
+    UInt32 crc = CRC_INIT_VAL;
+    SZ_RESULT fileRes = SZ_OK;
+    RINOK(callback->FileStart(callback, fileIndex));
+    while (rem != 0)
+    {
+      size_t cur;
+      if (buf->Pos == buf->Size)
+      {
+        RINOK(SzExtractBufferFill(buf));
+        if (buf->Size == 0)
+          return SZE_DATA_ERROR;
+      }
+      cur = buf->Size - buf->Pos;
+      if (cur > rem)
+        cur = (size_t)rem;
+      if (fileItem->IsFileCRCDefined)
+        crc = CrcUpdate(crc, buf->Buffer + buf->Pos, cur);
+      RINOK(callback->Write(callback, buf->Buffer + buf->Pos, cur));
+      buf->Pos += cur;
+      rem -= cur;
+    }
+    if (fileItem->IsFileCRCDefined && CRC_GET_DIGEST(crc) != fileItem->FileCRC)
+      res = fileRes = SZE_CRC_ERROR;
+    RINOK(callback->FileEnd(callback, fileIndex, fileRes));
+  }
+  
+  for (;;)
+  {
+    RINOK(SzExtractBufferFill(buf));
+    if (buf->Size == 0)
+      break;
+  }
+  if (folder->UnPackCRCDefined && CRC_GET_DIGEST(buf->Crc) != folder->UnPackCRC)
+    return SZE_CRC_ERROR;
+  return res;
+}
+
+SZ_RESULT SzExtractFolder(
+    ISzInStream *inStream, 
+    CArchiveDatabaseEx *db,
+    UInt32 folderIndex,
+    ISzExtractCallback *callback,
+    ISzAlloc *allocMain,
+    ISzAlloc *allocTemp)
+{
+  CSzExtractBuffer buf;
+  SZ_RESULT res;
+  buf.Buffer = (Byte *)allocMain->Alloc(kSzExtractBufferSize);
+  if (buf.Buffer == 0)
+    return SZE_OUTOFMEMORY;
+  buf.Pos = buf.Size = 0;
+  buf.Crc = CRC_INIT_VAL;
+  res = SzFolderDecoderInit(&buf.Decoder, 
+      db->Database.PackSizes + db->FolderStartPackStreamIndex[folderIndex], 
+      db->Database.Folders + folderIndex, 
+      inStream, SzArDbGetFolderStreamPos(db, folderIndex, 0), allocTemp);
+  if (res == SZ_OK)
+    res = SzExtractFolder2(db, folderIndex, callback, &buf);
+  SzFolderDecoderFree(&buf.Decoder, allocTemp);
+  allocMain->Free(buf.Buffer);
+  return res;
+}
+
+#endif
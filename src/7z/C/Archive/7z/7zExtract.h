@@ -4,6 +4,7 @@
 #define __7Z_EXTRACT_H
 
 #include "7zIn.h"
+#include "7zDecode.h"
 
 /*
   SzExtract extracts file from archive
@@ -37,4 +38,43 @@ SZ_RESULT SzExtract(
     ISzAlloc *allocMain,
     ISzAlloc *allocTemp);
 
+#ifdef _SZ_DECODE_STREAM
+
+/*
+  SzExtractFolder decodes solid block (folder) in parts and sends data 
+  of all files of that block to callback in order of files.
+  It's available, if _LZMA_IN_CB and _LZMA_OUT_READ are defined.
+
+  Memory usage doesn't depend from size of block: 
+    LZMA dictionary and probabilities (allocTemp),
+    kSzExtractBufferSize bytes buffer (allocMain).
+  
+  Each file gets FileStart, Write calls for its data and FileEnd.
+  FileEnd gets SZE_CRC_ERROR, if CRC of file is wrong. 
+  If any callback function returns value other than SZ_OK, 
+  SzExtractFolder stops and returns that value. So you can stop 
+  after required file without decoding rest of block.
+  
+  Folders with BCJ2 are not supported (SZE_NOTIMPL). Use SzExtract for them.
+*/
+
+#define kSzExtractBufferSize (1 << 16)
+
+typedef struct _ISzExtractCallback
+{
+  SZ_RESULT (*FileStart)(void *object, UInt32 fileIndex);
+  SZ_RESULT (*Write)(void *object, const Byte *data, size_t size);
+  SZ_RESULT (*FileEnd)(void *object, UInt32 fileIndex, SZ_RESULT res);
+} ISzExtractCallback;
+
+SZ_RESULT SzExtractFolder(
+    ISzInStream *inStream, 
+    CArchiveDatabaseEx *db,
+    UInt32 folderIndex,
+    ISzExtractCallback *callback,
+    ISzAlloc *allocMain,
+    ISzAlloc *allocTemp);
+
+#endif
+
 #endif
@@ -171,6 +171,26 @@ int MyCloseFile(MY_FILE_HANDLE file)
   #endif
 }
 
+int MyCreateOutFile(MY_FILE_HANDLE *file, const char *name)
+{
+  const char *fileName = name;
+  size_t nameLen = strlen(name);
+  for (; nameLen > 0; nameLen--)
+    if (name[nameLen - 1] == '/')
+    {
+      fileName = name + nameLen;
+      break;
+    }
+  #ifdef USE_WINDOWS_FUNCTIONS
+  *file = CreateFile(fileName, GENERIC_WRITE, FILE_SHARE_READ, 
+      NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  return (*file != INVALID_HANDLE_VALUE);
+  #else
+  *file = fopen(fileName, "wb+");
+  return (*file != 0);
+  #endif
+}
+
 typedef struct _CFileInStream
 {
   ISzInStream InStream;
@@ -240,6 +260,103 @@ void PrintError(char *sz)
   printf("\nERROR: %s\n", sz);
 }
 
+#ifdef _SZ_DECODE_STREAM
+
+typedef struct _CExtractCallbackImp
+{
+  ISzExtractCallback Callback;
+  CArchiveDatabaseEx *Db;
+  int TestMode;
+  int OutFileIsOpen;
+  MY_FILE_HANDLE OutFile;
+} CExtractCallbackImp;
+
+SZ_RESULT ExtractFileStart(void *object, UInt32 fileIndex)
+{
+  CExtractCallbackImp *cb = (CExtractCallbackImp *)object;
+  CFileItem *f = cb->Db->Database.Files + fileIndex;
+  printf(cb->TestMode ? 
+      "Testing   ":
+      "Extracting");
+  printf(" %s", f->Name);
+  if (cb->TestMode)
+    return SZ_OK;
+  if (!MyCreateOutFile(&cb->OutFile, f->Name))
+  {
+    PrintError("can not open output file");
+    return SZE_FAIL;
+  }
+  cb->OutFileIsOpen = 1;
+  return SZ_OK;
+}
+
+SZ_RESULT ExtractWrite(void *object, const Byte *data, size_t size)
+{
+  CExtractCallbackImp *cb = (CExtractCallbackImp *)object;
+  if (cb->TestMode)
+    return SZ_OK;
+  if (MyWriteFile(cb->OutFile, (void *)data, size) != size)
+  {
+    PrintError("can not write output file");
+    return SZE_FAIL;
+  }
+  return SZ_OK;
+}
+
+SZ_RESULT ExtractFileEnd(void *object, UInt32 fileIndex, SZ_RESULT res)
+{
+  CExtractCallbackImp *cb = (CExtractCallbackImp *)object;
+  if (cb->OutFileIsOpen)
+  {
+    cb->OutFileIsOpen = 0;
+    if (MyCloseFile(cb->OutFile))
+    {
+      PrintError("can not close output file");
+      return SZE_FAIL;
+    }
+  }
+  if (res == SZ_OK)
+    printf("\n");
+  return res;
+}
+
+/* SzExtractFolder doesn't support BCJ2 folders, so files of such folder 
+   are unpacked with SzExtract, that unpacks whole folder to memory. */
+
+SZ_RESULT ExtractFolderToBuffer(ISzInStream *inStream, CArchiveDatabaseEx *db, 
+    UInt32 folderIndex, CExtractCallbackImp *cb, 
+    ISzAlloc *allocMain, ISzAlloc *allocTemp)
+{
+  UInt32 blockIndex = 0xFFFFFFFF;
+  Byte *outBuffer = 0;
+  size_t outBufferSize = 0;
+  UInt32 fileIndex;
+  SZ_RESULT res = SZ_OK;
+  for (fileIndex = db->FolderStartFileIndex[folderIndex]; 
+      fileIndex < db->Database.NumFiles && 
+      db->FileIndexToFolderIndexMap[fileIndex] == folderIndex; fileIndex++)
+  {
+    size_t offset;
+    size_t outSizeProcessed;
+    res = SzExtract(inStream, db, fileIndex, 
+        &blockIndex, &outBuffer, &outBufferSize, 
+        &offset, &outSizeProcessed, 
+        allocMain, allocTemp);
+    if (res != SZ_OK)
+      break;
+    res = ExtractFileStart(cb, fileIndex);
+    if (res == SZ_OK)
+      res = ExtractWrite(cb, outBuffer + offset, outSizeProcessed);
+    res = ExtractFileEnd(cb, fileIndex, res);
+    if (res != SZ_OK)
+      break;
+  }
+  allocMain->Free(outBuffer);
+  return res;
+}
+
+#endif
+
 int main(int numargs, char *args[])
 {
   CFileInStream archiveStream;
@@ -325,6 +442,49 @@ int main(int numargs, char *args[])
     {
       UInt32 i;
 
+      #ifdef _SZ_DECODE_STREAM
+
+      CExtractCallbackImp extractCallback;
+      extractCallback.Callback.FileStart = ExtractFileStart;
+      extractCallback.Callback.Write = ExtractWrite;
+      extractCallback.Callback.FileEnd = ExtractFileEnd;
+      extractCallback.Db = &db;
+      extractCallback.TestMode = testCommand;
+      extractCallback.OutFileIsOpen = 0;
+
+      printf("\n");
+      for (i = 0; i < db.Database.NumFiles; i++)
+      {
+        CFileItem *f = db.Database.Files + i;
+        UInt32 folderIndex = db.FileIndexToFolderIndexMap[i];
+        if (f->IsDirectory)
+        {
+          printf("Directory  %s\n", f->Name);
+          continue;
+        }
+        if (folderIndex == (UInt32)-1)
+        {
+          /* empty file */
+          res = ExtractFileStart(&extractCallback, i);
+          if (res == SZ_OK)
+            res = ExtractFileEnd(&extractCallback, i, SZ_OK);
+        }
+        else if (i == db.FolderStartFileIndex[folderIndex])
+        {
+          res = SzExtractFolder(&archiveStream.InStream, &db, folderIndex, 
+              &extractCallback.Callback, &allocImp, &allocTempImp);
+          if (res == (SZ_RESULT)SZE_NOTIMPL)
+            res = ExtractFolderToBuffer(&archiveStream.InStream, &db, folderIndex, 
+                &extractCallback, &allocImp, &allocTempImp);
+        }
+        if (res != SZ_OK)
+          break;
+      }
+      if (extractCallback.OutFileIsOpen)
+        MyCloseFile(extractCallback.OutFile);
+
+      #else
+
       /*
       if you need cache, use these 3 variables.
       if you use external function, you can make these variable as static.
@@ -361,24 +521,7 @@ int main(int numargs, char *args[])
         {
           MY_FILE_HANDLE outputHandle;
           size_t processedSize;
-          char *fileName = f->Name;
-          size_t nameLen = strlen(f->Name);
-          for (; nameLen > 0; nameLen--)
-            if (f->Name[nameLen - 1] == '/')
-            {
-              fileName = f->Name + nameLen;
-              break;
-            }
-            
-          outputHandle = 
-          #ifdef USE_WINDOWS_FUNCTIONS
-            CreateFile(fileName, GENERIC_WRITE, FILE_SHARE_READ, 
-                NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
-          if (outputHandle == INVALID_HANDLE_VALUE)
-          #else
-          fopen(fileName, "wb+");
-          if (outputHandle == 0)
-          #endif
+          if (!MyCreateOutFile(&outputHandle, f->Name))
           {
             PrintError("can not open output file");
             res = SZE_FAIL;
@@ -401,6 +544,8 @@ int main(int numargs, char *args[])
         printf("\n");
       }
       allocImp.Free(outBuffer);
+
+      #endif
     }
     else
     {
@@ -7,6 +7,37 @@
 #include "LzHash.h"
 
 #include "../../7zCrc.h"
+#include "../../CpuArch.h"
+
+#if defined(__GNUC__) && ((__GNUC__ > 3) || (__GNUC__ == 3 && __GNUC_MINOR__ >= 4))
+#define MF_CTZ32(x) ((unsigned)__builtin_ctz(x))
+#ifdef MY_CPU_AMD64
+#define MF_CTZ64(x) ((unsigned)__builtin_ctzll(x))
+#endif
+#elif defined(_MSC_VER) && (_MSC_VER >= 1400)
+#include <intrin.h>
+static unsigned MfCtz32(UInt32 x) { unsigned long i; _BitScanForward(&i, x); return (unsigned)i; }
+#define MF_CTZ32(x) MfCtz32(x)
+#ifdef MY_CPU_AMD64
+static unsigned MfCtz64(UInt64 x) { unsigned long i; _BitScanForward64(&i, x); return (unsigned)i; }
+#define MF_CTZ64(x) MfCtz64(x)
+#endif
+#endif
+
+#if defined(LITTLE_ENDIAN_UNALIGN) && defined(MF_CTZ32)
+#define MF_USE_WORD
+#ifdef MF_CTZ64
+typedef UInt64 CMfWord;
+#define MF_CTZ_WORD(x) MF_CTZ64(x)
+#else
+typedef UInt32 CMfWord;
+#define MF_CTZ_WORD(x) MF_CTZ32(x)
+#endif
+#if defined(MY_CPU_X86_OR_AMD64) && defined(MY_CPU_INTRINSICS_TARGET)
+#define MF_USE_SSE2
+#include <emmintrin.h>
+#endif
+#endif
 
 #define kEmptyHashValue 0
 #define kMaxValForNormalize ((UInt32)0xFFFFFFFF)
@@ -120,12 +151,95 @@ void MatchFinder_SetDefaultSettings(CMatchFinder *p)
   p->bigHash = 0;
 }
 
+static UInt32 MY_FAST_CALL GetMatchLenByte(const Byte *pb, const Byte *cur, UInt32 len, UInt32 lenLimit)
+{
+  while(++len != lenLimit)
+    if (pb[len] != cur[len])
+      break;
+  return len;
+}
+
+#ifdef MF_USE_WORD
+
+/* The first different byte is found as count of trailing zero bits of (a ^ b).
+   Words are read only while they are within (lenLimit). */
+
+static UInt32 MY_FAST_CALL GetMatchLenWord(const Byte *pb, const Byte *cur, UInt32 len, UInt32 lenLimit)
+{
+  for (len++; len + sizeof(CMfWord) <= lenLimit; len += sizeof(CMfWord))
+  {
+    CMfWord x = *(const CMfWord *)(pb + len) ^ *(const CMfWord *)(cur + len);
+    if (x != 0)
+      return len + (MF_CTZ_WORD(x) >> 3);
+  }
+  for (; len != lenLimit; len++)
+    if (pb[len] != cur[len])
+      break;
+  return len;
+}
+
+#endif
+
+#ifdef MF_USE_SSE2
+
+MY_CPU_TARGET("sse2")
+static UInt32 MY_FAST_CALL GetMatchLenSse2(const Byte *pb, const Byte *cur, UInt32 len, UInt32 lenLimit)
+{
+  for (len++; len + 16 <= lenLimit; len += 16)
+  {
+    unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(
+        _mm_loadu_si128((const __m128i *)(pb + len)),
+        _mm_loadu_si128((const __m128i *)(cur + len)))) ^ 0xFFFF;
+    if (mask != 0)
+      return len + MF_CTZ32(mask);
+  }
+  return GetMatchLenWord(pb, cur, len - 1, lenLimit);
+}
+
+#endif
+
+Mf_MatchLen_Func g_MatchFinder_GetMatchLen = GetMatchLenByte;
+static int g_MatchLenImpl = MF_MATCH_LEN_BYTE;
+static Bool g_MatchLenImplWasSelected = False;
+
+int MatchFinder_GetMatchLenImpl(void)
+{
+  return g_MatchLenImpl;
+}
+
+Bool MatchFinder_SetMatchLenImpl(int impl)
+{
+  Mf_MatchLen_Func func;
+  switch (impl)
+  {
+    case MF_MATCH_LEN_BYTE: func = GetMatchLenByte; break;
+    #ifdef MF_USE_WORD
+    case MF_MATCH_LEN_WORD: func = GetMatchLenWord; break;
+    #endif
+    #ifdef MF_USE_SSE2
+    case MF_MATCH_LEN_SSE2:
+      if (!CPU_Is_Sse2_Supported())
+        return False;
+      func = GetMatchLenSse2;
+      break;
+    #endif
+    default: return False;
+  }
+  g_MatchFinder_GetMatchLen = func;
+  g_MatchLenImpl = impl;
+  g_MatchLenImplWasSelected = True;
+  return True;
+}
+
 void MatchFinder_Construct(CMatchFinder *p)
 {
   p->bufferBase = 0;
   p->directInput = 0;
   p->hash = 0;
   MatchFinder_SetDefaultSettings(p);
+  if (!g_MatchLenImplWasSelected)
+    if (!MatchFinder_SetMatchLenImpl(MF_MATCH_LEN_SSE2))
+      MatchFinder_SetMatchLenImpl(MF_MATCH_LEN_WORD);
 }
 
 void MatchFinder_FreeThisClassMemory(CMatchFinder *p, ISzAlloc *alloc)
@@ -315,10 +429,7 @@ UInt32 * Hc_GetMatchesSpec(UInt32 lenLimit, UInt32 curMatch, UInt32 pos, const B
       curMatch = son[_cyclicBufferPos - delta + ((delta > _cyclicBufferPos) ? _cyclicBufferSize : 0)];
       if (pb[maxLen] == cur[maxLen] && *pb == *cur)
       {
-        UInt32 len = 0;
-        while(++len != lenLimit)
-          if (pb[len] != cur[len])
-            break;
+        UInt32 len = g_MatchFinder_GetMatchLen(pb, cur, 0, lenLimit);
         if (maxLen < len)
         {
           *distances++ = maxLen = len;
@@ -353,9 +464,7 @@ UInt32 * GetMatchesSpec1(UInt32 lenLimit, UInt32 curMatch, UInt32 pos, const Byt
       if (pb[len] == cur[len])
       {
         if (++len != lenLimit && pb[len] == cur[len])
-          while(++len != lenLimit)
-            if (pb[len] != cur[len])
-              break;
+          len = g_MatchFinder_GetMatchLen(pb, cur, len, lenLimit);
         if (maxLen < len)
         {
           *distances++ = maxLen = len;
@@ -406,9 +515,7 @@ void SkipMatchesSpec(UInt32 lenLimit, UInt32 curMatch, UInt32 pos, const Byte *c
       UInt32 len = (len0 < len1 ? len0 : len1);
       if (pb[len] == cur[len])
       {
-        while(++len != lenLimit)
-          if (pb[len] != cur[len])
-            break;
+        len = g_MatchFinder_GetMatchLen(pb, cur, len, lenLimit);
         {
           if (len == lenLimit)
           {
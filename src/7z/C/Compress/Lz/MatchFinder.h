@@ -72,6 +72,25 @@ UInt32 * GetMatchesSpec1(UInt32 lenLimit, UInt32 curMatch, UInt32 pos, const Byt
     UInt32 _cyclicBufferPos, UInt32 _cyclicBufferSize, UInt32 _cutValue, 
     UInt32 *distances, UInt32 maxLen);
 
+/*
+Match length function: (pb[len] == cur[len]) and (len < lenLimit).
+It returns the position of the first mismatch after (len), or (lenLimit).
+*/
+typedef UInt32 (MY_FAST_CALL *Mf_MatchLen_Func)(const Byte *pb, const Byte *cur, UInt32 len, UInt32 lenLimit);
+extern Mf_MatchLen_Func g_MatchFinder_GetMatchLen;
+
+/* Match length implementations. MatchFinder_Construct selects the fastest one
+   for current CPU. MatchFinder_SetMatchLenImpl is intended for tests and benchmarks:
+   it returns False, if (impl) is not supported by this build or CPU. */
+
+#define MF_MATCH_LEN_BYTE 0
+#define MF_MATCH_LEN_WORD 1
+#define MF_MATCH_LEN_SSE2 2
+#define MF_MATCH_LEN_NUM_IMPLS 3
+
+int MatchFinder_GetMatchLenImpl(void);
+Bool MatchFinder_SetMatchLenImpl(int impl);
+
 /* 
 Conditions:
   Mf_GetNumAvailableBytes_Func must be called before each Mf_GetMatchLen_Func.
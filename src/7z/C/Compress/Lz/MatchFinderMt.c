@@ -275,9 +275,7 @@ Int32 NO_INLINE GetMatchesSpecN(UInt32 lenLimit, UInt32 pos, const Byte *cur, CL
       if (pb[len] == cur[len])
       {
         if (++len != lenLimit && pb[len] == cur[len])
-          while(++len != lenLimit)
-            if (pb[len] != cur[len])
-              break;
+          len = g_MatchFinder_GetMatchLen(pb, cur, len, lenLimit);
         if (maxLen < len)
         {
           *distances++ = maxLen = len;
@@ -0,0 +1,59 @@
+/* CpuArch.c */
+
+#include "CpuArch.h"
+
+#ifdef MY_CPU_X86_OR_AMD64
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__GNUC__)
+#include <cpuid.h>
+#endif
+
+static void MyCPUID(unsigned function, unsigned *a, unsigned *b, unsigned *c, unsigned *d)
+{
+  #if defined(_MSC_VER)
+  int regs[4];
+  __cpuid(regs, (int)function);
+  *a = (unsigned)regs[0];
+  *b = (unsigned)regs[1];
+  *c = (unsigned)regs[2];
+  *d = (unsigned)regs[3];
+  #elif defined(__GNUC__)
+  if (!__get_cpuid(function, a, b, c, d))
+    *a = *b = *c = *d = 0;
+  #else
+  *a = *b = *c = *d = 0;
+  #endif
+}
+
+static unsigned GetFeatures(int ecxReg)
+{
+  unsigned a, b, c, d;
+  MyCPUID(0, &a, &b, &c, &d);
+  if (a < 1)
+    return 0;
+  MyCPUID(1, &a, &b, &c, &d);
+  return ecxReg ? c : d;
+}
+
+int CPU_Is_Sse2_Supported(void)
+{
+  #ifdef MY_CPU_AMD64
+  return 1;
+  #else
+  return (GetFeatures(0) >> 26) & 1;
+  #endif
+}
+
+int CPU_Is_Pclmul_Supported(void)
+{
+  return CPU_Is_Sse2_Supported() && ((GetFeatures(1) >> 1) & 1);
+}
+
+int CPU_Is_Aes_Supported(void)
+{
+  return CPU_Is_Sse2_Supported() && ((GetFeatures(1) >> 25) & 1);
+}
+
+#endif
@@ -13,6 +13,35 @@ about these properties of platform.
 
 #if defined(_M_IX86) || defined(_M_X64) || defined(_M_AMD64) || defined(__i386__) || defined(__x86_64__)
 #define LITTLE_ENDIAN_UNALIGN
+#define MY_CPU_X86_OR_AMD64
+#endif
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__x86_64__)
+#define MY_CPU_AMD64
+#endif
+
+/*
+MY_CPU_TARGET(s) marks a function that is compiled for extended
+instruction set (s), so it can be called after runtime CPUID check
+without building the whole file with that instruction set.
+*/
+
+#if defined(__GNUC__) && ((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) || defined(__clang__)
+#define MY_CPU_TARGET(s) __attribute__((target(s)))
+#define MY_CPU_INTRINSICS_TARGET
+#elif defined(_MSC_VER) && (_MSC_VER >= 1500)
+#define MY_CPU_TARGET(s)
+#define MY_CPU_INTRINSICS_TARGET
+#endif
+
+#ifdef MY_CPU_X86_OR_AMD64
+
+/* These functions return nonzero, if CPU and OS support the feature */
+
+int CPU_Is_Sse2_Supported(void);
+int CPU_Is_Pclmul_Supported(void);
+int CPU_Is_Aes_Supported(void);
+
 #endif
 
 #endif
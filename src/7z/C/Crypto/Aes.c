@@ -3,6 +3,12 @@
 #include "Aes.h"
 #include "../CpuArch.h"
 
+#if defined(MY_CPU_X86_OR_AMD64) && defined(MY_CPU_INTRINSICS_TARGET)
+#define AES_USE_AESNI
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#endif
+
 UInt32 T[256 * 4];
 Byte Sbox[256] = {	
   0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
@@ -67,6 +73,8 @@ void MY_FAST_CALL AesGenTables(void)
       D[0x300 + i] = Ui32(a9, aD, aB, aE);
     }
   }
+  if (!AesSetImpl(AES_IMPL_AESNI))
+    AesSetImpl(AES_IMPL_TABLE);
 }
 
 #define HT(i, x, s) (T + (x << 8))[gb ## x(s[(i + x) & 3])]
@@ -202,15 +210,12 @@ void MY_FAST_CALL AesCbcInit(CAesCbc *cbc, const Byte *iv)
     cbc->prev[i] = GetUi32(iv + i * 4);
 }
 
-UInt32 MY_FAST_CALL AesCbcEncode(CAesCbc *cbc, Byte *data, UInt32 size)
+typedef void (MY_FAST_CALL *AES_CBC_FUNC)(CAesCbc *cbc, Byte *data, UInt32 numBlocks);
+typedef void (MY_FAST_CALL *AES_CTR_FUNC)(const CAes *p, UInt32 *ctr, Byte *data, UInt32 numBlocks);
+
+static void MY_FAST_CALL AesCbcEncodeTable(CAesCbc *cbc, Byte *data, UInt32 numBlocks)
 {
-  UInt32 i;
-  if (size == 0)
-    return 0;
-  if (size < AES_BLOCK_SIZE)
-    return AES_BLOCK_SIZE;
-  size -= AES_BLOCK_SIZE;
-  for (i = 0; i <= size; i += AES_BLOCK_SIZE, data += AES_BLOCK_SIZE)
+  for (; numBlocks != 0; numBlocks--, data += AES_BLOCK_SIZE)
   {
     cbc->prev[0] ^= GetUi32(data);
     cbc->prev[1] ^= GetUi32(data + 4);
@@ -224,19 +229,12 @@ UInt32 MY_FAST_CALL AesCbcEncode(CAesCbc *cbc, Byte *data, UInt32 size)
     SetUi32(data + 8,  cbc->prev[2]);
     SetUi32(data + 12, cbc->prev[3]);
   }
-  return i;
 }
 
-UInt32 MY_FAST_CALL AesCbcDecode(CAesCbc *cbc, Byte *data, UInt32 size)
+static void MY_FAST_CALL AesCbcDecodeTable(CAesCbc *cbc, Byte *data, UInt32 numBlocks)
 {
-  UInt32 i;
   UInt32 in[4], out[4];
-  if (size == 0)
-    return 0;
-  if (size < AES_BLOCK_SIZE)
-    return AES_BLOCK_SIZE;
-  size -= AES_BLOCK_SIZE;
-  for (i = 0; i <= size; i += AES_BLOCK_SIZE, data += AES_BLOCK_SIZE)
+  for (; numBlocks != 0; numBlocks--, data += AES_BLOCK_SIZE)
   {
     in[0] = GetUi32(data);
     in[1] = GetUi32(data + 4);
@@ -255,5 +253,221 @@ UInt32 MY_FAST_CALL AesCbcDecode(CAesCbc *cbc, Byte *data, UInt32 size)
     cbc->prev[2] = in[2];
     cbc->prev[3] = in[3];
   }
-  return i;
+}
+
+static void MY_FAST_CALL AesCtrCodeTable(const CAes *p, UInt32 *ctr, Byte *data, UInt32 numBlocks)
+{
+  UInt32 out[4];
+  for (; numBlocks != 0; numBlocks--, data += AES_BLOCK_SIZE)
+  {
+    if (++ctr[0] == 0)
+      ctr[1]++;
+    
+    AesEncode32(ctr, out, p->rkey, p->numRounds2);
+    
+    SetUi32(data,      GetUi32(data)      ^ out[0]);
+    SetUi32(data + 4,  GetUi32(data + 4)  ^ out[1]);
+    SetUi32(data + 8,  GetUi32(data + 8)  ^ out[2]);
+    SetUi32(data + 12, GetUi32(data + 12) ^ out[3]);
+  }
+}
+
+#ifdef AES_USE_AESNI
+
+/*
+AES-NI versions use the same round keys as table version:
+rkey contains round keys in byte order of AES specification, and
+AesSetKeyDecode applies InvMixColumns to middle round keys,
+as AESDEC instruction requires.
+CBC decoding and CTR process AES_NUM_WAYS independent blocks in parallel
+to hide the latency of AESDEC / AESENC instructions.
+*/
+
+#define AES_NUM_WAYS 8
+
+MY_CPU_TARGET("sse2,aes")
+static unsigned AesLoadKeys(__m128i *keys, const CAes *p)
+{
+  unsigned numRounds = p->numRounds2 * 2;
+  unsigned r;
+  for (r = 0; r <= numRounds; r++)
+    keys[r] = _mm_loadu_si128((const __m128i *)(p->rkey + r * 4));
+  return numRounds;
+}
+
+MY_CPU_TARGET("sse2,aes")
+static void MY_FAST_CALL AesCbcEncodeIntel(CAesCbc *cbc, Byte *data, UInt32 numBlocks)
+{
+  __m128i keys[15];
+  unsigned numRounds = AesLoadKeys(keys, &cbc->aes);
+  __m128i m = _mm_loadu_si128((const __m128i *)cbc->prev);
+  for (; numBlocks != 0; numBlocks--, data += AES_BLOCK_SIZE)
+  {
+    unsigned r;
+    m = _mm_xor_si128(m, _mm_loadu_si128((const __m128i *)data));
+    m = _mm_xor_si128(m, keys[0]);
+    for (r = 1; r < numRounds; r++)
+      m = _mm_aesenc_si128(m, keys[r]);
+    m = _mm_aesenclast_si128(m, keys[numRounds]);
+    _mm_storeu_si128((__m128i *)data, m);
+  }
+  _mm_storeu_si128((__m128i *)cbc->prev, m);
+}
+
+#define AES_FOR_WAYS(op) op(0) op(1) op(2) op(3) op(4) op(5) op(6) op(7)
+
+#define AES_LOAD(i)     m[i] = _mm_loadu_si128((const __m128i *)data + i);
+#define AES_XOR_KEY(i)  m[i] = _mm_xor_si128(m[i], key);
+#define AES_DEC(i)      m[i] = _mm_aesdec_si128(m[i], key);
+#define AES_DEC_LAST(i) m[i] = _mm_aesdeclast_si128(m[i], key);
+#define AES_ENC(i)      m[i] = _mm_aesenc_si128(m[i], key);
+#define AES_ENC_LAST(i) m[i] = _mm_aesenclast_si128(m[i], key);
+#define AES_CTR_NEXT(i) c = _mm_add_epi64(c, one); m[i] = _mm_xor_si128(c, key);
+#define AES_XOR_DATA(i) _mm_storeu_si128((__m128i *)data + i, \
+    _mm_xor_si128(_mm_loadu_si128((const __m128i *)data + i), m[i]));
+#define AES_CBC_XOR(i)  { __m128i in = _mm_loadu_si128((const __m128i *)data + i); \
+    _mm_storeu_si128((__m128i *)data + i, _mm_xor_si128(m[i], iv)); iv = in; }
+
+MY_CPU_TARGET("sse2,aes")
+static void MY_FAST_CALL AesCbcDecodeIntel(CAesCbc *cbc, Byte *data, UInt32 numBlocks)
+{
+  __m128i keys[15];
+  unsigned numRounds = AesLoadKeys(keys, &cbc->aes);
+  __m128i iv = _mm_loadu_si128((const __m128i *)cbc->prev);
+  for (; numBlocks >= AES_NUM_WAYS; numBlocks -= AES_NUM_WAYS, data += AES_NUM_WAYS * AES_BLOCK_SIZE)
+  {
+    __m128i m[AES_NUM_WAYS];
+    __m128i key = keys[numRounds];
+    unsigned r;
+    AES_FOR_WAYS(AES_LOAD)
+    AES_FOR_WAYS(AES_XOR_KEY)
+    for (r = numRounds - 1; r != 0; r--)
+    {
+      key = keys[r];
+      AES_FOR_WAYS(AES_DEC)
+    }
+    key = keys[0];
+    AES_FOR_WAYS(AES_DEC_LAST)
+    AES_FOR_WAYS(AES_CBC_XOR)
+  }
+  for (; numBlocks != 0; numBlocks--, data += AES_BLOCK_SIZE)
+  {
+    __m128i m[1];
+    __m128i key = keys[numRounds];
+    unsigned r;
+    AES_LOAD(0)
+    AES_XOR_KEY(0)
+    for (r = numRounds - 1; r != 0; r--)
+    {
+      key = keys[r];
+      AES_DEC(0)
+    }
+    key = keys[0];
+    AES_DEC_LAST(0)
+    AES_CBC_XOR(0)
+  }
+  _mm_storeu_si128((__m128i *)cbc->prev, iv);
+}
+
+MY_CPU_TARGET("sse2,aes")
+static void MY_FAST_CALL AesCtrCodeIntel(const CAes *p, UInt32 *ctr, Byte *data, UInt32 numBlocks)
+{
+  __m128i keys[15];
+  unsigned numRounds = AesLoadKeys(keys, p);
+  __m128i c = _mm_loadu_si128((const __m128i *)ctr);
+  __m128i one = _mm_set_epi32(0, 0, 0, 1);
+  for (; numBlocks >= AES_NUM_WAYS; numBlocks -= AES_NUM_WAYS, data += AES_NUM_WAYS * AES_BLOCK_SIZE)
+  {
+    __m128i m[AES_NUM_WAYS];
+    __m128i key = keys[0];
+    unsigned r;
+    AES_FOR_WAYS(AES_CTR_NEXT)
+    for (r = 1; r < numRounds; r++)
+    {
+      key = keys[r];
+      AES_FOR_WAYS(AES_ENC)
+    }
+    key = keys[numRounds];
+    AES_FOR_WAYS(AES_ENC_LAST)
+    AES_FOR_WAYS(AES_XOR_DATA)
+  }
+  for (; numBlocks != 0; numBlocks--, data += AES_BLOCK_SIZE)
+  {
+    __m128i m[1];
+    __m128i key = keys[0];
+    unsigned r;
+    AES_CTR_NEXT(0)
+    for (r = 1; r < numRounds; r++)
+    {
+      key = keys[r];
+      AES_ENC(0)
+    }
+    key = keys[numRounds];
+    AES_ENC_LAST(0)
+    AES_XOR_DATA(0)
+  }
+  _mm_storeu_si128((__m128i *)ctr, c);
+}
+
+#endif
+
+static AES_CBC_FUNC g_AesCbcEncode = AesCbcEncodeTable;
+static AES_CBC_FUNC g_AesCbcDecode = AesCbcDecodeTable;
+static AES_CTR_FUNC g_AesCtrCode = AesCtrCodeTable;
+static int g_AesImpl = AES_IMPL_TABLE;
+
+int AesGetImpl(void)
+{
+  return g_AesImpl;
+}
+
+Bool AesSetImpl(int impl)
+{
+  switch (impl)
+  {
+    case AES_IMPL_TABLE:
+      g_AesCbcEncode = AesCbcEncodeTable;
+      g_AesCbcDecode = AesCbcDecodeTable;
+      g_AesCtrCode = AesCtrCodeTable;
+      break;
+    #ifdef AES_USE_AESNI
+    case AES_IMPL_AESNI:
+      if (!CPU_Is_Aes_Supported())
+        return False;
+      g_AesCbcEncode = AesCbcEncodeIntel;
+      g_AesCbcDecode = AesCbcDecodeIntel;
+      g_AesCtrCode = AesCtrCodeIntel;
+      break;
+    #endif
+    default: return False;
+  }
+  g_AesImpl = impl;
+  return True;
+}
+
+UInt32 MY_FAST_CALL AesCbcEncode(CAesCbc *cbc, Byte *data, UInt32 size)
+{
+  if (size == 0)
+    return 0;
+  if (size < AES_BLOCK_SIZE)
+    return AES_BLOCK_SIZE;
+  size /= AES_BLOCK_SIZE;
+  g_AesCbcEncode(cbc, data, size);
+  return size * AES_BLOCK_SIZE;
+}
+
+UInt32 MY_FAST_CALL AesCbcDecode(CAesCbc *cbc, Byte *data, UInt32 size)
+{
+  if (size == 0)
+    return 0;
+  if (size < AES_BLOCK_SIZE)
+    return AES_BLOCK_SIZE;
+  size /= AES_BLOCK_SIZE;
+  g_AesCbcDecode(cbc, data, size);
+  return size * AES_BLOCK_SIZE;
+}
+
+void MY_FAST_CALL AesCtrCode(const CAes *p, UInt32 *ctr, Byte *data, UInt32 numBlocks)
+{
+  g_AesCtrCode(p, ctr, data, numBlocks);
 }
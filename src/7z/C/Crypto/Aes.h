@@ -13,7 +13,8 @@ typedef struct _CAes
   UInt32 rkey[(14 + 1) * 4];
 } CAes;
 
-/* Call AesGenTables one time before other AES functions */
+/* Call AesGenTables one time before other AES functions.
+   It also selects the fastest implementation for current CPU. */
 void MY_FAST_CALL AesGenTables(void);
 
 /* keySize = 16 or 24 or 32 */
@@ -37,4 +38,21 @@ void MY_FAST_CALL AesCbcInit(CAesCbc *cbc, const Byte *iv); /* iv size is AES_BL
 UInt32 MY_FAST_CALL AesCbcDecode(CAesCbc *cbc, Byte *data, UInt32 size);
 UInt32 MY_FAST_CALL AesCbcEncode(CAesCbc *cbc, Byte *data, UInt32 size);
 
+/* 
+AesCtrCode xors (numBlocks * AES_BLOCK_SIZE) bytes of data with encrypted counter blocks.
+ctr[0] and ctr[1] contain 64-bit little-endian counter. It's incremented before each block.
+p must be initialized with AesSetKeyEncode.
+*/
+void MY_FAST_CALL AesCtrCode(const CAes *p, UInt32 *ctr, Byte *data, UInt32 numBlocks);
+
+/* AES implementations. AesSetImpl is intended for tests and benchmarks:
+   it returns False, if (impl) is not supported by this build or CPU. */
+
+#define AES_IMPL_TABLE 0
+#define AES_IMPL_AESNI 1
+#define AES_NUM_IMPLS  2
+
+int AesGetImpl(void);
+Bool AesSetImpl(int impl);
+
 #endif
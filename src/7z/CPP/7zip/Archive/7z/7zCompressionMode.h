@@ -4,6 +4,7 @@
 #define __7Z_COMPRESSION_MODE_H
 
 #include "../../../Common/MyString.h"
+#include "../../../Common/Buffer.h"
 
 #include "../../../Windows/PropVariant.h"
 
@@ -36,6 +37,8 @@ struct CCompressionMethodMode
   #endif
   bool PasswordIsDefined;
   UString Password;
+  // data for coders that support priming, like PPMd ("prime" property)
+  CByteBuffer PrimingData;
 
   bool IsEmpty() const { return (Methods.IsEmpty() && !PasswordIsDefined); }
   CCompressionMethodMode(): PasswordIsDefined(false)
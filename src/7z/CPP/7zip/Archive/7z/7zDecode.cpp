@@ -87,6 +87,8 @@ CDecoder::CDecoder(bool multiThread)
   #endif
   _multiThread = multiThread;
   _bindInfoExPrevIsDefined = false;
+  _primingData = 0;
+  _primingSize = 0;
 }
 
 HRESULT CDecoder::Decode(
@@ -205,6 +207,15 @@ HRESULT CDecoder::Decode(
         RINOK(setCompressCodecsInfo->SetCompressCodecsInfo(codecsInfo));
       }
       #endif
+      if (_primingSize != 0)
+      {
+        CMyComPtr<ICompressSetPrimingData> setPrimingData;
+        decoderUnknown.QueryInterface(IID_ICompressSetPrimingData, &setPrimingData);
+        if (setPrimingData)
+        {
+          RINOK(setPrimingData->SetPrimingData(_primingData, _primingSize));
+        }
+      }
     }
     _bindInfoExPrev = bindInfo;
     _bindInfoExPrevIsDefined = true;
@@ -44,8 +44,17 @@ class CDecoder
   CMyComPtr<ICompressCoder2> _mixerCoder;
   CObjectVector<CMyComPtr<IUnknown> > _decoders;
   // CObjectVector<CMyComPtr<ICompressCoder2> > _decoders2;
+  const Byte *_primingData;
+  UInt32 _primingSize;
 public:
   CDecoder(bool multiThread);
+  // data is given to new coders that support priming. 
+  // It must be kept until the decoder is destroyed.
+  void SetPrimingData(const Byte *data, UInt32 size)
+  {
+    _primingData = data;
+    _primingSize = size;
+  }
   HRESULT Decode(
       DECL_EXTERNAL_CODECS_LOC_VARS
       IInStream *inStream,
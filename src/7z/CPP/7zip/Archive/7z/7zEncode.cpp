@@ -16,6 +16,8 @@
 static const UInt64 k_AES = 0x06F10701;
 static const UInt64 k_BCJ  = 0x03030103;
 static const UInt64 k_BCJ2 = 0x0303011B;
+static const UInt64 k_LZMA = 0x030101;
+static const UInt64 k_LZMABlock = 0x037F0101;
 
 namespace NArchive {
 namespace N7z {
@@ -50,6 +52,25 @@ static void ConvertBindInfoToFolderItemInfo(const NCoderMixer::CBindInfo &bindIn
     folder.PackStreams.Add(bindInfo.InStreams[i]);
 }
 
+// LZMA with block size property is stored as LZMABlock: 
+// the stream is split to independent blocks that are compressed in parallel.
+
+static void SetBlockMethods(CObjectVector<CMethodFull> &methods)
+{
+  for (int i = 0; i < methods.Size(); i++)
+  {
+    CMethodFull &methodFull = methods[i];
+    if (methodFull.Id != k_LZMA)
+      continue;
+    for (int j = 0; j < methodFull.Properties.Size(); j++)
+      if (methodFull.Properties[j].Id == NCoderPropID::kBlockSize)
+      {
+        methodFull.Id = k_LZMABlock;
+        break;
+      }
+  }
+}
+
 HRESULT CEncoder::CreateMixerCoder(
     DECL_EXTERNAL_CODECS_LOC_VARS
     const UInt64 *inSizeForReduce)
@@ -90,6 +111,17 @@ HRESULT CEncoder::CreateMixerCoder(
 
     RINOK(SetMethodProperties(methodFull, inSizeForReduce, encoderCommon));
 
+    if (_options.PrimingData.GetCapacity() != 0)
+    {
+      CMyComPtr<ICompressSetPrimingData> setPrimingData;
+      encoderCommon.QueryInterface(IID_ICompressSetPrimingData, &setPrimingData);
+      if (setPrimingData)
+      {
+        RINOK(setPrimingData->SetPrimingData(_options.PrimingData, 
+            (UInt32)_options.PrimingData.GetCapacity()));
+      }
+    }
+
     /*
     CMyComPtr<ICryptoResetSalt> resetSalt;
     encoderCommon.QueryInterface(IID_ICryptoResetSalt, (void **)&resetSalt);
@@ -323,6 +355,8 @@ HRESULT CEncoder::EncoderConstr()
   else
   {
 
+  SetBlockMethods(_options.Methods);
+
   UInt32 numInStreams = 0, numOutStreams = 0;
   int i;
   for (i = 0; i < _options.Methods.Size(); i++)
@@ -12,6 +12,16 @@
 #include "../../Common/ProgressUtils.h"
 #include "../../Common/LimitedStreams.h"
 
+#ifdef COMPRESS_MT
+#include "../../Common/StreamUtils.h"
+#include "../../Common/VirtThread.h"
+
+extern "C" 
+{ 
+#include "../../../../C/Alloc.h"
+}
+#endif
+
 namespace NArchive {
 namespace N7z {
 
@@ -44,6 +54,704 @@ struct CExtractFolderInfo
   };
 };
 
+#ifdef COMPRESS_MT
+
+/*
+In multithreaded mode small folders are decoded to memory by worker threads,
+each with its own CDecoder. The main thread reads pack streams of folders
+and writes decoded data to IArchiveExtractCallback streams in original order,
+so only main thread calls extractCallback and _inStream.
+Big and encrypted folders are decoded in main thread as before.
+Workers get new folders only while the buffers of started folders are 
+smaller than kMtFoldersMemMax. While the main thread waits for a worker, 
+it sends the progress of that worker to extractCallback.
+*/
+
+static const UInt64 kMtFolderSizeMax = (UInt64)1 << 26;
+static const UInt64 kMtFoldersMemMax = (UInt64)1 << 28;
+static const UInt32 kMtProgressTimeMs = 200;
+static const UInt64 k_AES = 0x06F10701;
+
+// Extract callback is not thread-safe and main thread calls it for each 
+// file, so decode thread only stores sizes, and main thread sends them.
+
+class CDecodeThreadProgress:
+  public ICompressProgressInfo,
+  public CMyUnknownImp
+{
+  NWindows::NSynchronization::CCriticalSection _criticalSection;
+  UInt64 _inSize;
+  UInt64 _outSize;
+  bool _inSizeDefined;
+  bool _outSizeDefined;
+  bool _changed;
+  HRESULT _result;
+public:
+  MY_UNKNOWN_IMP
+  void Init()
+  {
+    _inSizeDefined = _outSizeDefined = _changed = false;
+    _result = S_OK;
+  }
+  HRESULT Flush(ICompressProgressInfo *progress);
+  STDMETHOD(SetRatioInfo)(const UInt64 *inSize, const UInt64 *outSize);
+};
+
+STDMETHODIMP CDecodeThreadProgress::SetRatioInfo(const UInt64 *inSize, const UInt64 *outSize)
+{
+  NWindows::NSynchronization::CCriticalSectionLock lock(_criticalSection);
+  if (inSize != NULL)
+  {
+    _inSize = *inSize;
+    _inSizeDefined = true;
+  }
+  if (outSize != NULL)
+  {
+    _outSize = *outSize;
+    _outSizeDefined = true;
+  }
+  _changed = true;
+  return _result;
+}
+
+HRESULT CDecodeThreadProgress::Flush(ICompressProgressInfo *progress)
+{
+  UInt64 inSize, outSize;
+  bool inSizeDefined, outSizeDefined;
+  {
+    NWindows::NSynchronization::CCriticalSectionLock lock(_criticalSection);
+    if (!_changed || progress == NULL)
+      return S_OK;
+    _changed = false;
+    inSize = _inSize;
+    outSize = _outSize;
+    inSizeDefined = _inSizeDefined;
+    outSizeDefined = _outSizeDefined;
+  }
+  HRESULT res = progress->SetRatioInfo(
+      inSizeDefined ? &inSize : NULL, 
+      outSizeDefined ? &outSize : NULL);
+  if (res != S_OK)
+  {
+    // decoder will stop at next SetRatioInfo call
+    NWindows::NSynchronization::CCriticalSectionLock lock(_criticalSection);
+    _result = res;
+  }
+  return res;
+}
+
+class CFolderDecodeThread: public CVirtThread
+{
+public:
+  #ifdef EXTERNAL_CODECS
+  ICompressCodecsInfo *CodecsInfo;
+  const CObjectVector<CCodecInfoEx> *ExternalCodecs;
+  #endif
+  CDecoder Decoder;
+  CDecodeThreadProgress *ProgressSpec;
+  CMyComPtr<ICompressProgressInfo> Progress;
+  const CFolder *Folder;
+  const UInt64 *PackSizes;
+  Byte *PackData;
+  size_t PackSize;
+  Byte *UnPackData;
+  size_t UnPackSize;
+  size_t UnPackProcessed;
+  HRESULT Result;
+  int ExtractIndex;
+
+  CFolderDecodeThread(): 
+    Decoder(
+      #ifdef _ST_MODE
+      false
+      #else
+      true
+      #endif
+      ), 
+    PackData(0), UnPackData(0), ExtractIndex(-1)
+  {
+    ProgressSpec = new CDecodeThreadProgress;
+    Progress = ProgressSpec;
+  }
+  ~CFolderDecodeThread() { Free(); }
+  // It returns false, if the thread is not finished in (timeMs) milliseconds
+  bool TryWaitFinish(UInt32 timeMs) 
+    { return ::WaitForSingleObject(FinishedEvent, timeMs) == WAIT_OBJECT_0; }
+  void Free()
+  {
+    ::MidFree(PackData);
+    ::MidFree(UnPackData);
+    PackData = 0;
+    UnPackData = 0;
+    ExtractIndex = -1;
+  }
+  bool Alloc(size_t packSize, size_t unPackSize)
+  {
+    PackSize = packSize;
+    UnPackSize = unPackSize;
+    PackData = (Byte *)::MidAlloc(packSize);
+    UnPackData = (Byte *)::MidAlloc(unPackSize);
+    return (PackData != 0 || packSize == 0) && (UnPackData != 0 || unPackSize == 0);
+  }
+  virtual void Execute();
+};
+
+void CFolderDecodeThread::Execute()
+{
+  try
+  {
+    #ifdef EXTERNAL_CODECS
+    ICompressCodecsInfo *codecsInfo = CodecsInfo;
+    const CObjectVector<CCodecInfoEx> *externalCodecs = ExternalCodecs;
+    #endif
+    CBufInStream *inStreamSpec = new CBufInStream;
+    CMyComPtr<IInStream> inStream = inStreamSpec;
+    inStreamSpec->Init(PackData, PackSize);
+    CSequentialOutStreamImp2 *outStreamSpec = new CSequentialOutStreamImp2;
+    CMyComPtr<ISequentialOutStream> outStream = outStreamSpec;
+    outStreamSpec->Init(UnPackData, UnPackSize);
+    Result = Decoder.Decode(
+        EXTERNAL_CODECS_LOC_VARS
+        inStream, 0, PackSizes, *Folder, outStream, Progress
+        #ifndef _NO_CRYPTO
+        , NULL
+        #endif
+        , false, 1);
+    UnPackProcessed = outStreamSpec->GetPos();
+    // CSequentialOutStreamImp2 returns E_FAIL, if decoder writes more than folder size
+    if (Result == E_FAIL && UnPackProcessed == UnPackSize)
+      Result = S_FALSE;
+  }
+  catch(...)
+  {
+    Result = S_FALSE;
+  }
+}
+
+struct CFolderDecodeThreads
+{
+  CFolderDecodeThread *Items;
+  UInt32 NumThreads;
+  CFolderDecodeThreads(): Items(0), NumThreads(0) {}
+  ~CFolderDecodeThreads()
+  {
+    for (UInt32 i = 0; i < NumThreads; i++)
+      if (Items[i].ExtractIndex >= 0)
+        Items[i].WaitFinish();
+    delete []Items;
+  }
+  HRESULT Create(UInt32 numThreads)
+  {
+    Items = new CFolderDecodeThread[numThreads];
+    NumThreads = numThreads;
+    for (UInt32 i = 0; i < numThreads; i++)
+    {
+      RINOK(Items[i].Create());
+    }
+    return S_OK;
+  }
+  int Find(int extractIndex) const
+  {
+    for (UInt32 i = 0; i < NumThreads; i++)
+      if (Items[i].ExtractIndex == extractIndex)
+        return i;
+    return -1;
+  }
+  // size of buffers of started folders
+  UInt64 GetMemUsage() const
+  {
+    UInt64 size = 0;
+    for (UInt32 i = 0; i < NumThreads; i++)
+      if (Items[i].ExtractIndex >= 0)
+        size += Items[i].PackSize + Items[i].UnPackSize;
+    return size;
+  }
+};
+
+static bool IsEncryptedFolder(const CFolder &folderInfo)
+{
+  for (int i = 0; i < folderInfo.Coders.Size(); i++)
+    if (folderInfo.Coders[i].MethodID == k_AES)
+      return true;
+  return false;
+}
+
+static bool IsMtFolder(const CArchiveDatabaseEx &database, const CExtractFolderInfo &efi)
+{
+  if (efi.FileIndex != kNumNoIndex || efi.UnPackSize > kMtFolderSizeMax)
+    return false;
+  if (database.GetFolderFullPackSize(efi.FolderIndex) > kMtFolderSizeMax)
+    return false;
+  return !IsEncryptedFolder(database.Folders[efi.FolderIndex]);
+}
+
+/*
+Other folders with one pack stream go through pipeline of three stages 
+connected with CPipeQueue (kPipeNumBlocks blocks of kPipeBlockSize bytes):
+  reader thread:  archive stream -> pack queue
+  decoder thread: pack queue -> CDecoder -> unpack queue
+  main thread:    unpack queue -> CFolderOutStream
+So reading of archive, decoding and writing of files overlap, and 
+extractCallback streams are still used from main thread only.
+Each queue counts the time that its producer waits for free block and 
+the time that its consumer waits for data. These times are sent to 
+IArchiveExtractCallbackMt after extraction.
+The pipeline can be disabled with "pipe" property ("-mpipe=off").
+*/
+
+static const UInt32 kPipeBlockSize = (1 << 20);
+static const UInt32 kPipeNumBlocks = 4;
+static const UInt64 kPipeFolderSizeMin = (1 << 22);
+
+static UInt64 GetPipeTime()
+{
+  LARGE_INTEGER value;
+  if (::QueryPerformanceCounter(&value))
+    return value.QuadPart;
+  return ::GetTickCount();
+}
+
+static UInt64 GetPipeFreq()
+{
+  LARGE_INTEGER value;
+  if (::QueryPerformanceFrequency(&value))
+    return value.QuadPart;
+  return 1000;
+}
+
+class CPipeQueue
+{
+  NWindows::NSynchronization::CSemaphore _freeSemaphore;
+  NWindows::NSynchronization::CSemaphore _filledSemaphore;
+  Byte *_buf;
+  UInt32 _sizes[kPipeNumBlocks];
+  UInt32 _putIndex;
+  UInt32 _getIndex;
+public:
+  volatile bool Stopped;
+  HRESULT Result;
+  UInt64 PutWaitTime;
+  UInt64 GetWaitTime;
+
+  CPipeQueue(): _buf(0) {}
+  ~CPipeQueue() { ::MidFree(_buf); }
+  HRESULT Create()
+  {
+    _buf = (Byte *)::MidAlloc((size_t)kPipeBlockSize * kPipeNumBlocks);
+    return (_buf != 0) ? S_OK : E_OUTOFMEMORY;
+  }
+  HRESULT Init()
+  {
+    _freeSemaphore.Close();
+    _filledSemaphore.Close();
+    // one more for Stop()
+    RINOK(_freeSemaphore.Create(kPipeNumBlocks, kPipeNumBlocks + 1));
+    RINOK(_filledSemaphore.Create(0, kPipeNumBlocks));
+    _putIndex = _getIndex = 0;
+    Stopped = false;
+    Result = S_OK;
+    PutWaitTime = GetWaitTime = 0;
+    return S_OK;
+  }
+
+  // producer: it returns 0, if consumer was stopped.
+  // Stopped is checked before waiting: after Stop() consumer doesn't release
+  // blocks, and producer can get only one permit that is released by Stop().
+  Byte *GetFreeBlock()
+  {
+    if (Stopped)
+      return 0;
+    UInt64 startTime = GetPipeTime();
+    _freeSemaphore.Lock();
+    PutWaitTime += GetPipeTime() - startTime;
+    if (Stopped)
+      return 0;
+    return _buf + (size_t)_putIndex * kPipeBlockSize;
+  }
+  // block with size = 0 is end of data
+  void PutBlock(UInt32 size, HRESULT result = S_OK)
+  {
+    _sizes[_putIndex] = size;
+    if (size == 0)
+      Result = result;
+    if (++_putIndex == kPipeNumBlocks)
+      _putIndex = 0;
+    _filledSemaphore.Release();
+  }
+  void Finish(HRESULT result)
+  {
+    if (GetFreeBlock() != 0)
+      PutBlock(0, result);
+  }
+
+  // consumer
+  const Byte *GetBlock(UInt32 &size)
+  {
+    UInt64 startTime = GetPipeTime();
+    _filledSemaphore.Lock();
+    GetWaitTime += GetPipeTime() - startTime;
+    size = _sizes[_getIndex];
+    return _buf + (size_t)_getIndex * kPipeBlockSize;
+  }
+  void ReleaseBlock()
+  {
+    if (++_getIndex == kPipeNumBlocks)
+      _getIndex = 0;
+    _freeSemaphore.Release();
+  }
+  // consumer doesn't need more data
+  void Stop()
+  {
+    Stopped = true;
+    _freeSemaphore.Release();
+  }
+};
+
+class CPipeInStream: 
+  public IInStream,
+  public CMyUnknownImp
+{
+  CPipeQueue *_queue;
+  const Byte *_block;
+  UInt32 _blockSize;
+  UInt32 _blockPos;
+  UInt64 _pos;
+  bool _finished;
+public:
+  MY_UNKNOWN_IMP1(IInStream)
+  void Init(CPipeQueue *queue, UInt64 startPos)
+  {
+    _queue = queue;
+    _block = 0;
+    _blockSize = _blockPos = 0;
+    _pos = startPos;
+    _finished = false;
+  }
+  STDMETHOD(Read)(void *data, UInt32 size, UInt32 *processedSize);
+  STDMETHOD(Seek)(Int64 offset, UInt32 seekOrigin, UInt64 *newPosition);
+};
+
+STDMETHODIMP CPipeInStream::Read(void *data, UInt32 size, UInt32 *processedSize)
+{
+  if (processedSize != NULL)
+    *processedSize = 0;
+  if (size == 0)
+    return S_OK;
+  if (_blockPos == _blockSize)
+  {
+    if (_finished)
+      return _queue->Result;
+    if (_block != 0)
+      _queue->ReleaseBlock();
+    _block = _queue->GetBlock(_blockSize);
+    _blockPos = 0;
+    if (_blockSize == 0)
+    {
+      _block = 0;
+      _finished = true;
+      return _queue->Result;
+    }
+  }
+  UInt32 rem = _blockSize - _blockPos;
+  if (size > rem)
+    size = rem;
+  memcpy(data, _block + _blockPos, size);
+  _blockPos += size;
+  _pos += size;
+  if (processedSize != NULL)
+    *processedSize = size;
+  return S_OK;
+}
+
+// CDecoder reads pack stream with seek before each read, but it reads sequentially
+STDMETHODIMP CPipeInStream::Seek(Int64 offset, UInt32 seekOrigin, UInt64 *newPosition)
+{
+  UInt64 newPos;
+  switch(seekOrigin)
+  {
+    case STREAM_SEEK_SET: newPos = offset; break;
+    case STREAM_SEEK_CUR: newPos = _pos + offset; break;
+    default: return STG_E_INVALIDFUNCTION;
+  }
+  if (newPos != _pos)
+    return E_FAIL;
+  if (newPosition != NULL)
+    *newPosition = _pos;
+  return S_OK;
+}
+
+class CPipeOutStream: 
+  public ISequentialOutStream,
+  public CMyUnknownImp
+{
+  CPipeQueue *_queue;
+  Byte *_block;
+  UInt32 _blockPos;
+public:
+  MY_UNKNOWN_IMP
+  void Init(CPipeQueue *queue)
+  {
+    _queue = queue;
+    _block = 0;
+    _blockPos = 0;
+  }
+  void Finish(HRESULT result);
+  STDMETHOD(Write)(const void *data, UInt32 size, UInt32 *processedSize);
+};
+
+STDMETHODIMP CPipeOutStream::Write(const void *data, UInt32 size, UInt32 *processedSize)
+{
+  if (processedSize != NULL)
+    *processedSize = 0;
+  while (size != 0)
+  {
+    if (_block == 0)
+    {
+      _block = _queue->GetFreeBlock();
+      if (_block == 0)
+        return E_ABORT;
+      _blockPos = 0;
+    }
+    UInt32 cur = kPipeBlockSize - _blockPos;
+    if (cur > size)
+      cur = size;
+    memcpy(_block + _blockPos, data, cur);
+    _blockPos += cur;
+    data = (const Byte *)data + cur;
+    size -= cur;
+    if (processedSize != NULL)
+      *processedSize += cur;
+    if (_blockPos == kPipeBlockSize)
+    {
+      _queue->PutBlock(_blockPos);
+      _block = 0;
+    }
+  }
+  return S_OK;
+}
+
+void CPipeOutStream::Finish(HRESULT result)
+{
+  if (_block != 0)
+  {
+    if (_blockPos == 0)
+    {
+      _queue->PutBlock(0, result);
+      return;
+    }
+    _queue->PutBlock(_blockPos);
+  }
+  _queue->Finish(result);
+}
+
+class CPipeReaderThread: public CVirtThread
+{
+public:
+  IInStream *Stream;
+  UInt64 Pos;
+  UInt64 Size;
+  CPipeQueue Queue;
+  virtual void Execute();
+};
+
+void CPipeReaderThread::Execute()
+{
+  HRESULT res = Stream->Seek(Pos, STREAM_SEEK_SET, NULL);
+  UInt64 rem = Size;
+  for (;;)
+  {
+    Byte *block = Queue.GetFreeBlock();
+    if (block == 0)
+      return;
+    UInt32 cur = kPipeBlockSize;
+    if (cur > rem)
+      cur = (UInt32)rem;
+    UInt32 processed = 0;
+    if (res == S_OK && cur != 0)
+      res = ReadStream(Stream, block, cur, &processed);
+    if (res != S_OK)
+      processed = 0;
+    Queue.PutBlock(processed, res);
+    if (processed == 0)
+      return;
+    rem -= processed;
+  }
+}
+
+class CPipeDecodeThread: public CVirtThread
+{
+public:
+  #ifdef EXTERNAL_CODECS
+  ICompressCodecsInfo *CodecsInfo;
+  const CObjectVector<CCodecInfoEx> *ExternalCodecs;
+  #endif
+  CDecoder *Decoder;
+  CPipeQueue *InQueue;
+  UInt64 StartPos;
+  const UInt64 *PackSizes;
+  const CFolder *Folder;
+  ICompressProgressInfo *Progress;
+  UInt32 NumThreads;
+  CPipeQueue OutQueue;
+  virtual void Execute();
+};
+
+void CPipeDecodeThread::Execute()
+{
+  HRESULT result;
+  CPipeOutStream *outStreamSpec = 0;
+  CMyComPtr<ISequentialOutStream> outStream;
+  try
+  {
+    #ifdef EXTERNAL_CODECS
+    ICompressCodecsInfo *codecsInfo = CodecsInfo;
+    const CObjectVector<CCodecInfoEx> *externalCodecs = ExternalCodecs;
+    #endif
+    CPipeInStream *inStreamSpec = new CPipeInStream;
+    CMyComPtr<IInStream> inStream = inStreamSpec;
+    inStreamSpec->Init(InQueue, StartPos);
+    outStreamSpec = new CPipeOutStream;
+    outStream = outStreamSpec;
+    outStreamSpec->Init(&OutQueue);
+    result = Decoder->Decode(
+        EXTERNAL_CODECS_LOC_VARS
+        inStream, StartPos, PackSizes, *Folder, outStream, Progress
+        #ifndef _NO_CRYPTO
+        , NULL
+        #endif
+        , true, NumThreads);
+  }
+  catch(...)
+  {
+    result = S_FALSE;
+  }
+  InQueue->Stop();
+  if (outStreamSpec != 0)
+    outStreamSpec->Finish(result);
+  else
+    OutQueue.Finish(result);
+}
+
+struct CPipeStats
+{
+  UInt64 ReadWait;
+  UInt64 DecodeInWait;
+  UInt64 DecodeOutWait;
+  UInt64 WriteWait;
+  UInt32 NumFolders;
+  CPipeStats(): ReadWait(0), DecodeInWait(0), DecodeOutWait(0), WriteWait(0), NumFolders(0) {}
+  HRESULT Report(IArchiveExtractCallback *extractCallback) const;
+};
+
+static UInt32 GetPipeTimeMs(UInt64 time, UInt64 freq)
+{
+  return (UInt32)(time * 1000 / freq);
+}
+
+HRESULT CPipeStats::Report(IArchiveExtractCallback *extractCallback) const
+{
+  if (NumFolders == 0)
+    return S_OK;
+  CMyComPtr<IArchiveExtractCallbackMt> callbackMt;
+  extractCallback->QueryInterface(IID_IArchiveExtractCallbackMt, (void **)&callbackMt);
+  if (!callbackMt)
+    return S_OK;
+  UInt64 freq = GetPipeFreq();
+  return callbackMt->SetPipeStat(NumFolders, 
+      GetPipeTimeMs(ReadWait, freq), 
+      GetPipeTimeMs(DecodeInWait, freq), 
+      GetPipeTimeMs(DecodeOutWait, freq), 
+      GetPipeTimeMs(WriteWait, freq));
+}
+
+class CExtractPipe
+{
+public:
+  CPipeReaderThread Reader;
+  CPipeDecodeThread DecodeThread;
+  CPipeStats Stats;
+  CDecodeThreadProgress *ProgressSpec;
+  CMyComPtr<ICompressProgressInfo> Progress;
+  bool IsCreated;
+  
+  CExtractPipe(): IsCreated(false)
+  {
+    ProgressSpec = new CDecodeThreadProgress;
+    Progress = ProgressSpec;
+  }
+  HRESULT Create()
+  {
+    RINOK(Reader.Queue.Create());
+    RINOK(DecodeThread.OutQueue.Create());
+    RINOK(Reader.Create());
+    RINOK(DecodeThread.Create());
+    IsCreated = true;
+    return S_OK;
+  }
+  HRESULT Decode(IInStream *inStream, UInt64 startPos, UInt64 packSize, 
+      ISequentialOutStream *outStream, ICompressProgressInfo *progress);
+};
+
+HRESULT CExtractPipe::Decode(IInStream *inStream, UInt64 startPos, UInt64 packSize, 
+    ISequentialOutStream *outStream, ICompressProgressInfo *progress)
+{
+  CPipeQueue &inQueue = Reader.Queue;
+  CPipeQueue &outQueue = DecodeThread.OutQueue;
+  RINOK(inQueue.Init());
+  RINOK(outQueue.Init());
+  Reader.Stream = inStream;
+  Reader.Pos = startPos;
+  Reader.Size = packSize;
+  DecodeThread.InQueue = &inQueue;
+  DecodeThread.StartPos = startPos;
+  DecodeThread.Progress = Progress;
+  ProgressSpec->Init();
+  Reader.Start();
+  DecodeThread.Start();
+
+  HRESULT writeResult = S_OK;
+  for (;;)
+  {
+    UInt32 size;
+    const Byte *block = outQueue.GetBlock(size);
+    if (size == 0)
+      break;
+    writeResult = WriteStream(outStream, block, size, NULL);
+    outQueue.ReleaseBlock();
+    if (writeResult == S_OK)
+      writeResult = ProgressSpec->Flush(progress);
+    if (writeResult != S_OK)
+    {
+      outQueue.Stop();
+      break;
+    }
+  }
+  DecodeThread.WaitFinish();
+  Reader.WaitFinish();
+  if (writeResult == S_OK)
+    writeResult = ProgressSpec->Flush(progress);
+  
+  Stats.ReadWait += inQueue.PutWaitTime;
+  Stats.DecodeInWait += inQueue.GetWaitTime;
+  Stats.DecodeOutWait += outQueue.PutWaitTime;
+  Stats.WriteWait += outQueue.GetWaitTime;
+  Stats.NumFolders++;
+  
+  if (writeResult != S_OK)
+    return writeResult;
+  return outQueue.Result;
+}
+
+static bool IsPipeFolder(const CArchiveDatabaseEx &database, const CExtractFolderInfo &efi)
+{
+  if (efi.FileIndex != kNumNoIndex || efi.UnPackSize < kPipeFolderSizeMin)
+    return false;
+  const CFolder &folderInfo = database.Folders[efi.FolderIndex];
+  return folderInfo.PackStreams.Size() == 1 && !IsEncryptedFolder(folderInfo);
+}
+
+#endif
+
 STDMETHODIMP CHandler::Extract(const UInt32* indices, UInt32 numItems,
     Int32 testModeSpec, IArchiveExtractCallback *extractCallbackSpec)
 {
@@ -147,6 +855,7 @@ STDMETHODIMP CHandler::Extract(const UInt32* indices, UInt32 numItems,
     true
     #endif
     );
+  decoder.SetPrimingData(_primingData, (UInt32)_primingData.GetCapacity());
   // CDecoder1 decoder;
 
   UInt64 currentTotalPacked = 0;
@@ -158,6 +867,30 @@ STDMETHODIMP CHandler::Extract(const UInt32* indices, UInt32 numItems,
   CMyComPtr<ICompressProgressInfo> progress = lps;
   lps->Init(extractCallback, false);
 
+  #ifdef COMPRESS_MT
+  CFolderDecodeThreads threads;
+  CExtractPipe pipe;
+  int nextMtIndex = 0;
+  {
+    int numMtFolders = 0;
+    for (int i = 0; i < extractFolderInfoVector.Size(); i++)
+    {
+      const CExtractFolderInfo &efi = extractFolderInfoVector[i];
+      #ifdef _7Z_VOL
+      const CArchiveDatabaseEx &database = _volumes[efi.VolumeIndex].Database;
+      #else
+      const CArchiveDatabaseEx &database = _database;
+      #endif
+      if (IsMtFolder(database, efi))
+        numMtFolders++;
+    }
+    if (_numThreads > 1 && numMtFolders > 1)
+    {
+      RINOK(threads.Create(MyMin(_numThreads, (UInt32)numMtFolders)));
+    }
+  }
+  #endif
+
   for(int i = 0; i < extractFolderInfoVector.Size(); i++, 
       currentTotalUnPacked += totalFolderUnPacked,
       currentTotalPacked += totalFolderPacked)
@@ -165,6 +898,57 @@ STDMETHODIMP CHandler::Extract(const UInt32* indices, UInt32 numItems,
     lps->OutSize = currentTotalUnPacked;
     lps->InSize = currentTotalPacked;
     RINOK(lps->SetCur());
+
+    #ifdef COMPRESS_MT
+    if (nextMtIndex < i)
+      nextMtIndex = i;
+    for (; nextMtIndex < extractFolderInfoVector.Size(); nextMtIndex++)
+    {
+      const CExtractFolderInfo &efi = extractFolderInfoVector[nextMtIndex];
+      #ifdef _7Z_VOL
+      const CVolume &volume = _volumes[efi.VolumeIndex];
+      const CArchiveDatabaseEx &database = volume.Database;
+      IInStream *inStream = volume.Stream;
+      #else
+      const CArchiveDatabaseEx &database = _database;
+      IInStream *inStream = _inStream;
+      #endif
+      if (!IsMtFolder(database, efi))
+        continue;
+      int threadIndex = threads.Find(-1);
+      if (threadIndex < 0)
+        break;
+      CNum folderIndex = efi.FolderIndex;
+      const UInt64 memUsage = threads.GetMemUsage();
+      if (memUsage != 0 && 
+          memUsage + database.GetFolderFullPackSize(folderIndex) + efi.UnPackSize > kMtFoldersMemMax)
+        break;
+      CFolderDecodeThread &t = threads.Items[threadIndex];
+      if (!t.Alloc((size_t)database.GetFolderFullPackSize(folderIndex), (size_t)efi.UnPackSize))
+      {
+        t.Free();
+        continue;
+      }
+      RINOK(inStream->Seek(database.GetFolderStreamPos(folderIndex, 0), STREAM_SEEK_SET, NULL));
+      UInt32 processedSize;
+      RINOK(ReadStream(inStream, t.PackData, (UInt32)t.PackSize, &processedSize));
+      if (processedSize != t.PackSize)
+      {
+        t.Free();
+        continue;
+      }
+      #ifdef EXTERNAL_CODECS
+      t.CodecsInfo = _codecsInfo;
+      t.ExternalCodecs = &_externalCodecs;
+      #endif
+      t.Decoder.SetPrimingData(_primingData, (UInt32)_primingData.GetCapacity());
+      t.Folder = &database.Folders[folderIndex];
+      t.PackSizes = &database.PackSizes[database.FolderStartPackStreamIndex[folderIndex]];
+      t.ExtractIndex = nextMtIndex;
+      t.ProgressSpec->Init();
+      t.Start();
+    }
+    #endif
     
     const CExtractFolderInfo &efi = extractFolderInfoVector[i];
     totalFolderUnPacked = efi.UnPackSize;
@@ -216,9 +1000,51 @@ STDMETHODIMP CHandler::Extract(const UInt32* indices, UInt32 numItems,
       extractCallback.QueryInterface(IID_ICryptoGetTextPassword, &getTextPassword);
     #endif
 
+    #ifdef COMPRESS_MT
+    int threadIndex = threads.Find(i);
+    #endif
+
     try
     {
-      HRESULT result = decoder.Decode(
+      HRESULT result;
+      #ifdef COMPRESS_MT
+      if (threadIndex >= 0)
+      {
+        CFolderDecodeThread &t = threads.Items[threadIndex];
+        while (!t.TryWaitFinish(kMtProgressTimeMs))
+        {
+          RINOK(t.ProgressSpec->Flush(progress));
+        }
+        result = t.Result;
+        if (result == S_OK)
+          result = WriteStream(outStream, t.UnPackData, (UInt32)t.UnPackProcessed, NULL);
+        t.Free();
+      }
+      else if (_numThreads > 1 && _extractPipe && IsPipeFolder(database, efi))
+      {
+        if (!pipe.IsCreated)
+        {
+          RINOK(pipe.Create());
+        }
+        #ifdef EXTERNAL_CODECS
+        pipe.DecodeThread.CodecsInfo = _codecsInfo;
+        pipe.DecodeThread.ExternalCodecs = &_externalCodecs;
+        #endif
+        pipe.DecodeThread.Decoder = &decoder;
+        pipe.DecodeThread.PackSizes = &database.PackSizes[packStreamIndex];
+        pipe.DecodeThread.Folder = &folderInfo;
+        pipe.DecodeThread.NumThreads = _numThreads;
+        result = pipe.Decode(
+            #ifdef _7Z_VOL
+            volume.Stream,
+            #else
+            _inStream,
+            #endif
+            folderStartPackPos, totalFolderPacked, outStream, progress);
+      }
+      else
+      #endif
+      result = decoder.Decode(
           EXTERNAL_CODECS_VARS
           #ifdef _7Z_VOL
           volume.Stream,
@@ -262,6 +1088,9 @@ STDMETHODIMP CHandler::Extract(const UInt32* indices, UInt32 numItems,
       continue;
     }
   }
+  #ifdef COMPRESS_MT
+  RINOK(pipe.Stats.Report(extractCallback));
+  #endif
   return S_OK;
   COM_TRY_END
 }
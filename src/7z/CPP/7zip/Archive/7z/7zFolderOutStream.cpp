@@ -56,8 +56,8 @@ HRESULT CFolderOutStream::OpenFile()
   if (askMode == NArchive::NExtract::NAskMode::kExtract &&
       (!realOutStream)) 
   {
-    const CFileItem &fileInfo = _archiveDatabase->Files[index];
-    if (!fileInfo.IsAnti && !fileInfo.IsDirectory)
+    const CFileTable &files = _archiveDatabase->Files;
+    if (!files.IsAnti(index) && !files.IsDirectory(index))
       askMode = NArchive::NExtract::NAskMode::kSkip;
   }
   return _extractCallback->PrepareOperation(askMode);
@@ -68,8 +68,8 @@ HRESULT CFolderOutStream::WriteEmptyFiles()
   for(;_currentIndex < _extractStatuses->Size(); _currentIndex++)
   {
     UInt32 index = _startIndex + _currentIndex;
-    const CFileItem &fileInfo = _archiveDatabase->Files[index];
-    if (!fileInfo.IsAnti && !fileInfo.IsDirectory && fileInfo.UnPackSize != 0)
+    const CFileTable &files = _archiveDatabase->Files;
+    if (!files.IsAnti(index) && !files.IsDirectory(index) && files.GetUnPackSize(index) != 0)
       return S_OK;
     RINOK(OpenFile());
     RINOK(_extractCallback->SetOperationResult(
@@ -88,8 +88,8 @@ STDMETHODIMP CFolderOutStream::Write(const void *data,
     if (_fileIsOpen)
     {
       UInt32 index = _startIndex + _currentIndex;
-      const CFileItem &fileInfo = _archiveDatabase->Files[index];
-      UInt64 fileSize = fileInfo.UnPackSize;
+      const CFileTable &files = _archiveDatabase->Files;
+      UInt64 fileSize = files.GetUnPackSize(index);
       
       UInt32 numBytesToWrite = (UInt32)MyMin(fileSize - _filePos, 
           UInt64(size - realProcessedSize));
@@ -102,11 +102,10 @@ STDMETHODIMP CFolderOutStream::Write(const void *data,
       realProcessedSize += processedSizeLocal;
       if (_filePos == fileSize)
       {
-        bool digestsAreEqual;
-        if (fileInfo.IsFileCRCDefined && _checkCrc)
-          digestsAreEqual = fileInfo.FileCRC == _outStreamWithHashSpec->GetCRC();
-        else
-          digestsAreEqual = true;
+        bool digestsAreEqual = true;
+        UInt32 fileCRC;
+        if (_checkCrc && files.FileCRCs.Get(index, fileCRC))
+          digestsAreEqual = fileCRC == _outStreamWithHashSpec->GetCRC();
 
         RINOK(_extractCallback->SetOperationResult(
             digestsAreEqual ? 
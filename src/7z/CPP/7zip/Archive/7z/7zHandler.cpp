@@ -24,6 +24,10 @@
 #include "../../../Windows/System.h"
 #endif
 
+#ifdef __7Z_SET_PROPERTIES
+#include "../../../Windows/FileIO.h"
+#endif
+
 using namespace NWindows;
 
 extern UString ConvertMethodIdToString(UInt64 id);
@@ -34,6 +38,8 @@ namespace N7z {
 CHandler::CHandler()
 {
   _crcSize = 4;
+  _deferFileProperties = false;
+  _extractPipe = true;
 
   #ifdef EXTRACT_ONLY
   #ifdef COMPRESS_MT
@@ -124,10 +130,21 @@ IMP_IInArchive_ArcProps
 
 #endif
 
-static void MySetFileTime(bool timeDefined, FILETIME unixTime, NWindows::NCOM::CPropVariant &prop)
+// Names and times are parsed at first request (CInArchive::DeferFileProperties)
+
+static HRESULT ReadDeferredProperty(CArchiveDatabaseEx &database, UInt64 type)
 {
-  if (timeDefined)
-    prop = unixTime;
+  if (!database.IsPropertyDeferred(type) && !database.IsPropertyBad(type))
+    return S_OK;
+  CInArchive archive;
+  return archive.ReadDeferredProperties(database, type);
+}
+
+static void MySetFileTime(const CFileColumn<CArchiveFileTime> &times, UInt32 index, NWindows::NCOM::CPropVariant &prop)
+{
+  CArchiveFileTime fileTime;
+  if (times.Get(index, fileTime))
+    prop = fileTime;
 }
 
 #ifndef _SFX
@@ -217,29 +234,33 @@ STDMETHODIMP CHandler::GetProperty(UInt32 index, PROPID propID,  PROPVARIANT *va
   
   #ifdef _7Z_VOL
   const CRef &ref = _refs[index];
-  const CVolume &volume = _volumes[ref.VolumeIndex];
-  const CArchiveDatabaseEx &_database = volume.Database;
+  CVolume &volume = _volumes[ref.VolumeIndex];
+  CArchiveDatabaseEx &_database = volume.Database;
   UInt32 index2 = ref.ItemIndex;
-  const CFileItem &item = _database.Files[index2];
   #else
-  const CFileItem &item = _database.Files[index];
   UInt32 index2 = index;
   #endif
+  const CFileTable &files = _database.Files;
 
   switch(propID)
   {
     case kpidPath:
     {
-      if (!item.Name.IsEmpty())
-        prop = NItemName::GetOSName(item.Name);
+      RINOK(ReadDeferredProperty(_database, NID::kName));
+      if (!files.IsNameEmpty(index2))
+      {
+        UString name;
+        files.GetName(index2, name);
+        prop = NItemName::GetOSName(name);
+      }
       break;
     }
     case kpidIsFolder:
-      prop = item.IsDirectory;
+      prop = files.IsDirectory(index2);
       break;
     case kpidSize:
     {
-      prop = item.UnPackSize;
+      prop = files.GetUnPackSize(index2);
       // prop = ref2.UnPackSize;
       break;
     }
@@ -250,8 +271,11 @@ STDMETHODIMP CHandler::GetProperty(UInt32 index, PROPID propID,  PROPVARIANT *va
         prop = ref2.StartPos;
       else
       */
-        if (item.IsStartPosDefined)
-          prop = item.StartPos;
+      {
+        UInt64 startPos;
+        if (files.StartPositions.Get(index2, startPos))
+          prop = startPos;
+      }
       break;
     }
     case kpidPackedSize:
@@ -274,22 +298,31 @@ STDMETHODIMP CHandler::GetProperty(UInt32 index, PROPID propID,  PROPVARIANT *va
       break;
     }
     case kpidLastAccessTime:
-      MySetFileTime(item.IsLastAccessTimeDefined, item.LastAccessTime, prop);
+      RINOK(ReadDeferredProperty(_database, NID::kLastAccessTime));
+      MySetFileTime(files.LastAccessTimes, index2, prop);
       break;
     case kpidCreationTime:
-      MySetFileTime(item.IsCreationTimeDefined, item.CreationTime, prop);
+      RINOK(ReadDeferredProperty(_database, NID::kCreationTime));
+      MySetFileTime(files.CreationTimes, index2, prop);
       break;
     case kpidLastWriteTime:
-      MySetFileTime(item.IsLastWriteTimeDefined, item.LastWriteTime, prop);
+      RINOK(ReadDeferredProperty(_database, NID::kLastWriteTime));
+      MySetFileTime(files.LastWriteTimes, index2, prop);
       break;
     case kpidAttributes:
-      if (item.AreAttributesDefined)
-        prop = item.Attributes;
+    {
+      UInt32 attributes;
+      if (files.Attributes.Get(index2, attributes))
+        prop = attributes;
       break;
+    }
     case kpidCRC:
-      if (item.IsFileCRCDefined)
-        prop = item.FileCRC;
+    {
+      UInt32 crc;
+      if (files.FileCRCs.Get(index2, crc))
+        prop = crc;
       break;
+    }
     case kpidEncrypted:
     {
       prop = IsEncrypted(index2);
@@ -427,7 +460,7 @@ STDMETHODIMP CHandler::GetProperty(UInt32 index, PROPID propID,  PROPVARIANT *va
       break;
     #endif
     case kpidIsAnti:
-      prop = item.IsAnti;
+      prop = files.IsAnti(index2);
       break;
   }
   prop.Detach(value);
@@ -579,6 +612,7 @@ STDMETHODIMP CHandler::Open(IInStream *stream,
         inStream = stream;
 
       CInArchive archive;
+      archive.DeferFileProperties = _deferFileProperties;
       RINOK(archive.Open(inStream, maxCheckStartPosition));
 
       _volumes.Add(CVolume());
@@ -644,12 +678,12 @@ STDMETHODIMP CHandler::Open(IInStream *stream,
       }
       if (database.Files.Size() != 1)
         break;
-      const CFileItem &file = database.Files.Front();
-      if (!file.IsStartPosDefined)
+      if (!database.Files.StartPositions.Defined.Get(0))
         break;
     }
     #else
     CInArchive archive;
+    archive.DeferFileProperties = _deferFileProperties;
     RINOK(archive.Open(stream, maxCheckStartPosition));
     HRESULT result = archive.ReadDatabase(
       EXTERNAL_CODECS_VARS
@@ -690,6 +724,20 @@ STDMETHODIMP CHandler::Close()
   COM_TRY_END
 }
 
+#ifndef _7Z_VOL
+STDMETHODIMP CHandler::FindItem(const wchar_t *path, UInt32 *index)
+{
+  COM_TRY_BEGIN
+  RINOK(ReadDeferredProperty(_database, NID::kName));
+  int fileIndex = _database.Files.FindName(NItemName::MakeLegalName(path));
+  if (fileIndex < 0)
+    return S_FALSE;
+  *index = (UInt32)fileIndex;
+  return S_OK;
+  COM_TRY_END
+}
+#endif
+
 #ifdef _7Z_VOL
 STDMETHODIMP CHandler::GetStream(UInt32 index, ISequentialInStream **stream)
 {
@@ -700,17 +748,19 @@ STDMETHODIMP CHandler::GetStream(UInt32 index, ISequentialInStream **stream)
   CMyComPtr<ISequentialInStream> streamTemp = streamSpec;
   
   UInt64 pos = 0;
-  const UString *fileName;
+  UString fileName;
   for (int i = 0; i < _refs.Size(); i++)
   {
     const CRef &ref = _refs[i];
-    const CVolume &volume = _volumes[ref.VolumeIndex];
-    const CArchiveDatabaseEx &database = volume.Database;
-    const CFileItem &file = database.Files[ref.ItemIndex];
+    CVolume &volume = _volumes[ref.VolumeIndex];
+    CArchiveDatabaseEx &database = volume.Database;
+    RINOK(ReadDeferredProperty(database, NID::kName));
+    CFileItem file;
+    database.Files.GetItem(ref.ItemIndex, file);
     if (i == 0)
-      fileName = &file.Name;
+      fileName = file.Name;
     else
-      if (fileName->Compare(file.Name) != 0)
+      if (fileName.Compare(file.Name) != 0)
         return S_FALSE;
     if (!file.IsStartPosDefined)
       return S_FALSE;
@@ -749,6 +799,30 @@ STDMETHODIMP CHandler::GetStream(UInt32 index, ISequentialInStream **stream)
 
 
 #ifdef __7Z_SET_PROPERTIES
+
+static const UInt32 kPrimingSizeMax = (1 << 24);
+
+HRESULT CHandler::ReadPrimingData(const PROPVARIANT &value)
+{
+  _primingData.Free();
+  if (value.vt != VT_BSTR)
+    return E_INVALIDARG;
+  NFile::NIO::CInFile file;
+  UInt64 length;
+  if (!file.Open(value.bstrVal) || !file.GetLength(length))
+    return E_FAIL;
+  if (length == 0 || length > kPrimingSizeMax)
+    return E_INVALIDARG;
+  _primingData.SetCapacity((size_t)length);
+  UInt32 processedSize;
+  if (!file.Read(_primingData, (UInt32)length, processedSize) || processedSize != length)
+  {
+    _primingData.Free();
+    return E_FAIL;
+  }
+  return S_OK;
+}
+
 #ifdef EXTRACT_ONLY
 
 STDMETHODIMP CHandler::SetProperties(const wchar_t **names, const PROPVARIANT *values, Int32 numProperties)
@@ -758,6 +832,9 @@ STDMETHODIMP CHandler::SetProperties(const wchar_t **names, const PROPVARIANT *v
   const UInt32 numProcessors = NSystem::GetNumberOfProcessors();
   _numThreads = numProcessors;
   #endif
+  _deferFileProperties = false;
+  _extractPipe = true;
+  _primingData.Free();
 
   for (int i = 0; i < numProperties; i++)
   {
@@ -770,6 +847,21 @@ STDMETHODIMP CHandler::SetProperties(const wchar_t **names, const PROPVARIANT *v
     int index = ParseStringToUInt32(name, number);
     if (index == 0)
     {
+      if (name.CompareNoCase(L"DP") == 0)
+      {
+        RINOK(SetBoolProperty(_deferFileProperties, value));
+        continue;
+      }
+      if (name.CompareNoCase(L"PIPE") == 0)
+      {
+        RINOK(SetBoolProperty(_extractPipe, value));
+        continue;
+      }
+      if (name.CompareNoCase(L"PRIME") == 0)
+      {
+        RINOK(ReadPrimingData(value));
+        continue;
+      }
       if(name.Left(2).CompareNoCase(L"MT") == 0)
       {
         #ifdef COMPRESS_MT
@@ -53,6 +53,8 @@ class CHandler:
   public IInArchive,
   #ifdef _7Z_VOL
   public IInArchiveGetStream,
+  #else
+  public IInArchiveFindItem,
   #endif
   #ifdef __7Z_SET_PROPERTIES
   public ISetProperties, 
@@ -67,6 +69,8 @@ public:
   MY_QUERYINTERFACE_BEGIN2(IInArchive)
   #ifdef _7Z_VOL
   MY_QUERYINTERFACE_ENTRY(IInArchiveGetStream)
+  #else
+  MY_QUERYINTERFACE_ENTRY(IInArchiveFindItem)
   #endif
   #ifdef __7Z_SET_PROPERTIES
   MY_QUERYINTERFACE_ENTRY(ISetProperties)
@@ -82,6 +86,8 @@ public:
 
   #ifdef _7Z_VOL
   STDMETHOD(GetStream)(UInt32 index, ISequentialInStream **stream);  
+  #else
+  STDMETHOD(FindItem)(const wchar_t *path, UInt32 *index);
   #endif
 
   #ifdef __7Z_SET_PROPERTIES
@@ -105,6 +111,18 @@ private:
   NArchive::N7z::CArchiveDatabaseEx _database;
   #endif
 
+  // names and times are parsed at first request, if it's set ("dp" property)
+  bool _deferFileProperties;
+  // big folders are extracted with reader and decoder threads ("pipe" property)
+  bool _extractPipe;
+  // data from file of "prime" property for priming of coders, like PPMd.
+  // Archive must be extracted with same data, as it was created.
+  CByteBuffer _primingData;
+
+  #ifdef __7Z_SET_PROPERTIES
+  HRESULT ReadPrimingData(const PROPVARIANT &value);
+  #endif
+
   #ifdef EXTRACT_ONLY
   
   #ifdef COMPRESS_MT
@@ -205,11 +205,11 @@ STDMETHODIMP CHandler::UpdateItems(ISequentialOutStream *outStream, UInt32 numIt
 {
   COM_TRY_BEGIN
 
-  const CArchiveDatabaseEx *database = 0;
+  CArchiveDatabaseEx *database = 0;
   #ifdef _7Z_VOL
   if(_volumes.Size() > 1)
     return E_FAIL;
-  const CVolume *volume = 0;
+  CVolume *volume = 0;
   if (_volumes.Size() == 1)
   {
     volume = &_volumes.Front();
@@ -219,6 +219,13 @@ STDMETHODIMP CHandler::UpdateItems(ISequentialOutStream *outStream, UInt32 numIt
   if (_inStream != 0)
     database = &_database;
   #endif
+  if (database != 0 && 
+      (!database->DeferredProperties.IsEmpty() || !database->BadProperties.IsEmpty()))
+  {
+    // update needs all properties of old items
+    CInArchive archive;
+    RINOK(archive.ReadDeferredProperties(*database));
+  }
 
   // CRecordVector<bool> compressStatuses;
   CObjectVector<CUpdateItem> updateItems;
@@ -246,7 +253,8 @@ STDMETHODIMP CHandler::UpdateItems(ISequentialOutStream *outStream, UInt32 numIt
 
     if (updateItem.IndexInArchive != -1)
     {
-      const CFileItem &fileItem = database->Files[updateItem.IndexInArchive];
+      CFileItem fileItem;
+      database->Files.GetItem(updateItem.IndexInArchive, fileItem);
       updateItem.Name = fileItem.Name;
       updateItem.IsDirectory = fileItem.IsDirectory;
       updateItem.Size = fileItem.UnPackSize;
@@ -356,6 +364,7 @@ STDMETHODIMP CHandler::UpdateItems(ISequentialOutStream *outStream, UInt32 numIt
   #endif
 
   RINOK(SetPassword(methodMode, updateCallback));
+  methodMode.PrimingData = _primingData;
 
   bool compressMainHeader = _compressHeaders;  // check it
 
@@ -435,6 +444,9 @@ STDMETHODIMP CHandler::SetProperties(const wchar_t **names, const PROPVARIANT *v
   COM_TRY_BEGIN
   _binds.Clear();
   BeforeSetProperty();
+  _deferFileProperties = false;
+  _extractPipe = true;
+  _primingData.Free();
 
   for (int i = 0; i < numProperties; i++)
   {
@@ -445,6 +457,24 @@ STDMETHODIMP CHandler::SetProperties(const wchar_t **names, const PROPVARIANT *v
 
     const PROPVARIANT &value = values[i];
 
+    if (name.CompareNoCase(L"DP") == 0)
+    {
+      RINOK(SetBoolProperty(_deferFileProperties, value));
+      continue;
+    }
+
+    if (name.CompareNoCase(L"PIPE") == 0)
+    {
+      RINOK(SetBoolProperty(_extractPipe, value));
+      continue;
+    }
+
+    if (name.CompareNoCase(L"PRIME") == 0)
+    {
+      RINOK(ReadPrimingData(value));
+      continue;
+    }
+
     if (name[0] == 'B')
     {
       name.Delete(0);
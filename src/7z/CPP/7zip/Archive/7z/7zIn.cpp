@@ -129,6 +129,7 @@ void CInByte2::SkeepData(UInt64 size)
 {
   if (size > _size - _pos)
     ThrowEndOfData();
+  _pos += (size_t)size;
 }
 
 void CInByte2::SkeepData()
@@ -210,6 +211,33 @@ void CInByte2::ReadString(UString &s)
   _pos += rem + 2;
 }
 
+void CInByte2::ReadNames(int numItems, CByteBuffer &names, CRecordVector<UInt32> &offsets)
+{
+  const Byte *buf = _buffer + _pos;
+  size_t rem = (_size - _pos) / 2 * 2;
+  if (rem > (UInt32)0xFFFFFFFF)
+    ThrowUnsupported();
+  offsets.Clear();
+  offsets.Reserve(numItems + 1);
+  size_t pos = 0;
+  for (int i = 0; i < numItems; i++)
+  {
+    offsets.Add((UInt32)pos);
+    for (;; pos += 2)
+    {
+      if (pos >= rem)
+        ThrowEndOfData();
+      if (buf[pos] == 0 && buf[pos + 1] == 0)
+        break;
+    }
+    pos += 2;
+  }
+  offsets.Add((UInt32)pos);
+  names.SetCapacity(pos);
+  memcpy(names, buf, pos);
+  _pos += pos;
+}
+
 static inline bool TestSignatureCandidate(const Byte *p)
 {
   for (int i = 0; i < kSignatureSize; i++)
@@ -668,7 +696,7 @@ void CInArchive::ReadBoolVector2(int numItems, CBoolVector &v)
 }
 
 void CInArchive::ReadTime(const CObjectVector<CByteBuffer> &dataVector,
-    CObjectVector<CFileItem> &files, UInt32 type)
+    CFileTable &files, UInt32 type)
 {
   CBoolVector boolVector;
   ReadBoolVector2(files.Size(), boolVector);
@@ -676,37 +704,81 @@ void CInArchive::ReadTime(const CObjectVector<CByteBuffer> &dataVector,
   CStreamSwitch streamSwitch;
   streamSwitch.Set(this, &dataVector);
 
+  CFileColumn<CArchiveFileTime> *column;
+  switch(type)
+  {
+    case NID::kCreationTime: column = &files.CreationTimes; break;
+    case NID::kLastWriteTime: column = &files.LastWriteTimes; break;
+    default: column = &files.LastAccessTimes; break;
+  }
+  CArchiveFileTime fileTime;
+  fileTime.dwLowDateTime = 0;
+  fileTime.dwHighDateTime = 0;
+  column->Alloc(files.Size(), fileTime);
+
   for(int i = 0; i < files.Size(); i++)
   {
-    CFileItem &file = files[i];
-    CArchiveFileTime fileTime;
-    fileTime.dwLowDateTime = 0;
-    fileTime.dwHighDateTime = 0;
-    bool defined = boolVector[i];
-    if (defined)
+    if (boolVector[i])
     {
       fileTime.dwLowDateTime = ReadUInt32();
       fileTime.dwHighDateTime = ReadUInt32();
+      column->Set(i, fileTime);
     }
-    switch(type)
+  }
+}
+
+void CInArchive::ReadFileProperty(const CObjectVector<CByteBuffer> &dataVector,
+    CArchiveDatabaseEx &database, UInt64 type)
+{
+  CFileTable &files = database.Files;
+  if (type == NID::kName)
+  {
+    files.NameHash.Clear();
+    CStreamSwitch streamSwitch;
+    streamSwitch.Set(this, &dataVector);
+    _inByteBack->ReadNames(files.Size(), files.Names, files.NameOffsets);
+  }
+  else
+    ReadTime(dataVector, files, (UInt32)type);
+}
+
+HRESULT CInArchive::ReadDeferredProperties2(CArchiveDatabaseEx &database, const UInt64 *type)
+{
+  HRESULT res = S_OK;
+  if (type != NULL ? database.IsPropertyBad(*type) : !database.BadProperties.IsEmpty())
+    res = E_FAIL;
+  for (int i = 0; i < database.DeferredProperties.Size();)
+  {
+    CDeferredProperty prop = database.DeferredProperties[i];
+    if (type != NULL && prop.Type != *type)
     {
-      case NID::kCreationTime:
-        file.IsCreationTimeDefined = defined;
-        if (defined)
-          file.CreationTime = fileTime;
-        break;
-      case NID::kLastWriteTime:
-        file.IsLastWriteTimeDefined = defined;
-        if (defined)
-          file.LastWriteTime = fileTime;
-        break;
-      case NID::kLastAccessTime:
-        file.IsLastAccessTimeDefined = defined;
-        if (defined)
-          file.LastAccessTime = fileTime;
-        break;
+      i++;
+      continue;
+    }
+    database.DeferredProperties.Delete(i);
+    try
+    {
+      CStreamSwitch streamSwitch;
+      streamSwitch.Set(this, prop.Data, prop.Size);
+      ReadFileProperty(database.AdditionalStreams, database, prop.Type);
+    }
+    catch(CInArchiveException &)
+    {
+      CFileTable &files = database.Files;
+      switch((UInt32)prop.Type)
+      {
+        case NID::kName: files.Names.Free(); files.NameOffsets.Clear(); break;
+        case NID::kCreationTime: files.CreationTimes.Clear(); break;
+        case NID::kLastWriteTime: files.LastWriteTimes.Clear(); break;
+        case NID::kLastAccessTime: files.LastAccessTimes.Clear(); break;
+      }
+      database.BadProperties.Add(prop.Type);
+      res = E_FAIL;
     }
   }
+  if (database.DeferredProperties.IsEmpty())
+    database.FreeHeaderData();
+  return res;
 }
 
 HRESULT CInArchive::ReadAndDecodePackedStreams(
@@ -803,7 +875,7 @@ HRESULT CInArchive::ReadHeader(
     type = ReadID();
   }
  
-  CObjectVector<CByteBuffer> dataVector;
+  CObjectVector<CByteBuffer> &dataVector = database.AdditionalStreams;
   
   if (type == NID::kAdditionalStreamsInfo)
   {
@@ -860,10 +932,8 @@ HRESULT CInArchive::ReadHeader(
     ThrowIncorrect();
   
   CNum numFiles = ReadNum();
-  database.Files.Reserve(numFiles);
+  database.Files.Alloc(numFiles);
   CNum i;
-  for(i = 0; i < numFiles; i++)
-    database.Files.Add(CFileItem());
 
   database.ArchiveInfo.FileInfoPopIDs.Add(NID::kSize);
   if (!database.PackSizes.IsEmpty())
@@ -891,11 +961,21 @@ HRESULT CInArchive::ReadHeader(
     else switch((UInt32)type)
     {
       case NID::kName:
+      case NID::kCreationTime:
+      case NID::kLastWriteTime:
+      case NID::kLastAccessTime:
       {
-        CStreamSwitch streamSwitch;
-        streamSwitch.Set(this, &dataVector);
-        for(int i = 0; i < database.Files.Size(); i++)
-          _inByteBack->ReadString(database.Files[i].Name);
+        if (DeferFileProperties)
+        {
+          CDeferredProperty prop;
+          prop.Type = type;
+          prop.Data = _inByteBack->GetPtr();
+          SkeepData(size);
+          prop.Size = (size_t)size;
+          database.DeferredProperties.Add(prop);
+        }
+        else
+          ReadFileProperty(dataVector, database, type);
         break;
       }
       case NID::kWinAttributes:
@@ -904,13 +984,10 @@ HRESULT CInArchive::ReadHeader(
         ReadBoolVector2(database.Files.Size(), boolVector);
         CStreamSwitch streamSwitch;
         streamSwitch.Set(this, &dataVector);
+        database.Files.Attributes.Alloc(numFiles, 0);
         for(i = 0; i < numFiles; i++)
-        {
-          CFileItem &file = database.Files[i];
-          file.AreAttributesDefined = boolVector[i];
-          if (file.AreAttributesDefined)
-            file.Attributes = ReadUInt32();
-        }
+          if (boolVector[i])
+            database.Files.Attributes.Set(i, ReadUInt32());
         break;
       }
       case NID::kStartPos:
@@ -919,13 +996,10 @@ HRESULT CInArchive::ReadHeader(
         ReadBoolVector2(database.Files.Size(), boolVector);
         CStreamSwitch streamSwitch;
         streamSwitch.Set(this, &dataVector);
+        database.Files.StartPositions.Alloc(numFiles, 0);
         for(i = 0; i < numFiles; i++)
-        {
-          CFileItem &file = database.Files[i];
-          file.IsStartPosDefined = boolVector[i];
-          if (file.IsStartPosDefined)
-            file.StartPos = ReadUInt64();
-        }
+          if (boolVector[i])
+            database.Files.StartPositions.Set(i, ReadUInt64());
         break;
       }
       case NID::kEmptyStream:
@@ -953,13 +1027,6 @@ HRESULT CInArchive::ReadHeader(
         ReadBoolVector(numEmptyStreams, antiFileVector);
         break;
       }
-      case NID::kCreationTime:
-      case NID::kLastWriteTime:
-      case NID::kLastAccessTime:
-      {
-        ReadTime(dataVector, database.Files, (UInt32)type);
-        break;
-      }
       default:
         isKnownType = false;
     }
@@ -969,33 +1036,140 @@ HRESULT CInArchive::ReadHeader(
       SkeepData(size);
   }
 
+  CFileTable &files = database.Files;
   CNum emptyFileIndex = 0;
   CNum sizeIndex = 0;
+  if (numEmptyStreams != numFiles)
+    files.FileCRCs.Alloc(numFiles, 0);
   for(i = 0; i < numFiles; i++)
   {
-    CFileItem &file = database.Files[i];
-    file.HasStream = !emptyStreamVector[i];
-    if(file.HasStream)
+    bool hasStream = !emptyStreamVector[i];
+    files.HasStreamFlags.Set(i, hasStream);
+    if(hasStream)
     {
-      file.IsDirectory = false;
-      file.IsAnti = false;
-      file.UnPackSize = unPackSizes[sizeIndex];
-      file.FileCRC = digests[sizeIndex];
-      file.IsFileCRCDefined = digestsDefined[sizeIndex];
+      if (sizeIndex >= (CNum)unPackSizes.Size())
+        ThrowIncorrect();
+      files.UnPackSizes[i] = unPackSizes[sizeIndex];
+      if (digestsDefined[sizeIndex])
+        files.FileCRCs.Set(i, digests[sizeIndex]);
       sizeIndex++;
     }
     else
     {
-      file.IsDirectory = !emptyFileVector[emptyFileIndex];
-      file.IsAnti = antiFileVector[emptyFileIndex];
+      files.DirectoryFlags.Set(i, !emptyFileVector[emptyFileIndex]);
+      files.AntiFlags.Set(i, antiFileVector[emptyFileIndex]);
       emptyFileIndex++;
-      file.UnPackSize = 0;
-      file.IsFileCRCDefined = false;
     }
   }
   return S_OK;
 }
 
+void CFileTable::Clear()
+{
+  Names.Free();
+  NameOffsets.Clear();
+  NameHash.Clear();
+  UnPackSizes.Clear();
+  HasStreamFlags.Clear();
+  DirectoryFlags.Clear();
+  AntiFlags.Clear();
+  FileCRCs.Clear();
+  Attributes.Clear();
+  StartPositions.Clear();
+  CreationTimes.Clear();
+  LastWriteTimes.Clear();
+  LastAccessTimes.Clear();
+}
+
+void CFileTable::Alloc(int numFiles)
+{
+  Clear();
+  UnPackSizes.Reserve(numFiles);
+  for (int i = 0; i < numFiles; i++)
+    UnPackSizes.Add(0);
+  HasStreamFlags.Alloc(numFiles);
+  DirectoryFlags.Alloc(numFiles);
+  AntiFlags.Alloc(numFiles);
+}
+
+void CFileTable::GetName(int index, UString &name) const
+{
+  if (NameOffsets.IsEmpty())
+  {
+    name.Empty();
+    return;
+  }
+  const Byte *p = (const Byte *)Names + NameOffsets[index];
+  int len = (int)((NameOffsets[index + 1] - NameOffsets[index]) / 2 - 1);
+  wchar_t *s = name.GetBuffer(len);
+  int i;
+  for (i = 0; i < len; i++, p += 2)
+    s[i] = (wchar_t)GetUInt16FromMem(p);
+  s[i] = 0;
+  name.ReleaseBuffer(len);
+}
+
+// NameHash is open addressing hash table of (file index + 1).
+// Files are inserted in index order, so the first of equal names is found.
+
+int CFileTable::FindName(const UString &name)
+{
+  if (NameOffsets.IsEmpty() || name.IsEmpty())
+    return -1;
+  if (NameHash.IsEmpty())
+  {
+    int hashSize = 1;
+    while (hashSize < Size() * 2 && hashSize < (1 << 30))
+      hashSize <<= 1;
+    NameHash.Reserve(hashSize);
+    for (int i = 0; i < hashSize; i++)
+      NameHash.Add(0);
+    for (int i = 0; i < Size(); i++)
+    {
+      UInt32 h = CrcCalc((const Byte *)Names + NameOffsets[i], 
+          NameOffsets[i + 1] - NameOffsets[i]) & (hashSize - 1);
+      while (NameHash[h] != 0)
+        h = (h + 1) & (hashSize - 1);
+      NameHash[h] = (CNum)i + 1;
+    }
+  }
+
+  size_t keySize = ((size_t)name.Length() + 1) * 2;
+  CByteBuffer key;
+  key.SetCapacity(keySize);
+  for (int i = 0; i <= name.Length(); i++)
+  {
+    wchar_t c = name[i];
+    key[i * 2] = (Byte)c;
+    key[i * 2 + 1] = (Byte)(c >> 8);
+  }
+
+  UInt32 mask = NameHash.Size() - 1;
+  for (UInt32 h = CrcCalc(key, keySize) & mask; NameHash[h] != 0; h = (h + 1) & mask)
+  {
+    CNum index = NameHash[h] - 1;
+    if (NameOffsets[index + 1] - NameOffsets[index] == keySize &&
+        memcmp((const Byte *)Names + NameOffsets[index], key, keySize) == 0)
+      return index;
+  }
+  return -1;
+}
+
+void CFileTable::GetItem(int index, CFileItem &item) const
+{
+  GetName(index, item.Name);
+  item.HasStream = HasStream(index);
+  item.IsDirectory = IsDirectory(index);
+  item.IsAnti = IsAnti(index);
+  item.UnPackSize = UnPackSizes[index];
+  item.IsFileCRCDefined = FileCRCs.Get(index, item.FileCRC);
+  item.AreAttributesDefined = Attributes.Get(index, item.Attributes);
+  item.IsStartPosDefined = StartPositions.Get(index, item.StartPos);
+  item.IsCreationTimeDefined = CreationTimes.Get(index, item.CreationTime);
+  item.IsLastWriteTimeDefined = LastWriteTimes.Get(index, item.LastWriteTime);
+  item.IsLastAccessTimeDefined = LastAccessTimes.Get(index, item.LastAccessTime);
+}
+
 
 void CArchiveDatabaseEx::FillFolderStartPackStream()
 {
@@ -1032,8 +1206,7 @@ void CArchiveDatabaseEx::FillFolderStartFileIndex()
   CNum indexInFolder = 0;
   for (int i = 0; i < Files.Size(); i++)
   {
-    const CFileItem &file = Files[i];
-    bool emptyStream = !file.HasStream;
+    bool emptyStream = !Files.HasStream(i);
     if (emptyStream && indexInFolder == 0)
     {
       FileIndexToFolderIndexMap.Add(kNumNoIndex);
@@ -1134,7 +1307,7 @@ HRESULT CInArchive::ReadDatabase2(
 
   RINOK(_stream->Seek(nextHeaderOffset, STREAM_SEEK_CUR, NULL));
 
-  CByteBuffer buffer2;
+  CByteBuffer &buffer2 = database.HeaderBuffer;
   buffer2.SetCapacity((size_t)nextHeaderSize);
 
   UInt32 realProcessedSize;
@@ -1147,7 +1320,7 @@ HRESULT CInArchive::ReadDatabase2(
   CStreamSwitch streamSwitch;
   streamSwitch.Set(this, buffer2);
   
-  CObjectVector<CByteBuffer> dataVector;
+  CObjectVector<CByteBuffer> &dataVector = database.HeaderStreams;
   
   for (;;)
   {
@@ -1174,13 +1347,16 @@ HRESULT CInArchive::ReadDatabase2(
     streamSwitch.Set(this, dataVector.Front());
   }
 
-  return ReadHeader(
+  RINOK(ReadHeader(
     EXTERNAL_CODECS_LOC_VARS
     database
     #ifndef _NO_CRYPTO
     , getTextPassword
     #endif
-    );
+    ));
+  if (database.DeferredProperties.IsEmpty())
+    database.FreeHeaderData();
+  return S_OK;
 }
 
 HRESULT CInArchive::ReadDatabase(
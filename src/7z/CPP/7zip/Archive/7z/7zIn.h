@@ -28,22 +28,68 @@ struct CInArchiveInfo
   }
 };
 
-struct CArchiveDatabaseEx: public CArchiveDatabase
+// File property that was not parsed at open time.
+// Data points to the property in the header buffers of the database.
+
+struct CDeferredProperty
 {
+  UInt64 Type;
+  const Byte *Data;
+  size_t Size;
+};
+
+struct CArchiveDatabaseEx: public CArchiveDatabaseBase
+{
+  CFileTable Files;
   CInArchiveInfo ArchiveInfo;
   CRecordVector<UInt64> PackStreamStartPositions;
   CRecordVector<CNum> FolderStartPackStreamIndex;
   CRecordVector<CNum> FolderStartFileIndex;
   CRecordVector<CNum> FileIndexToFolderIndexMap;
 
+  // they are kept after ReadDatabase only while there are deferred properties
+  CByteBuffer HeaderBuffer;
+  CObjectVector<CByteBuffer> HeaderStreams;
+  CObjectVector<CByteBuffer> AdditionalStreams;
+  CRecordVector<CDeferredProperty> DeferredProperties;
+  // deferred properties that can't be parsed. Reading of them always fails.
+  CRecordVector<UInt64> BadProperties;
+
+  void FreeHeaderData()
+  {
+    DeferredProperties.Clear();
+    HeaderBuffer.Free();
+    HeaderStreams.Clear();
+    AdditionalStreams.Clear();
+  }
+
   void Clear()
   {
-    CArchiveDatabase::Clear();
+    CArchiveDatabaseBase::Clear();
+    Files.Clear();
     ArchiveInfo.Clear();
     PackStreamStartPositions.Clear();
     FolderStartPackStreamIndex.Clear();
     FolderStartFileIndex.Clear();
     FileIndexToFolderIndexMap.Clear();
+    FreeHeaderData();
+    BadProperties.Clear();
+  }
+
+  bool IsPropertyDeferred(UInt64 type) const
+  {
+    for (int i = 0; i < DeferredProperties.Size(); i++)
+      if (DeferredProperties[i].Type == type)
+        return true;
+    return false;
+  }
+
+  bool IsPropertyBad(UInt64 type) const
+  {
+    for (int i = 0; i < BadProperties.Size(); i++)
+      if (BadProperties[i] == type)
+        return true;
+    return false;
   }
 
   void FillFolderStartPackStream();
@@ -100,6 +146,7 @@ public:
     _size = size;
     _pos = 0;
   }
+  const Byte *GetPtr() const { return _buffer + _pos; }
   Byte ReadByte();
   void ReadBytes(Byte *data, size_t size);
   void SkeepData(UInt64 size);
@@ -109,6 +156,7 @@ public:
   UInt32 ReadUInt32();
   UInt64 ReadUInt64();
   void ReadString(UString &s);
+  void ReadNames(int numItems, CByteBuffer &names, CRecordVector<UInt32> &offsets);
 };
 
 class CStreamSwitch;
@@ -194,7 +242,10 @@ private:
   void ReadBoolVector(int numItems, CBoolVector &v);
   void ReadBoolVector2(int numItems, CBoolVector &v);
   void ReadTime(const CObjectVector<CByteBuffer> &dataVector,
-      CObjectVector<CFileItem> &files, UInt32 type);
+      CFileTable &files, UInt32 type);
+  void ReadFileProperty(const CObjectVector<CByteBuffer> &dataVector,
+      CArchiveDatabaseEx &database, UInt64 type);
+  HRESULT ReadDeferredProperties2(CArchiveDatabaseEx &database, const UInt64 *type);
   HRESULT ReadAndDecodePackedStreams(
       DECL_EXTERNAL_CODECS_LOC_VARS
       UInt64 baseOffset, UInt64 &dataOffset,
@@ -218,6 +269,12 @@ private:
       #endif
       );
 public:
+  // Names and times are not parsed by ReadDatabase, if DeferFileProperties is set.
+  // Call ReadDeferredProperties before they are used.
+  bool DeferFileProperties;
+
+  CInArchive(): DeferFileProperties(false) {}
+
   HRESULT Open(IInStream *stream, const UInt64 *searchHeaderSizeLimit); // S_FALSE means is not archive
   void Close();
 
@@ -228,6 +285,12 @@ public:
       ,ICryptoGetTextPassword *getTextPassword
       #endif
       );
+
+  // E_FAIL means that property data is incorrect
+  HRESULT ReadDeferredProperties(CArchiveDatabaseEx &database, UInt64 type)
+    { return ReadDeferredProperties2(database, &type); }
+  HRESULT ReadDeferredProperties(CArchiveDatabaseEx &database)
+    { return ReadDeferredProperties2(database, NULL); }
 };
   
 }}
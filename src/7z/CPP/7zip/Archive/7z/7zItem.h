@@ -144,14 +144,121 @@ public:
   }
 };
 
-struct CArchiveDatabase
+class CBitVector
+{
+  CRecordVector<UInt32> _words;
+  int _numBits;
+public:
+  CBitVector(): _numBits(0) {}
+  int Size() const { return _numBits; }
+  void Clear()
+  {
+    _words.Clear();
+    _numBits = 0;
+  }
+  void Alloc(int numBits) // all bits are cleared
+  {
+    int numWords = (numBits + 31) >> 5;
+    _words.Clear();
+    _words.Reserve(numWords);
+    for (int i = 0; i < numWords; i++)
+      _words.Add(0);
+    _numBits = numBits;
+  }
+  // bits that were never allocated read as false
+  bool Get(int index) const 
+  { 
+    return index < _numBits && ((_words[index >> 5] >> (index & 31)) & 1) != 0;
+  }
+  void Set(int index, bool value)
+  {
+    UInt32 mask = (UInt32)1 << (index & 31);
+    if (value)
+      _words[index >> 5] |= mask;
+    else
+      _words[index >> 5] &= ~mask;
+  }
+};
+
+// Optional per-file property: values are stored for all files once the
+// property is present in the archive; Defined marks which ones are valid.
+
+template <class T>
+struct CFileColumn
+{
+  CBitVector Defined;
+  CRecordVector<T> Values;
+  void Clear()
+  {
+    Defined.Clear();
+    Values.Clear();
+  }
+  void Alloc(int numItems, const T &zero)
+  {
+    Defined.Alloc(numItems);
+    Values.Clear();
+    Values.Reserve(numItems);
+    for (int i = 0; i < numItems; i++)
+      Values.Add(zero);
+  }
+  void Set(int index, const T &value)
+  {
+    Defined.Set(index, true);
+    Values[index] = value;
+  }
+  bool Get(int index, T &value) const
+  {
+    if (!Defined.Get(index))
+      return false;
+    value = Values[index];
+    return true;
+  }
+};
+
+// Compact file list of an opened archive. Names are kept in one buffer
+// exactly as they are stored in the header (zero-terminated UTF-16LE),
+// all other properties are kept in columns, so the number of allocations
+// doesn't depend on the number of files.
+
+struct CFileTable
+{
+  CByteBuffer Names;
+  CRecordVector<UInt32> NameOffsets; // Size() + 1 offsets in Names
+  CRecordVector<UInt64> UnPackSizes;
+  CBitVector HasStreamFlags;
+  CBitVector DirectoryFlags;
+  CBitVector AntiFlags;
+  CFileColumn<UInt32> FileCRCs;
+  CFileColumn<UInt32> Attributes;
+  CFileColumn<UInt64> StartPositions;
+  CFileColumn<CArchiveFileTime> CreationTimes;
+  CFileColumn<CArchiveFileTime> LastWriteTimes;
+  CFileColumn<CArchiveFileTime> LastAccessTimes;
+  CRecordVector<CNum> NameHash; // it's built by first FindName()
+
+  int Size() const { return UnPackSizes.Size(); }
+  bool IsEmpty() const { return UnPackSizes.IsEmpty(); }
+  void Clear();
+  void Alloc(int numFiles);
+
+  bool HasStream(int index) const { return HasStreamFlags.Get(index); }
+  bool IsDirectory(int index) const { return DirectoryFlags.Get(index); }
+  bool IsAnti(int index) const { return AntiFlags.Get(index); }
+  UInt64 GetUnPackSize(int index) const { return UnPackSizes[index]; }
+  bool IsNameEmpty(int index) const { return NameOffsets.IsEmpty() || 
+      NameOffsets[index + 1] - NameOffsets[index] <= 2; }
+  void GetName(int index, UString &name) const;
+  void GetItem(int index, CFileItem &item) const;
+  int FindName(const UString &name);
+};
+
+struct CArchiveDatabaseBase
 {
   CRecordVector<UInt64> PackSizes;
   CRecordVector<bool> PackCRCsDefined;
   CRecordVector<UInt32> PackCRCs;
   CObjectVector<CFolder> Folders;
   CRecordVector<CNum> NumUnPackStreamsVector;
-  CObjectVector<CFileItem> Files;
   void Clear()
   {
     PackSizes.Clear();
@@ -159,7 +266,6 @@ struct CArchiveDatabase
     PackCRCs.Clear();
     Folders.Clear();
     NumUnPackStreamsVector.Clear();
-    Files.Clear();
   }
   bool IsEmpty() const
   {
@@ -167,8 +273,7 @@ struct CArchiveDatabase
       PackCRCsDefined.IsEmpty() && 
       PackCRCs.IsEmpty() && 
       Folders.IsEmpty() && 
-      NumUnPackStreamsVector.IsEmpty() && 
-      Files.IsEmpty());
+      NumUnPackStreamsVector.IsEmpty());
   }
   bool IsSolid() const
   {
@@ -179,6 +284,20 @@ struct CArchiveDatabase
   }
 };
 
+struct CArchiveDatabase: public CArchiveDatabaseBase
+{
+  CObjectVector<CFileItem> Files;
+  void Clear()
+  {
+    CArchiveDatabaseBase::Clear();
+    Files.Clear();
+  }
+  bool IsEmpty() const
+  {
+    return (CArchiveDatabaseBase::IsEmpty() && Files.IsEmpty());
+  }
+};
+
 }}
 
 #endif
@@ -103,9 +103,12 @@ static int CompareFolders(const CFolder &f1, const CFolder &f2)
   return 0;
 }
 
-static int CompareFiles(const CFileItem &f1, const CFileItem &f2)
+static int CompareFiles(const CFileTable &files, CNum i1, CNum i2)
 {
-  return MyStringCompareNoCase(f1.Name, f2.Name);
+  UString name1, name2;
+  files.GetName(i1, name1);
+  files.GetName(i2, name2);
+  return MyStringCompareNoCase(name1, name2);
 }
 
 static int CompareFolderRefs(const int *p1, const int *p2, void *param)
@@ -121,9 +124,9 @@ static int CompareFolderRefs(const int *p1, const int *p2, void *param)
       db.NumUnPackStreamsVector[i2]));
   if (db.NumUnPackStreamsVector[i1] == 0)
     return 0;
-  return CompareFiles(
-      db.Files[db.FolderStartFileIndex[i1]],
-      db.Files[db.FolderStartFileIndex[i2]]);
+  return CompareFiles(db.Files,
+      db.FolderStartFileIndex[i1],
+      db.FolderStartFileIndex[i2]);
 }
 
 ////////////////////////////////////////////////////////////
@@ -513,7 +516,7 @@ static HRESULT Update2(
       for (CNum fileIndex = database->FolderStartFileIndex[i];
       indexInFolder < numUnPackStreams; fileIndex++)
       {
-        if (database->Files[fileIndex].HasStream)
+        if (database->Files.HasStream(fileIndex))
         {
           indexInFolder++;
           int updateIndex = fileIndexToUpdateIndexMap[fileIndex];
@@ -595,9 +598,10 @@ static HRESULT Update2(
     for (CNum fi = database->FolderStartFileIndex[folderIndex];
         indexInFolder < numUnPackStreams; fi++)
     {
-      CFileItem file = database->Files[fi];
-      if (file.HasStream)
+      if (database->Files.HasStream(fi))
       {
+        CFileItem file;
+        database->Files.GetItem(fi, file);
         indexInFolder++;
         int updateIndex = fileIndexToUpdateIndexMap[fi];
         if (updateIndex >= 0)
@@ -720,7 +724,7 @@ static HRESULT Update2(
         if (updateItem.NewProperties)
           FromUpdateItemToFileItem(updateItem, file);
         else
-          file = database->Files[updateItem.IndexInArchive];
+          database->Files.GetItem(updateItem.IndexInArchive, file);
         if (file.IsAnti || file.IsDirectory)
           return E_FAIL;
         
@@ -771,7 +775,7 @@ static HRESULT Update2(
       }
       else
         if (updateItem.IndexInArchive != -1)
-          if (database->Files[updateItem.IndexInArchive].HasStream)
+          if (database->Files.HasStream(updateItem.IndexInArchive))
             continue;
       emptyRefs.Add(i);
     }
@@ -783,7 +787,7 @@ static HRESULT Update2(
       if (updateItem.NewProperties)
         FromUpdateItemToFileItem(updateItem, file);
       else
-        file = database->Files[updateItem.IndexInArchive];
+        database->Files.GetItem(updateItem.IndexInArchive, file);
       newDatabase.Files.Add(file);
     }
   }
@@ -869,7 +873,7 @@ HRESULT UpdateVolume(
   if (updateItem.NewProperties)
     FromUpdateItemToFileItem(updateItem, file);
   else
-    file = database->Files[updateItem.IndexInArchive];
+    database->Files.GetItem(updateItem.IndexInArchive, file);
   if (file.IsAnti || file.IsDirectory)
     return E_FAIL;
 
@@ -19,6 +19,7 @@ namespace NArchive {
 static const wchar_t *kCopyMethod = L"Copy";
 static const wchar_t *kLZMAMethodName = L"LZMA";
 static const wchar_t *kLZMA2MethodName = L"LZMA2";
+static const wchar_t *kLZMABlockMethodName = L"LZMABlock";
 static const wchar_t *kBZip2MethodName = L"BZip2";
 static const wchar_t *kPpmdMethodName = L"PPMd";
 static const wchar_t *kDeflateMethodName = L"Deflate";
@@ -82,7 +83,8 @@ static inline bool IsLZMAMethod(const UString &methodName)
 { 
   return 
     AreEqual(methodName, kLZMAMethodName) || 
-    AreEqual(methodName, kLZMA2MethodName); 
+    AreEqual(methodName, kLZMA2MethodName) || 
+    AreEqual(methodName, kLZMABlockMethodName); 
 }
 
 static inline bool IsBZip2Method(const UString &methodName)
@@ -314,12 +316,15 @@ HRESULT COutHandler::SetParam(COneMethodInfo &oneMethodInfo, const UString &name
   CProp property;
   if (
     name.CompareNoCase(L"D") == 0 || 
-    name.CompareNoCase(L"MEM") == 0)
+    name.CompareNoCase(L"MEM") == 0 ||
+    name.CompareNoCase(L"C") == 0)
   {
     UInt32 dicSize;
     RINOK(ParsePropDictionaryValue(value, dicSize));
     if (name.CompareNoCase(L"D") == 0)
       property.Id = NCoderPropID::kDictionarySize;
+    else if (name.CompareNoCase(L"C") == 0)
+      property.Id = NCoderPropID::kBlockSize;
     else
       property.Id = NCoderPropID::kUsedMemorySize;
     property.Value = dicSize;
@@ -597,6 +602,14 @@ HRESULT COutHandler::SetProperty(const wchar_t *nameSpec, const PROPVARIANT &val
       if (number <= mainDicMethodIndex)
         mainDicSize = dicSize;
     }
+    else if (realName.Left(1).CompareNoCase(L"C") == 0)
+    {
+      UInt32 blockSize;
+      RINOK(ParsePropDictionaryValue(realName.Mid(1), value, blockSize));
+      property.Id = NCoderPropID::kBlockSize;
+      property.Value = blockSize;
+      oneMethodInfo.Properties.Add(property);
+    }
     else
     {
       int index = FindPropIdFromStringName(realName);
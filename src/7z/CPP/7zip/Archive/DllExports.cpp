@@ -6,6 +6,12 @@
 #include "../../Common/ComTry.h"
 #include "../../Common/Types.h"
 #include "../../Windows/PropVariant.h"
+#ifdef _7ZIP_LARGE_PAGES
+extern "C" 
+{ 
+#include "../../../C/Alloc.h"
+}
+#endif
 
 #include "IArchive.h"
 #include "../ICoder.h"
@@ -49,7 +55,7 @@ STDAPI CreateObject(const GUID *clsid, const GUID *iid, void **outObject)
 
 STDAPI SetLargePageMode()
 {
-  #if defined(_WIN32) && defined(_7ZIP_LARGE_PAGES)
+  #ifdef _7ZIP_LARGE_PAGES_SUPPORTED
   SetLargePageSize();
   #endif
   return S_OK;
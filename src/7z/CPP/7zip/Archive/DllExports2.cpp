@@ -6,7 +6,7 @@
 #include "../../Common/ComTry.h"
 #include "../../Common/Types.h"
 #include "../../Windows/PropVariant.h"
-#if defined(_WIN32) && defined(_7ZIP_LARGE_PAGES)
+#ifdef _7ZIP_LARGE_PAGES
 extern "C" 
 { 
 #include "../../../C/Alloc.h"
@@ -75,7 +75,7 @@ STDAPI CreateObject(const GUID *clsid, const GUID *iid, void **outObject)
 
 STDAPI SetLargePageMode()
 {
-  #if defined(_WIN32) && defined(_7ZIP_LARGE_PAGES)
+  #ifdef _7ZIP_LARGE_PAGES_SUPPORTED
   SetLargePageSize();
   #endif
   return S_OK;
@@ -13,8 +13,14 @@
 #include "../../ICoder.h"
 #include "../../Common/ProgressUtils.h"
 #include "../../Common/CreateCoder.h"
+#include "../../Common/StreamUtils.h"
 #include "../Common/OutStreamWithCRC.h"
 
+#ifdef COMPRESS_MT
+#include "Windows/Thread.h"
+#include "../../Common/StreamObjects.h"
+#endif
+
 using namespace NWindows;
 
 namespace NArchive {
@@ -147,9 +153,12 @@ STDMETHODIMP CHandler::GetProperty(UInt32 /* index */, PROPID propID,  PROPVARIA
 
 STDMETHODIMP CHandler::Open(IInStream *inStream, 
     const UInt64 * /* maxCheckStartPosition */,
-    IArchiveOpenCallback * /* openArchiveCallback */)
+    IArchiveOpenCallback *openArchiveCallback)
 {
   COM_TRY_BEGIN
+  m_Index.Clear();
+  m_IndexWasChanged = false;
+  m_IndexIsStale = false;
   try
   {
     CInArchive archive;
@@ -167,16 +176,262 @@ STDMETHODIMP CHandler::Open(IInStream *inStream,
   {
     return S_FALSE;
   }
+  ReadIndex(openArchiveCallback);
   return S_OK;
   COM_TRY_END
 }
 
+void CHandler::ReadIndex(IArchiveOpenCallback *openArchiveCallback)
+{
+  if (openArchiveCallback == NULL)
+    return;
+  CMyComPtr<IArchiveOpenVolumeCallback> openVolumeCallback;
+  {
+    CMyComPtr<IArchiveOpenCallback> openArchiveCallbackWrap = openArchiveCallback;
+    openArchiveCallbackWrap.QueryInterface(IID_IArchiveOpenVolumeCallback, &openVolumeCallback);
+  }
+  if (!openVolumeCallback)
+    return;
+  UString indexName;
+  {
+    NCOM::CPropVariant prop;
+    if (openVolumeCallback->GetProperty(kpidName, &prop) != S_OK || prop.vt != VT_BSTR)
+      return;
+    indexName = prop.bstrVal;
+  }
+  indexName += kIndexExtension;
+  CMyComPtr<IInStream> indexStream;
+  if (openVolumeCallback->GetStream(indexName, &indexStream) != S_OK || !indexStream)
+    return;
+  bool isIndex;
+  if (m_Index.Read(indexStream, isIndex) != S_OK ||
+      m_Index.ArcPackSize != m_PackSize ||
+      m_Index.FileCRC != m_Item.FileCRC ||
+      (UInt32)m_Index.UnpackSize != m_Item.UnPackSize32)
+  {
+    m_Index.Clear();
+    m_IndexIsStale = isIndex;
+  }
+}
+
 STDMETHODIMP CHandler::Close()
 {
+  m_Index.Clear();
+  m_IndexWasChanged = false;
+  m_IndexIsStale = false;
   m_Stream.Release();
   return S_OK;
 }
 
+STDMETHODIMP CHandler::GetStream(UInt32 index, ISequentialInStream **stream)
+{
+  COM_TRY_BEGIN
+  *stream = 0;
+  if (index != 0 || m_Index.IsEmpty())
+    return S_FALSE;
+  CIndexInStream *streamSpec = new CIndexInStream;
+  CMyComPtr<ISequentialInStream> streamTemp = streamSpec;
+  streamSpec->Init(m_Stream, m_StreamStartPosition + m_DataOffset, &m_Index);
+  streamSpec->IndexOwner = (IInArchive *)this;
+  *stream = streamTemp.Detach();
+  return S_OK;
+  COM_TRY_END
+}
+
+STDMETHODIMP CHandler::IndexWasChanged(Int32 *changed)
+{
+  *changed = NIndexChange::kNone;
+  if (m_IndexWasChanged)
+    *changed = m_IndexIsStale ? NIndexChange::kReplace : NIndexChange::kNew;
+  return S_OK;
+}
+
+STDMETHODIMP CHandler::WriteIndex(ISequentialOutStream *outStream)
+{
+  COM_TRY_BEGIN
+  if (m_Index.IsEmpty())
+    return S_FALSE;
+  RINOK(m_Index.Write(outStream));
+  m_IndexWasChanged = false;
+  m_IndexIsStale = false;
+  return S_OK;
+  COM_TRY_END
+}
+
+#ifdef COMPRESS_MT
+
+// packed data after range end that can be read ahead by bit decoder
+static const UInt32 kRangeInPadSize = 16;
+
+// Each started range keeps its packed and unpacked data in memory.
+// Bigger ranges are not decoded in parallel, and the number of started 
+// ranges is reduced, if their buffers can be larger than kRangesMemMax.
+static const UInt64 kRangeSizeMax = (UInt64)1 << 26;
+static const UInt64 kRangesMemMax = (UInt64)1 << 28;
+
+struct CRangeDecoder
+{
+  NWindows::CThread Thread;
+  NCompress::NDeflate::NDecoder::CCOMCoder *DecoderSpec;
+  CMyComPtr<ICompressCoder> Decoder;
+  const CIndexPoint *Point;
+  CByteBuffer InBuffer;
+  size_t InSize;
+  CByteBuffer OutBuffer;
+  size_t OutSize;
+  UInt64 InEnd;
+  UInt64 OutEnd;
+  HRESULT Result;
+
+  CRangeDecoder()
+  {
+    DecoderSpec = new NCompress::NDeflate::NDecoder::CCOMCoder;
+    Decoder = DecoderSpec;
+  }
+  void Decode();
+  void WaitFinish()
+  {
+    if (Thread.IsCreated())
+    {
+      Thread.Wait();
+      Thread.Close();
+    }
+  }
+};
+
+void CRangeDecoder::Decode()
+{
+  try
+  {
+    CSequentialInStreamImp *inStreamSpec = new CSequentialInStreamImp;
+    CMyComPtr<ISequentialInStream> inStream = inStreamSpec;
+    inStreamSpec->Init(InBuffer, InSize);
+    CSequentialOutStreamImp2 *outStreamSpec = new CSequentialOutStreamImp2;
+    CMyComPtr<ISequentialOutStream> outStream = outStreamSpec;
+    outStreamSpec->Init(OutBuffer, OutSize);
+    DecoderSpec->SetStartPoint(Point);
+    const UInt64 outSize = OutSize;
+    Result = Decoder->Code(inStream, outStream, NULL, &outSize, NULL);
+    if (Result == S_OK && outStreamSpec->GetPos() != OutSize)
+      Result = S_FALSE;
+  }
+  catch(...) { Result = E_OUTOFMEMORY; }
+}
+
+static THREAD_FUNC_DECL RangeDecoderThread(void *rangeDecoder)
+{
+  ((CRangeDecoder *)rangeDecoder)->Decode();
+  return 0;
+}
+
+class CRangeDecoders
+{
+public:
+  CRangeDecoder *Items;
+  int Num;
+  CRangeDecoders(int num): Items(new CRangeDecoder[num]), Num(num) {}
+  ~CRangeDecoders()
+  {
+    for (int i = 0; i < Num; i++)
+      Items[i].WaitFinish();
+    delete []Items;
+  }
+};
+
+// It returns false, if positions in index are not correct.
+
+bool CHandler::GetRange(int rangeIndex, 
+    UInt64 &inStart, UInt64 &inEnd, UInt64 &outStart, UInt64 &outEnd) const
+{
+  const CIndexPoint *point = (rangeIndex == 0) ? NULL : &m_Index.Points[rangeIndex - 1];
+  inStart = (point != NULL) ? (point->InBitPos >> 3) : 0;
+  outStart = (point != NULL) ? point->OutPos : 0;
+  inEnd = m_PackSize;
+  outEnd = m_Index.UnpackSize;
+  if (rangeIndex < m_Index.Points.Size())
+  {
+    const CIndexPoint &next = m_Index.Points[rangeIndex];
+    inEnd = (next.InBitPos >> 3) + kRangeInPadSize;
+    if (inEnd > m_PackSize)
+      inEnd = m_PackSize;
+    outEnd = next.OutPos;
+  }
+  return (inStart <= inEnd && outStart <= outEnd);
+}
+
+// It returns the number of ranges that can be decoded at same time 
+// or 0, if some range is too big for memory buffers.
+
+int CHandler::GetNumParallelRanges() const
+{
+  UInt64 rangeSizeMax = 1;
+  for (int i = 0; i <= m_Index.Points.Size(); i++)
+  {
+    UInt64 inStart, inEnd, outStart, outEnd;
+    if (!GetRange(i, inStart, inEnd, outStart, outEnd))
+      return 0;
+    UInt64 size = (inEnd - inStart) + (outEnd - outStart);
+    if (inEnd - inStart > kRangeSizeMax || outEnd - outStart > kRangeSizeMax)
+      return 0;
+    if (rangeSizeMax < size)
+      rangeSizeMax = size;
+  }
+  UInt64 num = kRangesMemMax / rangeSizeMax;
+  if (num > m_NumDecodeThreads)
+    num = m_NumDecodeThreads;
+  if (num > (UInt64)m_Index.Points.Size() + 1)
+    num = m_Index.Points.Size() + 1;
+  return (int)num;
+}
+
+HRESULT CHandler::StartRange(CRangeDecoder &d, int rangeIndex)
+{
+  UInt64 inStart, outStart;
+  if (!GetRange(rangeIndex, inStart, d.InEnd, outStart, d.OutEnd))
+    return S_FALSE;
+  d.Point = (rangeIndex == 0) ? NULL : &m_Index.Points[rangeIndex - 1];
+  d.InSize = (size_t)(d.InEnd - inStart);
+  d.OutSize = (size_t)(d.OutEnd - outStart);
+  if (d.InBuffer.GetCapacity() < d.InSize)
+    d.InBuffer.SetCapacity(d.InSize);
+  if (d.OutBuffer.GetCapacity() < d.OutSize)
+    d.OutBuffer.SetCapacity(d.OutSize);
+  RINOK(m_Stream->Seek(m_StreamStartPosition + m_DataOffset + inStart, STREAM_SEEK_SET, NULL));
+  UInt32 processedSize;
+  RINOK(ReadStream(m_Stream, d.InBuffer, (UInt32)d.InSize, &processedSize));
+  if (processedSize != d.InSize)
+    return S_FALSE;
+  return d.Thread.Create(RangeDecoderThread, &d);
+}
+
+// Ranges between index points are unpacked in parallel threads
+// and are written to (outStream) in original order. Each range is 
+// written as soon as it's unpacked, and then its thread starts next range.
+// It returns S_FALSE for data error.
+
+HRESULT CHandler::ExtractRanges(ISequentialOutStream *outStream, 
+    ICompressProgressInfo *progress, int numThreads)
+{
+  const int numRanges = m_Index.Points.Size() + 1;
+  CRangeDecoders decoders(numThreads);
+  int nextRange = 0;
+  for (int range = 0; range < numRanges; range++)
+  {
+    for (; nextRange < numRanges && nextRange < range + numThreads; nextRange++)
+    {
+      RINOK(StartRange(decoders.Items[nextRange % numThreads], nextRange));
+    }
+    CRangeDecoder &d = decoders.Items[range % numThreads];
+    d.WaitFinish();
+    RINOK(d.Result);
+    RINOK(WriteStream(outStream, d.OutBuffer, (UInt32)d.OutSize, NULL));
+    RINOK(progress->SetRatioInfo(&d.InEnd, &d.OutEnd));
+  }
+  return S_OK;
+}
+
+#endif
+
 STDMETHODIMP CHandler::Extract(const UInt32* indices, UInt32 numItems,
     Int32 _aTestMode, IArchiveExtractCallback *extractCallback)
 {
@@ -221,10 +476,35 @@ STDMETHODIMP CHandler::Extract(const UInt32* indices, UInt32 numItems,
   CMyComPtr<ICompressProgressInfo> progress = lps;
   lps->Init(extractCallback, true);
 
+  Int32 opRes;
+
+  #ifdef COMPRESS_MT
+  int numRangeThreads = 0;
+  if (!m_Index.IsEmpty() && m_NumDecodeThreads > 1)
+    numRangeThreads = GetNumParallelRanges();
+  if (numRangeThreads > 1)
+  {
+    HRESULT result = ExtractRanges(outStream, progress, numRangeThreads);
+    if (result == S_FALSE || (result == S_OK && outStreamSpec->GetSize() != m_Index.UnpackSize))
+      opRes = NArchive::NExtract::NOperationResult::kDataError;
+    else if (result != S_OK)
+      return result;
+    else if (outStreamSpec->GetCRC() != m_Item.FileCRC)
+      opRes = NArchive::NExtract::NOperationResult::kCRCError;
+    else
+      opRes = NArchive::NExtract::NOperationResult::kOK;
+    outStream.Release();
+    return extractCallback->SetOperationResult(opRes);
+  }
+  #endif
+
   CMyComPtr<ICompressCoder> deflateDecoder;
+  NCompress::NDeflate::NDecoder::CCOMCoder *deflateDecoderSpec = NULL;
+  CObjectVector<CIndexPoint> indexPoints;
+  const bool buildIndex = (m_IndexSpan != 0 && m_Index.IsEmpty());
+  int numMembers = 0;
   bool firstItem = true;
   RINOK(m_Stream->Seek(m_StreamStartPosition, STREAM_SEEK_SET, NULL));
-  Int32 opRes;
   for (;;)
   {
     lps->InSize = currentTotalPacked;
@@ -255,15 +535,30 @@ STDMETHODIMP CHandler::Extract(const UInt32* indices, UInt32 numItems,
 
     if (!deflateDecoder)
     {
-      RINOK(CreateCoder(
-          EXTERNAL_CODECS_VARS
-          kMethodId_Deflate, deflateDecoder, false));
+      if (buildIndex)
+      {
+        deflateDecoderSpec = new NCompress::NDeflate::NDecoder::CCOMCoder;
+        deflateDecoder = deflateDecoderSpec;
+        deflateDecoderSpec->SetCheckpoints(&indexPoints, m_IndexSpan);
+      }
+      else
+      {
+        RINOK(CreateCoder(
+            EXTERNAL_CODECS_VARS
+            kMethodId_Deflate, deflateDecoder, false));
+      }
       if (!deflateDecoder)
       {
         opRes = NArchive::NExtract::NOperationResult::kUnSupportedMethod;
         break;
       }
     }
+    else if (deflateDecoderSpec != NULL)
+    {
+      // index is built only for single-member archives
+      deflateDecoderSpec->SetCheckpoints(NULL, 0);
+    }
+    numMembers++;
     result = deflateDecoder->Code(m_Stream, outStream, NULL, NULL, progress);
     if (result != S_OK)
     {
@@ -292,6 +587,15 @@ STDMETHODIMP CHandler::Extract(const UInt32* indices, UInt32 numItems,
       break;
     }
   }
+  if (buildIndex && numMembers == 1 && !indexPoints.IsEmpty() && 
+      opRes == NArchive::NExtract::NOperationResult::kOK)
+  {
+    m_Index.ArcPackSize = m_PackSize;
+    m_Index.FileCRC = m_Item.FileCRC;
+    m_Index.UnpackSize = outStreamSpec->GetSize();
+    m_Index.Points = indexPoints;
+    m_IndexWasChanged = true;
+  }
   outStream.Release();
   return extractCallback->SetOperationResult(opRes);
   COM_TRY_END
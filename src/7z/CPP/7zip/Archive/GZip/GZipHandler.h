@@ -10,15 +10,26 @@
 #include "../../Common/CreateCoder.h"
 
 #include "GZipIn.h"
+#include "GZipIndex.h"
 #include "GZipUpdate.h"
 
+#ifdef COMPRESS_MT
+#include "../../../Windows/System.h"
+#endif
+
 namespace NArchive {
 namespace NGZip {
 
+#ifdef COMPRESS_MT
+struct CRangeDecoder;
+#endif
+
 class CHandler: 
   public IInArchive,
   public IOutArchive,
   public ISetProperties,
+  public IInArchiveGetStream,
+  public IInArchiveIndex,
   PUBLIC_ISetCompressCodecsInfo
   public CMyUnknownImp
 {
@@ -26,6 +37,8 @@ public:
   MY_QUERYINTERFACE_BEGIN2(IInArchive)
   MY_QUERYINTERFACE_ENTRY(IOutArchive)
   MY_QUERYINTERFACE_ENTRY(ISetProperties)
+  MY_QUERYINTERFACE_ENTRY(IInArchiveGetStream)
+  MY_QUERYINTERFACE_ENTRY(IInArchiveIndex)
   QUERY_ENTRY_ISetCompressCodecsInfo
   MY_QUERYINTERFACE_END
   MY_ADDREF_RELEASE
@@ -35,9 +48,14 @@ public:
 
   STDMETHOD(SetProperties)(const wchar_t **names, const PROPVARIANT *values, Int32 numProperties);
 
+  STDMETHOD(GetStream)(UInt32 index, ISequentialInStream **stream);
+
+  STDMETHOD(IndexWasChanged)(Int32 *changed);
+  STDMETHOD(WriteIndex)(ISequentialOutStream *outStream);
+
   DECL_ISetCompressCodecsInfo
 
-  CHandler() { InitMethodProperties(); }
+  CHandler(): m_IndexWasChanged(false), m_IndexIsStale(false) { InitMethodProperties(); }
 
 private:
   NArchive::NGZip::CItem m_Item;
@@ -48,13 +66,38 @@ private:
   CCompressionMethodMode m_Method;
   UInt32 m_Level;
 
+  CIndex m_Index;
+  bool m_IndexWasChanged;
+  bool m_IndexIsStale; // index file exists, but it's for old version of archive
+  UInt32 m_IndexSpan; // index is built during Extract, if (m_IndexSpan != 0)
+  #ifdef COMPRESS_MT
+  UInt32 m_NumDecodeThreads; // for ranges of index in Extract ("mt" property)
+  #endif
+
   DECL_EXTERNAL_CODECS_VARS
 
+  void ReadIndex(IArchiveOpenCallback *openArchiveCallback);
+
+  #ifdef COMPRESS_MT
+  bool GetRange(int rangeIndex, 
+      UInt64 &inStart, UInt64 &inEnd, UInt64 &outStart, UInt64 &outEnd) const;
+  int GetNumParallelRanges() const;
+  HRESULT StartRange(CRangeDecoder &d, int rangeIndex);
+  HRESULT ExtractRanges(ISequentialOutStream *outStream, 
+      ICompressProgressInfo *progress, int numThreads);
+  #endif
+
   void InitMethodProperties()
   {
     m_Method.NumMatchFinderCyclesDefined = false;
     m_Level = m_Method.NumPasses = m_Method.NumFastBytes = 
         m_Method.NumMatchFinderCycles = m_Method.Algo = 0xFFFFFFFF;
+    m_IndexSpan = 0;
+    #ifdef COMPRESS_MT
+    // compression is single-threaded unless "mt" is set
+    m_Method.NumThreads = 1;
+    m_NumDecodeThreads = NWindows::NSystem::GetNumberOfProcessors();
+    #endif
   }
 };
 
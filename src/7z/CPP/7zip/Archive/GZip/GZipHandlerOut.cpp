@@ -32,6 +32,8 @@ static const UInt32 kNumFastBytesX1 = 32;
 static const UInt32 kNumFastBytesX7 = 64;
 static const UInt32 kNumFastBytesX9 = 128;
 
+static const UInt32 kIndexSpanDefault = 1 << 24;
+
 
 STDMETHODIMP CHandler::GetFileTimeType(UInt32 *timeType)
 {
@@ -170,6 +172,9 @@ STDMETHODIMP CHandler::UpdateItems(ISequentialOutStream *outStream, UInt32 numIt
 STDMETHODIMP CHandler::SetProperties(const wchar_t **names, const PROPVARIANT *values, Int32 numProperties)
 {
   InitMethodProperties();
+  #ifdef COMPRESS_MT
+  const UInt32 numProcessors = NSystem::GetNumberOfProcessors();
+  #endif
   for (int i = 0; i < numProperties; i++)
   {
     UString name = names[i];
@@ -200,6 +205,22 @@ STDMETHODIMP CHandler::SetProperties(const wchar_t **names, const PROPVARIANT *v
       m_Method.NumMatchFinderCycles = num;
       m_Method.NumMatchFinderCyclesDefined = true;
     }
+    else if (name.Left(2) == L"MT")
+    {
+      #ifdef COMPRESS_MT
+      RINOK(ParseMtProp(name.Mid(2), prop, numProcessors, m_Method.NumThreads));
+      // it also limits decoding of index ranges in Extract
+      m_NumDecodeThreads = m_Method.NumThreads;
+      #endif
+    }
+    else if (name.Left(2) == L"IX")
+    {
+      m_IndexSpan = kIndexSpanDefault;
+      if (name.Length() > 2 || prop.vt != VT_EMPTY)
+      {
+        RINOK(ParsePropDictionaryValue(name.Mid(2), prop, m_IndexSpan));
+      }
+    }
     else if (name.Left(1) == L"A")
     {
       UInt32 num = kAlgoX5;
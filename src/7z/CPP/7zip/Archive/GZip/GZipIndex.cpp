@@ -0,0 +1,245 @@
+// Archive/GZipIndex.cpp
+
+#include "StdAfx.h"
+
+#include "GZipIndex.h"
+
+#include "../../Common/StreamUtils.h"
+
+extern "C" 
+{ 
+  #include "../../../../C/7zCrc.h" 
+}
+
+namespace NArchive {
+namespace NGZip {
+
+static const Byte kSignature[8] = { 'G', 'Z', 'I', 'D', 'X', 0x1A, 0, 1 };
+static const UInt32 kHeaderSize = 8 + 8 + 4 + 8 + 4;
+static const UInt32 kPointHeaderSize = 8 + 8 + 4;
+static const UInt32 kWindowSizeMax = 1 << 16;
+
+static void SetUInt32(Byte *p, UInt32 v)
+{
+  for (int i = 0; i < 4; i++)
+    p[i] = (Byte)(v >> (8 * i));
+}
+
+static void SetUInt64(Byte *p, UInt64 v)
+{
+  for (int i = 0; i < 8; i++)
+    p[i] = (Byte)(v >> (8 * i));
+}
+
+static UInt32 GetUInt32(const Byte *p)
+{
+  UInt32 v = 0;
+  for (int i = 0; i < 4; i++)
+    v |= ((UInt32)p[i] << (8 * i));
+  return v;
+}
+
+static UInt64 GetUInt64(const Byte *p)
+{
+  return GetUInt32(p) | ((UInt64)GetUInt32(p + 4) << 32);
+}
+
+int CIndex::FindPoint(UInt64 pos) const
+{
+  int left = 0, right = Points.Size();
+  while (left != right)
+  {
+    int mid = (left + right) / 2;
+    if (Points[mid].OutPos <= pos)
+      left = mid + 1;
+    else
+      right = mid;
+  }
+  return left - 1;
+}
+
+static HRESULT ReadBytes(ISequentialInStream *stream, void *data, UInt32 size, UInt32 &crc)
+{
+  UInt32 processedSize;
+  RINOK(ReadStream(stream, data, size, &processedSize));
+  if (processedSize != size)
+    return S_FALSE;
+  crc = CrcUpdate(crc, data, size);
+  return S_OK;
+}
+
+static HRESULT WriteBytes(ISequentialOutStream *stream, const void *data, UInt32 size, UInt32 &crc)
+{
+  crc = CrcUpdate(crc, data, size);
+  return WriteStream(stream, data, size, NULL);
+}
+
+HRESULT CIndex::Read(ISequentialInStream *stream, bool &isIndex)
+{
+  Clear();
+  isIndex = false;
+  UInt32 crc = CRC_INIT_VAL;
+  Byte buf[kHeaderSize];
+  RINOK(ReadBytes(stream, buf, kHeaderSize, crc));
+  for (UInt32 i = 0; i < sizeof(kSignature); i++)
+    if (buf[i] != kSignature[i])
+      return S_FALSE;
+  isIndex = true;
+  ArcPackSize = GetUInt64(buf + 8);
+  FileCRC = GetUInt32(buf + 16);
+  UInt64 unpackSize = GetUInt64(buf + 20);
+  UInt32 numPoints = GetUInt32(buf + 28);
+  for (UInt32 i = 0; i < numPoints; i++)
+  {
+    RINOK(ReadBytes(stream, buf, kPointHeaderSize, crc));
+    CIndexPoint point;
+    point.InBitPos = GetUInt64(buf);
+    point.OutPos = GetUInt64(buf + 8);
+    UInt32 windowSize = GetUInt32(buf + 16);
+    if (windowSize > kWindowSizeMax || point.OutPos > unpackSize ||
+        (!Points.IsEmpty() && point.OutPos <= Points.Back().OutPos))
+      return S_FALSE;
+    point.Window.SetCapacity(windowSize);
+    RINOK(ReadBytes(stream, point.Window, windowSize, crc));
+    Points.Add(point);
+  }
+  UInt32 crc2 = CRC_GET_DIGEST(crc);
+  RINOK(ReadBytes(stream, buf, 4, crc));
+  if (GetUInt32(buf) != crc2)
+  {
+    Clear();
+    return S_FALSE;
+  }
+  UnpackSize = unpackSize;
+  return S_OK;
+}
+
+HRESULT CIndex::Write(ISequentialOutStream *stream) const
+{
+  UInt32 crc = CRC_INIT_VAL;
+  Byte buf[kHeaderSize];
+  memcpy(buf, kSignature, sizeof(kSignature));
+  SetUInt64(buf + 8, ArcPackSize);
+  SetUInt32(buf + 16, FileCRC);
+  SetUInt64(buf + 20, UnpackSize);
+  SetUInt32(buf + 28, Points.Size());
+  RINOK(WriteBytes(stream, buf, kHeaderSize, crc));
+  for (int i = 0; i < Points.Size(); i++)
+  {
+    const CIndexPoint &point = Points[i];
+    UInt32 windowSize = (UInt32)point.Window.GetCapacity();
+    SetUInt64(buf, point.InBitPos);
+    SetUInt64(buf + 8, point.OutPos);
+    SetUInt32(buf + 16, windowSize);
+    RINOK(WriteBytes(stream, buf, kPointHeaderSize, crc));
+    RINOK(WriteBytes(stream, point.Window, windowSize, crc));
+  }
+  SetUInt32(buf, CRC_GET_DIGEST(crc));
+  return WriteStream(stream, buf, 4, NULL);
+}
+
+static const UInt32 kSkipBufferSize = 1 << 16;
+
+void CIndexInStream::Init(IInStream *stream, UInt64 dataOffset, const CIndex *index)
+{
+  _stream = stream;
+  _dataOffset = dataOffset;
+  _index = index;
+  _decoderSpec = new NCompress::NDeflate::NDecoder::CCOMCoder;
+  _decoder = _decoderSpec;
+  _decoderIsStarted = false;
+  _virtPos = 0;
+}
+
+HRESULT CIndexInStream::RestartDecoder()
+{
+  _decoderIsStarted = false;
+  int pointIndex = _index->FindPoint(_virtPos);
+  const CIndexPoint *point = (pointIndex >= 0) ? &_index->Points[pointIndex] : NULL;
+  UInt64 inPos = (point != NULL) ? (point->InBitPos >> 3) : 0;
+  RINOK(_stream->Seek(_dataOffset + inPos, STREAM_SEEK_SET, NULL));
+  _decoderSpec->SetStartPoint(point);
+  RINOK(_decoderSpec->SetInStream(_stream));
+  RINOK(_decoderSpec->SetOutStreamSize(NULL));
+  _decodePos = (point != NULL) ? point->OutPos : 0;
+  _decoderIsStarted = true;
+  return S_OK;
+}
+
+HRESULT CIndexInStream::ReadDecoder(void *data, UInt32 size, UInt32 &processedSize)
+{
+  HRESULT res = ReadStream(_decoder, data, size, &processedSize);
+  _decodePos += processedSize;
+  if (res != S_OK)
+  {
+    _decoderIsStarted = false;
+    return (res == S_FALSE) ? E_FAIL : res;
+  }
+  return S_OK;
+}
+
+STDMETHODIMP CIndexInStream::Read(void *data, UInt32 size, UInt32 *processedSize)
+{
+  if (processedSize != NULL)
+    *processedSize = 0;
+  if (_virtPos >= _index->UnpackSize)
+    return S_OK;
+  {
+    UInt64 rem = _index->UnpackSize - _virtPos;
+    if (size > rem)
+      size = (UInt32)rem;
+  }
+  if (size == 0)
+    return S_OK;
+
+  bool restart = (!_decoderIsStarted || _virtPos < _decodePos);
+  if (!restart)
+  {
+    // it's faster to restart from point than to skip data before that point
+    int pointIndex = _index->FindPoint(_virtPos);
+    restart = (pointIndex >= 0 && _index->Points[pointIndex].OutPos > _decodePos);
+  }
+  if (restart)
+  {
+    RINOK(RestartDecoder());
+  }
+  if (_decodePos != _virtPos)
+  {
+    CByteBuffer skipBuffer;
+    skipBuffer.SetCapacity(kSkipBufferSize);
+    while (_decodePos != _virtPos)
+    {
+      UInt64 rem = _virtPos - _decodePos;
+      UInt32 curSize = (rem < kSkipBufferSize) ? (UInt32)rem : kSkipBufferSize;
+      UInt32 processedSizeLoc;
+      RINOK(ReadDecoder(skipBuffer, curSize, processedSizeLoc));
+      if (processedSizeLoc != curSize)
+        return E_FAIL;
+    }
+  }
+  UInt32 processedSizeLoc;
+  RINOK(ReadDecoder(data, size, processedSizeLoc));
+  _virtPos += processedSizeLoc;
+  if (processedSize != NULL)
+    *processedSize = processedSizeLoc;
+  return S_OK;
+}
+
+STDMETHODIMP CIndexInStream::Seek(Int64 offset, UInt32 seekOrigin, UInt64 *newPosition)
+{
+  switch(seekOrigin)
+  {
+    case STREAM_SEEK_SET: break;
+    case STREAM_SEEK_CUR: offset += _virtPos; break;
+    case STREAM_SEEK_END: offset += _index->UnpackSize; break;
+    default: return STG_E_INVALIDFUNCTION;
+  }
+  if (offset < 0)
+    return STG_E_INVALIDFUNCTION;
+  _virtPos = offset;
+  if (newPosition != NULL)
+    *newPosition = offset;
+  return S_OK;
+}
+
+}}
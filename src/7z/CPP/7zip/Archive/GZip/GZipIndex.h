@@ -0,0 +1,74 @@
+// Archive/GZipIndex.h
+
+#ifndef __ARCHIVE_GZIP_INDEX_H
+#define __ARCHIVE_GZIP_INDEX_H
+
+#include "Common/MyCom.h"
+#include "Common/MyVector.h"
+
+#include "../../IStream.h"
+#include "../../Compress/Deflate/DeflateDecoder.h"
+
+namespace NArchive {
+namespace NGZip {
+
+// Side index file is stored next to archive: "name.gz" + kIndexExtension
+
+typedef NCompress::NDeflate::NDecoder::CCheckpoint CIndexPoint;
+
+// Access points of single-member gzip archive.
+// Decoding can be started from any point, so ranges
+// between points can be unpacked independently.
+class CIndex
+{
+public:
+  UInt64 ArcPackSize;  // these fields are used to check that index
+  UInt32 FileCRC;      // corresponds to archive
+  UInt64 UnpackSize;
+  CObjectVector<CIndexPoint> Points;
+
+  CIndex(): UnpackSize(0) {}
+  void Clear() { Points.Clear(); UnpackSize = 0; }
+  bool IsEmpty() const { return Points.IsEmpty(); }
+
+  // returns index of last point with (OutPos <= pos) or -1
+  int FindPoint(UInt64 pos) const;
+
+  // returns S_FALSE, if data is not correct index.
+  // isIndex is set, if data has signature of index.
+  HRESULT Read(ISequentialInStream *stream, bool &isIndex);
+  HRESULT Write(ISequentialOutStream *stream) const;
+};
+
+// Seekable stream of unpacked data. Seek is cheap: decoding
+// is restarted from nearest access point before new position.
+class CIndexInStream: 
+  public IInStream,
+  public CMyUnknownImp
+{
+  CMyComPtr<IInStream> _stream;
+  UInt64 _dataOffset;
+  const CIndex *_index;
+  NCompress::NDeflate::NDecoder::CCOMCoder *_decoderSpec;
+  CMyComPtr<ISequentialInStream> _decoder;
+  bool _decoderIsStarted;
+  UInt64 _decodePos;
+  UInt64 _virtPos;
+
+  HRESULT RestartDecoder();
+  HRESULT ReadDecoder(void *data, UInt32 size, UInt32 &processedSize);
+public:
+  CMyComPtr<IUnknown> IndexOwner; // keeps (index) alive
+
+  // (dataOffset) is position of deflate stream in (stream)
+  void Init(IInStream *stream, UInt64 dataOffset, const CIndex *index);
+
+  MY_UNKNOWN_IMP1(IInStream)
+
+  STDMETHOD(Read)(void *data, UInt32 size, UInt32 *processedSize);
+  STDMETHOD(Seek)(Int64 offset, UInt32 seekOrigin, UInt64 *newPosition);
+};
+
+}}
+
+#endif
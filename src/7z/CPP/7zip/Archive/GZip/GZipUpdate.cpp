@@ -78,6 +78,9 @@ HRESULT UpdateArchive(
       compressionMethod.Algo, 
       compressionMethod.NumPasses, 
       compressionMethod.NumFastBytes,
+      #ifdef COMPRESS_MT
+      compressionMethod.NumThreads,
+      #endif
       compressionMethod.NumMatchFinderCycles
     };
     PROPID propIDs[] = 
@@ -85,6 +88,9 @@ HRESULT UpdateArchive(
       NCoderPropID::kAlgorithm,
       NCoderPropID::kNumPasses, 
       NCoderPropID::kNumFastBytes,
+      #ifdef COMPRESS_MT
+      NCoderPropID::kNumThreads,
+      #endif
       NCoderPropID::kMatchFinderCycles
     };
     int numProps = sizeof(propIDs) / sizeof(propIDs[0]);
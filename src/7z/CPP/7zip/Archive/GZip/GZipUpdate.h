@@ -20,6 +20,9 @@ struct CCompressionMethodMode
   UInt32 Algo;
   bool NumMatchFinderCyclesDefined;
   UInt32 NumMatchFinderCycles;
+  #ifdef COMPRESS_MT
+  UInt32 NumThreads;
+  #endif
 };
 
 HRESULT UpdateArchive(
@@ -87,6 +87,26 @@ ARCHIVE_INTERFACE_SUB(IArchiveExtractCallback, IProgress, 0x20)
 };
 
 
+/*
+IArchiveExtractCallbackMt:
+  optional interface of extract callback for multithreaded handlers.
+  SetPipeStat is called at the end of extraction, if handler has decoded
+    some folders with pipeline of reader, decoder and writer threads.
+    Times are in milliseconds:
+      readWait      - reader waits for free block
+      decodeInWait  - decoder waits for packed data
+      decodeOutWait - decoder waits for free block
+      writeWait     - writer waits for unpacked data
+*/
+
+ARCHIVE_INTERFACE(IArchiveExtractCallbackMt, 0x21)
+{
+  STDMETHOD(SetPipeStat)(UInt32 numFolders, 
+      UInt32 readWait, UInt32 decodeInWait, 
+      UInt32 decodeOutWait, UInt32 writeWait) PURE;
+};
+
+
 ARCHIVE_INTERFACE(IArchiveOpenVolumeCallback, 0x30)
 {
   STDMETHOD(GetProperty)(PROPID propID, PROPVARIANT *value) PURE;
@@ -131,6 +151,53 @@ ARCHIVE_INTERFACE(IInArchive, 0x60)
 };
 
 
+/*
+IInArchiveIndex:
+  handler can build side index of archive during Extract.
+  Index is stored next to archive as "archive name" + kIndexExtension,
+  handler reads it with IArchiveOpenVolumeCallback::GetStream.
+  IndexWasChanged returns (changed != NIndexChange::kNone), if new index 
+  must be written:
+    kNew     - there is no index file of handler. Existing file with 
+               same name is not index, so it must not be overwritten.
+    kReplace - existing index file of handler is stale or broken.
+*/
+
+namespace NArchive
+{
+  const wchar_t * const kIndexExtension = L".idx";
+  namespace NIndexChange
+  {
+    enum
+    {
+      kNone = 0,
+      kNew,
+      kReplace
+    };
+  }
+}
+
+ARCHIVE_INTERFACE(IInArchiveIndex, 0x70)
+{
+  STDMETHOD(IndexWasChanged)(Int32 *changed) PURE;
+  STDMETHOD(WriteIndex)(ISequentialOutStream *outStream) PURE;
+};
+
+
+/*
+IInArchiveFindItem:
+  FindItem returns index of item with exact path (as returned in kpidPath).
+  Result is S_FALSE, if there is no such item.
+  Handler can build name index at first call, so it's faster than 
+  reading kpidPath of all items.
+*/
+
+ARCHIVE_INTERFACE(IInArchiveFindItem, 0x71)
+{
+  STDMETHOD(FindItem)(const wchar_t *path, UInt32 *index) PURE;
+};
+
+
 ARCHIVE_INTERFACE_SUB(IArchiveUpdateCallback, IProgress, 0x80)
 {
   STDMETHOD(GetUpdateItemInfo)(UInt32 index, 
@@ -151,6 +218,24 @@ ARCHIVE_INTERFACE_SUB(IArchiveUpdateCallback2, IArchiveUpdateCallback, 0x82)
 };
 
 
+/*
+IArchiveUpdateCallbackMt:
+  optional interface of update callback for multithreaded handlers.
+  GetWorkDir returns folder for temp files of handler.
+    Empty string means default temp folder.
+  SetThreadStat is called at the end of update for each thread of handler.
+    threadIndex is -1 for main thread. Times are in milliseconds.
+*/
+
+ARCHIVE_INTERFACE(IArchiveUpdateCallbackMt, 0x83)
+{
+  STDMETHOD(GetWorkDir)(BSTR *path) PURE;
+  STDMETHOD(SetThreadStat)(Int32 threadIndex, UInt32 numItems, 
+      UInt64 unpackSize, UInt64 packSize, UInt64 spillSize,
+      UInt32 busyTime, UInt32 totalTime) PURE;
+};
+
+
 #define INTERFACE_IOutArchive(x) \
   STDMETHOD(UpdateItems)(ISequentialOutStream *outStream, UInt32 numItems, IArchiveUpdateCallback *updateCallback) x; \
   STDMETHOD(GetFileTimeType)(UInt32 *type) x;
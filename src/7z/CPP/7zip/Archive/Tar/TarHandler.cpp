@@ -19,6 +19,7 @@
 #include "../../Compress/Copy/CopyCoder.h"
 
 #include "../Common/ItemNameUtils.h"
+#include "../Common/ParseProperties.h"
 
 using namespace NWindows;
 using namespace NTime;
@@ -48,11 +49,63 @@ STATPROPSTG kProps[] =
 IMP_IInArchive_Props
 IMP_IInArchive_ArcProps_NO
 
+// Side index is checked with size and last write time of archive file.
+// Callback doesn't return these properties for sub-archives, 
+// so index is used only for archive files.
+
+bool CHandler::ReadIndex(IInStream *stream, IArchiveOpenVolumeCallback *openVolumeCallback,
+    const UString &arcName)
+{
+  if (openVolumeCallback == NULL || arcName.IsEmpty())
+    return false;
+  {
+    NCOM::CPropVariant prop;
+    if (openVolumeCallback->GetProperty(kpidLastWriteTime, &prop) != S_OK || 
+        prop.vt != VT_FILETIME)
+      return false;
+    _indexKey.ArcTime = ((UInt64)prop.filetime.dwHighDateTime << 32) | 
+        prop.filetime.dwLowDateTime;
+  }
+  UInt64 startPosition;
+  if (stream->Seek(0, STREAM_SEEK_CUR, &startPosition) != S_OK ||
+      stream->Seek(0, STREAM_SEEK_END, &_indexKey.ArcSize) != S_OK ||
+      stream->Seek(startPosition, STREAM_SEEK_SET, NULL) != S_OK)
+    return false;
+  _indexKeyDefined = true;
+  CMyComPtr<IInStream> indexStream;
+  if (openVolumeCallback->GetStream(arcName + kIndexExtension, &indexStream) != S_OK || 
+      !indexStream)
+    return false;
+  bool isIndex;
+  _indexIsActual = (NTar::ReadIndex(indexStream, _indexKey, _items, isIndex) == S_OK);
+  _indexIsStale = (isIndex && !_indexIsActual);
+  return _indexIsActual;
+}
+
 STDMETHODIMP CHandler::Open(IInStream *stream, 
     const UInt64 * /* maxCheckStartPosition */,
     IArchiveOpenCallback *openArchiveCallback)
 {
   COM_TRY_BEGIN
+  Close();
+  CMyComPtr<IArchiveOpenVolumeCallback> openVolumeCallback;
+  UString arcName;
+  if (openArchiveCallback != NULL)
+  {
+    openArchiveCallback->QueryInterface(IID_IArchiveOpenVolumeCallback, (void **)&openVolumeCallback);
+    if (openVolumeCallback)
+    {
+      // index is optional, so we don't use it, if name is unknown
+      NCOM::CPropVariant prop;
+      if (openVolumeCallback->GetProperty(kpidName, &prop) == S_OK && prop.vt == VT_BSTR)
+        arcName = prop.bstrVal;
+    }
+  }
+  if (ReadIndex(stream, openVolumeCallback, arcName))
+  {
+    _inStream = stream;
+    return S_OK;
+  }
   // try
   {
     CInArchive archive;
@@ -90,18 +143,9 @@ STDMETHODIMP CHandler::Open(IInStream *stream,
     }
     if (_items.Size() == 0)
     {
-      CMyComPtr<IArchiveOpenVolumeCallback> openVolumeCallback;
-      if (!openArchiveCallback)
-        return S_FALSE;
-      openArchiveCallback->QueryInterface(IID_IArchiveOpenVolumeCallback, (void **)&openVolumeCallback);
       if (!openVolumeCallback)
         return S_FALSE;
-      NCOM::CPropVariant prop;
-      RINOK(openVolumeCallback->GetProperty(kpidName, &prop));
-      if (prop.vt != VT_BSTR)
-        return S_FALSE;
-      UString baseName = prop.bstrVal;
-      baseName = baseName.Right(4);
+      UString baseName = arcName.Right(4);
       if (baseName.CompareNoCase(L".tar") != 0)
         return S_FALSE;
     }
@@ -121,9 +165,70 @@ STDMETHODIMP CHandler::Close()
 {
   _items.Clear();
   _inStream.Release();
+  _indexKeyDefined = false;
+  _indexIsActual = false;
+  _indexIsStale = false;
   return S_OK;
 }
 
+STDMETHODIMP CHandler::SetProperties(const wchar_t **names, const PROPVARIANT *values, Int32 numProperties)
+{
+  for (int i = 0; i < numProperties; i++)
+  {
+    UString name = names[i];
+    name.MakeUpper();
+    if (name.IsEmpty())
+      return E_INVALIDARG;
+    const PROPVARIANT &prop = values[i];
+    if (name == L"IX")
+    {
+      RINOK(SetBoolProperty(_createIndex, prop));
+    }
+    // Tar has no other properties. We ignore them, since UI 
+    // also sends compression properties to archive handler.
+  }
+  return S_OK;
+}
+
+STDMETHODIMP CHandler::IndexWasChanged(Int32 *changed)
+{
+  *changed = NIndexChange::kNone;
+  if (_createIndex && _indexKeyDefined && !_indexIsActual)
+    *changed = _indexIsStale ? NIndexChange::kReplace : NIndexChange::kNew;
+  return S_OK;
+}
+
+STDMETHODIMP CHandler::WriteIndex(ISequentialOutStream *outStream)
+{
+  COM_TRY_BEGIN
+  if (!_indexKeyDefined)
+    return E_FAIL;
+  RINOK(NTar::WriteIndex(outStream, _indexKey, _items));
+  _indexIsActual = true;
+  _indexIsStale = false;
+  return S_OK;
+  COM_TRY_END
+}
+
+STDMETHODIMP CHandler::GetStream(UInt32 index, ISequentialInStream **stream)
+{
+  COM_TRY_BEGIN
+  *stream = 0;
+  if (index >= (UInt32)_items.Size())
+    return E_INVALIDARG;
+  const CItemEx &item = _items[index];
+  if (item.IsDirectory())
+    return S_FALSE;
+  RINOK(_inStream->Seek(item.GetDataPosition(), STREAM_SEEK_SET, NULL));
+  CLimitedSequentialInStream *streamSpec = new CLimitedSequentialInStream;
+  CMyComPtr<ISequentialInStream> inStream(streamSpec);
+  streamSpec->SetStream(_inStream);
+  streamSpec->Init(item.Size);
+  *stream = inStream.Detach();
+  return S_OK;
+  COM_TRY_END
+}
+
 STDMETHODIMP CHandler::GetNumberOfItems(UInt32 *numItems)
 {
   *numItems = _items.Size();
@@ -7,6 +7,7 @@
 #include "../IArchive.h"
 
 #include "TarItem.h"
+#include "TarIndex.h"
 
 namespace NArchive {
 namespace NTar {
@@ -14,20 +15,45 @@ namespace NTar {
 class CHandler: 
   public IInArchive,
   public IOutArchive,
+  public ISetProperties,
+  public IInArchiveGetStream,
+  public IInArchiveIndex,
   public CMyUnknownImp
 {
 public:
-  MY_UNKNOWN_IMP2(
+  MY_UNKNOWN_IMP5(
     IInArchive,
-    IOutArchive
+    IOutArchive,
+    ISetProperties,
+    IInArchiveGetStream,
+    IInArchiveIndex
   )
 
   INTERFACE_IInArchive(;)
   INTERFACE_IOutArchive(;)
 
+  STDMETHOD(SetProperties)(const wchar_t **names, const PROPVARIANT *values, Int32 numProperties);
+
+  STDMETHOD(GetStream)(UInt32 index, ISequentialInStream **stream);
+
+  STDMETHOD(IndexWasChanged)(Int32 *changed);
+  STDMETHOD(WriteIndex)(ISequentialOutStream *outStream);
+
+  CHandler(): _createIndex(false), _indexKeyDefined(false), _indexIsActual(false), 
+      _indexIsStale(false) {}
+
 private:
   CObjectVector<CItemEx> _items;
   CMyComPtr<IInStream> _inStream;
+
+  bool _createIndex;      // "ix" property: UI saves items table to side index
+  CIndexKey _indexKey;
+  bool _indexKeyDefined;
+  bool _indexIsActual;    // side index exists and corresponds to archive
+  bool _indexIsStale;     // side index exists, but it's for old version of archive
+
+  bool ReadIndex(IInStream *stream, IArchiveOpenVolumeCallback *openVolumeCallback,
+      const UString &arcName);
 };
 
 }}
@@ -0,0 +1,287 @@
+// Archive/TarIndex.cpp
+
+#include "StdAfx.h"
+
+#include "Common/Buffer.h"
+
+#include "TarIndex.h"
+
+#include "../../Common/StreamUtils.h"
+
+extern "C" 
+{ 
+  #include "../../../../C/7zCrc.h" 
+}
+
+namespace NArchive {
+namespace NTar {
+
+static const Byte kSignature[8] = { 'T', 'A', 'R', 'I', 'D', 'X', 0x1A, 1 };
+static const UInt32 kHeaderSize = 8 + 8 + 8 + 4 + 4;
+static const UInt32 kRecordSize = 80;
+static const UInt32 kNumItemsMax = (1 << 24);
+static const UInt32 kNamesSizeMax = (1 << 30);
+static const UInt32 kWriteBufferSize = (1 << 16);
+
+namespace NRecord
+{
+  const int kHeaderPosition = 0;
+  const int kLongLinkSize = 8;
+  const int kSize = 16;
+  const int kMode = 24;
+  const int kUID = 28;
+  const int kGID = 32;
+  const int kModificationTime = 36;
+  const int kDeviceMajor = 40;
+  const int kDeviceMinor = 44;
+  const int kName = 48;
+  const int kLinkName = 52;
+  const int kUserName = 56;
+  const int kGroupName = 60;
+  const int kMagic = 64;
+  const int kLinkFlag = 72;
+  const int kFlags = 73;
+
+  const Byte kDeviceMajorDefined = 1;
+  const Byte kDeviceMinorDefined = 2;
+}
+
+static void SetUInt32(Byte *p, UInt32 v)
+{
+  for (int i = 0; i < 4; i++)
+    p[i] = (Byte)(v >> (8 * i));
+}
+
+static void SetUInt64(Byte *p, UInt64 v)
+{
+  for (int i = 0; i < 8; i++)
+    p[i] = (Byte)(v >> (8 * i));
+}
+
+static UInt32 GetUInt32(const Byte *p)
+{
+  UInt32 v = 0;
+  for (int i = 0; i < 4; i++)
+    v |= ((UInt32)p[i] << (8 * i));
+  return v;
+}
+
+static UInt64 GetUInt64(const Byte *p)
+{
+  return GetUInt32(p) | ((UInt64)GetUInt32(p + 4) << 32);
+}
+
+static bool GetString(const Byte *names, UInt32 namesSize, const Byte *p, AString &s)
+{
+  UInt32 offset = GetUInt32(p);
+  if (offset >= namesSize)
+    return false;
+  s = (const char *)(names + offset);
+  return true;
+}
+
+HRESULT ReadIndex(ISequentialInStream *stream, const CIndexKey &key, 
+    CObjectVector<CItemEx> &items, bool &isIndex)
+{
+  items.Clear();
+  isIndex = false;
+  Byte header[kHeaderSize];
+  UInt32 processedSize;
+  RINOK(ReadStream(stream, header, kHeaderSize, &processedSize));
+  if (processedSize != kHeaderSize)
+    return S_FALSE;
+  for (UInt32 i = 0; i < sizeof(kSignature); i++)
+    if (header[i] != kSignature[i])
+      return S_FALSE;
+  isIndex = true;
+  if (GetUInt64(header + 8) != key.ArcSize || 
+      GetUInt64(header + 16) != key.ArcTime)
+    return S_FALSE;
+  UInt32 numItems = GetUInt32(header + 24);
+  UInt32 namesSize = GetUInt32(header + 28);
+  if (numItems > kNumItemsMax || namesSize > kNamesSizeMax)
+    return S_FALSE;
+  
+  // last string of pool must be terminated, so any offset in pool is safe
+  if (numItems != 0 && namesSize == 0)
+    return S_FALSE;
+
+  UInt32 recordsSize = numItems * kRecordSize;
+  UInt32 dataSize = recordsSize + namesSize + 4;
+  CByteBuffer buffer;
+  buffer.SetCapacity(dataSize);
+  Byte *data = buffer;
+  RINOK(ReadStream(stream, data, dataSize, &processedSize));
+  if (processedSize != dataSize)
+    return S_FALSE;
+  UInt32 crc = CrcUpdate(CRC_INIT_VAL, header, kHeaderSize);
+  crc = CrcUpdate(crc, data, dataSize - 4);
+  if (GetUInt32(data + dataSize - 4) != CRC_GET_DIGEST(crc))
+    return S_FALSE;
+  
+  const Byte *names = data + recordsSize;
+  if (namesSize != 0 && names[namesSize - 1] != 0)
+    return S_FALSE;
+
+  items.Reserve(numItems);
+  for (UInt32 i = 0; i < numItems; i++)
+  {
+    const Byte *p = data + i * kRecordSize;
+    CItemEx item;
+    item.HeaderPosition = GetUInt64(p + NRecord::kHeaderPosition);
+    item.LongLinkSize = GetUInt64(p + NRecord::kLongLinkSize);
+    item.Size = GetUInt64(p + NRecord::kSize);
+    item.Mode = GetUInt32(p + NRecord::kMode);
+    item.UID = GetUInt32(p + NRecord::kUID);
+    item.GID = GetUInt32(p + NRecord::kGID);
+    item.ModificationTime = GetUInt32(p + NRecord::kModificationTime);
+    item.DeviceMajor = GetUInt32(p + NRecord::kDeviceMajor);
+    item.DeviceMinor = GetUInt32(p + NRecord::kDeviceMinor);
+    if (!GetString(names, namesSize, p + NRecord::kName, item.Name) ||
+        !GetString(names, namesSize, p + NRecord::kLinkName, item.LinkName) ||
+        !GetString(names, namesSize, p + NRecord::kUserName, item.UserName) ||
+        !GetString(names, namesSize, p + NRecord::kGroupName, item.GroupName))
+    {
+      items.Clear();
+      return S_FALSE;
+    }
+    memmove(item.Magic, p + NRecord::kMagic, 8);
+    item.LinkFlag = (char)p[NRecord::kLinkFlag];
+    Byte flags = p[NRecord::kFlags];
+    item.DeviceMajorDefined = ((flags & NRecord::kDeviceMajorDefined) != 0);
+    item.DeviceMinorDefined = ((flags & NRecord::kDeviceMinorDefined) != 0);
+    if (item.GetDataPosition() + item.Size > key.ArcSize)
+    {
+      items.Clear();
+      return S_FALSE;
+    }
+    items.Add(item);
+  }
+  return S_OK;
+}
+
+class CIndexWriter
+{
+  ISequentialOutStream *_stream;
+  CByteBuffer _buffer;
+  UInt32 _pos;
+  UInt32 _crc;
+public:
+  CIndexWriter(ISequentialOutStream *stream): _stream(stream), _pos(0), _crc(CRC_INIT_VAL)
+    { _buffer.SetCapacity(kWriteBufferSize); }
+  HRESULT Flush()
+  {
+    _crc = CrcUpdate(_crc, _buffer, _pos);
+    HRESULT res = WriteStream(_stream, _buffer, _pos, NULL);
+    _pos = 0;
+    return res;
+  }
+  // returns pointer to (size) bytes in buffer; (size <= kRecordSize)
+  HRESULT GetSpace(UInt32 size, Byte *&p)
+  {
+    if (_pos + size > kWriteBufferSize)
+    {
+      RINOK(Flush());
+    }
+    p = (Byte *)_buffer + _pos;
+    _pos += size;
+    return S_OK;
+  }
+  HRESULT WriteString(const AString &s)
+  {
+    const char *p = s;
+    UInt32 size = s.Length() + 1;
+    while (size != 0)
+    {
+      if (_pos == kWriteBufferSize)
+      {
+        RINOK(Flush());
+      }
+      UInt32 cur = kWriteBufferSize - _pos;
+      if (cur > size)
+        cur = size;
+      memcpy((Byte *)_buffer + _pos, p, cur);
+      _pos += cur;
+      p += cur;
+      size -= cur;
+    }
+    return S_OK;
+  }
+  HRESULT WriteCrc()
+  {
+    RINOK(Flush());
+    Byte buf[4];
+    SetUInt32(buf, CRC_GET_DIGEST(_crc));
+    return WriteStream(_stream, buf, 4, NULL);
+  }
+};
+
+static UInt32 GetStringSize(const AString &s) { return s.Length() + 1; }
+
+HRESULT WriteIndex(ISequentialOutStream *stream, const CIndexKey &key, const CObjectVector<CItemEx> &items)
+{
+  UInt32 numItems = items.Size();
+  if (numItems > kNumItemsMax)
+    return E_INVALIDARG;
+  UInt64 namesSize = 0;
+  int i;
+  for (i = 0; i < items.Size(); i++)
+  {
+    const CItemEx &item = items[i];
+    namesSize += GetStringSize(item.Name) + GetStringSize(item.LinkName) + 
+        GetStringSize(item.UserName) + GetStringSize(item.GroupName);
+  }
+  if (namesSize > kNamesSizeMax)
+    return E_INVALIDARG;
+
+  CIndexWriter writer(stream);
+  Byte *p;
+  RINOK(writer.GetSpace(kHeaderSize, p));
+  memcpy(p, kSignature, sizeof(kSignature));
+  SetUInt64(p + 8, key.ArcSize);
+  SetUInt64(p + 16, key.ArcTime);
+  SetUInt32(p + 24, numItems);
+  SetUInt32(p + 28, (UInt32)namesSize);
+
+  UInt32 nameOffset = 0;
+  for (i = 0; i < items.Size(); i++)
+  {
+    const CItemEx &item = items[i];
+    RINOK(writer.GetSpace(kRecordSize, p));
+    memset(p, 0, kRecordSize);
+    SetUInt64(p + NRecord::kHeaderPosition, item.HeaderPosition);
+    SetUInt64(p + NRecord::kLongLinkSize, item.LongLinkSize);
+    SetUInt64(p + NRecord::kSize, item.Size);
+    SetUInt32(p + NRecord::kMode, item.Mode);
+    SetUInt32(p + NRecord::kUID, item.UID);
+    SetUInt32(p + NRecord::kGID, item.GID);
+    SetUInt32(p + NRecord::kModificationTime, item.ModificationTime);
+    SetUInt32(p + NRecord::kDeviceMajor, item.DeviceMajor);
+    SetUInt32(p + NRecord::kDeviceMinor, item.DeviceMinor);
+    SetUInt32(p + NRecord::kName, nameOffset);
+    nameOffset += GetStringSize(item.Name);
+    SetUInt32(p + NRecord::kLinkName, nameOffset);
+    nameOffset += GetStringSize(item.LinkName);
+    SetUInt32(p + NRecord::kUserName, nameOffset);
+    nameOffset += GetStringSize(item.UserName);
+    SetUInt32(p + NRecord::kGroupName, nameOffset);
+    nameOffset += GetStringSize(item.GroupName);
+    memcpy(p + NRecord::kMagic, item.Magic, 8);
+    p[NRecord::kLinkFlag] = (Byte)item.LinkFlag;
+    p[NRecord::kFlags] = (Byte)(
+        (item.DeviceMajorDefined ? NRecord::kDeviceMajorDefined : 0) |
+        (item.DeviceMinorDefined ? NRecord::kDeviceMinorDefined : 0));
+  }
+  
+  for (i = 0; i < items.Size(); i++)
+  {
+    const CItemEx &item = items[i];
+    RINOK(writer.WriteString(item.Name));
+    RINOK(writer.WriteString(item.LinkName));
+    RINOK(writer.WriteString(item.UserName));
+    RINOK(writer.WriteString(item.GroupName));
+  }
+  return writer.WriteCrc();
+}
+
+}}
@@ -0,0 +1,41 @@
+// Archive/TarIndex.h
+
+#ifndef __ARCHIVE_TAR_INDEX_H
+#define __ARCHIVE_TAR_INDEX_H
+
+#include "Common/MyVector.h"
+
+#include "../../IStream.h"
+
+#include "TarItem.h"
+
+namespace NArchive {
+namespace NTar {
+
+// Side index file is stored next to archive: "name.tar" + kIndexExtension
+
+// Index file contains items table of archive, so archive can be opened
+// without reading of all headers. It has the following layout:
+//   header: signature, archive size, archive time, number of items,
+//           size of names pool
+//   items: fixed-size records with header and data positions
+//   names pool: zero-terminated strings
+//   CRC of all previous bytes
+// All numbers are little-endian. Records refer to strings by offset in
+// names pool, so the file can be mapped to memory and used as is.
+
+struct CIndexKey
+{
+  UInt64 ArcSize;  // these fields are used to check that index
+  UInt64 ArcTime;  // corresponds to archive
+};
+
+// returns S_FALSE, if data is not correct index or it's index of another archive.
+// isIndex is set, if data has signature of index.
+HRESULT ReadIndex(ISequentialInStream *stream, const CIndexKey &key, 
+    CObjectVector<CItemEx> &items, bool &isIndex);
+HRESULT WriteIndex(ISequentialOutStream *stream, const CIndexKey &key, const CObjectVector<CItemEx> &items);
+
+}}
+
+#endif
@@ -10,6 +10,9 @@
 
 #include "../../Common/StreamUtils.h"
 #include "../../Common/ProgressUtils.h"
+#include "../../Common/StreamObjects.h"
+
+#include "../Common/ParseProperties.h"
 
 #include "WimHandler.h"
 
@@ -342,6 +345,10 @@ STDMETHODIMP CHandler::Close()
   return S_OK;
 }
 
+// Streams referenced by several items of one Extract call are unpacked once
+// into memory and written from there for the remaining items.
+static const UInt32 kCacheSizeMax = (1 << 26);
+
 STDMETHODIMP CHandler::Extract(const UInt32* indices, UInt32 numItems,
     Int32 _aTestMode, IArchiveExtractCallback *extractCallback)
 {
@@ -356,6 +363,9 @@ STDMETHODIMP CHandler::Extract(const UInt32* indices, UInt32 numItems,
 
   UInt32 i;
   UInt64 totalSize = 0;
+  CRecordVector<UInt32> streamRefs;
+  for (i = 0; i < (UInt32)m_Database.Streams.Size(); i++)
+    streamRefs.Add(0);
   for (i = 0; i < numItems; i++)
   {
     UInt32 index = allFilesMode ? i : indices[i];
@@ -366,6 +376,7 @@ STDMETHODIMP CHandler::Extract(const UInt32* indices, UInt32 numItems,
       {
         const CStreamInfo &si = m_Database.Streams[streamIndex];
         totalSize += si.Resource.UnpackSize;
+        streamRefs[streamIndex]++;
       }
     }
     else
@@ -380,7 +391,15 @@ STDMETHODIMP CHandler::Extract(const UInt32* indices, UInt32 numItems,
   
   int prevSuccessStreamIndex = -1;
 
+  CObjectVector<CByteBuffer> cache;
+  for (i = 0; i < (UInt32)m_Database.Streams.Size(); i++)
+    cache.Add(CByteBuffer());
+  UInt32 cacheSize = 0;
+
   CUnpacker unpacker;
+  #ifdef COMPRESS_MT
+  unpacker.SetNumThreads(_numThreads);
+  #endif
 
   CLocalProgress *lps = new CLocalProgress;
   CMyComPtr<ICompressProgressInfo> progress = lps;
@@ -438,14 +457,53 @@ STDMETHODIMP CHandler::Extract(const UInt32* indices, UInt32 numItems,
     currentItemUnPacked = si.Resource.UnpackSize;
     currentItemPacked = si.Resource.PackSize;
 
+    CByteBuffer &cached = cache[streamIndex];
+    bool isLastRef = (--streamRefs[streamIndex] == 0);
+
     if(!testMode && (!realOutStream))
+    {
+      if (isLastRef && cached.GetCapacity() != 0)
+      {
+        cacheSize -= (UInt32)cached.GetCapacity();
+        cached.Free();
+      }
       continue;
+    }
     RINOK(extractCallback->PrepareOperation(askMode));
     Int32 opRes = NExtract::NOperationResult::kOK;
-    if (streamIndex != prevSuccessStreamIndex || realOutStream)
+    if (cached.GetCapacity() != 0)
+    {
+      if (realOutStream)
+      {
+        RINOK(WriteStream(realOutStream, (const Byte *)cached, (UInt32)cached.GetCapacity(), NULL));
+      }
+    }
+    else if (streamIndex != prevSuccessStreamIndex || realOutStream)
     {
       Byte digest[20];
-      HRESULT res = unpacker.Unpack(m_Volumes[si.PartNumber].Stream, si.Resource, realOutStream, progress, digest);
+      HRESULT res;
+      UInt64 unpackSize = si.Resource.UnpackSize;
+      if (!isLastRef && unpackSize != 0 && unpackSize <= kCacheSizeMax - cacheSize)
+      {
+        cached.SetCapacity((size_t)unpackSize);
+        CSequentialOutStreamImp2 *bufStreamSpec = new CSequentialOutStreamImp2;
+        CMyComPtr<ISequentialOutStream> bufStream = bufStreamSpec;
+        bufStreamSpec->Init((Byte *)cached, (size_t)unpackSize);
+        res = unpacker.Unpack(m_Volumes[si.PartNumber].Stream, si.Resource, bufStream, progress, digest);
+        if (res == S_OK && bufStreamSpec->GetPos() != unpackSize)
+          res = S_FALSE;
+        if (res == S_OK || res == S_FALSE)
+          if (realOutStream)
+          {
+            RINOK(WriteStream(realOutStream, (const Byte *)cached, (UInt32)bufStreamSpec->GetPos(), NULL));
+          }
+        if (res == S_OK && memcmp(digest, si.Hash, kHashSize) == 0)
+          cacheSize += (UInt32)unpackSize;
+        else
+          cached.Free();
+      }
+      else
+        res = unpacker.Unpack(m_Volumes[si.PartNumber].Stream, si.Resource, realOutStream, progress, digest);
       if (res == S_OK)
       {
         if (memcmp(digest, si.Hash, kHashSize) == 0)
@@ -458,6 +516,11 @@ STDMETHODIMP CHandler::Extract(const UInt32* indices, UInt32 numItems,
       else
         return res;
     }
+    if (isLastRef && cached.GetCapacity() != 0)
+    {
+      cacheSize -= (UInt32)cached.GetCapacity();
+      cached.Free();
+    }
     realOutStream.Release();
     RINOK(extractCallback->SetOperationResult(opRes));
   }
@@ -465,6 +528,34 @@ STDMETHODIMP CHandler::Extract(const UInt32* indices, UInt32 numItems,
   COM_TRY_END
 }
 
+STDMETHODIMP CHandler::SetProperties(const wchar_t **names, const PROPVARIANT *values, Int32 numProperties)
+{
+  COM_TRY_BEGIN
+  #ifdef COMPRESS_MT
+  const UInt32 numProcessors = NSystem::GetNumberOfProcessors();
+  _numThreads = numProcessors;
+  #endif
+
+  for (int i = 0; i < numProperties; i++)
+  {
+    UString name = names[i];
+    name.MakeUpper();
+    if (name.IsEmpty())
+      return E_INVALIDARG;
+    const PROPVARIANT &value = values[i];
+    if (name.Left(2) == L"MT")
+    {
+      #ifdef COMPRESS_MT
+      RINOK(ParseMtProp(name.Mid(2), value, numProcessors, _numThreads));
+      #endif
+      continue;
+    }
+    return E_INVALIDARG;
+  }
+  return S_OK;
+  COM_TRY_END
+}
+
 STDMETHODIMP CHandler::GetNumberOfItems(UInt32 *numItems)
 {
   *numItems = m_Database.Items.Size() + m_Xmls.Size();
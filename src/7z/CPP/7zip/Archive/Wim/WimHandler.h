@@ -7,6 +7,10 @@
 #include "../IArchive.h"
 #include "WimIn.h"
 
+#ifdef COMPRESS_MT
+#include "../../../Windows/System.h"
+#endif
+
 namespace NArchive {
 namespace NWim {
 
@@ -24,17 +28,30 @@ struct CXml
 
 class CHandler: 
   public IInArchive,
+  public ISetProperties,
   public CMyUnknownImp
 {
 public:
-  MY_UNKNOWN_IMP1(IInArchive)
+  MY_UNKNOWN_IMP2(IInArchive, ISetProperties)
   INTERFACE_IInArchive(;)
 
+  STDMETHOD(SetProperties)(const wchar_t **names, const PROPVARIANT *values, Int32 numProperties);
+
+  CHandler()
+  {
+    #ifdef COMPRESS_MT
+    _numThreads = NWindows::NSystem::GetNumberOfProcessors();
+    #endif
+  }
+
 private:
   CDatabase m_Database;
   CObjectVector<CVolume> m_Volumes;
   CObjectVector<CXml> m_Xmls;
   int m_NameLenForStreams;
+  #ifdef COMPRESS_MT
+  UInt32 _numThreads;
+  #endif
 };
 
 }}
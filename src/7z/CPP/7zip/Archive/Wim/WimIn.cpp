@@ -20,6 +20,9 @@ namespace NWim{
 
 static const int kChunkSizeBits = 15;
 static const UInt32 kChunkSize = (1 << kChunkSizeBits);
+#ifdef COMPRESS_MT
+static const UInt32 kChunkSizeMax = (kChunkSize << 1);
+#endif
 
 static HRESULT ReadBytes(ISequentialInStream *inStream, void *data, UInt32 size)
 {
@@ -44,6 +47,168 @@ static void GetFileTimeFromMem(const Byte *p, FILETIME *ft)
   ft->dwHighDateTime = GetUInt32FromMem(p + 4);
 }
 
+#ifdef COMPRESS_MT
+
+static THREAD_FUNC_DECL ChunkDecoderThread(void *p) { ((CChunkDecoder *)p)->ThreadFunc(); return 0; }
+
+HRes CChunkDecoder::Create()
+{
+  RINOK(CanStartEvent.CreateIfNotCreated());
+  RINOK(WasFinishedEvent.CreateIfNotCreated());
+  if (!LzxDecoder)
+  {
+    LzxDecoderSpec = new NCompress::NLzx::CDecoder(true);
+    LzxDecoder = LzxDecoderSpec;
+    RINOK(LzxDecoderSpec->SetParams(kChunkSizeBits));
+  }
+  if (InBuf.GetCapacity() == 0)
+  {
+    InBuf.SetCapacity(kChunkSizeMax);
+    OutBuf.SetCapacity(kChunkSize);
+  }
+  return Thread.Create(ChunkDecoderThread, this);
+}
+
+void CChunkDecoder::Decode()
+{
+  CSequentialInStreamImp *inStreamSpec = new CSequentialInStreamImp;
+  CMyComPtr<ISequentialInStream> inStream = inStreamSpec;
+  inStreamSpec->Init(InBuf, InSize);
+  CSequentialOutStreamImp2 *outStreamSpec = new CSequentialOutStreamImp2;
+  CMyComPtr<ISequentialOutStream> outStream = outStreamSpec;
+  outStreamSpec->Init(OutBuf, OutSize);
+  UInt64 outSize64 = OutSize;
+  LzxDecoderSpec->SetKeepHistory(false);
+  Result = LzxDecoder->Code(inStream, outStream, NULL, &outSize64, NULL);
+  if (Result == S_OK && outStreamSpec->GetPos() != OutSize)
+    Result = S_FALSE;
+}
+
+void CChunkDecoder::ThreadFunc()
+{
+  for (;;)
+  {
+    CanStartEvent.Lock();
+    if (Exit)
+      return;
+    Decode();
+    WasFinishedEvent.Set();
+  }
+}
+
+HRESULT CUnpacker::CreateDecoders()
+{
+  if (_decoders != 0 && _numDecoders == _numThreads)
+    return S_OK;
+  FreeDecoders();
+  _decoders = new CChunkDecoder[_numThreads];
+  for (UInt32 t = 0; t < _numThreads; t++)
+  {
+    HRes res = _decoders[t].Create();
+    if (res != S_OK)
+    {
+      _numDecoders = t;
+      FreeDecoders();
+      return res;
+    }
+  }
+  _numDecoders = _numThreads;
+  return S_OK;
+}
+
+void CUnpacker::FreeDecoders()
+{
+  if (_decoders == 0)
+    return;
+  for (UInt32 t = 0; t < _numDecoders; t++)
+  {
+    CChunkDecoder &d = _decoders[t];
+    d.Exit = true;
+    d.CanStartEvent.Set();
+    d.Thread.Wait();
+  }
+  delete []_decoders;
+  _decoders = 0;
+  _numDecoders = 0;
+}
+
+static UInt64 GetChunkOffset(const Byte *sizes, unsigned entrySize, UInt32 index)
+{
+  if (index == 0)
+    return 0;
+  const Byte *p = sizes + (size_t)(index - 1) * entrySize;
+  return (entrySize == 4) ? GetUInt32FromMem(p) : GetUInt64FromMem(p);
+}
+
+// Chunks are read in order by the calling thread and handed to a ring of
+// decoders; the oldest one is written out (and hashed by outStream) while
+// the others are still decoding. Stored chunks bypass the decoder thread.
+
+HRESULT CUnpacker::UnpackChunks(IInStream *inStream, UInt64 baseOffset, UInt64 packDataSize, 
+    UInt64 unpackSize, const Byte *sizes, unsigned entrySize, UInt32 numChunks, 
+    ISequentialOutStream *outStream, ICompressProgressInfo *progress)
+{
+  RINOK(CreateDecoders());
+  HRESULT res = S_OK;
+  UInt32 numStarted = 0;
+  UInt32 numFinished = 0;
+  UInt64 outProcessed = 0;
+  while (numFinished < numChunks)
+  {
+    if (res == S_OK && numStarted < numChunks && numStarted - numFinished < _numDecoders)
+    {
+      CChunkDecoder &d = _decoders[numStarted % _numDecoders];
+      UInt64 offset = GetChunkOffset(sizes, entrySize, numStarted);
+      UInt64 nextOffset = packDataSize;
+      if (numStarted + 1 < numChunks)
+        nextOffset = GetChunkOffset(sizes, entrySize, numStarted + 1);
+      if (nextOffset < offset || nextOffset - offset > kChunkSizeMax)
+      {
+        res = S_FALSE;
+        continue;
+      }
+      d.InSize = (UInt32)(nextOffset - offset);
+      d.OutSize = kChunkSize;
+      UInt64 rem = unpackSize - ((UInt64)numStarted << kChunkSizeBits);
+      if (rem < d.OutSize)
+        d.OutSize = (UInt32)rem;
+      d.IsStored = (d.InSize == d.OutSize);
+      res = inStream->Seek(baseOffset + offset, STREAM_SEEK_SET, NULL);
+      if (res == S_OK)
+        res = ReadBytes(inStream, d.InBuf, d.InSize);
+      if (res != S_OK)
+        continue;
+      numStarted++;
+      if (!d.IsStored)
+        d.CanStartEvent.Set();
+      continue;
+    }
+    if (numFinished == numStarted)
+      break;
+    CChunkDecoder &d = _decoders[numFinished % _numDecoders];
+    numFinished++;
+    if (!d.IsStored)
+      d.WasFinishedEvent.Lock();
+    if (res != S_OK)
+      continue;
+    if (!d.IsStored)
+      res = d.Result;
+    if (res == S_OK)
+      res = WriteStream(outStream, d.IsStored ? d.InBuf : d.OutBuf, d.OutSize, NULL);
+    outProcessed += d.OutSize;
+    if (res == S_OK && progress)
+    {
+      UInt64 packProcessed = packDataSize;
+      if (numFinished < numChunks)
+        packProcessed = GetChunkOffset(sizes, entrySize, numFinished);
+      res = progress->SetRatioInfo(&packProcessed, &outProcessed);
+    }
+  }
+  return res;
+}
+
+#endif
+
 HRESULT CUnpacker::Unpack(IInStream *inStream, const CResource &resource,
     ISequentialOutStream *outStream, ICompressProgressInfo *progress)
 {
@@ -80,6 +245,13 @@ HRESULT CUnpacker::Unpack(IInStream *inStream, const CResource &resource,
   }
   RINOK(ReadBytes(inStream, (Byte *)sizesBuf, sizesBufSize));
   const Byte *p = (const Byte *)sizesBuf;
+  UInt64 baseOffset = resource.Offset + sizesBufSize64;
+
+  #ifdef COMPRESS_MT
+  if (_numThreads > 1 && numChunks > 1)
+    return UnpackChunks(inStream, baseOffset, resource.PackSize - sizesBufSize64, 
+        resource.UnpackSize, p, entrySize, (UInt32)numChunks, outStream, progress);
+  #endif
   
   if (!lzxDecoder)
   {
@@ -88,7 +260,6 @@ HRESULT CUnpacker::Unpack(IInStream *inStream, const CResource &resource,
     RINOK(lzxDecoderSpec->SetParams(kChunkSizeBits));
   }
   
-  UInt64 baseOffset = resource.Offset + sizesBufSize64;
   UInt64 outProcessed = 0;
   for (UInt32 i = 0; i < (UInt32)numChunks; i++)
   {
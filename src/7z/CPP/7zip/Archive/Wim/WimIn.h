@@ -9,6 +9,11 @@
 #include "../../Compress/Lzx/LzxDecoder.h"
 #include "../../Compress/Copy/CopyCoder.h"
 
+#ifdef COMPRESS_MT
+#include "../../../Windows/Thread.h"
+#include "../../../Windows/Synchronization.h"
+#endif
+
 namespace NArchive {
 namespace NWim {
 
@@ -135,6 +140,33 @@ HRESULT ReadHeader(IInStream *inStream, CHeader &header);
 HRESULT OpenArchive(IInStream *inStream, const CHeader &header, CByteBuffer &xml, CDatabase &database);
 HRESULT SortDatabase(CDatabase &database);
 
+#ifdef COMPRESS_MT
+
+// Each thread decodes one chunk at a time with its own LZX decoder.
+
+struct CChunkDecoder
+{
+  NWindows::CThread Thread;
+  NWindows::NSynchronization::CAutoResetEvent CanStartEvent;
+  NWindows::NSynchronization::CAutoResetEvent WasFinishedEvent;
+  NCompress::NLzx::CDecoder *LzxDecoderSpec;
+  CMyComPtr<ICompressCoder> LzxDecoder;
+  CByteBuffer InBuf;
+  CByteBuffer OutBuf;
+  UInt32 InSize;
+  UInt32 OutSize;
+  bool IsStored;
+  bool Exit;
+  HRESULT Result;
+
+  CChunkDecoder(): LzxDecoderSpec(0), Exit(false) {}
+  HRes Create();
+  void Decode();
+  void ThreadFunc();
+};
+
+#endif
+
 class CUnpacker
 {
   NCompress::CCopyCoder *copyCoderSpec;
@@ -144,9 +176,26 @@ class CUnpacker
   CMyComPtr<ICompressCoder> lzxDecoder;
 
   CByteBuffer sizesBuf;
+
+  #ifdef COMPRESS_MT
+  UInt32 _numThreads;
+  CChunkDecoder *_decoders;
+  UInt32 _numDecoders;
+  HRESULT CreateDecoders();
+  void FreeDecoders();
+  HRESULT UnpackChunks(IInStream *inStream, UInt64 baseOffset, UInt64 packDataSize, 
+      UInt64 unpackSize, const Byte *sizes, unsigned entrySize, UInt32 numChunks, 
+      ISequentialOutStream *outStream, ICompressProgressInfo *progress);
+  #endif
+
   HRESULT Unpack(IInStream *inStream, const CResource &res, 
       ISequentialOutStream *outStream, ICompressProgressInfo *progress);
 public:
+  #ifdef COMPRESS_MT
+  CUnpacker(): _numThreads(1), _decoders(0), _numDecoders(0) {}
+  ~CUnpacker() { FreeDecoders(); }
+  void SetNumThreads(UInt32 numThreads) { _numThreads = numThreads; }
+  #endif
   HRESULT Unpack(IInStream *inStream, const CResource &res, 
       ISequentialOutStream *outStream, ICompressProgressInfo *progress, Byte *digest);
 };
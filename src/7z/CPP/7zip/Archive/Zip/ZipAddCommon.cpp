@@ -169,6 +169,9 @@ HRESULT CAddCommon::Compress(
               _options.Algo, 
               _options.NumPasses, 
               _options.NumFastBytes,
+              #ifdef COMPRESS_MT
+              _options.NumThreads,
+              #endif
               _options.NumMatchFinderCycles
             };
             PROPID propIDs[] = 
@@ -176,6 +179,9 @@ HRESULT CAddCommon::Compress(
               NCoderPropID::kAlgorithm,
               NCoderPropID::kNumPasses,
               NCoderPropID::kNumFastBytes,
+              #ifdef COMPRESS_MT
+              NCoderPropID::kNumThreads,
+              #endif
               NCoderPropID::kMatchFinderCycles
             };
             int numProps = sizeof(propIDs) / sizeof(propIDs[0]);
@@ -125,6 +125,53 @@ static void SetItemInfoFromCompressingResult(const CCompressingResult &compressi
 
 #ifdef COMPRESS_MT
 
+/*
+Items are compressed to memory blocks by pool of threads and they are 
+written to archive in order of updateItems, so central directory 
+keeps that order. 
+If there are no free memory blocks, thread writes the rest of item to 
+temp file (spill) instead of waiting for main thread. Spill files are 
+created in work folder of IArchiveUpdateCallbackMt, if it's supported.
+Big Deflate items (more than kMemPerThread) are not sent to pool. 
+Main thread compresses such item directly to archive, when the pool has 
+finished previous items, and Deflate encoder splits it to all threads.
+Each thread counts its items and busy time. These stats are sent to 
+IArchiveUpdateCallbackMt after update.
+*/
+
+static UInt64 GetMtTime()
+{
+  LARGE_INTEGER value;
+  if (::QueryPerformanceCounter(&value))
+    return value.QuadPart;
+  return ::GetTickCount();
+}
+
+static UInt64 GetMtFreq()
+{
+  LARGE_INTEGER value;
+  if (::QueryPerformanceFrequency(&value))
+    return value.QuadPart;
+  return 1000;
+}
+
+struct CMtThreadStat
+{
+  UInt32 NumItems;
+  UInt64 UnpackSize;
+  UInt64 PackSize;
+  UInt64 SpillSize;
+  UInt64 BusyTime;
+
+  CMtThreadStat(): NumItems(0), UnpackSize(0), PackSize(0), SpillSize(0), BusyTime(0) {}
+  void AddItem(const CCompressingResult &result)
+  {
+    NumItems++;
+    UnpackSize += result.UnpackSize;
+    PackSize += result.PackSize;
+  }
+};
+
 static THREAD_FUNC_DECL CoderThread(void *threadCoderInfo);
 
 struct CThreadInfo
@@ -152,6 +199,7 @@ struct CThreadInfo
 
   bool IsFree;
   UInt32 UpdateIndex;
+  CMtThreadStat Stat;
 
   CThreadInfo(const CCompressionMethodMode &options):
       ExitThread(false),
@@ -188,6 +236,7 @@ void CThreadInfo::WaitAndCode()
     CompressEvent.Lock();
     if (ExitThread)
       return;
+    UInt64 startTime = GetMtTime();
     Result = Coder.Compress(
         #ifdef EXTERNAL_CODECS
         _codecsInfo, _externalCodecs, 
@@ -195,6 +244,7 @@ void CThreadInfo::WaitAndCode()
         InStream, OutStream, Progress, CompressingResult);
     if (Result == S_OK && Progress)
       Result = Progress->SetRatioInfo(&CompressingResult.UnpackSize, &CompressingResult.PackSize);
+    Stat.BusyTime += GetMtTime() - startTime;
     CompressionCompletedEvent.Set();
   }
 }
@@ -219,11 +269,21 @@ public:
 struct CMemBlocks2: public CMemLockBlocks
 {
   CCompressingResult CompressingResult;
+  CSpillFile Spill;
   bool Defined;
   bool Skip;
-  CMemBlocks2(): Defined(false), Skip(false) {}
+  bool InMainThread;
+  CMemBlocks2(): Defined(false), Skip(false), InMainThread(false) {}
 };
 
+static HRESULT ReportMtStat(IArchiveUpdateCallbackMt *callback, Int32 threadIndex, 
+    const CMtThreadStat &stat, UInt64 totalTime, UInt64 freq)
+{
+  return callback->SetThreadStat(threadIndex, stat.NumItems, 
+      stat.UnpackSize, stat.PackSize, stat.SpillSize, 
+      (UInt32)(stat.BusyTime * 1000 / freq), (UInt32)(totalTime * 1000 / freq));
+}
+
 class CMemRefs
 {
 public:
@@ -549,6 +609,18 @@ static HRESULT Update2(
       if (numThreads <= 1)
         mtMode = false;
     }
+    else
+      options2.NumThreads = 1; // items are compressed in parallel threads already
+  }
+
+  // Deflate encoder can split one big item to all threads itself
+  bool bigItemsInMainThread = false;
+  if (mtMode)
+  {
+    Byte method = options->MethodSequence.Front();
+    bigItemsInMainThread = (
+        method == NFileHeader::NCompressionMethod::kDeflated ||
+        method == NFileHeader::NCompressionMethod::kDeflated64);
   }
 
   if (!mtMode)
@@ -570,6 +642,17 @@ static HRESULT Update2(
   CMtCompressProgressMixer mtCompressProgressMixer;
   mtCompressProgressMixer.Init(numThreads, mtProgressMixerSpec->RatioProgress); 
 
+  CMyComPtr<IArchiveUpdateCallbackMt> updateCallbackMt;
+  updateCallback->QueryInterface(IID_IArchiveUpdateCallbackMt, (void **)&updateCallbackMt);
+  CSysString spillDir;
+  if (updateCallbackMt)
+  {
+    CMyComBSTR workDir;
+    RINOK(updateCallbackMt->GetWorkDir(&workDir));
+    if (workDir != 0)
+      spillDir = GetSystemString((const wchar_t *)workDir);
+  }
+
   CMemBlockManagerMt memManager(kBlockSize);
   CMemRefs refs(&memManager);
 
@@ -580,7 +663,12 @@ static HRESULT Update2(
   {
     RINOK(memManager.AllocateSpaceAlways((size_t)numThreads * (kMemPerThread / kBlockSize)));
     for(i = 0; i < updateItems.Size(); i++)
+    {
       refs.Refs.Add(CMemBlocks2());
+      const CUpdateItem &updateItem = updateItems[i];
+      if (bigItemsInMainThread && updateItem.NewData && updateItem.Size >= kMemPerThread)
+        refs.Refs.Back().InMainThread = true;
+    }
 
     UInt32 i;
     for (i = 0; i < numThreads; i++)
@@ -596,6 +684,8 @@ static HRESULT Update2(
       RINOK(threadInfo.CreateEvents());
       threadInfo.OutStreamSpec = new COutMemStream(&memManager);
       RINOK(threadInfo.OutStreamSpec->CreateEvents());
+      threadInfo.OutStreamSpec->AllowSpill(true);
+      threadInfo.OutStreamSpec->SetSpillDir(spillDir);
       threadInfo.OutStream = threadInfo.OutStreamSpec;
       threadInfo.IsFree = true;
       threadInfo.ProgressSpec = new CMtCompressProgress();
@@ -609,12 +699,17 @@ static HRESULT Update2(
   int itemIndex = 0;
   int lastRealStreamItemIndex = -1;
 
+  CMtThreadStat mainStat;
+  UInt64 startTime = GetMtTime();
+
   while (itemIndex < updateItems.Size())
   {
-    if ((UInt32)threadIndices.Size() < numThreads && mtItemIndex < updateItems.Size())
+    // pool doesn't go beyond big item until main thread has written it
+    if ((UInt32)threadIndices.Size() < numThreads && mtItemIndex < updateItems.Size() &&
+        !(refs.Refs[mtItemIndex].InMainThread && itemIndex <= mtItemIndex))
     {
       const CUpdateItem &updateItem = updateItems[mtItemIndex++];
-      if (!updateItem.NewData)
+      if (!updateItem.NewData || refs.Refs[mtItemIndex - 1].InMainThread)
         continue;
       CItemEx item;
       if (updateItem.NewProperties)
@@ -695,6 +790,40 @@ static HRESULT Update2(
       {
         WriteDirHeader(archive, options, updateItem, item);
       }
+      else if (refs.Refs[itemIndex].InMainThread)
+      {
+        // all previous items are written, so pool threads are free now
+        CMyComPtr<ISequentialInStream> fileInStream;
+        {
+          NWindows::NSynchronization::CCriticalSectionLock lock(mtProgressMixerSpec->Mixer2->CriticalSection);
+          HRESULT res = updateCallback->GetStream(updateItem.IndexInClient, &fileInStream);
+          if (res == S_FALSE)
+          {
+            complexity += updateItem.Size;
+            complexity += NFileHeader::kLocalBlockSize;
+            mtProgressMixerSpec->Mixer2->SetProgressOffset(complexity);
+            RINOK(updateCallback->SetOperationResult(NArchive::NUpdate::NOperationResult::kOK));
+            itemIndex++;
+            continue;
+          }
+          RINOK(res);
+          RINOK(updateCallback->SetOperationResult(NArchive::NUpdate::NOperationResult::kOK));
+        }
+        SetFileHeader(archive, *options, updateItem, item);
+        archive.PrepareWriteCompressedData((UInt16)item.Name.Length(), updateItem.Size, options->IsAesMode);
+        CCompressingResult compressingResult;
+        CMyComPtr<IOutStream> outStream;
+        archive.CreateStreamForCompressing(&outStream);
+        UInt64 itemStartTime = GetMtTime();
+        RINOK(compressor.Compress(
+            EXTERNAL_CODECS_LOC_VARS
+            fileInStream, outStream, progress, compressingResult));
+        mainStat.BusyTime += GetMtTime() - itemStartTime;
+        mainStat.AddItem(compressingResult);
+        complexity += updateItem.Size;
+        SetItemInfoFromCompressingResult(compressingResult, options->IsAesMode, options->AesKeyMode, item);
+        archive.WriteLocalHeader(item);
+      }
       else
       {
         if (lastRealStreamItemIndex < itemIndex)
@@ -711,6 +840,8 @@ static HRESULT Update2(
           CMyComPtr<IOutStream> outStream;
           archive.CreateStreamForCompressing(&outStream);
           memRef.WriteToStream(memManager.GetBlockSize(), outStream);
+          RINOK(memRef.Spill.WriteToStream(outStream));
+          memRef.Spill.Free();
           SetItemInfoFromCompressingResult(memRef.CompressingResult,
               options->IsAesMode, options->AesKeyMode, item);
           SetFileHeader(archive, *options, updateItem, item);
@@ -740,6 +871,8 @@ static HRESULT Update2(
           RINOK(threadInfo.Result);
           threadIndices.Delete(t);
           compressingCompletedEvents.Delete(t);
+          threadInfo.Stat.AddItem(threadInfo.CompressingResult);
+          threadInfo.Stat.SpillSize += threadInfo.OutStreamSpec->GetSpillSize();
           if (t == 0)
           {
             RINOK(threadInfo.OutStreamSpec->WriteToRealStream());
@@ -752,7 +885,7 @@ static HRESULT Update2(
           else
           {
             CMemBlocks2 &memRef = refs.Refs[threadInfo.UpdateIndex];
-            threadInfo.OutStreamSpec->DetachData(memRef);
+            threadInfo.OutStreamSpec->DetachData(memRef, memRef.Spill);
             memRef.CompressingResult = threadInfo.CompressingResult;
             memRef.Defined = true;
             continue;
@@ -770,6 +903,16 @@ static HRESULT Update2(
     itemIndex++;
   }
   archive.WriteCentralDir(items, comment);
+  if (updateCallbackMt)
+  {
+    UInt64 totalTime = GetMtTime() - startTime;
+    UInt64 freq = GetMtFreq();
+    for (int t = 0; t < threads.Threads.Size(); t++)
+    {
+      RINOK(ReportMtStat(updateCallbackMt, t, threads.Threads[t].Stat, totalTime, freq));
+    }
+    RINOK(ReportMtStat(updateCallbackMt, -1, mainStat, totalTime, freq));
+  }
   return S_OK;
   #endif  
 }
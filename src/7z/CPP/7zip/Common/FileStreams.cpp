@@ -6,6 +6,9 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #endif
 
 #include "FileStreams.h"
@@ -24,9 +27,51 @@ static inline HRESULT ConvertBoolToHRESULT(bool result)
   #endif
 }
 
+#ifndef USE_WIN_FILE
+
+// Mapping cost grows with the size of file, while the number of Read / Seek calls 
+// for archive headers doesn't, so big files are read without mapping.
+static const UInt64 kMapSizeMax = (1 << 24);
+
+void CInFileStream::MapFile()
+{
+  UnmapFile();
+  if (!UseMap)
+    return;
+  struct stat st;
+  if (fstat(File.GetHandle(), &st) != 0 || !S_ISREG(st.st_mode))
+    return;
+  if (st.st_size <= 0 || (UInt64)st.st_size > kMapSizeMax)
+    return;
+  void *p = mmap(0, (size_t)st.st_size, PROT_READ, MAP_SHARED, File.GetHandle(), 0);
+  if (p == MAP_FAILED)
+    return;
+  _map = (const Byte *)p;
+  _mapSize = (UInt64)st.st_size;
+  _mapPos = 0;
+}
+
+void CInFileStream::UnmapFile()
+{
+  if (_map == 0)
+    return;
+  munmap((void *)_map, (size_t)_mapSize);
+  _map = 0;
+}
+
+#endif
+
 bool CInFileStream::Open(LPCTSTR fileName)
 {
+  #ifdef USE_WIN_FILE
   return File.Open(fileName);
+  #else
+  UnmapFile();
+  if (!File.Open(fileName))
+    return false;
+  MapFile();
+  return true;
+  #endif
 }
 
 #ifdef USE_WIN_FILE
@@ -40,7 +85,16 @@ bool CInFileStream::Open(LPCWSTR fileName)
 
 bool CInFileStream::OpenShared(LPCTSTR fileName, bool shareForWrite)
 {
+  #ifdef USE_WIN_FILE
   return File.OpenShared(fileName, shareForWrite);
+  #else
+  UnmapFile();
+  if (!File.OpenShared(fileName, shareForWrite))
+    return false;
+  if (!shareForWrite)
+    MapFile();
+  return true;
+  #endif
 }
 
 #ifdef USE_WIN_FILE
@@ -64,6 +118,18 @@ STDMETHODIMP CInFileStream::Read(void *data, UInt32 size, UInt32 *processedSize)
   
   #else
   
+  if (_map != 0)
+  {
+    UInt64 rem = (_mapPos < _mapSize) ? _mapSize - _mapPos : 0;
+    if (size > rem)
+      size = (UInt32)rem;
+    memcpy(data, _map + (size_t)_mapPos, size);
+    _mapPos += size;
+    if(processedSize != NULL)
+      *processedSize = size;
+    return S_OK;
+  }
+
   if(processedSize != NULL)
     *processedSize = 0;
   ssize_t res = File.Read(data, (size_t)size);
@@ -126,6 +192,25 @@ STDMETHODIMP CInFileStream::Seek(Int64 offset, UInt32 seekOrigin,
   
   #else
   
+  if (_map != 0)
+  {
+    Int64 pos;
+    switch(seekOrigin)
+    {
+      case STREAM_SEEK_SET: pos = 0; break;
+      case STREAM_SEEK_CUR: pos = (Int64)_mapPos; break;
+      case STREAM_SEEK_END: pos = (Int64)_mapSize; break;
+      default: return STG_E_INVALIDFUNCTION;
+    }
+    pos += offset;
+    if (pos < 0)
+      return E_FAIL;
+    _mapPos = (UInt64)pos;
+    if(newPosition != NULL)
+      *newPosition = _mapPos;
+    return S_OK;
+  }
+
   off_t res = File.Seek(offset, seekOrigin);
   if (res == -1)
     return E_FAIL;
@@ -138,6 +223,13 @@ STDMETHODIMP CInFileStream::Seek(Int64 offset, UInt32 seekOrigin,
 
 STDMETHODIMP CInFileStream::GetSize(UInt64 *size)
 {
+  #ifndef USE_WIN_FILE
+  if (_map != 0)
+  {
+    *size = _mapSize;
+    return S_OK;
+  }
+  #endif
   return ConvertBoolToHRESULT(File.GetLength(*size));
 }
 
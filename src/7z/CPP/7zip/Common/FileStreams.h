@@ -21,14 +21,34 @@ class CInFileStream:
   public IStreamGetSize,
   public CMyUnknownImp
 {
+  #ifndef USE_WIN_FILE
+  const Byte *_map;
+  UInt64 _mapSize;
+  UInt64 _mapPos;
+  void MapFile();
+  void UnmapFile();
+  #endif
 public:
   #ifdef USE_WIN_FILE
   NWindows::NFile::NIO::CInFile File;
   #else
   NC::NFile::NIO::CInFile File;
+
+  /* If UseMap is set before Open, a regular file that is not larger than 
+     kMapSizeMax is mapped to memory, so Read and Seek don't call the kernel. 
+     The file must not be truncated by other processes while it's mapped, 
+     so it's used only for archives, and OpenShared(, true) doesn't map. */
+  bool UseMap;
+  bool IsMapped() const { return _map != 0; }
   #endif
+
+  #ifdef USE_WIN_FILE
   CInFileStream() {}
   virtual ~CInFileStream() {}
+  #else
+  CInFileStream(): _map(0), UseMap(false) {}
+  virtual ~CInFileStream() { UnmapFile(); }
+  #endif
 
   bool Open(LPCTSTR fileName);
   #ifdef USE_WIN_FILE
@@ -36,6 +36,8 @@ public:
   
   UInt64 GetProcessedSize() const 
     { return m_Stream.GetProcessedSize() - (kNumBigValueBits - m_BitPos) / 8; }
+  UInt64 GetProcessedBitsSize() const 
+    { return (m_Stream.GetProcessedSize() << 3) - (kNumBigValueBits - m_BitPos); }
   UInt32 GetBitPosition() const { return (m_BitPos & 7); }
   
   void Normalize()
@@ -2,12 +2,72 @@
 
 #include "StdAfx.h"
 
+#include "Common/Buffer.h"
+#include "Windows/FileDir.h"
+
 #include "OutMemStream.h"
+#include "StreamUtils.h"
+
+static LPCTSTR kSpillFilePrefix = TEXT("7zs");
+
+static inline HRESULT GetLastErrorResult()
+{
+  DWORD lastError = ::GetLastError();
+  if (lastError == 0)
+    return E_FAIL;
+  return lastError;
+}
+
+void CSpillFile::Free()
+{
+  if (IsDefined())
+    NWindows::NFile::NDirectory::DeleteFileAlways(Path);
+  Path.Empty();
+  Size = 0;
+}
+
+void CSpillFile::Detach(CSpillFile &dest)
+{
+  dest.Free();
+  dest.Path = Path;
+  dest.Size = Size;
+  Path.Empty();
+  Size = 0;
+}
+
+HRESULT CSpillFile::WriteToStream(ISequentialOutStream *outStream) const
+{
+  if (Size == 0)
+    return S_OK;
+  NWindows::NFile::NIO::CInFile file;
+  if (!file.Open(Path))
+    return GetLastErrorResult();
+  const UInt32 kBufSize = (1 << 16);
+  CByteBuffer buffer;
+  buffer.SetCapacity(kBufSize);
+  UInt64 rem = Size;
+  while (rem != 0)
+  {
+    UInt32 curSize = (rem < kBufSize) ? (UInt32)rem : kBufSize;
+    UInt32 processedSize;
+    if (!file.Read(buffer, curSize, processedSize))
+      return GetLastErrorResult();
+    if (processedSize != curSize)
+      return E_FAIL;
+    RINOK(WriteStream(outStream, buffer, curSize, NULL));
+    rem -= curSize;
+  }
+  return S_OK;
+}
 
 void COutMemStream::Free()
 {
   Blocks.Free(_memManager);
   Blocks.LockMode = true;
+  SpillFile.Close();
+  Spill.Free();
+  _spillMode = false;
+  _spillPos = 0;
 }
 
 void COutMemStream::Init()
@@ -26,11 +86,55 @@ void COutMemStream::DetachData(CMemLockBlocks &blocks)
   Free();
 }
 
+void COutMemStream::DetachData(CMemLockBlocks &blocks, CSpillFile &spill)
+{
+  Blocks.Detach(blocks, _memManager);
+  SpillFile.Close();
+  Spill.Detach(spill);
+  Free();
+}
+
 
 HRESULT COutMemStream::WriteToRealStream()
 {
   RINOK(Blocks.WriteToStream(_memManager->GetBlockSize(), OutSeqStream));
   Blocks.Free(_memManager);
+  if (Spill.IsDefined())
+  {
+    SpillFile.Close();
+    RINOK(Spill.WriteToStream(OutSeqStream));
+    Spill.Free();
+    _spillMode = false;
+    _spillPos = 0;
+  }
+  return S_OK;
+}
+
+HRESULT COutMemStream::WriteToSpill(const void *data, UInt32 size, UInt32 *processedSize)
+{
+  if (!Spill.IsDefined())
+  {
+    CSysString tempDir = _spillDir;
+    if (tempDir.IsEmpty())
+      if (!NWindows::NFile::NDirectory::MyGetTempPath(tempDir))
+        return GetLastErrorResult();
+    if (NWindows::NFile::NDirectory::MyGetTempFileName(tempDir, kSpillFilePrefix, Spill.Path) == 0)
+    {
+      Spill.Path.Empty();
+      return GetLastErrorResult();
+    }
+    if (!SpillFile.Create(Spill.Path, true))
+      return GetLastErrorResult();
+  }
+  _spillMode = true;
+  UInt32 processedSize2;
+  if (!SpillFile.Write(data, size, processedSize2))
+    return GetLastErrorResult();
+  if (processedSize != 0)
+    *processedSize += processedSize2;
+  _spillPos += processedSize2;
+  if (_spillPos > Spill.Size)
+    Spill.Size = _spillPos;
   return S_OK;
 }
 
@@ -42,7 +146,7 @@ STDMETHODIMP COutMemStream::Write(const void *data, UInt32 size, UInt32 *process
     *processedSize = 0;
   while(size != 0)
   {
-    if ((int)_curBlockIndex < Blocks.Blocks.Size())
+    if (!_spillMode && (int)_curBlockIndex < Blocks.Blocks.Size())
     {
       Byte *p = (Byte *)Blocks.Blocks[(int)_curBlockIndex] + _curBlockPos;
       size_t curSize = _memManager->GetBlockSize() - _curBlockPos;
@@ -66,7 +170,10 @@ STDMETHODIMP COutMemStream::Write(const void *data, UInt32 size, UInt32 *process
       continue;
     }
     HANDLE events[3] = { StopWritingEvent, WriteToRealStreamEvent, /* NoLockEvent, */ _memManager->Semaphore };
-    DWORD waitResult = ::WaitForMultipleObjects((Blocks.LockMode ? 3 : 2), events, FALSE, INFINITE);
+    // in spill mode new blocks are not allocated: the tail of stream is in temp file
+    DWORD numEvents = ((Blocks.LockMode && !_spillMode) ? 3 : 2);
+    DWORD waitResult = ::WaitForMultipleObjects(numEvents, events, FALSE, 
+        (_spillIsAllowed ? 0 : INFINITE));
     switch (waitResult)
     {
       case (WAIT_OBJECT_0 + 0):
@@ -92,6 +199,8 @@ STDMETHODIMP COutMemStream::Write(const void *data, UInt32 size, UInt32 *process
       */
       case (WAIT_OBJECT_0 + 2):
         break;
+      case WAIT_TIMEOUT:
+        return WriteToSpill(data, size, processedSize);
       default:
         return E_FAIL;
     }
@@ -121,6 +230,14 @@ STDMETHODIMP COutMemStream::Seek(Int64 offset, UInt32 seekOrigin, UInt64 *newPos
       return E_NOTIMPL;
     _curBlockIndex = 0;
     _curBlockPos = 0;
+    if (_spillMode)
+    {
+      UInt64 pos;
+      if (!SpillFile.Seek(0, pos))
+        return GetLastErrorResult();
+      _spillMode = false;
+      _spillPos = 0;
+    }
   }
   else
     return E_NOTIMPL;
@@ -137,6 +254,17 @@ STDMETHODIMP COutMemStream::SetSize(Int64 newSize)
       return E_FAIL;
     return OutStream->SetSize(newSize);
   }
+  if (Spill.IsDefined())
+  {
+    UInt64 memSize = (UInt64)Blocks.Blocks.Size() * _memManager->GetBlockSize();
+    if ((UInt64)newSize > memSize)
+    {
+      Blocks.TotalSize = memSize;
+      Spill.Size = newSize - memSize;
+      return S_OK;
+    }
+    Spill.Size = 0;
+  }
   Blocks.TotalSize = newSize;
   return S_OK;
 }
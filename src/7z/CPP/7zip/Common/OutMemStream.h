@@ -4,8 +4,25 @@
 #define __OUTMEMSTREAM_H
 
 #include "Common/MyCom.h"
+#include "Common/MyString.h"
+#include "Windows/FileIO.h"
 #include "MemBlocks.h"
 
+// Temp file that keeps the tail of stream that didn't fit to memory blocks
+
+struct CSpillFile
+{
+  CSysString Path;
+  UInt64 Size;
+
+  CSpillFile(): Size(0) {}
+  ~CSpillFile() { Free(); }
+  bool IsDefined() const { return !Path.IsEmpty(); }
+  void Free();
+  void Detach(CSpillFile &dest);
+  HRESULT WriteToStream(ISequentialOutStream *outStream) const;
+};
+
 class COutMemStream:
   public IOutStream,
   public CMyUnknownImp
@@ -15,6 +32,13 @@ class COutMemStream:
   size_t _curBlockPos;
   bool _realStreamMode;
 
+  bool _spillIsAllowed;
+  bool _spillMode;
+  UInt64 _spillPos;
+  CSysString _spillDir;
+  CSpillFile Spill;
+  NWindows::NFile::NIO::COutFile SpillFile;
+
   bool _unlockEventWasSent;
   NWindows::NSynchronization::CAutoResetEvent StopWritingEvent;
   NWindows::NSynchronization::CAutoResetEvent WriteToRealStreamEvent;
@@ -23,7 +47,8 @@ class COutMemStream:
   HRESULT StopWriteResult;
   CMemLockBlocks Blocks;
 
-  UInt64 GetPos() const { return (UInt64)_curBlockIndex * _memManager->GetBlockSize() + _curBlockPos; }
+  UInt64 GetPos() const { return (UInt64)_curBlockIndex * _memManager->GetBlockSize() + _curBlockPos + _spillPos; }
+  HRESULT WriteToSpill(const void *data, UInt32 size, UInt32 *processedSize);
 
   CMyComPtr<ISequentialOutStream> OutSeqStream;
   CMyComPtr<IOutStream> OutStream;
@@ -54,7 +79,14 @@ public:
     OutSeqStream.Release();
   }
 
-  COutMemStream(CMemBlockManagerMt *memManager): _memManager(memManager)  { }
+  COutMemStream(CMemBlockManagerMt *memManager): _memManager(memManager),
+      _spillIsAllowed(false), _spillMode(false), _spillPos(0) { }
+
+  // If spill is allowed, Write doesn't wait for free memory block. 
+  // It writes the rest of stream to temp file instead.
+  void AllowSpill(bool allow) { _spillIsAllowed = allow; }
+  // Folder for temp file. Empty string means default temp folder.
+  void SetSpillDir(const CSysString &dir) { _spillDir = dir; }
 
   ~COutMemStream() { Free(); }
   void Free();
@@ -63,6 +95,8 @@ public:
   HRESULT WriteToRealStream();
 
   void DetachData(CMemLockBlocks &blocks);
+  void DetachData(CMemLockBlocks &blocks, CSpillFile &spill);
+  UInt64 GetSpillSize() const { return Spill.Size; }
 
   bool WasUnlockEventSent() const { return _unlockEventWasSent; }
 
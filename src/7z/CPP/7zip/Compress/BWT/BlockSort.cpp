@@ -22,6 +22,261 @@ extern "C"
 #endif
 #endif
 
+#ifndef BLOCK_SORT_PREFIX_DOUBLING
+
+/*
+BlockSort with induced sorting (SA-IS, Nong, Zhang, Chan, 2009).
+Its time is linear for any data, including long runs and periodic data,
+where prefix doubling sorter needs many passes.
+
+BWT needs the order of cyclic rotations of block, but SA-IS sorts suffixes.
+If block is rotated to its smallest rotation, it's u^k, where u is Lyndon word.
+And the order of rotations of Lyndon word is the same as the order of its suffixes.
+So we sort the suffixes of u and write (k) equal rotations for each suffix.
+*/
+
+static const UInt32 kEmpty = 0xFFFFFFFF;
+
+#define SA_IS_SET_TYPE(t, i) (t)[(i) >> 5] |= ((UInt32)1 << ((i) & 31))
+#define SA_IS_S_TYPE(t, i) (((t)[(i) >> 5] >> ((i) & 31)) & 1)
+#define SA_IS_LMS(t, i) ((i) > 0 && SA_IS_S_TYPE(t, i) && !SA_IS_S_TYPE(t, (i) - 1))
+
+template <class TChar>
+static void SaIsGetTypes(const TChar *s, UInt32 n, UInt32 *types)
+{
+  UInt32 i;
+  for (i = 0; i < ((n + 31) >> 5); i++)
+    types[i] = 0;
+  // the last suffix is L-type, since it's larger than virtual sentinel
+  bool sType = false;
+  for (i = n - 1; i > 0; i--)
+  {
+    TChar c0 = s[i - 1];
+    TChar c1 = s[i];
+    if (c0 < c1 || (c0 == c1 && sType))
+    {
+      SA_IS_SET_TYPE(types, i - 1);
+      sType = true;
+    }
+    else
+      sType = false;
+  }
+}
+
+template <class TChar>
+static void SaIsGetBuckets(const TChar *s, UInt32 n, UInt32 k, UInt32 *buckets, bool end)
+{
+  UInt32 i;
+  for (i = 0; i < k; i++)
+    buckets[i] = 0;
+  for (i = 0; i < n; i++)
+    buckets[s[i]]++;
+  UInt32 sum = 0;
+  for (i = 0; i < k; i++)
+  {
+    sum += buckets[i];
+    buckets[i] = end ? sum : sum - buckets[i];
+  }
+}
+
+template <class TChar>
+static void SaIsInduce(const TChar *s, UInt32 *SA, UInt32 n, UInt32 k, UInt32 *buckets, const UInt32 *types)
+{
+  UInt32 i;
+  SaIsGetBuckets(s, n, k, buckets, false);
+  // suffix of virtual sentinel is first
+  SA[buckets[s[n - 1]]++] = n - 1;
+  for (i = 0; i < n; i++)
+  {
+    UInt32 j = SA[i];
+    if (j != kEmpty && j != 0 && !SA_IS_S_TYPE(types, j - 1))
+      SA[buckets[s[j - 1]]++] = j - 1;
+  }
+  SaIsGetBuckets(s, n, k, buckets, true);
+  for (i = n; i != 0;)
+  {
+    UInt32 j = SA[--i];
+    if (j != kEmpty && j != 0 && SA_IS_S_TYPE(types, j - 1))
+      SA[--buckets[s[j - 1]]] = j - 1;
+  }
+}
+
+/*
+SA must have space for n items.
+buckets must have space for max(k, n / 2) items.
+types must have space for (n + 31) / 32 items.
+*/
+
+template <class TChar>
+static void SaIs(const TChar *s, UInt32 *SA, UInt32 n, UInt32 k, UInt32 *buckets, UInt32 *types)
+{
+  UInt32 i;
+  if (n == 1)
+  {
+    SA[0] = 0;
+    return;
+  }
+  SaIsGetTypes(s, n, types);
+
+  // Stage 1: sort LMS-substrings
+  for (i = 0; i < n; i++)
+    SA[i] = kEmpty;
+  SaIsGetBuckets(s, n, k, buckets, true);
+  for (i = 1; i < n; i++)
+    if (SA_IS_LMS(types, i))
+      SA[--buckets[s[i]]] = i;
+  SaIsInduce(s, SA, n, k, buckets, types);
+
+  // move sorted LMS-substrings to the start of SA
+  UInt32 n1 = 0;
+  for (i = 0; i < n; i++)
+    if (SA_IS_LMS(types, SA[i]))
+      SA[n1++] = SA[i];
+
+  // name LMS-substrings. Last LMS-substring contains virtual sentinel, 
+  // so it's not equal to any other LMS-substring.
+  for (i = n1; i < n; i++)
+    SA[i] = kEmpty;
+  UInt32 name = 0;
+  UInt32 prev = kEmpty;
+  for (i = 0; i < n1; i++)
+  {
+    UInt32 pos = SA[i];
+    bool diff = true;
+    if (prev != kEmpty)
+      for (UInt32 d = 0; ; d++)
+      {
+        if (pos + d == n || prev + d == n || 
+            s[pos + d] != s[prev + d] || 
+            SA_IS_S_TYPE(types, pos + d) != SA_IS_S_TYPE(types, prev + d))
+          break;
+        if (d > 0 && (SA_IS_LMS(types, pos + d) || SA_IS_LMS(types, prev + d)))
+        {
+          diff = !(SA_IS_LMS(types, pos + d) && SA_IS_LMS(types, prev + d));
+          break;
+        }
+      }
+    if (diff)
+    {
+      name++;
+      prev = pos;
+    }
+    SA[n1 + (pos >> 1)] = name - 1;
+  }
+  UInt32 *s1 = SA + n - n1;
+  {
+    UInt32 j = n;
+    for (i = n; i > n1;)
+      if (SA[--i] != kEmpty)
+        SA[--j] = SA[i];
+  }
+
+  // Stage 2: sort suffixes of reduced string
+  UInt32 *SA1 = SA;
+  if (name < n1)
+    SaIs(s1, SA1, n1, name, buckets, types);
+  else
+    for (i = 0; i < n1; i++)
+      SA1[s1[i]] = i;
+
+  // Stage 3: induce suffix array from sorted LMS-suffixes
+  SaIsGetTypes(s, n, types);
+  {
+    UInt32 j = 0;
+    for (i = 1; i < n; i++)
+      if (SA_IS_LMS(types, i))
+        s1[j++] = i;
+  }
+  for (i = 0; i < n1; i++)
+    SA1[i] = s1[SA1[i]];
+  for (i = n1; i < n; i++)
+    SA[i] = kEmpty;
+  SaIsGetBuckets(s, n, k, buckets, true);
+  for (i = n1; i != 0;)
+  {
+    UInt32 j = SA[--i];
+    SA[i] = kEmpty;
+    SA[--buckets[s[j]]] = j;
+  }
+  SaIsInduce(s, SA, n, k, buckets, types);
+}
+
+// conditions: blockSize > 0
+UInt32 BlockSort(UInt32 *Indices, const Byte *data, UInt32 blockSize)
+{
+  // find the smallest rotation (r) of data
+  UInt32 r;
+  {
+    UInt32 i = 0, j = 1, k = 0;
+    while (i < blockSize && j < blockSize && k < blockSize)
+    {
+      UInt32 a = i + k; if (a >= blockSize) a -= blockSize;
+      UInt32 b = j + k; if (b >= blockSize) b -= blockSize;
+      if (data[a] == data[b])
+      {
+        k++;
+        continue;
+      }
+      if (data[a] > data[b])
+        i += k + 1;
+      else
+        j += k + 1;
+      if (i == j)
+        j++;
+      k = 0;
+    }
+    r = (i < j) ? i : j;
+  }
+
+  // work buffers after Indices: rotated data, types, buckets
+  Byte *u = (Byte *)(Indices + blockSize);
+  UInt32 *types = Indices + blockSize + ((blockSize + 3) >> 2);
+  UInt32 *buckets = types + ((blockSize + 31) >> 5);
+  {
+    UInt32 i;
+    for (i = 0; i < blockSize - r; i++)
+      u[i] = data[r + i];
+    for (; i < blockSize; i++)
+      u[i] = data[i - (blockSize - r)];
+  }
+
+  // rotated data is u^k. We get length of Lyndon word u (period) with Duval's method.
+  UInt32 period;
+  {
+    UInt32 i = 0, j;
+    for (j = 1; j < blockSize && u[i] <= u[j]; j++)
+      if (u[i] < u[j])
+        i = 0;
+      else
+        i++;
+    period = j - i;
+    if (blockSize % period != 0)
+      period = blockSize;
+  }
+
+  UInt32 *SA = Indices + blockSize - period;
+  SaIs(u, SA, period, 256, buckets, types);
+
+  UInt32 origPtr = 0;
+  UInt32 pos = 0;
+  for (UInt32 i = 0; i < period; i++)
+  {
+    UInt32 p = SA[i] + r;
+    for (UInt32 j = 0; j < blockSize; j += period)
+    {
+      UInt32 t = p + j;
+      if (t >= blockSize)
+        t -= blockSize;
+      if (t == 0)
+        origPtr = pos;
+      Indices[pos++] = t;
+    }
+  }
+  return origPtr;
+}
+
+#else
+
 // Don't change it !!
 static const int kNumHashBytes = 2;
 static const UInt32 kNumHashValues = 1 << (kNumHashBytes * 8);
@@ -484,3 +739,4 @@ UInt32 BlockSort(UInt32 *Indices, const Byte *data, UInt32 blockSize)
   return Groups[0];
 }
 
+#endif
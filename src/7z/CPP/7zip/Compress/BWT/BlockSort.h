@@ -5,7 +5,10 @@
 
 #include "Common/Types.h"
 
-// use BLOCK_SORT_EXTERNAL_FLAGS if blockSize can be > 1M
+// BlockSort uses induced sorting (SA-IS) by default.
+// Define BLOCK_SORT_PREFIX_DOUBLING to use old radix / prefix doubling sorter.
+
+// use BLOCK_SORT_EXTERNAL_FLAGS if blockSize can be > 1M (prefix doubling sorter only)
 // #define BLOCK_SORT_EXTERNAL_FLAGS
 
 #ifdef BLOCK_SORT_EXTERNAL_FLAGS
@@ -16,7 +16,7 @@ extern "C"
 namespace NCompress {
 namespace NBZip2 {
 
-const UInt32 kNumThreadsMax = 4;
+const UInt32 kNumThreadsMax = 16;
 
 static const UInt32 kBufferSize = (1 << 17);
 
@@ -75,10 +75,30 @@ static Int16 kRandNums[512] = {
    936, 638
 };
 
+#ifdef COMPRESS_BZIP2_MT
+
+// Block data can't be larger than (kBlockSizeMax + 1) codes of kMaxHuffmanLen bits 
+// plus the tables.
+static const UInt32 kPackBufSize = (kBlockSizeMax / 8 + 1) * kMaxHuffmanLen + (1 << 16);
+
+static const UInt64 kSigMask = ((UInt64)1 << 48) - 1;
+static const UInt64 kBlockSig = ((UInt64)0x3141 << 32) | 0x59265359;
+static const UInt64 kFinSig = ((UInt64)0x1772 << 32) | 0x45385090;
+
+#endif
+
 bool CState::Alloc()
 {
   if (Counters == 0)
     Counters = (UInt32 *)BigAlloc((256 + kBlockSizeMax) * sizeof(UInt32));
+  #ifdef COMPRESS_BZIP2_MT
+  if (Decoder->MtMode && PackBuf == 0)
+  {
+    PackBuf = (Byte *)BigAlloc(kPackBufSize);
+    if (PackBuf == 0)
+      return false;
+  }
+  #endif
   return (Counters != 0);
 }
 
@@ -86,6 +106,10 @@ void CState::Free()
 {
   ::BigFree(Counters);
   Counters = 0;
+  #ifdef COMPRESS_BZIP2_MT
+  ::BigFree(PackBuf);
+  PackBuf = 0;
+  #endif
 }
 
 UInt32 CDecoder::ReadBits(int numBits) {  return m_InStream.ReadBits(numBits); }
@@ -103,17 +127,20 @@ UInt32 CDecoder::ReadCRC()
   return crc;
 }
 
-UInt32 NO_INLINE ReadBits(NStream::NMSBF::CDecoder<CInBuffer> *m_InStream, int num)
+template <class TInByte>
+UInt32 NO_INLINE ReadBits(NStream::NMSBF::CDecoder<TInByte> *m_InStream, int num)
 {
   return m_InStream->ReadBits(num);
 }
 
-UInt32 NO_INLINE ReadBit(NStream::NMSBF::CDecoder<CInBuffer> *m_InStream)
+template <class TInByte>
+UInt32 NO_INLINE ReadBit(NStream::NMSBF::CDecoder<TInByte> *m_InStream)
 {
   return m_InStream->ReadBits(1);
 }
 
-static HRESULT NO_INLINE ReadBlock(NStream::NMSBF::CDecoder<CInBuffer> *m_InStream, 
+template <class TInByte>
+static HRESULT NO_INLINE ReadBlock(NStream::NMSBF::CDecoder<TInByte> *m_InStream, 
   UInt32 *CharCounters, UInt32 blockSizeMax, Byte *m_Selectors, CHuffmanDecoder *m_HuffmanDecoders, 
   UInt32 *blockSizeRes, UInt32 *origPtrRes, bool *randRes)
 {
@@ -421,7 +448,8 @@ static UInt32 NO_INLINE DecodeBlock2Rand(const UInt32 *tt, UInt32 blockSize, UIn
 #ifdef COMPRESS_BZIP2_MT
 
 CDecoder::CDecoder():
-  m_States(0)
+  m_States(0),
+  MergeBuf(0)
 {
   m_NumThreadsPrev = 0;
   NumThreads = 1;
@@ -468,6 +496,8 @@ HRes CDecoder::Create()
 
 void CDecoder::Free()
 {
+  ::BigFree(MergeBuf);
+  MergeBuf = 0;
   if (!m_States)
     return;
   CloseThreads = true;
@@ -528,6 +558,12 @@ HRESULT CDecoder::DecodeFile(bool &isBZ, ICompressProgressInfo *progress)
     s.WaitingWasStartedEvent.Reset();
     s.CanWriteEvent.Reset();
   }
+  if (MtMode && MergeBuf == 0)
+  {
+    MergeBuf = (Byte *)BigAlloc(kPackBufSize);
+    if (MergeBuf == 0)
+      return E_OUTOFMEMORY;
+  }
   #else
   if (!m_States[0].Alloc())
     return E_OUTOFMEMORY;
@@ -552,6 +588,9 @@ HRESULT CDecoder::DecodeFile(bool &isBZ, ICompressProgressInfo *progress)
   if (MtMode)
   {
     NextBlockIndex = 0;
+    SigWasRead = false;
+    ScanCRC.Init();
+    MergeIsPending = false;
     StreamWasFinished1 = StreamWasFinished2 = false;
     CloseThreads = false;
     CanStartWaitingEvent.Reset();
@@ -569,6 +608,8 @@ HRESULT CDecoder::DecodeFile(bool &isBZ, ICompressProgressInfo *progress)
     CanStartWaitingEvent.Reset();
     RINOK(Result2);
     RINOK(Result1);
+    if (MergeIsPending || StreamCRC != CombinedCRC.GetDigest())
+      return S_FALSE;
   }
   else
   #endif
@@ -664,6 +705,232 @@ void CState::FinishStream()
   WaitingWasStartedEvent.Set();
 }
 
+/*
+ReadPackBlock reads the CRC of block and copies the data of block to state.PackBuf.
+The end of block data is located with bit-level search of next 48-bit 
+signature, so the decoding of block doesn't need critical section.
+The signature can be found also inside block data. Such block can't be 
+decoded, and MergePackBlock joins it with next block.
+End of stream signature found by search is only candidate. It's accepted, 
+if stream CRC after it matches CRC of scanned blocks, or if stream ends 
+after it. Otherwise search continues.
+*/
+
+bool CDecoder::IsAtStreamEnd()
+{
+  // MSBF decoder keeps next 4 bytes in m_Value.
+  if (m_InStream.m_Stream.WasFinished())
+    return true;
+  return m_InStream.GetValue(24) == 
+      (((UInt32)kArSig0 << 16) | ((UInt32)kArSig1 << 8) | kArSig2);
+}
+
+HRESULT CDecoder::ReadPackBlock(CState &state, bool &wasFinished)
+{
+  wasFinished = false;
+  if (!SigWasRead)
+  {
+    // signature of first block in stream is aligned to byte boundary
+    Byte s[6];
+    for (int i = 0; i < 6; i++)
+      s[i] = ReadByte();
+    UInt64 sig = 0;
+    for (int j = 0; j < 6; j++)
+      sig = (sig << 8) | s[j];
+    if (sig != kBlockSig && sig != kFinSig)
+      return S_FALSE;
+    FinSigWasRead = (sig == kFinSig);
+    PendingBits = 0;
+    NumPendingBits = 0;
+  }
+  else if (FinSigWasRead)
+  {
+    // stream CRC was read by search
+    SigWasRead = false;
+    wasFinished = true;
+    return S_OK;
+  }
+  SigWasRead = false;
+
+  UInt32 crc = PendingBits;
+  for (int numBits = 32 - NumPendingBits; numBits > 0;)
+  {
+    int curBits = (numBits > 16) ? 16 : numBits;
+    crc = (crc << curBits) | ReadBits(curBits);
+    numBits -= curBits;
+  }
+  if (FinSigWasRead)
+  {
+    StreamCRC = crc;
+    wasFinished = true;
+    return S_OK;
+  }
+  state.BlockCRC = crc;
+  ScanCRC.Update(crc);
+
+  Byte *buf = state.PackBuf;
+  UInt32 size = 0;
+  UInt32 numTailBytes = 0;
+  UInt64 value = 0;
+  
+  // bytes that were read after end of stream signature candidate
+  Byte ahead[4];
+  int numAhead = 0;
+  int aheadPos = 0;
+  
+  // last rejected candidate with zero padding. We use it, if there is no other end.
+  bool candIsDefined = false;
+  UInt32 candBits = 0;
+  UInt32 candCRC = 0;
+
+  for (;;)
+  {
+    Byte b;
+    if (aheadPos != numAhead)
+      b = ahead[aheadPos++];
+    else
+    {
+      // MSBF decoder keeps up to 4 bytes in m_Value, so we can stop soon after end of stream.
+      if (size == kPackBufSize || 
+          (m_InStream.m_Stream.WasFinished() && ++numTailBytes > 8))
+      {
+        if (!candIsDefined)
+          return S_FALSE;
+        state.PackBits = candBits;
+        StreamCRC = candCRC;
+        SigWasRead = true;
+        FinSigWasRead = true;
+        return S_OK;
+      }
+      b = ReadByte();
+    }
+    buf[size++] = b;
+    value = (value << 8) | b;
+    if (size < 7)
+      continue;
+    for (int k = 0; k < 8; k++)
+    {
+      UInt64 sig = (value >> k) & kSigMask;
+      if (sig == kBlockSig)
+      {
+        state.PackBits = (size << 3) - k - 48;
+        SigWasRead = true;
+        FinSigWasRead = false;
+        PendingBits = b & ((1 << k) - 1);
+        NumPendingBits = k;
+        // remaining bytes after rejected candidate are bits of block CRC
+        for (; aheadPos < numAhead; aheadPos++, NumPendingBits += 8)
+          PendingBits = (PendingBits << 8) | ahead[aheadPos];
+        return S_OK;
+      }
+      if (sig == kFinSig)
+      {
+        int i;
+        for (i = 0; aheadPos + i < numAhead; i++)
+          ahead[i] = ahead[aheadPos + i];
+        for (numAhead = i, aheadPos = 0; numAhead < 4; numAhead++)
+          ahead[numAhead] = ReadByte();
+        UInt32 next = 0;
+        for (i = 0; i < 4; i++)
+          next = (next << 8) | ahead[i];
+        UInt32 streamCRC = next;
+        if (k != 0)
+          streamCRC = ((UInt32)(b & ((1 << k) - 1)) << (32 - k)) | (next >> k);
+        bool padIsZero = ((next & ((1 << k) - 1)) == 0);
+        if (streamCRC == ScanCRC.GetDigest() || (padIsZero && IsAtStreamEnd()))
+        {
+          state.PackBits = (size << 3) - k - 48;
+          StreamCRC = streamCRC;
+          SigWasRead = true;
+          FinSigWasRead = true;
+          return S_OK;
+        }
+        if (padIsZero)
+        {
+          candIsDefined = true;
+          candBits = (size << 3) - k - 48;
+          candCRC = streamCRC;
+        }
+      }
+    }
+  }
+}
+
+HRESULT CState::DecodePackBlock(const Byte *data, UInt32 numBits, 
+    UInt32 *blockSize, UInt32 *origPtr, bool *randMode)
+{
+  PackStream.m_Stream.SetBuffer(data, (numBits + 7) >> 3);
+  PackStream.Init();
+  RINOK(ReadBlock(&PackStream, Counters, Decoder->BlockSizeMax, 
+      Selectors, HuffmanDecoders, blockSize, origPtr, randMode));
+  if (PackStream.GetProcessedBitsSize() != numBits)
+    return S_FALSE;
+  DecodeBlock1(Counters, *blockSize);
+  return S_OK;
+}
+
+static UInt32 WriteBits(Byte *buf, UInt32 pos, UInt32 value, int numBits)
+{
+  while (numBits > 0)
+  {
+    int bitPos = (int)(pos & 7);
+    int curBits = 8 - bitPos;
+    if (curBits > numBits)
+      curBits = numBits;
+    numBits -= curBits;
+    Byte b = (Byte)((value >> numBits) & ((1 << curBits) - 1));
+    if (bitPos == 0)
+      buf[pos >> 3] = 0;
+    buf[pos >> 3] |= (Byte)(b << (8 - bitPos - curBits));
+    pos += curBits;
+  }
+  return pos;
+}
+
+// It's called in order of blocks, when state has CanWriteEvent.
+
+HRESULT CDecoder::MergePackBlock(CState &state, bool &blockIsOk, 
+    UInt32 *blockSize, UInt32 *origPtr, bool *randMode)
+{
+  if (!MergeIsPending)
+  {
+    if (blockIsOk)
+      return S_OK;
+    memcpy(MergeBuf, state.PackBuf, (state.PackBits + 7) >> 3);
+    MergeBits = state.PackBits;
+    MergeCRC = state.BlockCRC;
+    MergeIsPending = true;
+    return S_OK;
+  }
+  
+  // previous block is broken, if this block can be decoded alone
+  if (blockIsOk)
+    return S_FALSE;
+  if (state.PackBits + 48 + 32 > (kPackBufSize << 3) - MergeBits)
+    return S_FALSE;
+  
+  UInt32 pos = MergeBits;
+  pos = WriteBits(MergeBuf, pos, (UInt32)(kBlockSig >> 24), 24);
+  pos = WriteBits(MergeBuf, pos, (UInt32)kBlockSig & 0xFFFFFF, 24);
+  pos = WriteBits(MergeBuf, pos, state.BlockCRC >> 16, 16);
+  pos = WriteBits(MergeBuf, pos, state.BlockCRC & 0xFFFF, 16);
+  const Byte *src = state.PackBuf;
+  UInt32 numBits;
+  for (numBits = state.PackBits; numBits >= 8; numBits -= 8)
+    pos = WriteBits(MergeBuf, pos, *src++, 8);
+  if (numBits != 0)
+    pos = WriteBits(MergeBuf, pos, *src >> (8 - numBits), numBits);
+  MergeBits = pos;
+
+  if (state.DecodePackBlock(MergeBuf, MergeBits, blockSize, origPtr, randMode) == S_OK)
+  {
+    state.BlockCRC = MergeCRC;
+    MergeIsPending = false;
+    blockIsOk = true;
+  }
+  return S_OK;
+}
+
 void CState::ThreadFunc()
 {
   for (;;)
@@ -687,15 +954,14 @@ void CState::ThreadFunc()
     if (nextBlockIndex == Decoder->NumThreads)
       nextBlockIndex = 0;
     Decoder->NextBlockIndex = nextBlockIndex;
-    UInt32 crc;
-    UInt64 packSize;
+    UInt64 packSize = 0;
     UInt32 blockSize = 0, origPtr = 0;
     bool randMode = false;
 
     try 
     {
       bool wasFinished;
-      res = Decoder->ReadSignatures(wasFinished, crc);
+      res = Decoder->ReadPackBlock(*this, wasFinished);
       if (res != S_OK)
       {
         Decoder->Result1 = res;
@@ -708,16 +974,6 @@ void CState::ThreadFunc()
         FinishStream();
         continue;
       }
-
-      res = ReadBlock(&Decoder->m_InStream, Counters, Decoder->BlockSizeMax, 
-          Decoder->m_Selectors, Decoder->m_HuffmanDecoders, 
-          &blockSize, &origPtr, &randMode);
-      if (res != S_OK)
-      {
-        Decoder->Result1 = res;
-        FinishStream();
-        continue;
-      }
       packSize = Decoder->m_InStream.GetProcessedSize();
     }
     catch(const CInBufferException &e) { res = e.ErrorCode;  if (res != S_OK) res = E_FAIL; }
@@ -731,7 +987,7 @@ void CState::ThreadFunc()
 
     Decoder->CS.Leave();
 
-    DecodeBlock1(Counters, blockSize);
+    bool blockIsOk = (DecodePackBlock(PackBuf, PackBits, &blockSize, &origPtr, &randMode) == S_OK);
 
     bool needFinish = true;
     try
@@ -740,18 +996,23 @@ void CState::ThreadFunc()
       needFinish = Decoder->StreamWasFinished2;
       if (!needFinish)
       {
-        if ((randMode ? 
-          DecodeBlock2Rand(Counters + 256, blockSize, origPtr, Decoder->m_OutStream) :
-          DecodeBlock2(Counters + 256, blockSize, origPtr, Decoder->m_OutStream)) == crc)
+        res = Decoder->MergePackBlock(*this, blockIsOk, &blockSize, &origPtr, &randMode);
+        if (res == S_OK && blockIsOk)
         {
-          if (Decoder->Progress)
+          if ((randMode ? 
+            DecodeBlock2Rand(Counters + 256, blockSize, origPtr, Decoder->m_OutStream) :
+            DecodeBlock2(Counters + 256, blockSize, origPtr, Decoder->m_OutStream)) == BlockCRC)
           {
-            UInt64 unpackSize = Decoder->m_OutStream.GetProcessedSize();
-            res = Decoder->Progress->SetRatioInfo(&packSize, &unpackSize);
+            Decoder->CombinedCRC.Update(BlockCRC);
+            if (Decoder->Progress)
+            {
+              UInt64 unpackSize = Decoder->m_OutStream.GetProcessedSize();
+              res = Decoder->Progress->SetRatioInfo(&packSize, &unpackSize);
+            }
           }
+          else
+            res = S_FALSE;
         }
-        else
-          res = S_FALSE;
       }
     }
     catch(const COutBufferException &e) { res = e.ErrorCode; if (res != S_OK) res = E_FAIL; }
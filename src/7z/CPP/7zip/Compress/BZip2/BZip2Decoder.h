@@ -32,6 +32,31 @@ typedef NCompress::NHuffman::CDecoder<kMaxHuffmanLen, kMaxAlphaSize> CHuffmanDec
 
 class CDecoder;
 
+#ifdef COMPRESS_BZIP2_MT
+
+// Bit source for block data that was copied to memory by block scanner.
+// Reading past the end returns 0xFF, like CInBuffer does.
+
+class CPackInBuffer
+{
+  const Byte *_buffer;
+  UInt32 _size;
+  UInt32 _pos;
+public:
+  void SetBuffer(const Byte *buffer, UInt32 size) { _buffer = buffer; _size = size; }
+  void Init() { _pos = 0; }
+  Byte ReadByte()
+  {
+    if (_pos < _size)
+      return _buffer[_pos++];
+    _pos++;
+    return 0xFF;
+  }
+  UInt64 GetProcessedSize() const { return _pos; }
+};
+
+#endif
+
 struct CState
 {
   UInt32 *Counters;
@@ -42,6 +67,14 @@ struct CState
   NWindows::CThread Thread;
   bool m_OptimizeNumTables;
 
+  // Block data (without signature and CRC) aligned to byte boundary
+  Byte *PackBuf;
+  UInt32 PackBits;
+  UInt32 BlockCRC;
+  NStream::NMSBF::CDecoder<CPackInBuffer> PackStream;
+  Byte Selectors[kNumSelectorsMax];
+  CHuffmanDecoder HuffmanDecoders[kNumTablesMax];
+
   NWindows::NSynchronization::CAutoResetEvent StreamWasFinishedEvent;
   NWindows::NSynchronization::CAutoResetEvent WaitingWasStartedEvent;
 
@@ -52,11 +85,17 @@ struct CState
 
   HRes Create();
   void FinishStream();
+  HRESULT DecodePackBlock(const Byte *data, UInt32 numBits, 
+      UInt32 *blockSize, UInt32 *origPtr, bool *randMode);
   void ThreadFunc();
 
   #endif
 
-  CState(): Counters(0) {}
+  CState(): Counters(0)
+    #ifdef COMPRESS_BZIP2_MT
+    , PackBuf(0)
+    #endif
+    {}
   ~CState() { Free(); }
   bool Alloc();
   void Free();
@@ -124,6 +163,29 @@ public:
   HRESULT Result2;
 
   UInt32 BlockSizeMax;
+
+  // Block scanner state: the signature of next block was already read,
+  // and NumPendingBits bits of its CRC are in PendingBits.
+  bool SigWasRead;
+  bool FinSigWasRead;
+  UInt32 PendingBits;
+  int NumPendingBits;
+  UInt32 StreamCRC;
+  // CRC of blocks found by block scanner. It's used to confirm end of stream signature.
+  CBZip2CombinedCRC ScanCRC;
+
+  // Block that can't be decoded alone. It's possible, if block scanner
+  // has found signature inside block data. Then we join it with next block.
+  Byte *MergeBuf;
+  UInt32 MergeBits;
+  UInt32 MergeCRC;
+  bool MergeIsPending;
+
+  bool IsAtStreamEnd();
+  HRESULT ReadPackBlock(CState &state, bool &wasFinished);
+  HRESULT MergePackBlock(CState &state, bool &blockIsOk, 
+      UInt32 *blockSize, UInt32 *origPtr, bool *randMode);
+
   CDecoder();
   ~CDecoder();
   HRes Create();
@@ -14,7 +14,10 @@ static const int kLenIdNeedInit = -2;
 CCoder::CCoder(bool deflate64Mode, bool deflateNSIS):  
     _deflate64Mode(deflate64Mode), 
     _deflateNSIS(deflateNSIS), 
-    _keepHistory(false) {}
+    _keepHistory(false),
+    _checkpoints(0),
+    _checkpointSpan(0),
+    _startPoint(0) {}
 
 UInt32 CCoder::ReadBits(int numBits)
 {
@@ -57,6 +60,22 @@ bool CCoder::DeCodeLevelTable(Byte *values, int numSymbols)
   return true;
 }
 
+void CCoder::AddCheckpoint()
+{
+  const UInt64 outPos = m_OutWindowStream.GetProcessedSize();
+  UInt64 historySize = outPos + _startHistorySize;
+  const UInt32 kHistorySize = _deflate64Mode ? kHistorySize64 : kHistorySize32;
+  if (historySize > kHistorySize)
+    historySize = kHistorySize;
+  CCheckpoint point;
+  point.InBitPos = _inStartBitPos + m_InBitStream.GetProcessedBitsSize();
+  point.OutPos = _outStartPos + outPos;
+  point.Window.SetCapacity((size_t)historySize);
+  m_OutWindowStream.GetHistory(point.Window, (UInt32)historySize);
+  _checkpoints->Add(point);
+  _nextCheckpointPos = outPos + _checkpointSpan;
+}
+
 #define RIF(x) { if (!(x)) return false; }
 
 bool CCoder::ReadTables(void)
@@ -116,7 +135,7 @@ bool CCoder::ReadTables(void)
     memcpy(levels.litLenLevels, tmpLevels, numLitLenLevels);
     memcpy(levels.distLevels, tmpLevels + numLitLenLevels, _numDistLevels);
   }
-  RIF(m_MainDecoder.SetCodeLengths(levels.litLenLevels));
+  RIF(m_MainDecoder.SetCodeLengths(levels.litLenLevels, kSymbolEndOfBlock));
   return m_DistDecoder.SetCodeLengths(levels.distLevels);
 }
 
@@ -136,6 +155,19 @@ HRESULT CCoder::CodeSpec(UInt32 curSize)
     m_FinalBlock = false;
     _remainLen = 0;
     _needReadTable = true;
+    _inStartBitPos = 0;
+    _outStartPos = 0;
+    _startHistorySize = 0;
+    if (_startPoint != 0)
+    {
+      _startHistorySize = (UInt32)_startPoint->Window.GetCapacity();
+      m_OutWindowStream.SetHistory(_startPoint->Window, _startHistorySize);
+      _inStartBitPos = _startPoint->InBitPos & ~(UInt64)7;
+      _outStartPos = _startPoint->OutPos;
+      m_InBitStream.ReadBits((int)(_startPoint->InBitPos & 7));
+      _startPoint = 0;
+    }
+    _nextCheckpointPos = _checkpointSpan;
   }
 
   if (curSize == 0)
@@ -158,6 +190,9 @@ HRESULT CCoder::CodeSpec(UInt32 curSize)
         _remainLen = kLenIdFinished;
         break;
       }
+      if (_checkpoints != 0)
+        if (m_OutWindowStream.GetProcessedSize() >= _nextCheckpointPos)
+          AddCheckpoint();
       if (!ReadTables())
         return S_FALSE;
       _needReadTable = false;
@@ -175,7 +210,21 @@ HRESULT CCoder::CodeSpec(UInt32 curSize)
       if (m_InBitStream.NumExtraBytes > 4)
         return S_FALSE;
 
-      UInt32 number = m_MainDecoder.DecodeSymbol(&m_InBitStream);
+      UInt32 number;
+      if (curSize >= 2)
+      {
+        UInt32 number2;
+        number = m_MainDecoder.DecodeSymbols(&m_InBitStream, number2);
+        if (number2 != NHuffman::kSymbolNone)
+        {
+          // first symbol of pair is always literal
+          m_OutWindowStream.PutByte((Byte)number);
+          curSize--;
+          number = number2;
+        }
+      }
+      else
+        number = m_MainDecoder.DecodeSymbol(&m_InBitStream);
       if (number < 0x100)
       {
         m_OutWindowStream.PutByte((Byte)number);
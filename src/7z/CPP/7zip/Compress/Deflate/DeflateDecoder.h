@@ -4,6 +4,8 @@
 #define __DEFLATE_DECODER_H
 
 #include "../../../Common/MyCom.h"
+#include "../../../Common/Buffer.h"
+#include "../../../Common/MyVector.h"
 
 #include "../../ICoder.h"
 #include "../../Common/LSBFDecoder.h"
@@ -17,6 +19,17 @@ namespace NCompress {
 namespace NDeflate {
 namespace NDecoder {
 
+// Wider root table for main symbols: most literal pairs fit into it.
+const int kNumMainTableBits = 11;
+
+// Block boundary, where decoding can be restarted.
+struct CCheckpoint
+{
+  UInt64 InBitPos;   // position of block header in packed stream (in bits)
+  UInt64 OutPos;     // position in unpacked stream
+  CByteBuffer Window; // unpacked data before OutPos (up to history size)
+};
+
 class CCoder:
   public ICompressCoder,
   public ICompressGetInStreamProcessedSize,
@@ -29,7 +42,7 @@ class CCoder:
 {
   CLZOutWindow m_OutWindowStream;
   NStream::NLSBF::CDecoder<CInBuffer> m_InBitStream;
-  NCompress::NHuffman::CDecoder<kNumHuffmanBits, kFixedMainTableSize> m_MainDecoder;
+  NCompress::NHuffman::CDecoder<kNumHuffmanBits, kFixedMainTableSize, kNumMainTableBits> m_MainDecoder;
   NCompress::NHuffman::CDecoder<kNumHuffmanBits, kFixedDistTableSize> m_DistDecoder;
   NCompress::NHuffman::CDecoder<kNumHuffmanBits, kLevelTableSize> m_LevelDecoder;
 
@@ -47,6 +60,16 @@ class CCoder:
   UInt32 _rep0;
   bool _needReadTable;
 
+  CObjectVector<CCheckpoint> *_checkpoints;
+  UInt64 _checkpointSpan;
+  UInt64 _nextCheckpointPos;
+  const CCheckpoint *_startPoint;
+  UInt64 _inStartBitPos;
+  UInt64 _outStartPos;
+  UInt32 _startHistorySize;
+
+  void AddCheckpoint();
+
   UInt32 ReadBits(int numBits);
 
   bool DeCodeLevelTable(Byte *values, int numSymbols);
@@ -79,6 +102,18 @@ public:
   CCoder(bool deflate64Mode, bool deflateNSIS = false);
   void SetKeepHistory(bool keepHistory) { _keepHistory = keepHistory; }
 
+  // Code() adds checkpoint to (checkpoints) at first block boundary
+  // after each (span) bytes of unpacked data. NULL disables it.
+  void SetCheckpoints(CObjectVector<CCheckpoint> *checkpoints, UInt64 span)
+  {
+    _checkpoints = checkpoints;
+    _checkpointSpan = span;
+  }
+
+  // Next Code() starts decoding from (point). Input stream must be
+  // positioned to byte (point->InBitPos >> 3) of packed stream.
+  void SetStartPoint(const CCheckpoint *point) { _startPoint = point; }
+
   HRESULT CodeReal(ISequentialInStream *inStream,
       ISequentialOutStream *outStream, const UInt64 *inSize, const UInt64 *outSize,
       ICompressProgressInfo *progress);
@@ -6,6 +6,11 @@
 
 #include "Windows/Defs.h"
 #include "Common/ComTry.h"
+
+#include "../../Common/StreamObjects.h"
+#ifdef COMPRESS_DEFLATE_MT
+#include "../../Common/StreamUtils.h"
+#endif
 extern "C" 
 { 
 #include "../../../../C/Alloc.h"
@@ -114,6 +119,12 @@ CCoder::CCoder(bool deflate64Mode):
   m_MatchFinderCycles(0)
   // m_SetMfPasses(0)
 {
+  #ifdef COMPRESS_DEFLATE_MT
+  ThreadsInfo = 0;
+  m_NumThreadsPrev = 0;
+  NumThreads = 1;
+  m_History = 0;
+  #endif
   m_MatchMaxLen = deflate64Mode ? kMatchMaxLen64 : kMatchMaxLen32;
   m_NumLenCombinations = deflate64Mode ? kNumLenSymbols64 : kNumLenSymbols32;
   m_LenStart = deflate64Mode ? kLenStart64 : kLenStart32;
@@ -224,6 +235,17 @@ HRESULT CCoder::BaseSetEncoderProperties2(const PROPID *propIDs,
         _btMode = !_fastMode;
         break;
       }
+      case NCoderPropID::kNumThreads:
+      {
+        #ifdef COMPRESS_DEFLATE_MT
+        if (prop.vt != VT_UI4)
+          return E_INVALIDARG;
+        NumThreads = prop.ulVal;
+        if (NumThreads < 1)
+          NumThreads = 1;
+        #endif
+        break;
+      }
       default:
         return E_INVALIDARG;
     }
@@ -245,6 +267,10 @@ void CCoder::Free()
 
 CCoder::~CCoder()
 {
+  #ifdef COMPRESS_DEFLATE_MT
+  FreeThreads();
+  ::MyFree(m_History);
+  #endif
   Free();
   MatchFinder_Free(&_lzInWindow, &g_Alloc);
 }
@@ -926,9 +952,8 @@ HRes Read(void *object, void *data, UInt32 size, UInt32 *processedSize)
   return (HRes)((CSeqInStream *)object)->RealStream->Read(data, size, processedSize);
 }
 
-HRESULT CCoder::CodeReal(ISequentialInStream *inStream,
-    ISequentialOutStream *outStream, const UInt64 * /* inSize */ , const UInt64 * /* outSize */ ,
-    ICompressProgressInfo *progress)
+HRESULT CCoder::CodeStream(ISequentialInStream *inStream, ISequentialOutStream *outStream, 
+    UInt32 presetSize, bool finalStream, ICompressProgressInfo *progress)
 {
   m_CheckStatic = (m_NumPasses != 1 || m_NumDivPasses != 1);
   m_IsMultiPass = (m_CheckStatic || (m_NumPasses != 1 || m_NumDivPasses != 1));
@@ -944,6 +969,13 @@ HRESULT CCoder::CodeReal(ISequentialInStream *inStream,
   _lzInWindow.stream = &_seqInStream.SeqInStream;
 
   MatchFinder_Init(&_lzInWindow);
+  if (presetSize != 0)
+  {
+    if (_btMode)
+      Bt3Zip_MatchFinder_Skip(&_lzInWindow, presetSize);
+    else
+      Hc3Zip_MatchFinder_Skip(&_lzInWindow, presetSize);
+  }
   m_OutStream.SetStream(outStream);
   m_OutStream.Init();
 
@@ -961,7 +993,7 @@ HRESULT CCoder::CodeReal(ISequentialInStream *inStream,
     t.BlockSizeRes = kBlockUncompressedSizeThreshold;
     m_SecondPass = false;
     GetBlockPrice(1, m_NumDivPasses);
-    CodeBlock(1, Inline_MatchFinder_GetNumAvailableBytes(&_lzInWindow) == 0);
+    CodeBlock(1, finalStream && Inline_MatchFinder_GetNumAvailableBytes(&_lzInWindow) == 0);
     nowPos += m_Tables[1].BlockSizeRes;
     if (progress != NULL)
     {
@@ -972,9 +1004,275 @@ HRESULT CCoder::CodeReal(ISequentialInStream *inStream,
   while (Inline_MatchFinder_GetNumAvailableBytes(&_lzInWindow) != 0);
   if (_lzInWindow.result != SZ_OK)
     return _lzInWindow.result;
+  if (!finalStream)
+    WriteStoreBlock(0, 0, false);
   return m_OutStream.Flush();
 }
 
+HRESULT CCoder::CodeChunk(const Byte *data, UInt32 presetSize, UInt32 size, bool finalChunk, 
+    ISequentialOutStream *outStream)
+{
+  CSequentialInStreamImp *inStreamSpec = new CSequentialInStreamImp;
+  CMyComPtr<ISequentialInStream> inStream = inStreamSpec;
+  inStreamSpec->Init(data, presetSize + size);
+  try { return CodeStream(inStream, outStream, presetSize, finalChunk, NULL); }
+  catch(const COutBufferException &e) { return e.ErrorCode; }
+  catch(...) { return E_FAIL; }
+}
+
+#ifdef COMPRESS_DEFLATE_MT
+
+static THREAD_FUNC_DECL MFThread(void *threadCoderInfo)
+{
+  return ((CThreadInfo *)threadCoderInfo)->ThreadFunc();
+}
+
+HRes CThreadInfo::Create()
+{
+  RINOK(StreamWasFinishedEvent.Create());
+  RINOK(WaitingWasStartedEvent.Create());
+  RINOK(CanWriteEvent.Create());
+  return Thread.Create(MFThread, this);
+}
+
+bool CThreadInfo::Alloc(const CCoder *props)
+{
+  if (m_Buffer == 0)
+  {
+    m_Buffer = (Byte *)::MidAlloc(kHistorySize64 + kMtChunkSize);
+    if (m_Buffer == 0)
+      return false;
+  }
+  if (Coder == 0)
+  {
+    Coder = new CCoder(props->m_Deflate64Mode);
+    if (Coder == 0)
+      return false;
+  }
+  Coder->SetMtProps(props);
+  if (OutStreamSpec == 0)
+  {
+    OutStreamSpec = new CSequentialOutStreamImp;
+    OutStream = OutStreamSpec;
+  }
+  return true;
+}
+
+void CThreadInfo::Free()
+{
+  ::MidFree(m_Buffer);
+  m_Buffer = 0;
+  delete Coder;
+  Coder = 0;
+}
+
+void CThreadInfo::FinishStream(bool needLeave)
+{
+  Encoder->StreamWasFinished = true;
+  StreamWasFinishedEvent.Set();
+  if (needLeave)
+    Encoder->CS.Leave();
+  Encoder->CanStartWaitingEvent.Lock();
+  WaitingWasStartedEvent.Set();
+}
+
+DWORD CThreadInfo::ThreadFunc()
+{
+  for (;;)
+  {
+    Encoder->CanProcessEvent.Lock();
+    Encoder->CS.Enter();
+    if (Encoder->CloseThreads)
+    {
+      Encoder->CS.Leave();
+      return 0;
+    }
+    if (Encoder->StreamWasFinished)
+    {
+      FinishStream(true);
+      continue;
+    }
+    HRESULT res = Encoder->ReadChunk(this);
+    if (res != S_OK)
+    {
+      Encoder->Result = res;
+      FinishStream(true);
+      continue;
+    }
+    m_BlockIndex = Encoder->NextBlockIndex;
+    if (++Encoder->NextBlockIndex == Encoder->NumThreads)
+      Encoder->NextBlockIndex = 0;
+    if (m_FinalChunk)
+      Encoder->StreamWasFinished = true;
+    Encoder->CS.Leave();
+    res = EncodeChunk();
+    if (res != S_OK)
+    {
+      Encoder->Result = res;
+      FinishStream(false);
+    }
+  }
+}
+
+HRESULT CThreadInfo::EncodeChunk()
+{
+  OutStreamSpec->Init();
+  HRESULT res = Coder->CodeChunk(m_Buffer, m_PresetSize, m_Size, m_FinalChunk, OutStream);
+
+  // we must pass the write turn to next chunk even after error
+  Encoder->ThreadsInfo[m_BlockIndex].CanWriteEvent.Lock();
+  if (res == S_OK)
+    res = Encoder->Result;
+  if (res == S_OK)
+  {
+    UInt32 size = (UInt32)OutStreamSpec->GetSize();
+    res = WriteStream(Encoder->MtOutStream, (const Byte *)OutStreamSpec->GetBuffer(), size, NULL);
+    Encoder->MtInSize += m_Size;
+    Encoder->MtOutSize += size;
+    if (res == S_OK && Encoder->Progress)
+      res = Encoder->Progress->SetRatioInfo(&Encoder->MtInSize, &Encoder->MtOutSize);
+  }
+  UInt32 blockIndex = m_BlockIndex + 1;
+  if (blockIndex == Encoder->NumThreads)
+    blockIndex = 0;
+  Encoder->ThreadsInfo[blockIndex].CanWriteEvent.Set();
+  return res;
+}
+
+void CCoder::SetMtProps(const CCoder *props)
+{
+  m_NumPasses = props->m_NumPasses;
+  m_NumDivPasses = props->m_NumDivPasses;
+  m_NumFastBytes = props->m_NumFastBytes;
+  _fastMode = props->_fastMode;
+  _btMode = props->_btMode;
+  m_MatchFinderCycles = props->m_MatchFinderCycles;
+}
+
+// it's called in critical section
+HRESULT CCoder::ReadChunk(CThreadInfo *ti)
+{
+  ti->m_PresetSize = m_HistorySize;
+  memcpy(ti->m_Buffer, m_History, m_HistorySize);
+  UInt32 size;
+  RINOK(ReadStream(MtInStream, ti->m_Buffer + m_HistorySize, kMtChunkSize, &size));
+  ti->m_Size = size;
+  ti->m_FinalChunk = (size != kMtChunkSize);
+  UInt32 totalSize = m_HistorySize + size;
+  UInt32 dictSize = GetMtDictSize();
+  m_HistorySize = MyMin(totalSize, dictSize);
+  memcpy(m_History, ti->m_Buffer + totalSize - m_HistorySize, m_HistorySize);
+  return S_OK;
+}
+
+HRes CCoder::CreateThreads()
+{
+  RINOK(CanProcessEvent.CreateIfNotCreated());
+  RINOK(CanStartWaitingEvent.CreateIfNotCreated());
+  if (m_History == 0)
+  {
+    m_History = (Byte *)::MyAlloc(kHistorySize64);
+    if (m_History == 0)
+      return E_OUTOFMEMORY;
+  }
+  if (ThreadsInfo != 0 && m_NumThreadsPrev == NumThreads)
+    return S_OK;
+  try 
+  { 
+    FreeThreads();
+    m_NumThreadsPrev = NumThreads;
+    ThreadsInfo = new CThreadInfo[NumThreads];
+    if (ThreadsInfo == 0)
+      return E_OUTOFMEMORY;
+  }
+  catch(...) { return E_OUTOFMEMORY; }
+  for (UInt32 t = 0; t < NumThreads; t++)
+  {
+    CThreadInfo &ti = ThreadsInfo[t];
+    ti.Encoder = this;
+    HRes res = ti.Create();
+    if (res != S_OK)
+    {
+      NumThreads = t;
+      FreeThreads();
+      return res; 
+    }
+  }
+  return S_OK;
+}
+
+void CCoder::FreeThreads()
+{
+  if (!ThreadsInfo)
+    return;
+  CloseThreads = true;
+  CanProcessEvent.Set();
+  for (UInt32 t = 0; t < NumThreads; t++)
+  {
+    CThreadInfo &ti = ThreadsInfo[t];
+    ti.Thread.Wait();
+    ti.Free();
+  }
+  delete []ThreadsInfo;
+  ThreadsInfo = 0;
+}
+
+HRESULT CCoder::CodeMt(ISequentialInStream *inStream, ISequentialOutStream *outStream, 
+    ICompressProgressInfo *progress)
+{
+  RINOK(CreateThreads());
+  UInt32 t;
+  for (t = 0; t < NumThreads; t++)
+  {
+    CThreadInfo &ti = ThreadsInfo[t];
+    ti.StreamWasFinishedEvent.Reset();
+    ti.WaitingWasStartedEvent.Reset();
+    ti.CanWriteEvent.Reset();
+    try
+    {
+      if (!ti.Alloc(this))
+        return E_OUTOFMEMORY;
+    }
+    catch(...) { return E_OUTOFMEMORY; }
+  }
+
+  Progress = progress;
+  MtInStream = inStream;
+  MtOutStream = outStream;
+  MtInSize = 0;
+  MtOutSize = 0;
+  m_HistorySize = 0;
+  NextBlockIndex = 0;
+  StreamWasFinished = false;
+  CloseThreads = false;
+  CanStartWaitingEvent.Reset();
+
+  ThreadsInfo[0].CanWriteEvent.Set();
+  Result = S_OK;
+  CanProcessEvent.Set();
+  for (t = 0; t < NumThreads; t++)
+    ThreadsInfo[t].StreamWasFinishedEvent.Lock();
+  CanProcessEvent.Reset();
+  CanStartWaitingEvent.Set();
+  for (t = 0; t < NumThreads; t++)
+    ThreadsInfo[t].WaitingWasStartedEvent.Lock();
+  CanStartWaitingEvent.Reset();
+  return Result;
+}
+
+#endif
+
+HRESULT CCoder::CodeReal(ISequentialInStream *inStream,
+    ISequentialOutStream *outStream, const UInt64 * /* inSize */ , const UInt64 * /* outSize */ ,
+    ICompressProgressInfo *progress)
+{
+  #ifdef COMPRESS_DEFLATE_MT
+  if (NumThreads > 1)
+    return CodeMt(inStream, outStream, progress);
+  #endif
+  return CodeStream(inStream, outStream, 0, true, progress);
+}
+
 HRESULT CCoder::BaseCode(ISequentialInStream *inStream,
     ISequentialOutStream *outStream, const UInt64 *inSize, const UInt64 *outSize,
     ICompressProgressInfo *progress)
@@ -1002,5 +1300,25 @@ STDMETHODIMP CCOMCoder64::SetCoderProperties(const PROPID *propIDs,
     const PROPVARIANT *properties, UInt32 numProperties)
   { return BaseSetEncoderProperties2(propIDs, properties, numProperties); }
 
+#ifdef COMPRESS_DEFLATE_MT
+
+STDMETHODIMP CCOMCoder::SetNumberOfThreads(UInt32 numThreads)
+{
+  NumThreads = numThreads;
+  if (NumThreads < 1)
+    NumThreads = 1;
+  return S_OK;
+}
+
+STDMETHODIMP CCOMCoder64::SetNumberOfThreads(UInt32 numThreads)
+{
+  NumThreads = numThreads;
+  if (NumThreads < 1)
+    NumThreads = 1;
+  return S_OK;
+}
+
+#endif
+
 }}}
 
@@ -10,6 +10,12 @@
 
 #include "DeflateConst.h"
 
+#ifdef COMPRESS_DEFLATE_MT
+#include "../../Common/StreamObjects.h"
+#include "../../../Windows/Thread.h"
+#include "../../../Windows/Synchronization.h"
+#endif
+
 extern "C"
 {
   #include "../../../../C/Compress/Lz/MatchFinder.h"
@@ -39,6 +45,50 @@ const UInt32 kNumOpts = kNumOptsBase + kMatchMaxLen;
 
 class CCoder;
 
+#ifdef COMPRESS_DEFLATE_MT
+
+// In multithreaded mode the input is split to chunks of kMtChunkSize bytes.
+// Each chunk is compressed by its own thread with previous 32 KB (64 KB for Deflate64)
+// of input as preset dictionary. Chunks are byte-aligned with empty stored blocks,
+// so the output is one Deflate stream.
+const UInt32 kMtChunkSize = (1 << 20);
+
+class CThreadInfo
+{
+public:
+  CCoder *Encoder;
+  CCoder *Coder;
+  Byte *m_Buffer;
+  UInt32 m_PresetSize;
+  UInt32 m_Size;
+  bool m_FinalChunk;
+  CSequentialOutStreamImp *OutStreamSpec;
+  CMyComPtr<ISequentialOutStream> OutStream;
+
+  NWindows::CThread Thread;
+
+  NWindows::NSynchronization::CAutoResetEvent StreamWasFinishedEvent;
+  NWindows::NSynchronization::CAutoResetEvent WaitingWasStartedEvent;
+
+  // it's not member of this thread. We just need one event per thread
+  NWindows::NSynchronization::CAutoResetEvent CanWriteEvent;
+
+  UInt64 m_UnpackSize;
+  int m_BlockIndex;
+
+  HRes Create();
+  void FinishStream(bool needLeave);
+  DWORD ThreadFunc();
+  HRESULT EncodeChunk();
+
+  CThreadInfo(): Coder(0), m_Buffer(0), OutStreamSpec(0) {}
+  ~CThreadInfo() { Free(); }
+  bool Alloc(const CCoder *props);
+  void Free();
+};
+
+#endif
+
 struct CTables: public CLevels
 {
   bool UseSubBlocks;
@@ -167,10 +217,49 @@ public:
   UInt32 GetBlockPrice(int tableIndex, int numDivPasses);
   void CodeBlock(int tableIndex, bool finalBlock);
 
+  HRESULT CodeStream(ISequentialInStream *inStream, ISequentialOutStream *outStream, 
+      UInt32 presetSize, bool finalStream, ICompressProgressInfo *progress);
+
+  #ifdef COMPRESS_DEFLATE_MT
+  CThreadInfo *ThreadsInfo;
+  NWindows::NSynchronization::CManualResetEvent CanProcessEvent;
+  NWindows::NSynchronization::CCriticalSection CS;
+  UInt32 NumThreads;
+  UInt32 m_NumThreadsPrev;
+  UInt32 NextBlockIndex;
+
+  bool CloseThreads;
+  bool StreamWasFinished;
+  NWindows::NSynchronization::CManualResetEvent CanStartWaitingEvent;
+
+  HRESULT Result;
+  ICompressProgressInfo *Progress;
+  ISequentialInStream *MtInStream;
+  ISequentialOutStream *MtOutStream;
+  UInt64 MtInSize;
+  UInt64 MtOutSize;
+  Byte *m_History;
+  UInt32 m_HistorySize;
+
+  UInt32 GetMtDictSize() const { return m_Deflate64Mode ? kHistorySize64 : kHistorySize32; }
+  void SetMtProps(const CCoder *props);
+  HRESULT ReadChunk(CThreadInfo *ti);
+  HRes CreateThreads();
+  void FreeThreads();
+  HRESULT CodeMt(ISequentialInStream *inStream, ISequentialOutStream *outStream, 
+      ICompressProgressInfo *progress);
+  #endif
+
 public:
   CCoder(bool deflate64Mode = false);
   ~CCoder();
 
+  // It compresses (size) bytes from (data + presetSize). First presetSize bytes are
+  // used only as dictionary. If (finalChunk == false), the stream is finished by
+  // empty stored block, so next chunk starts from byte boundary.
+  HRESULT CodeChunk(const Byte *data, UInt32 presetSize, UInt32 size, bool finalChunk, 
+      ISequentialOutStream *outStream);
+
   HRESULT CodeReal(ISequentialInStream *inStream,
       ISequentialOutStream *outStream, const UInt64 *inSize, const UInt64 *outSize,
       ICompressProgressInfo *progress);
@@ -189,11 +278,18 @@ public:
 class CCOMCoder :
   public ICompressCoder,
   public ICompressSetCoderProperties, 
+  #ifdef COMPRESS_DEFLATE_MT
+  public ICompressSetCoderMt,
+  #endif
   public CMyUnknownImp,
   public CCoder
 {
 public:
+  #ifdef COMPRESS_DEFLATE_MT
+  MY_UNKNOWN_IMP2(ICompressSetCoderMt, ICompressSetCoderProperties)
+  #else
   MY_UNKNOWN_IMP1(ICompressSetCoderProperties)
+  #endif
   CCOMCoder(): CCoder(false) {};
   STDMETHOD(Code)(ISequentialInStream *inStream,
       ISequentialOutStream *outStream, const UInt64 *inSize, const UInt64 *outSize,
@@ -201,16 +297,26 @@ public:
   // ICompressSetCoderProperties
   STDMETHOD(SetCoderProperties)(const PROPID *propIDs, 
       const PROPVARIANT *properties, UInt32 numProperties);
+  #ifdef COMPRESS_DEFLATE_MT
+  STDMETHOD(SetNumberOfThreads)(UInt32 numThreads);
+  #endif
 };
 
 class CCOMCoder64 :
   public ICompressCoder,
   public ICompressSetCoderProperties,
+  #ifdef COMPRESS_DEFLATE_MT
+  public ICompressSetCoderMt,
+  #endif
   public CMyUnknownImp,
   public CCoder
 {
 public:
+  #ifdef COMPRESS_DEFLATE_MT
+  MY_UNKNOWN_IMP2(ICompressSetCoderMt, ICompressSetCoderProperties)
+  #else
   MY_UNKNOWN_IMP1(ICompressSetCoderProperties)
+  #endif
   CCOMCoder64(): CCoder(true) {};
   STDMETHOD(Code)(ISequentialInStream *inStream,
       ISequentialOutStream *outStream, const UInt64 *inSize, const UInt64 *outSize,
@@ -218,6 +324,9 @@ public:
   // ICompressSetCoderProperties
   STDMETHOD(SetCoderProperties)(const PROPID *propIDs, 
       const PROPVARIANT *properties, UInt32 numProperties);
+  #ifdef COMPRESS_DEFLATE_MT
+  STDMETHOD(SetNumberOfThreads)(UInt32 numThreads);
+  #endif
 };
 
 
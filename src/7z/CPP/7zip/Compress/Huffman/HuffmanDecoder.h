@@ -8,23 +8,61 @@
 namespace NCompress {
 namespace NHuffman {
 
-const int kNumTableBits = 9;
+// Default number of bits in root table. It must be 15 or less.
+const int kNumTableBits = 10;
 
-template <int kNumBitsMax, UInt32 m_NumSymbols>
+// Symbol value in table entries that means "no symbol".
+// Alphabets of decoders must be smaller than kSymbolNone.
+const UInt32 kSymbolNone = 0xFFF;
+
+/*
+Root table entry (kNumRootBits bits of code are used as index):
+  bits  0 -  3 : length of first code (0 means link to second-level table)
+  bits  4 -  7 : length of second code (0, if there is no second symbol)
+  bits  8 - 19 : first symbol
+  bits 20 - 31 : second symbol (kSymbolNone, if there is no second symbol)
+Root table link entry:
+  bits  4 -  7 : number of index bits in second-level table
+  bits  8 - 31 : offset of second-level table in m_SubTable
+Second-level table entry:
+  bits  0 -  7 : full length of code
+  bits  8 - 19 : symbol
+*/
+
+template <int kNumBitsMax, UInt32 m_NumSymbols,
+    int kNumRootBits = (kNumBitsMax < kNumTableBits ? kNumBitsMax : kNumTableBits)>
 class CDecoder
 {
-  UInt32 m_Limits[kNumBitsMax + 1];     // m_Limits[i] = value limit for symbols with length = i 
-  UInt32 m_Positions[kNumBitsMax + 1];  // m_Positions[i] = index in m_Symbols[] of first symbol with length = i 
-  UInt32 m_Symbols[m_NumSymbols];
-  Byte m_Lengths[1 << kNumTableBits];   // Table oh length for short codes.
+  UInt32 m_Table[1 << kNumRootBits];
+  UInt32 *m_SubTable;
+  UInt32 m_SubTableSize;
+
+  enum { kNumSubBitsMax = kNumBitsMax - kNumRootBits };
+
+  static UInt32 GetSymbol(UInt32 entry)
+  {
+    UInt32 symbol = (entry >> 8) & 0xFFF;
+    if (symbol >= m_NumSymbols)
+      // throw CDecoderException(); // test it
+      return 0xFFFFFFFF;
+    return symbol;
+  }
 
 public:
+  CDecoder(): m_SubTable(0), m_SubTableSize(0) {}
+  ~CDecoder() { delete []m_SubTable; }
+
+  /*
+  numPairSymbols: if the first decoded symbol is smaller than numPairSymbols (it's literal),
+  the code of next symbol follows it directly. Then the root table entry can
+  contain two symbols, and DecodeSymbols() returns both of them after one lookup.
+  */
   
-  bool SetCodeLengths(const Byte *codeLengths)
+  bool SetCodeLengths(const Byte *codeLengths, UInt32 numPairSymbols = 0)
   {
-    int lenCounts[kNumBitsMax + 1], tmpPositions[kNumBitsMax + 1];
+    UInt32 lenCounts[kNumBitsMax + 1], codes[kNumBitsMax + 1];
     int i;
-    for(i = 1; i <= kNumBitsMax; i++)
+    for(i = 0; i <= kNumBitsMax; i++)
       lenCounts[i] = 0;
     UInt32 symbol;
     for (symbol = 0; symbol < m_NumSymbols; symbol++)
@@ -33,53 +71,151 @@ public:
       if (len > kNumBitsMax)
         return false;
       lenCounts[len]++;
-      m_Symbols[symbol] = 0xFFFFFFFF;
     }
     lenCounts[0] = 0;
-    m_Positions[0] = m_Limits[0] = 0;
+    // codes[i] = first code with length = i, aligned to kNumBitsMax bits
     UInt32 startPos = 0;
-    UInt32 index = 0;
     const UInt32 kMaxValue = (1 << kNumBitsMax);
     for (i = 1; i <= kNumBitsMax; i++)
     {
+      codes[i] = startPos;
       startPos += lenCounts[i] << (kNumBitsMax - i);
       if (startPos > kMaxValue)
         return false;
-      m_Limits[i] = (i == kNumBitsMax) ? kMaxValue : startPos;
-      m_Positions[i] = m_Positions[i - 1] + lenCounts[i - 1];
-      tmpPositions[i] = m_Positions[i];
-      if(i <= kNumTableBits)
-      {
-        UInt32 limit = (m_Limits[i] >> (kNumBitsMax - kNumTableBits));
-        for (; index < limit; index++)
-          m_Lengths[index] = (Byte)i;
-      }
     }
+
+    const UInt32 kNumRootEntries = (1 << kNumRootBits);
+    const UInt32 kRootInvalid = (kSymbolNone << 20) | (kSymbolNone << 8) | kNumRootBits;
+    UInt32 index;
+    for (index = 0; index < kNumRootEntries; index++)
+      m_Table[index] = kRootInvalid;
+    
+    // Short codes go to root table. For long codes we write link entries
+    // with maximum number of second-level bits for each prefix.
     for (symbol = 0; symbol < m_NumSymbols; symbol++)
     {
       int len = codeLengths[symbol];
-      if (len != 0)
-        m_Symbols[tmpPositions[len]++] = symbol;
+      if (len == 0)
+        continue;
+      UInt32 code = codes[len];
+      codes[len] += (UInt32)1 << (kNumBitsMax - len);
+      UInt32 prefix = code >> kNumSubBitsMax;
+      if (len <= kNumRootBits)
+      {
+        UInt32 entry = (kSymbolNone << 20) | (symbol << 8) | (UInt32)len;
+        UInt32 num = (UInt32)1 << (kNumRootBits - len);
+        for (index = 0; index < num; index++)
+          m_Table[prefix + index] = entry;
+      }
+      else
+      {
+        UInt32 subBits = (UInt32)(len - kNumRootBits);
+        UInt32 entry = m_Table[prefix];
+        if (entry == kRootInvalid || ((entry >> 4) & 0xF) < subBits)
+          m_Table[prefix] = subBits << 4;
+      }
     }
+
+    UInt32 subTableSize = 0;
+    for (index = 0; index < kNumRootEntries; index++)
+    {
+      UInt32 entry = m_Table[index];
+      if ((entry & 0xF) == 0)
+      {
+        m_Table[index] = entry | (subTableSize << 8);
+        subTableSize += (UInt32)1 << (entry >> 4);
+      }
+    }
+    if (subTableSize > m_SubTableSize)
+    {
+      delete []m_SubTable;
+      m_SubTableSize = 0;
+      m_SubTable = new UInt32[subTableSize];
+      if (m_SubTable == 0)
+        return false;
+      m_SubTableSize = subTableSize;
+    }
+
+    if (subTableSize != 0)
+    {
+      for (index = 0; index < subTableSize; index++)
+        m_SubTable[index] = (kSymbolNone << 8) | kNumBitsMax;
+      for (i = 1; i <= kNumBitsMax; i++)
+        codes[i] -= lenCounts[i] << (kNumBitsMax - i);
+      for (symbol = 0; symbol < m_NumSymbols; symbol++)
+      {
+        int len = codeLengths[symbol];
+        if (len == 0)
+          continue;
+        UInt32 code = codes[len];
+        codes[len] += (UInt32)1 << (kNumBitsMax - len);
+        if (len <= kNumRootBits)
+          continue;
+        UInt32 link = m_Table[code >> kNumSubBitsMax];
+        UInt32 subBits = (link >> 4) & 0xF;
+        UInt32 *subTable = m_SubTable + (link >> 8) + 
+            ((code & ((1 << kNumSubBitsMax) - 1)) >> (kNumSubBitsMax - subBits));
+        UInt32 entry = (symbol << 8) | (UInt32)len;
+        UInt32 num = (UInt32)1 << (kNumRootBits + subBits - len);
+        for (index = 0; index < num; index++)
+          subTable[index] = entry;
+      }
+    }
+
+    // Pairs: the rest bits of root index after short literal code
+    // are the start of next code. If next code is short enough, we store it too.
+    if (numPairSymbols != 0)
+      for (index = 0; index < kNumRootEntries; index++)
+      {
+        UInt32 entry = m_Table[index];
+        UInt32 len = entry & 0xF;
+        if (len == 0 || len >= kNumRootBits || ((entry >> 8) & 0xFFF) >= numPairSymbols)
+          continue;
+        UInt32 entry2 = m_Table[(index << len) & (kNumRootEntries - 1)];
+        UInt32 len2 = entry2 & 0xF;
+        if (len2 == 0 || len + len2 > kNumRootBits || ((entry2 >> 8) & 0xFFF) >= m_NumSymbols)
+          continue;
+        m_Table[index] = (entry & 0xFFF0F) | (len2 << 4) | ((entry2 & 0xFFF00) << 12);
+      }
     return true;
   }
 
   template <class TBitDecoder>
   UInt32 DecodeSymbol(TBitDecoder *bitStream)
   {
-    int numBits;
     UInt32 value = bitStream->GetValue(kNumBitsMax);
-    if (value < m_Limits[kNumTableBits])
-      numBits = m_Lengths[value >> (kNumBitsMax - kNumTableBits)];
-    else 
-      for (numBits = kNumTableBits + 1; value >= m_Limits[numBits]; numBits++);
+    UInt32 entry = m_Table[value >> kNumSubBitsMax];
+    UInt32 numBits = entry & 0xF;
+    if (numBits == 0)
+    {
+      UInt32 subBits = (entry >> 4) & 0xF;
+      entry = m_SubTable[(entry >> 8) + 
+          ((value & ((1 << kNumSubBitsMax) - 1)) >> (kNumSubBitsMax - subBits))];
+      numBits = entry & 0xFF;
+    }
     bitStream->MovePos(numBits);
-    UInt32 index = m_Positions[numBits] + 
-      ((value - m_Limits[numBits - 1]) >> (kNumBitsMax - numBits));
-    if (index >= m_NumSymbols)
-      // throw CDecoderException(); // test it
-      return 0xFFFFFFFF;
-    return m_Symbols[index];
+    return GetSymbol(entry);
+  }
+
+  // It decodes one or two symbols. If there is no second symbol, symbol2 = kSymbolNone.
+  template <class TBitDecoder>
+  UInt32 DecodeSymbols(TBitDecoder *bitStream, UInt32 &symbol2)
+  {
+    UInt32 value = bitStream->GetValue(kNumBitsMax);
+    UInt32 entry = m_Table[value >> kNumSubBitsMax];
+    UInt32 numBits = entry & 0xF;
+    if (numBits == 0)
+    {
+      UInt32 subBits = (entry >> 4) & 0xF;
+      entry = m_SubTable[(entry >> 8) + 
+          ((value & ((1 << kNumSubBitsMax) - 1)) >> (kNumSubBitsMax - subBits))];
+      bitStream->MovePos(entry & 0xFF);
+      symbol2 = kSymbolNone;
+      return GetSymbol(entry);
+    }
+    bitStream->MovePos(numBits + ((entry >> 4) & 0xF));
+    symbol2 = entry >> 20;
+    return GetSymbol(entry);
   }
 };
 
@@ -13,4 +13,21 @@ void CLZOutWindow::Init(bool solid)
   #endif
 }
 
+void CLZOutWindow::SetHistory(const Byte *data, UInt32 size)
+{
+  if (size > _bufferSize)
+  {
+    data += size - _bufferSize;
+    size = _bufferSize;
+  }
+  memcpy(_buffer, data, size);
+  _pos = size;
+  if (_pos == _bufferSize)
+  {
+    _pos = 0;
+    _overDict = true;
+  }
+  _streamPos = _pos;
+}
+
 
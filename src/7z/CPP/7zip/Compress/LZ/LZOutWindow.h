@@ -60,6 +60,16 @@ public:
       pos += _bufferSize;
     return _buffer[pos]; 
   }
+
+  // copies the last (size) bytes of window to (dest)
+  void GetHistory(Byte *dest, UInt32 size) const
+  {
+    for (UInt32 i = 0; i < size; i++)
+      dest[i] = GetByte(size - 1 - i);
+  }
+
+  // call it after Init(): (data) becomes history, it's not written to stream
+  void SetHistory(const Byte *data, UInt32 size);
 };
 
 #endif
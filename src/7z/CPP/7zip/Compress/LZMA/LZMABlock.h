@@ -0,0 +1,34 @@
+// LZMA/LZMABlock.h
+
+#ifndef __LZMA_BLOCK_H
+#define __LZMA_BLOCK_H
+
+#include "../../../Common/Types.h"
+
+/*
+LZMABlock stream is a sequence of blocks:
+
+  UInt32 UnpackSize  (little-endian). 0 means end of stream.
+  UInt32 PackSize    (little-endian)
+  Byte   Data[PackSize]
+
+Each block is LZMA data without end marker. The coder state and the 
+dictionary are reset at the start of each block, so blocks can be 
+decoded independently. Coder properties are the same 5 bytes as in LZMA.
+*/
+
+namespace NCompress {
+namespace NLZMABlock {
+
+const UInt32 kHeaderSize = 8;
+
+const UInt32 kBlockSizeMin = (1 << 16);
+const UInt32 kBlockSizeMax = (1 << 30);
+const UInt32 kBlockSizeDefaultMin = (1 << 20);
+
+inline UInt32 GetPackSizeMax(UInt32 unpackSize) 
+  { return unpackSize + (unpackSize >> 3) + (1 << 16); }
+
+}}
+
+#endif
@@ -0,0 +1,280 @@
+// LZMABlockDecoder.cpp
+
+#include "StdAfx.h"
+
+#include "LZMABlockDecoder.h"
+
+#include "../../Common/StreamObjects.h"
+#include "../../Common/StreamUtils.h"
+
+namespace NCompress {
+namespace NLZMABlock {
+
+#ifdef COMPRESS_MT
+static const UInt32 kNumThreadsMax = 64;
+#endif
+
+static UInt32 GetUInt32(const Byte *p)
+{
+  UInt32 value = 0;
+  for (int i = 0; i < 4; i++)
+    value |= ((UInt32)p[i] << (8 * i));
+  return value;
+}
+
+void CBlockDecoder::Free()
+{
+  ::MidFree(PackData);
+  ::MidFree(UnpackData);
+  PackData = 0;
+  UnpackData = 0;
+  PackBufSize = 0;
+  UnpackBufSize = 0;
+}
+
+bool CBlockDecoder::Alloc(UInt32 packSize, UInt32 unpackSize)
+{
+  if (packSize > PackBufSize)
+  {
+    ::MidFree(PackData);
+    PackData = (Byte *)::MidAlloc(packSize);
+    PackBufSize = (PackData == 0) ? 0 : packSize;
+    if (PackData == 0)
+      return false;
+  }
+  if (unpackSize > UnpackBufSize)
+  {
+    ::MidFree(UnpackData);
+    UnpackData = (Byte *)::MidAlloc(unpackSize);
+    UnpackBufSize = (UnpackData == 0) ? 0 : unpackSize;
+    if (UnpackData == 0)
+      return false;
+  }
+  return true;
+}
+
+HRESULT CBlockDecoder::Decode()
+{
+  if (!LzmaDecoder)
+  {
+    LzmaDecoderSpec = new NLZMA::CDecoder;
+    LzmaDecoder = LzmaDecoderSpec;
+  }
+  RINOK(LzmaDecoderSpec->SetDecoderProperties2(Props, 5));
+
+  CBufInStream *inStreamSpec = new CBufInStream;
+  CMyComPtr<ISequentialInStream> inStream = inStreamSpec;
+  inStreamSpec->Init(PackData, PackSize);
+
+  CSequentialOutStreamImp2 *outStreamSpec = new CSequentialOutStreamImp2;
+  CMyComPtr<ISequentialOutStream> outStream = outStreamSpec;
+  outStreamSpec->Init(UnpackData, UnpackSize);
+
+  const UInt64 packSize = PackSize;
+  const UInt64 unpackSize = UnpackSize;
+  RINOK(LzmaDecoder->Code(inStream, outStream, &packSize, &unpackSize, NULL));
+  if (outStreamSpec->GetPos() != UnpackSize)
+    return S_FALSE;
+  UInt64 inProcessed;
+  RINOK(LzmaDecoderSpec->GetInStreamProcessedSize(&inProcessed));
+  return (inProcessed == packSize) ? S_OK : S_FALSE;
+}
+
+CDecoder::CDecoder(): 
+  _propsWereSet(false)
+  #ifdef COMPRESS_MT
+  , _numThreads(1), 
+  _numThreadsPrev(0),
+  _threads(0)
+  #endif
+{
+}
+
+CDecoder::~CDecoder()
+{
+  #ifdef COMPRESS_MT
+  FreeThreads();
+  #endif
+}
+
+STDMETHODIMP CDecoder::SetDecoderProperties2(const Byte *data, UInt32 size)
+{
+  if (size < 5)
+    return E_INVALIDARG;
+  for (int i = 0; i < 5; i++)
+    _props[i] = data[i];
+  _propsWereSet = true;
+  return S_OK;
+}
+
+HRESULT CDecoder::ReadBlock(ISequentialInStream *inStream, CBlockDecoder &block, bool &finished)
+{
+  finished = false;
+  Byte header[kHeaderSize];
+  UInt32 processedSize;
+  RINOK(ReadStream(inStream, header, kHeaderSize, &processedSize));
+  _inProcessed += processedSize;
+  if (processedSize != kHeaderSize)
+    return S_FALSE;
+  UInt32 unpackSize = GetUInt32(header);
+  UInt32 packSize = GetUInt32(header + 4);
+  if (unpackSize == 0)
+  {
+    finished = true;
+    return (packSize == 0) ? S_OK : S_FALSE;
+  }
+  if (unpackSize > kBlockSizeMax || packSize < 5 || packSize > GetPackSizeMax(unpackSize))
+    return S_FALSE;
+  // header sizes are not trusted: don't allocate more than the stream can still hold
+  if (_outSizeDefined && unpackSize > _outSize - _outReserved)
+    return S_FALSE;
+  if (_inSizeDefined && packSize > _inSize - _inProcessed)
+    return S_FALSE;
+  _outReserved += unpackSize;
+  if (!block.Alloc(packSize, unpackSize))
+    return E_OUTOFMEMORY;
+  RINOK(ReadStream(inStream, block.PackData, packSize, &processedSize));
+  _inProcessed += processedSize;
+  if (processedSize != packSize)
+    return S_FALSE;
+  block.PackSize = packSize;
+  block.UnpackSize = unpackSize;
+  block.Props = _props;
+  return S_OK;
+}
+
+HRESULT CDecoder::WriteBlock(ISequentialOutStream *outStream, const CBlockDecoder &block, 
+    ICompressProgressInfo *progress)
+{
+  RINOK(WriteStream(outStream, block.UnpackData, block.UnpackSize, NULL));
+  _outProcessed += block.UnpackSize;
+  if (progress != NULL)
+  {
+    RINOK(progress->SetRatioInfo(&_inProcessed, &_outProcessed));
+  }
+  return S_OK;
+}
+
+#ifdef COMPRESS_MT
+
+STDMETHODIMP CDecoder::SetNumberOfThreads(UInt32 numThreads)
+{
+  _numThreads = numThreads;
+  if (_numThreads < 1)
+    _numThreads = 1;
+  if (_numThreads > kNumThreadsMax)
+    _numThreads = kNumThreadsMax;
+  return S_OK;
+}
+
+void CDecoder::FreeThreads()
+{
+  delete []_threads;
+  _threads = 0;
+  _numThreadsPrev = 0;
+}
+
+HRes CDecoder::CreateThreads()
+{
+  if (_threads != 0 && _numThreadsPrev == _numThreads)
+    return S_OK;
+  FreeThreads();
+  try 
+  { 
+    _threads = new CDecoderThread[_numThreads];
+    if (_threads == 0)
+      return E_OUTOFMEMORY;
+  }
+  catch(...) { return E_OUTOFMEMORY; }
+  _numThreadsPrev = _numThreads;
+  for (UInt32 t = 0; t < _numThreads; t++)
+  {
+    HRes res = _threads[t].Create();
+    if (res != S_OK)
+    {
+      FreeThreads();
+      return res;
+    }
+  }
+  return S_OK;
+}
+
+HRESULT CDecoder::CodeMt(ISequentialInStream *inStream, ISequentialOutStream *outStream, 
+    ICompressProgressInfo *progress)
+{
+  RINOK(CreateThreads());
+  const UInt32 numThreads = _numThreadsPrev;
+  UInt32 numStarted = 0;
+  UInt32 numWritten = 0;
+  bool finished = false;
+  HRESULT res = S_OK;
+  for (;;)
+  {
+    while (!finished && numStarted - numWritten < numThreads)
+    {
+      CDecoderThread &t = _threads[numStarted % numThreads];
+      res = ReadBlock(inStream, t, finished);
+      if (res != S_OK || finished)
+        break;
+      t.Start();
+      numStarted++;
+    }
+    if (res != S_OK || numWritten == numStarted)
+      break;
+    CDecoderThread &t = _threads[numWritten % numThreads];
+    t.WaitFinish();
+    numWritten++;
+    res = t.Result;
+    if (res != S_OK)
+      break;
+    res = WriteBlock(outStream, t, progress);
+    if (res != S_OK)
+      break;
+  }
+  for (; numWritten < numStarted; numWritten++)
+    _threads[numWritten % numThreads].WaitFinish();
+  return res;
+}
+
+#endif
+
+HRESULT CDecoder::CodeReal(ISequentialInStream *inStream, ISequentialOutStream *outStream, 
+    ICompressProgressInfo *progress)
+{
+  if (!_propsWereSet)
+    return E_FAIL;
+  _inProcessed = 0;
+  _outProcessed = 0;
+  _outReserved = 0;
+
+  #ifdef COMPRESS_MT
+  if (_numThreads > 1)
+    return CodeMt(inStream, outStream, progress);
+  #endif
+
+  for (;;)
+  {
+    bool finished;
+    RINOK(ReadBlock(inStream, _block, finished));
+    if (finished)
+      return S_OK;
+    RINOK(_block.Decode());
+    RINOK(WriteBlock(outStream, _block, progress));
+  }
+}
+
+STDMETHODIMP CDecoder::Code(ISequentialInStream *inStream,
+    ISequentialOutStream *outStream, const UInt64 *inSize, const UInt64 *outSize,
+    ICompressProgressInfo *progress)
+{
+  _inSizeDefined = (inSize != NULL);
+  if (_inSizeDefined)
+    _inSize = *inSize;
+  _outSizeDefined = (outSize != NULL);
+  if (_outSizeDefined)
+    _outSize = *outSize;
+  try { return CodeReal(inStream, outStream, progress); }
+  catch(...) { return E_OUTOFMEMORY; }
+}
+
+}}
@@ -0,0 +1,111 @@
+// LZMA/LZMABlockDecoder.h
+
+#ifndef __LZMA_BLOCK_DECODER_H
+#define __LZMA_BLOCK_DECODER_H
+
+#include "../../../Common/MyCom.h"
+#include "../../ICoder.h"
+
+#ifdef COMPRESS_MT
+#include "../../Common/VirtThread.h"
+#endif
+
+#include "LZMADecoder.h"
+#include "LZMABlock.h"
+
+namespace NCompress {
+namespace NLZMABlock {
+
+struct CBlockDecoder
+{
+  NLZMA::CDecoder *LzmaDecoderSpec;
+  CMyComPtr<ICompressCoder> LzmaDecoder;
+  Byte *PackData;
+  Byte *UnpackData;
+  UInt32 PackSize;
+  UInt32 UnpackSize;
+  UInt32 PackBufSize;
+  UInt32 UnpackBufSize;
+  const Byte *Props;
+  HRESULT Result;
+
+  CBlockDecoder(): LzmaDecoderSpec(0), PackData(0), UnpackData(0), PackBufSize(0), UnpackBufSize(0) {}
+  ~CBlockDecoder() { Free(); }
+  void Free();
+  bool Alloc(UInt32 packSize, UInt32 unpackSize);
+  HRESULT Decode();
+};
+
+#ifdef COMPRESS_MT
+
+struct CDecoderThread: public CBlockDecoder, public CVirtThread
+{
+  void Execute() 
+  { 
+    try { Result = Decode(); }
+    catch(...) { Result = E_OUTOFMEMORY; }
+  }
+};
+
+#endif
+
+class CDecoder:
+  public ICompressCoder,
+  public ICompressSetDecoderProperties2,
+  #ifdef COMPRESS_MT
+  public ICompressSetCoderMt,
+  #endif
+  public CMyUnknownImp
+{
+  Byte _props[5];
+  bool _propsWereSet;
+  UInt64 _inProcessed;
+  UInt64 _outProcessed;
+  UInt64 _outReserved;
+  UInt64 _inSize;
+  UInt64 _outSize;
+  bool _inSizeDefined;
+  bool _outSizeDefined;
+
+  #ifdef COMPRESS_MT
+  UInt32 _numThreads;
+  UInt32 _numThreadsPrev;
+  CDecoderThread *_threads;
+  void FreeThreads();
+  HRes CreateThreads();
+  HRESULT CodeMt(ISequentialInStream *inStream, ISequentialOutStream *outStream, 
+      ICompressProgressInfo *progress);
+  #endif
+
+  CBlockDecoder _block;
+
+  HRESULT ReadBlock(ISequentialInStream *inStream, CBlockDecoder &block, bool &finished);
+  HRESULT WriteBlock(ISequentialOutStream *outStream, const CBlockDecoder &block, 
+      ICompressProgressInfo *progress);
+  HRESULT CodeReal(ISequentialInStream *inStream, ISequentialOutStream *outStream, 
+      ICompressProgressInfo *progress);
+public:
+
+  #ifdef COMPRESS_MT
+  MY_UNKNOWN_IMP2(ICompressSetDecoderProperties2, ICompressSetCoderMt)
+  #else
+  MY_UNKNOWN_IMP1(ICompressSetDecoderProperties2)
+  #endif
+
+  STDMETHOD(Code)(ISequentialInStream *inStream,
+      ISequentialOutStream *outStream, const UInt64 *inSize, const UInt64 *outSize,
+      ICompressProgressInfo *progress);
+
+  STDMETHOD(SetDecoderProperties2)(const Byte *data, UInt32 size);
+
+  #ifdef COMPRESS_MT
+  STDMETHOD(SetNumberOfThreads)(UInt32 numThreads);
+  #endif
+
+  CDecoder();
+  virtual ~CDecoder();
+};
+
+}}
+
+#endif
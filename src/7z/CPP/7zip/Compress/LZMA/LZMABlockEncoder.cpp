@@ -0,0 +1,342 @@
+// LZMABlockEncoder.cpp
+
+#include "StdAfx.h"
+
+#include "LZMABlockEncoder.h"
+
+#include "../../Common/StreamUtils.h"
+
+namespace NCompress {
+namespace NLZMABlock {
+
+static const UInt32 kDictionarySizeDefault = (1 << 22);
+
+#ifdef COMPRESS_MT
+static const UInt32 kNumThreadsMax = 64;
+#endif
+
+static void SetUInt32(Byte *p, UInt32 value)
+{
+  for (int i = 0; i < 4; i++)
+    p[i] = (Byte)(value >> (8 * i));
+}
+
+void CBlockEncoder::Free()
+{
+  ::MidFree(InData);
+  InData = 0;
+  InBufSize = 0;
+}
+
+bool CBlockEncoder::Alloc(UInt32 size)
+{
+  if (!OutStream)
+  {
+    OutStreamSpec = new CSequentialOutStreamImp;
+    OutStream = OutStreamSpec;
+  }
+  if (size <= InBufSize)
+    return true;
+  Free();
+  InData = (Byte *)::MidAlloc(size);
+  if (InData == 0)
+    return false;
+  InBufSize = size;
+  return true;
+}
+
+HRESULT CBlockEncoder::Encode()
+{
+  CSequentialInStreamImp *inStreamSpec = new CSequentialInStreamImp;
+  CMyComPtr<ISequentialInStream> inStream = inStreamSpec;
+  inStreamSpec->Init(InData, InSize);
+  OutStreamSpec->Init();
+  return LzmaEncoder->Code(inStream, OutStream, NULL, NULL, NULL);
+}
+
+CEncoder::CEncoder(): 
+  _dictionarySize(kDictionarySizeDefault),
+  _blockSize(0),
+  _numThreads(1)
+  #ifdef COMPRESS_MT
+  , _numThreadsPrev(0),
+  _threads(0)
+  #endif
+{
+}
+
+CEncoder::~CEncoder()
+{
+  #ifdef COMPRESS_MT
+  FreeThreads();
+  #endif
+}
+
+UInt32 CEncoder::GetBlockSize() const
+{
+  if (_blockSize != 0)
+    return _blockSize;
+  UInt64 blockSize = (UInt64)_dictionarySize << 2;
+  if (blockSize < kBlockSizeDefaultMin)
+    blockSize = kBlockSizeDefaultMin;
+  if (blockSize > kBlockSizeMax)
+    blockSize = kBlockSizeMax;
+  return (UInt32)blockSize;
+}
+
+UInt32 CEncoder::GetDictionarySize() const
+{
+  // dictionary is reset at each block, so it's useless to allocate more than block size
+  UInt32 blockSize = GetBlockSize();
+  return (_dictionarySize < blockSize) ? _dictionarySize : blockSize;
+}
+
+STDMETHODIMP CEncoder::SetCoderProperties(const PROPID *propIDs, 
+    const PROPVARIANT *properties, UInt32 numProperties)
+{
+  _propIDs.Clear();
+  _props.Clear();
+  _dictionarySize = kDictionarySizeDefault;
+  _blockSize = 0;
+  _numThreads = 1;
+  for (UInt32 i = 0; i < numProperties; i++)
+  {
+    const PROPVARIANT &prop = properties[i];
+    switch(propIDs[i])
+    {
+      case NCoderPropID::kBlockSize:
+      {
+        if (prop.vt != VT_UI4)
+          return E_INVALIDARG;
+        UInt32 blockSize = prop.ulVal;
+        if (blockSize < kBlockSizeMin || blockSize > kBlockSizeMax)
+          return E_INVALIDARG;
+        _blockSize = blockSize;
+        break;
+      }
+      case NCoderPropID::kDictionarySize:
+      {
+        if (prop.vt != VT_UI4)
+          return E_INVALIDARG;
+        _dictionarySize = prop.ulVal;
+        break;
+      }
+      case NCoderPropID::kNumThreads:
+      {
+        if (prop.vt != VT_UI4)
+          return E_INVALIDARG;
+        _numThreads = prop.ulVal;
+        if (_numThreads < 1)
+          _numThreads = 1;
+        #ifdef COMPRESS_MT
+        if (_numThreads > kNumThreadsMax)
+          _numThreads = kNumThreadsMax;
+        #endif
+        break;
+      }
+      case NCoderPropID::kEndMarker:
+        // blocks are stored with sizes, so end marker is never written
+        break;
+      default:
+        _propIDs.Add(propIDs[i]);
+        _props.Add(NWindows::NCOM::CPropVariant(prop));
+    }
+  }
+  // check all properties with temp encoder 
+  CBlockEncoder block;
+  return SetLzmaProperties(block, 1);
+}
+
+HRESULT CEncoder::SetLzmaProperties(CBlockEncoder &block, UInt32 numMfThreads)
+{
+  if (!block.LzmaEncoder)
+  {
+    block.LzmaEncoderSpec = new NLZMA::CEncoder;
+    block.LzmaEncoder = block.LzmaEncoderSpec;
+  }
+  CRecordVector<PROPID> propIDs;
+  CRecordVector<PROPVARIANT> props;
+  for (int i = 0; i < _propIDs.Size(); i++)
+  {
+    propIDs.Add(_propIDs[i]);
+    props.Add(_props[i]);
+  }
+  NWindows::NCOM::CPropVariant dictionarySize = GetDictionarySize();
+  propIDs.Add(NCoderPropID::kDictionarySize);
+  props.Add(dictionarySize);
+  NWindows::NCOM::CPropVariant numThreads = numMfThreads;
+  propIDs.Add(NCoderPropID::kNumThreads);
+  props.Add(numThreads);
+  return block.LzmaEncoderSpec->SetCoderProperties(&propIDs.Front(), &props.Front(), props.Size());
+}
+
+STDMETHODIMP CEncoder::WriteCoderProperties(ISequentialOutStream *outStream)
+{ 
+  CBlockEncoder block;
+  RINOK(SetLzmaProperties(block, 1));
+  return block.LzmaEncoderSpec->WriteCoderProperties(outStream);
+}
+
+HRESULT CEncoder::ReadBlock(ISequentialInStream *inStream, CBlockEncoder &block)
+{
+  UInt32 blockSize = GetBlockSize();
+  if (!block.Alloc(blockSize))
+    return E_OUTOFMEMORY;
+  RINOK(ReadStream(inStream, block.InData, blockSize, &block.InSize));
+  _inProcessed += block.InSize;
+  return S_OK;
+}
+
+HRESULT CEncoder::WriteBlock(ISequentialOutStream *outStream, const CBlockEncoder &block, 
+    ICompressProgressInfo *progress)
+{
+  UInt32 packSize = (UInt32)block.OutStreamSpec->GetSize();
+  if (packSize > GetPackSizeMax(block.InSize))
+    return E_FAIL;
+  Byte header[kHeaderSize];
+  SetUInt32(header, block.InSize);
+  SetUInt32(header + 4, packSize);
+  RINOK(WriteStream(outStream, header, kHeaderSize, NULL));
+  RINOK(WriteStream(outStream, block.OutStreamSpec->GetBuffer(), packSize, NULL));
+  _outProcessed += kHeaderSize + packSize;
+  if (progress != NULL)
+  {
+    RINOK(progress->SetRatioInfo(&_inProcessed, &_outProcessed));
+  }
+  return S_OK;
+}
+
+static HRESULT WriteEndMarker(ISequentialOutStream *outStream)
+{
+  Byte header[kHeaderSize];
+  SetUInt32(header, 0);
+  SetUInt32(header + 4, 0);
+  return WriteStream(outStream, header, kHeaderSize, NULL);
+}
+
+#ifdef COMPRESS_MT
+
+void CEncoder::FreeThreads()
+{
+  delete []_threads;
+  _threads = 0;
+  _numThreadsPrev = 0;
+}
+
+HRes CEncoder::CreateThreads(UInt32 numThreads)
+{
+  if (_threads != 0 && _numThreadsPrev == numThreads)
+    return S_OK;
+  FreeThreads();
+  try 
+  { 
+    _threads = new CEncoderThread[numThreads];
+    if (_threads == 0)
+      return E_OUTOFMEMORY;
+  }
+  catch(...) { return E_OUTOFMEMORY; }
+  _numThreadsPrev = numThreads;
+  for (UInt32 t = 0; t < numThreads; t++)
+  {
+    HRes res = _threads[t].Create();
+    if (res != S_OK)
+    {
+      FreeThreads();
+      return res;
+    }
+  }
+  return S_OK;
+}
+
+HRESULT CEncoder::CodeMt(ISequentialInStream *inStream, ISequentialOutStream *outStream, 
+    ICompressProgressInfo *progress, UInt32 numThreads)
+{
+  RINOK(CreateThreads(numThreads));
+  for (UInt32 i = 0; i < numThreads; i++)
+  {
+    // each block encoder gets its own thread, so match finder works in same thread
+    RINOK(SetLzmaProperties(_threads[i], 1));
+  }
+  UInt32 numStarted = 0;
+  UInt32 numWritten = 0;
+  bool finished = false;
+  HRESULT res = S_OK;
+  for (;;)
+  {
+    while (!finished && numStarted - numWritten < numThreads)
+    {
+      CEncoderThread &t = _threads[numStarted % numThreads];
+      res = ReadBlock(inStream, t);
+      if (res != S_OK)
+        break;
+      if (t.InSize == 0)
+      {
+        finished = true;
+        break;
+      }
+      t.Start();
+      numStarted++;
+    }
+    if (res != S_OK || numWritten == numStarted)
+      break;
+    CEncoderThread &t = _threads[numWritten % numThreads];
+    t.WaitFinish();
+    numWritten++;
+    res = t.Result;
+    if (res != S_OK)
+      break;
+    res = WriteBlock(outStream, t, progress);
+    if (res != S_OK)
+      break;
+  }
+  for (; numWritten < numStarted; numWritten++)
+    _threads[numWritten % numThreads].WaitFinish();
+  RINOK(res);
+  return WriteEndMarker(outStream);
+}
+
+#endif
+
+HRESULT CEncoder::CodeReal(ISequentialInStream *inStream, ISequentialOutStream *outStream, 
+    const UInt64 *inSize, ICompressProgressInfo *progress)
+{
+  _inProcessed = 0;
+  _outProcessed = 0;
+
+  #ifdef COMPRESS_MT
+  // blocks are sent to threads only if we know that there are several blocks
+  UInt32 numThreads = 1;
+  if (inSize != NULL)
+  {
+    const UInt32 blockSize = GetBlockSize();
+    UInt64 numBlocks = (*inSize + blockSize - 1) / blockSize;
+    numThreads = _numThreads;
+    if (numBlocks < numThreads)
+      numThreads = (UInt32)numBlocks;
+  }
+  if (numThreads > 1)
+    return CodeMt(inStream, outStream, progress, numThreads);
+  #endif
+
+  // blocks are encoded one by one, so the match finder can use additional thread
+  RINOK(SetLzmaProperties(_block, _numThreads));
+  for (;;)
+  {
+    RINOK(ReadBlock(inStream, _block));
+    if (_block.InSize == 0)
+      break;
+    RINOK(_block.Encode());
+    RINOK(WriteBlock(outStream, _block, progress));
+  }
+  return WriteEndMarker(outStream);
+}
+
+STDMETHODIMP CEncoder::Code(ISequentialInStream *inStream,
+    ISequentialOutStream *outStream, const UInt64 *inSize, const UInt64 * /* outSize */,
+    ICompressProgressInfo *progress)
+{
+  try { return CodeReal(inStream, outStream, inSize, progress); }
+  catch(...) { return E_OUTOFMEMORY; }
+}
+
+}}
@@ -0,0 +1,103 @@
+// LZMA/LZMABlockEncoder.h
+
+#ifndef __LZMA_BLOCK_ENCODER_H
+#define __LZMA_BLOCK_ENCODER_H
+
+#include "../../../Common/MyCom.h"
+#include "../../../Common/MyVector.h"
+#include "../../../Windows/PropVariant.h"
+#include "../../ICoder.h"
+#include "../../Common/StreamObjects.h"
+
+#ifdef COMPRESS_MT
+#include "../../Common/VirtThread.h"
+#endif
+
+#include "LZMAEncoder.h"
+#include "LZMABlock.h"
+
+namespace NCompress {
+namespace NLZMABlock {
+
+struct CBlockEncoder
+{
+  NLZMA::CEncoder *LzmaEncoderSpec;
+  CMyComPtr<ICompressCoder> LzmaEncoder;
+  CSequentialOutStreamImp *OutStreamSpec;
+  CMyComPtr<ISequentialOutStream> OutStream;
+  Byte *InData;
+  UInt32 InSize;
+  UInt32 InBufSize;
+  HRESULT Result;
+
+  CBlockEncoder(): LzmaEncoderSpec(0), OutStreamSpec(0), InData(0), InBufSize(0) {}
+  ~CBlockEncoder() { Free(); }
+  void Free();
+  bool Alloc(UInt32 size);
+  HRESULT Encode();
+};
+
+#ifdef COMPRESS_MT
+
+struct CEncoderThread: public CBlockEncoder, public CVirtThread
+{
+  void Execute() 
+  { 
+    try { Result = Encode(); }
+    catch(...) { Result = E_OUTOFMEMORY; }
+  }
+};
+
+#endif
+
+class CEncoder:
+  public ICompressCoder,
+  public ICompressSetCoderProperties,
+  public ICompressWriteCoderProperties,
+  public CMyUnknownImp
+{
+  CRecordVector<PROPID> _propIDs;
+  CObjectVector<NWindows::NCOM::CPropVariant> _props;
+  UInt32 _dictionarySize;
+  UInt32 _blockSize;
+  UInt32 _numThreads;
+  UInt64 _inProcessed;
+  UInt64 _outProcessed;
+
+  #ifdef COMPRESS_MT
+  UInt32 _numThreadsPrev;
+  CEncoderThread *_threads;
+  void FreeThreads();
+  HRes CreateThreads(UInt32 numThreads);
+  HRESULT CodeMt(ISequentialInStream *inStream, ISequentialOutStream *outStream, 
+      ICompressProgressInfo *progress, UInt32 numThreads);
+  #endif
+
+  CBlockEncoder _block;
+
+  UInt32 GetBlockSize() const;
+  UInt32 GetDictionarySize() const;
+  HRESULT SetLzmaProperties(CBlockEncoder &block, UInt32 numMfThreads);
+  HRESULT ReadBlock(ISequentialInStream *inStream, CBlockEncoder &block);
+  HRESULT WriteBlock(ISequentialOutStream *outStream, const CBlockEncoder &block, 
+      ICompressProgressInfo *progress);
+  HRESULT CodeReal(ISequentialInStream *inStream, ISequentialOutStream *outStream, 
+      const UInt64 *inSize, ICompressProgressInfo *progress);
+public:
+  MY_UNKNOWN_IMP2(ICompressSetCoderProperties, ICompressWriteCoderProperties)
+ 
+  STDMETHOD(Code)(ISequentialInStream *inStream,
+      ISequentialOutStream *outStream, const UInt64 *inSize, const UInt64 *outSize,
+      ICompressProgressInfo *progress);
+
+  STDMETHOD(SetCoderProperties)(const PROPID *propIDs, 
+      const PROPVARIANT *properties, UInt32 numProperties);
+  STDMETHOD(WriteCoderProperties)(ISequentialOutStream *outStream);
+
+  CEncoder();
+  virtual ~CEncoder();
+};
+
+}}
+
+#endif
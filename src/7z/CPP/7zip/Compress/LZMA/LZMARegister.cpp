@@ -5,15 +5,23 @@
 #include "../../Common/RegisterCodec.h"
 
 #include "LZMADecoder.h"
+#include "LZMABlockDecoder.h"
 static void *CreateCodec() { return (void *)(ICompressCoder *)(new NCompress::NLZMA::CDecoder); }
+static void *CreateCodecBlock() { return (void *)(ICompressCoder *)(new NCompress::NLZMABlock::CDecoder); }
 #ifndef EXTRACT_ONLY
 #include "LZMAEncoder.h"
+#include "LZMABlockEncoder.h"
 static void *CreateCodecOut() { return (void *)(ICompressCoder *)(new NCompress::NLZMA::CEncoder);  }
+static void *CreateCodecBlockOut() { return (void *)(ICompressCoder *)(new NCompress::NLZMABlock::CEncoder);  }
 #else
 #define CreateCodecOut 0
+#define CreateCodecBlockOut 0
 #endif
 
-static CCodecInfo g_CodecInfo =
-  { CreateCodec, CreateCodecOut, 0x030101, L"LZMA", 1, false };
+static CCodecInfo g_CodecsInfo[] =
+{
+  { CreateCodec, CreateCodecOut, 0x030101, L"LZMA", 1, false },
+  { CreateCodecBlock, CreateCodecBlockOut, 0x037F0101, L"LZMABlock", 1, false }
+};
 
-REGISTER_CODEC(LZMA)
+REGISTER_CODECS(LZMA)
@@ -35,6 +35,9 @@
 extern "C"
 {
 #include "LzmaRamDecode.h"
+#ifdef _7ZIP_LARGE_PAGES
+#include "../../../../C/Alloc.h"
+#endif
 }
 
 using namespace NCommandLineParser;
@@ -72,7 +75,8 @@ enum Enum
   kEOS,
   kStdIn,
   kStdOut,
-  kFilter86
+  kFilter86,
+  kLargePages
 };
 }
 
@@ -92,7 +96,8 @@ static const CSwitchForm kSwitchForms[] =
   { L"EOS", NSwitchType::kSimple, false },
   { L"SI",  NSwitchType::kSimple, false },
   { L"SO",  NSwitchType::kSimple, false },
-  { L"F86",  NSwitchType::kPostChar, false, 0, 0, L"+" }
+  { L"F86",  NSwitchType::kPostChar, false, 0, 0, L"+" },
+  { L"SLP", NSwitchType::kSimple, false }
 };
 
 static const int kNumSwitches = sizeof(kSwitchForms) / sizeof(kSwitchForms[0]);
@@ -103,6 +108,11 @@ static void PrintHelp()
              "  e: encode file\n"
              "  d: decode file\n"
              "  b: Benchmark\n"
+             "  c: CRC32 Benchmark\n"
+             "  a: AES Benchmark\n"
+             "  m: LZMABlock multithread Benchmark\n"
+             "  f: Match finder Benchmark\n"
+             "  o: Open file Benchmark\n"
     "<Switches>\n"
     "  -a{N}:  set compression mode - [0, 1], default: 1 (max)\n"
     "  -d{N}:  set dictionary - [0,30], default: 23 (8MB)\n"
@@ -116,6 +126,9 @@ static void PrintHelp()
     "  -eos:   write End Of Stream marker\n"
     "  -si:    read data from stdin\n"
     "  -so:    write data to stdout\n"
+    #ifdef _7ZIP_LARGE_PAGES_SUPPORTED
+    "  -slp:   set Large Pages mode\n"
+    #endif
     );
 }
 
@@ -212,6 +225,11 @@ int main2(int n, const char *args[])
   if (parser[NKey::kMatchFinder].ThereIs)
     mf = parser[NKey::kMatchFinder].PostStrings[0];
 
+  #ifdef _7ZIP_LARGE_PAGES_SUPPORTED
+  if (parser[NKey::kLargePages].ThereIs)
+    SetLargePageSize();
+  #endif
+
   UInt32 numThreads = (UInt32)-1;
 
   #ifdef COMPRESS_MF_MT
@@ -239,6 +257,73 @@ int main2(int n, const char *args[])
     return LzmaBenchCon(stderr, numIterations, numThreads, dictionary);
   }
 
+  if (command.CompareNoCase(L"c") == 0)
+  {
+    const UInt32 kNumDefaultItereations = 1;
+    UInt32 numIterations = kNumDefaultItereations;
+    {
+      if (paramIndex < nonSwitchStrings.Size())
+        if (!GetNumber(nonSwitchStrings[paramIndex++], numIterations))
+          numIterations = kNumDefaultItereations;
+    }
+    return CrcBenchCon(stderr, numIterations, numThreads, dictionary);
+  }
+
+  if (command.CompareNoCase(L"a") == 0)
+  {
+    const UInt32 kNumDefaultItereations = 1;
+    UInt32 numIterations = kNumDefaultItereations;
+    {
+      if (paramIndex < nonSwitchStrings.Size())
+        if (!GetNumber(nonSwitchStrings[paramIndex++], numIterations))
+          numIterations = kNumDefaultItereations;
+    }
+    return AesBenchCon(stderr, numIterations, numThreads, dictionary);
+  }
+
+  if (command.CompareNoCase(L"m") == 0)
+  {
+    const UInt32 kNumDefaultItereations = 1;
+    UInt32 numIterations = kNumDefaultItereations;
+    {
+      if (paramIndex < nonSwitchStrings.Size())
+        if (!GetNumber(nonSwitchStrings[paramIndex++], numIterations))
+          numIterations = kNumDefaultItereations;
+    }
+    return LzmaBlockBenchCon(stderr, numIterations, numThreads, dictionary);
+  }
+
+  if (command.CompareNoCase(L"f") == 0)
+  {
+    const UInt32 kNumDefaultItereations = 1;
+    UInt32 numIterations = kNumDefaultItereations;
+    {
+      if (paramIndex < nonSwitchStrings.Size())
+        if (!GetNumber(nonSwitchStrings[paramIndex++], numIterations))
+          numIterations = kNumDefaultItereations;
+    }
+    return MatchFinderBenchCon(stderr, numIterations, numThreads, dictionary);
+  }
+
+  if (command.CompareNoCase(L"o") == 0)
+  {
+    if (paramIndex >= nonSwitchStrings.Size())
+      IncorrectCommand();
+    const UString &fileName = nonSwitchStrings[paramIndex++]; 
+    const UInt32 kNumDefaultItereations = 1000;
+    UInt32 numIterations = kNumDefaultItereations;
+    {
+      if (paramIndex < nonSwitchStrings.Size())
+        if (!GetNumber(nonSwitchStrings[paramIndex++], numIterations))
+          numIterations = kNumDefaultItereations;
+    }
+    HRESULT res = OpenBenchCon(stderr, GetSystemString(fileName), numIterations);
+    if (res == E_FAIL)
+      fprintf(stderr, "\nError: can not open input file %s\n", 
+          (const char *)GetOemString(fileName));
+    return res;
+  }
+
   if (numThreads == (UInt32)-1)
     numThreads = 1;
 
@@ -32,6 +32,9 @@ extern "C"
 { 
 #include "../../../../C/Alloc.h"
 #include "../../../../C/7zCrc.h"
+#ifndef _NO_CRYPTO
+#include "../../../../C/Crypto/Aes.h"
+#endif
 }
 #include "../../../Common/MyCom.h"
 #include "../../ICoder.h"
@@ -43,15 +46,22 @@ extern "C"
 
 #ifdef EXTERNAL_LZMA
 #include "../../../Windows/PropVariant.h"
+#include "../../Common/StreamObjects.h"
 #else
 #include "../LZMA/LZMADecoder.h"
 #include "../LZMA/LZMAEncoder.h"
+#include "../LZMA/LZMABlockDecoder.h"
+#include "../LZMA/LZMABlockEncoder.h"
+#include "../../Common/FileStreams.h"
+#include "../../Common/StreamUtils.h"
+#include "../../../Common/MyVector.h"
 #endif
 
 static const UInt32 kUncompressMinBlockSize = 1 << 26;
 static const UInt32 kAdditionalSize = (1 << 16);
 static const UInt32 kCompressedAdditionalSize = (1 << 10);
 static const UInt32 kMaxLzmaPropSize = 5;
+static const UInt32 kMaxPPMdPropSize = 9;
 
 class CBaseRandomGenerator
 {
@@ -840,6 +850,637 @@ HRESULT LzmaBench(
   return S_OK;
 }
 
+HRESULT LzmaBlockBench(
+  #ifdef EXTERNAL_LZMA
+  CCodecs *codecs,
+  #endif
+  UInt32 numThreads, UInt32 dictionarySize, UInt32 bufferSize, 
+  CBenchInfo &encodeInfo, CBenchInfo &decodeInfo)
+{
+  if (dictionarySize < (1 << kBenchMinDicLogSize) || numThreads < 1)
+    return E_INVALIDARG;
+
+  CMyComPtr<ICompressCoder> encoder;
+  CMyComPtr<ICompressCoder> decoder;
+  #ifdef EXTERNAL_LZMA
+  UString name = L"LZMABlock";
+  RINOK(codecs->CreateCoder(name, true, encoder));
+  RINOK(codecs->CreateCoder(name, false, decoder));
+  #else
+  encoder = new NCompress::NLZMABlock::CEncoder;
+  decoder = new NCompress::NLZMABlock::CDecoder;
+  #endif
+  if (!encoder || !decoder)
+    return E_NOTIMPL;
+
+  CBaseRandomGenerator rgBase;
+  CBenchRandomGenerator rg;
+  rg.Set(&rgBase);
+  if (!rg.Alloc(bufferSize))
+    return E_OUTOFMEMORY;
+  rg.Generate();
+  UInt32 crc = CrcCalc(rg.Buffer, rg.BufferSize);
+
+  CBenchmarkOutStream *outStreamSpec = new CBenchmarkOutStream;
+  CMyComPtr<ISequentialOutStream> outStream = outStreamSpec;
+  if (!outStreamSpec->Alloc(bufferSize + (bufferSize >> 3) + kAdditionalSize))
+    return E_OUTOFMEMORY;
+  CBenchmarkOutStream *propStreamSpec = new CBenchmarkOutStream;
+  CMyComPtr<ISequentialOutStream> propStream = propStreamSpec;
+  if (!propStreamSpec->Alloc(kMaxLzmaPropSize))
+    return E_OUTOFMEMORY;
+  propStreamSpec->Init();
+
+  PROPID propIDs[] = 
+  { 
+    NCoderPropID::kDictionarySize, 
+    NCoderPropID::kBlockSize, 
+    NCoderPropID::kNumThreads
+  };
+  const int kNumProps = sizeof(propIDs) / sizeof(propIDs[0]);
+  PROPVARIANT properties[kNumProps];
+  properties[0].vt = VT_UI4;
+  properties[0].ulVal = dictionarySize;
+  properties[1].vt = VT_UI4;
+  properties[1].ulVal = dictionarySize;
+  properties[2].vt = VT_UI4;
+  properties[2].ulVal = numThreads;
+  {
+    CMyComPtr<ICompressSetCoderProperties> setCoderProperties;
+    RINOK(encoder.QueryInterface(IID_ICompressSetCoderProperties, &setCoderProperties));
+    if (!setCoderProperties)
+      return E_FAIL;
+    RINOK(setCoderProperties->SetCoderProperties(propIDs, properties, kNumProps));
+    CMyComPtr<ICompressWriteCoderProperties> writeCoderProperties;
+    RINOK(encoder.QueryInterface(IID_ICompressWriteCoderProperties, &writeCoderProperties));
+    if (!writeCoderProperties)
+      return E_FAIL;
+    RINOK(writeCoderProperties->WriteCoderProperties(propStream));
+  }
+
+  CBenchmarkInStream *inStreamSpec = new CBenchmarkInStream;
+  CMyComPtr<ISequentialInStream> inStream = inStreamSpec;
+  
+  {
+    inStreamSpec->Init(rg.Buffer, rg.BufferSize);
+    outStreamSpec->Init();
+    const UInt64 inSize = bufferSize;
+    CBenchInfo start;
+    SetStartTime(start);
+    RINOK(encoder->Code(inStream, outStream, &inSize, 0, 0));
+    SetFinishTime(start, encodeInfo);
+    encodeInfo.UnpackSize = bufferSize;
+    encodeInfo.PackSize = outStreamSpec->Pos;
+    encodeInfo.NumIterations = 1;
+  }
+
+  {
+    CMyComPtr<ICompressSetDecoderProperties2> setDecoderProperties;
+    RINOK(decoder.QueryInterface(IID_ICompressSetDecoderProperties2, &setDecoderProperties));
+    if (!setDecoderProperties)
+      return E_FAIL;
+    RINOK(setDecoderProperties->SetDecoderProperties2(propStreamSpec->Buffer, propStreamSpec->Pos));
+    #ifdef COMPRESS_MT
+    CMyComPtr<ICompressSetCoderMt> setCoderMt;
+    decoder.QueryInterface(IID_ICompressSetCoderMt, &setCoderMt);
+    if (setCoderMt)
+    {
+      RINOK(setCoderMt->SetNumberOfThreads(numThreads));
+    }
+    #endif
+
+    CCrcOutStream *crcOutStreamSpec = new CCrcOutStream;
+    CMyComPtr<ISequentialOutStream> crcOutStream = crcOutStreamSpec;
+    inStreamSpec->Init(outStreamSpec->Buffer, outStreamSpec->Pos);
+    crcOutStreamSpec->Init();
+    CBenchInfo start;
+    SetStartTime(start);
+    RINOK(decoder->Code(inStream, crcOutStream, 0, 0, 0));
+    SetFinishTime(start, decodeInfo);
+    if (CRC_GET_DIGEST(crcOutStreamSpec->Crc) != crc)
+      return S_FALSE;
+    decodeInfo.UnpackSize = bufferSize;
+    decodeInfo.PackSize = outStreamSpec->Pos;
+    decodeInfo.NumIterations = 1;
+  }
+  return S_OK;
+}
+
+#ifdef EXTERNAL_LZMA
+
+HRESULT BZip2Bench(CCodecs *codecs, UInt32 numThreads, UInt32 bufferSize, 
+    CBenchInfo &encodeInfo, CBenchInfo &decodeInfo)
+{
+  if (numThreads < 1)
+    return E_INVALIDARG;
+
+  CMyComPtr<ICompressCoder> encoder;
+  CMyComPtr<ICompressCoder> decoder;
+  UString name = L"BZip2";
+  RINOK(codecs->CreateCoder(name, true, encoder));
+  RINOK(codecs->CreateCoder(name, false, decoder));
+  if (!encoder || !decoder)
+    return E_NOTIMPL;
+
+  CBaseRandomGenerator rgBase;
+  CBenchRandomGenerator rg;
+  rg.Set(&rgBase);
+  if (!rg.Alloc(bufferSize))
+    return E_OUTOFMEMORY;
+  rg.Generate();
+  UInt32 crc = CrcCalc(rg.Buffer, rg.BufferSize);
+
+  CBenchmarkOutStream *outStreamSpec = new CBenchmarkOutStream;
+  CMyComPtr<ISequentialOutStream> outStream = outStreamSpec;
+  if (!outStreamSpec->Alloc(bufferSize + (bufferSize >> 3) + kAdditionalSize))
+    return E_OUTOFMEMORY;
+
+  PROPID propIDs[] = 
+  { 
+    NCoderPropID::kDictionarySize, 
+    NCoderPropID::kNumThreads
+  };
+  const int kNumProps = sizeof(propIDs) / sizeof(propIDs[0]);
+  PROPVARIANT properties[kNumProps];
+  properties[0].vt = VT_UI4;
+  properties[0].ulVal = kBZip2BenchBlockSize;
+  properties[1].vt = VT_UI4;
+  properties[1].ulVal = numThreads;
+  {
+    CMyComPtr<ICompressSetCoderProperties> setCoderProperties;
+    RINOK(encoder.QueryInterface(IID_ICompressSetCoderProperties, &setCoderProperties));
+    if (!setCoderProperties)
+      return E_FAIL;
+    RINOK(setCoderProperties->SetCoderProperties(propIDs, properties, kNumProps));
+  }
+
+  CBenchmarkInStream *inStreamSpec = new CBenchmarkInStream;
+  CMyComPtr<ISequentialInStream> inStream = inStreamSpec;
+  
+  {
+    inStreamSpec->Init(rg.Buffer, rg.BufferSize);
+    outStreamSpec->Init();
+    const UInt64 inSize = bufferSize;
+    CBenchInfo start;
+    SetStartTime(start);
+    RINOK(encoder->Code(inStream, outStream, &inSize, 0, 0));
+    SetFinishTime(start, encodeInfo);
+    encodeInfo.UnpackSize = bufferSize;
+    encodeInfo.PackSize = outStreamSpec->Pos;
+    encodeInfo.NumIterations = 1;
+  }
+
+  {
+    #ifdef COMPRESS_MT
+    CMyComPtr<ICompressSetCoderMt> setCoderMt;
+    decoder.QueryInterface(IID_ICompressSetCoderMt, &setCoderMt);
+    if (setCoderMt)
+    {
+      RINOK(setCoderMt->SetNumberOfThreads(numThreads));
+    }
+    #endif
+
+    CCrcOutStream *crcOutStreamSpec = new CCrcOutStream;
+    CMyComPtr<ISequentialOutStream> crcOutStream = crcOutStreamSpec;
+    inStreamSpec->Init(outStreamSpec->Buffer, outStreamSpec->Pos);
+    crcOutStreamSpec->Init();
+    CBenchInfo start;
+    SetStartTime(start);
+    RINOK(decoder->Code(inStream, crcOutStream, 0, 0, 0));
+    SetFinishTime(start, decodeInfo);
+    if (CRC_GET_DIGEST(crcOutStreamSpec->Crc) != crc)
+      return S_FALSE;
+    decodeInfo.UnpackSize = bufferSize;
+    decodeInfo.PackSize = outStreamSpec->Pos;
+    decodeInfo.NumIterations = 1;
+  }
+  return S_OK;
+}
+
+// Text like source or log files: words from a small vocabulary,
+// where the first words are much more frequent than the last ones.
+static void GenerateBenchText(CBaseRandomGenerator &rg, Byte *data, size_t size)
+{
+  size_t pos = 0;
+  while (pos < size)
+  {
+    UInt32 r = rg.GetRnd();
+    UInt32 word = (r & 0x7FF) % (((r >> 11) & 0x7FF) + 1);
+    UInt32 h = word * 2654435761U + 1;
+    UInt32 len = 2 + (h >> 29);
+    for (UInt32 i = 0; i < len && pos < size; i++)
+    {
+      h = h * 1103515245 + 12345;
+      data[pos++] = (Byte)('a' + (h >> 16) % 26);
+    }
+    if (pos < size)
+      data[pos++] = (Byte)((((r >> 22) % 12) == 0) ? '\n' : ' ');
+  }
+}
+
+// In kPPMdBenchSharedModel mode the first coder trains the model 
+// and the next coders use that model.
+static HRESULT PrimePPMdCoder(ICompressCoder *coder, int mode, const Byte *data, UInt32 size,
+    CMyComPtr<IUnknown> &model)
+{
+  if (mode != kPPMdBenchPrimedCoders && mode != kPPMdBenchSharedModel)
+    return S_OK;
+  CMyComPtr<ICompressSetPrimingData> setPrimingData;
+  coder->QueryInterface(IID_ICompressSetPrimingData, (void **)&setPrimingData);
+  if (!setPrimingData)
+    return E_NOTIMPL;
+  if (model)
+    return setPrimingData->SetPrimingModel(model);
+  RINOK(setPrimingData->SetPrimingData(data, size));
+  if (mode == kPPMdBenchSharedModel)
+    return setPrimingData->GetPrimingModel(&model);
+  return S_OK;
+}
+
+HRESULT PPMdBench(CCodecs *codecs, int mode, UInt32 fileSize, UInt32 numFiles, UInt32 primingSize, 
+    CBenchInfo &encodeInfo, CBenchInfo &decodeInfo)
+{
+  if (fileSize == 0 || numFiles == 0)
+    return E_INVALIDARG;
+  UInt64 unpackSize64 = (UInt64)fileSize * numFiles;
+  if (unpackSize64 + primingSize > ((UInt32)1 << 30))
+    return E_INVALIDARG;
+  UInt32 unpackSize = (UInt32)unpackSize64;
+  if (mode != kPPMdBenchPrimedCoders && mode != kPPMdBenchSharedModel)
+    primingSize = 0;
+  bool newCoders = (mode == kPPMdBenchNewCoders || mode == kPPMdBenchSharedModel);
+
+  CBaseRandomGenerator rg;
+  CBenchBuffer data;
+  if (!data.Alloc(unpackSize + primingSize))
+    return E_OUTOFMEMORY;
+  GenerateBenchText(rg, data.Buffer, data.BufferSize);
+  const Byte *primingData = data.Buffer + unpackSize;
+  UInt32 crc = CrcCalc(data.Buffer, unpackSize);
+
+  CBenchmarkOutStream *outStreamSpec = new CBenchmarkOutStream;
+  CMyComPtr<ISequentialOutStream> outStream = outStreamSpec;
+  if (!outStreamSpec->Alloc(unpackSize + (unpackSize >> 1) + kAdditionalSize))
+    return E_OUTOFMEMORY;
+  outStreamSpec->Init();
+  CRecordVector<UInt32> packSizes;
+
+  CBenchmarkOutStream *propStreamSpec = new CBenchmarkOutStream;
+  CMyComPtr<ISequentialOutStream> propStream = propStreamSpec;
+  if (!propStreamSpec->Alloc(kMaxPPMdPropSize))
+    return E_OUTOFMEMORY;
+  propStreamSpec->Init();
+
+  CBenchmarkInStream *inStreamSpec = new CBenchmarkInStream;
+  CMyComPtr<ISequentialInStream> inStream = inStreamSpec;
+  
+  UString name = L"PPMD";
+  UInt32 i;
+  {
+    CMyComPtr<ICompressCoder> encoder;
+    CMyComPtr<IUnknown> model;
+    CBenchInfo start;
+    SetStartTime(start);
+    for (i = 0; i < numFiles; i++)
+    {
+      if (!encoder || newCoders)
+      {
+        encoder.Release();
+        RINOK(codecs->CreateCoder(name, true, encoder));
+        if (!encoder)
+          return E_NOTIMPL;
+        RINOK(PrimePPMdCoder(encoder, mode, primingData, primingSize, model));
+        if (i == 0)
+        {
+          CMyComPtr<ICompressWriteCoderProperties> writeCoderProperties;
+          encoder.QueryInterface(IID_ICompressWriteCoderProperties, &writeCoderProperties);
+          if (!writeCoderProperties)
+            return E_FAIL;
+          RINOK(writeCoderProperties->WriteCoderProperties(propStream));
+        }
+      }
+      UInt32 startPos = outStreamSpec->Pos;
+      inStreamSpec->Init(data.Buffer + (size_t)i * fileSize, fileSize);
+      RINOK(encoder->Code(inStream, outStream, 0, 0, 0));
+      packSizes.Add(outStreamSpec->Pos - startPos);
+    }
+    SetFinishTime(start, encodeInfo);
+    encodeInfo.UnpackSize = unpackSize;
+    encodeInfo.PackSize = outStreamSpec->Pos;
+    encodeInfo.NumIterations = 1;
+  }
+
+  {
+    CMyComPtr<ICompressCoder> decoder;
+    CMyComPtr<IUnknown> model;
+    CCrcOutStream *crcOutStreamSpec = new CCrcOutStream;
+    CMyComPtr<ISequentialOutStream> crcOutStream = crcOutStreamSpec;
+    crcOutStreamSpec->Init();
+    UInt32 packPos = 0;
+    CBenchInfo start;
+    SetStartTime(start);
+    for (i = 0; i < numFiles; i++)
+    {
+      if (!decoder || newCoders)
+      {
+        decoder.Release();
+        RINOK(codecs->CreateCoder(name, false, decoder));
+        if (!decoder)
+          return E_NOTIMPL;
+        CMyComPtr<ICompressSetDecoderProperties2> setDecoderProperties;
+        decoder.QueryInterface(IID_ICompressSetDecoderProperties2, &setDecoderProperties);
+        if (!setDecoderProperties)
+          return E_FAIL;
+        RINOK(setDecoderProperties->SetDecoderProperties2(propStreamSpec->Buffer, propStreamSpec->Pos));
+        RINOK(PrimePPMdCoder(decoder, mode, primingData, primingSize, model));
+      }
+      const UInt64 outSize = fileSize;
+      inStreamSpec->Init(outStreamSpec->Buffer + packPos, packSizes[i]);
+      RINOK(decoder->Code(inStream, crcOutStream, 0, &outSize, 0));
+      packPos += packSizes[i];
+    }
+    SetFinishTime(start, decodeInfo);
+    if (CRC_GET_DIGEST(crcOutStreamSpec->Crc) != crc)
+      return S_FALSE;
+    decodeInfo.UnpackSize = unpackSize;
+    decodeInfo.PackSize = outStreamSpec->Pos;
+    decodeInfo.NumIterations = 1;
+  }
+  return S_OK;
+}
+
+// gzip member header: ID = 1F 8B, Method = Deflate, Flags = 0, Time = 0, ExtraFlags = 0, HostOS = Unix
+static const Byte kBenchGZipHeader[10] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 3 };
+
+class CBenchExtractCallback: 
+  public IArchiveExtractCallback,
+  public CMyUnknownImp
+{
+public:
+  CMyComPtr<ISequentialOutStream> OutStream;
+  Int32 OperationResult;
+  MY_UNKNOWN_IMP
+  STDMETHOD(SetTotal)(UInt64 /* total */) { return S_OK; }
+  STDMETHOD(SetCompleted)(const UInt64 * /* completeValue */) { return S_OK; }
+  STDMETHOD(GetStream)(UInt32 /* index */, ISequentialOutStream **outStream, Int32 /* askExtractMode */)
+  {
+    CMyComPtr<ISequentialOutStream> stream = OutStream;
+    *outStream = stream.Detach();
+    return S_OK;
+  }
+  STDMETHOD(PrepareOperation)(Int32 /* askExtractMode */) { return S_OK; }
+  STDMETHOD(SetOperationResult)(Int32 operationResult)
+  {
+    OperationResult = operationResult;
+    return S_OK;
+  }
+};
+
+// It extracts opened gzip archive with numThreads range decoders.
+// If indexSpanLog != 0, handler also builds index with that span.
+
+static HRESULT GZipBenchExtract(IInArchive *archive, UInt32 numThreads, UInt32 indexSpanLog, 
+    UInt32 crc, CBenchInfo &info)
+{
+  CMyComPtr<ISetProperties> setProperties;
+  archive->QueryInterface(IID_ISetProperties, (void **)&setProperties);
+  if (!setProperties)
+    return E_NOTIMPL;
+  const wchar_t *names[] = { L"mt", L"ix" };
+  PROPVARIANT values[2];
+  values[0].vt = VT_UI4;
+  values[0].ulVal = numThreads;
+  values[1].vt = VT_UI4;
+  values[1].ulVal = indexSpanLog;
+  RINOK(setProperties->SetProperties(names, values, (indexSpanLog != 0) ? 2 : 1));
+
+  CBenchExtractCallback *callbackSpec = new CBenchExtractCallback;
+  CMyComPtr<IArchiveExtractCallback> callback = callbackSpec;
+  CCrcOutStream *crcOutStreamSpec = new CCrcOutStream;
+  callbackSpec->OutStream = crcOutStreamSpec;
+  callbackSpec->OperationResult = NArchive::NExtract::NOperationResult::kDataError;
+  crcOutStreamSpec->Init();
+  CBenchInfo start;
+  SetStartTime(start);
+  RINOK(archive->Extract(NULL, (UInt32)(Int32)-1, 0, callback));
+  SetFinishTime(start, info);
+  if (callbackSpec->OperationResult != NArchive::NExtract::NOperationResult::kOK ||
+      CRC_GET_DIGEST(crcOutStreamSpec->Crc) != crc)
+    return S_FALSE;
+  info.NumIterations = 1;
+  return S_OK;
+}
+
+HRESULT GZipRangeBench(CCodecs *codecs, UInt32 numThreads, UInt32 bufferSize, UInt32 indexSpanLog, 
+    CBenchInfo &encodeInfo, CBenchInfo &decodeInfo1, CBenchInfo &decodeInfo)
+{
+  if (numThreads < 1 || indexSpanLog == 0 || indexSpanLog >= 32)
+    return E_INVALIDARG;
+
+  CMyComPtr<ICompressCoder> encoder;
+  RINOK(codecs->CreateCoder(L"Deflate", true, encoder));
+  if (!encoder)
+    return E_NOTIMPL;
+  int formatIndex = codecs->FindFormatForArchiveType(L"gzip");
+  if (formatIndex < 0)
+    return E_NOTIMPL;
+  CMyComPtr<IInArchive> archive;
+  RINOK(codecs->CreateInArchive(formatIndex, archive));
+  if (!archive)
+    return E_NOTIMPL;
+
+  CBaseRandomGenerator rgBase;
+  CBenchRandomGenerator rg;
+  rg.Set(&rgBase);
+  if (!rg.Alloc(bufferSize))
+    return E_OUTOFMEMORY;
+  rg.Generate();
+  UInt32 crc = CrcCalc(rg.Buffer, rg.BufferSize);
+
+  CBenchmarkOutStream *outStreamSpec = new CBenchmarkOutStream;
+  CMyComPtr<ISequentialOutStream> outStream = outStreamSpec;
+  if (!outStreamSpec->Alloc(bufferSize + (bufferSize >> 3) + kAdditionalSize))
+    return E_OUTOFMEMORY;
+
+  {
+    CBenchmarkInStream *inStreamSpec = new CBenchmarkInStream;
+    CMyComPtr<ISequentialInStream> inStream = inStreamSpec;
+    inStreamSpec->Init(rg.Buffer, rg.BufferSize);
+    outStreamSpec->Init();
+    RINOK(outStream->Write(kBenchGZipHeader, sizeof(kBenchGZipHeader), NULL));
+    const UInt64 inSize = bufferSize;
+    CBenchInfo start;
+    SetStartTime(start);
+    RINOK(encoder->Code(inStream, outStream, &inSize, 0, 0));
+    SetFinishTime(start, encodeInfo);
+    Byte trailer[8];
+    for (int i = 0; i < 4; i++)
+    {
+      trailer[i] = (Byte)(crc >> (8 * i));
+      trailer[4 + i] = (Byte)(bufferSize >> (8 * i));
+    }
+    RINOK(outStream->Write(trailer, sizeof(trailer), NULL));
+    encodeInfo.UnpackSize = bufferSize;
+    encodeInfo.PackSize = outStreamSpec->Pos;
+    encodeInfo.NumIterations = 1;
+  }
+
+  CBufInStream *arcStreamSpec = new CBufInStream;
+  CMyComPtr<IInStream> arcStream = arcStreamSpec;
+  arcStreamSpec->Init(outStreamSpec->Buffer, outStreamSpec->Pos);
+  HRESULT res = archive->Open(arcStream, NULL, NULL);
+  if (res != S_OK)
+    return (res == S_FALSE) ? E_FAIL : res;
+
+  // first extracting sets Deflate checkpoints for index in handler.
+  // Then single thread decodes whole stream, and numThreads threads decode ranges of index.
+  CBenchInfo indexInfo;
+  res = GZipBenchExtract(archive, 1, indexSpanLog, crc, indexInfo);
+  if (res == S_OK)
+    res = GZipBenchExtract(archive, 1, 0, crc, decodeInfo1);
+  if (res == S_OK)
+    res = GZipBenchExtract(archive, numThreads, 0, crc, decodeInfo);
+  archive->Close();
+  RINOK(res);
+  decodeInfo1.UnpackSize = decodeInfo.UnpackSize = bufferSize;
+  decodeInfo1.PackSize = decodeInfo.PackSize = outStreamSpec->Pos;
+  return S_OK;
+}
+
+#endif
+
+#ifndef EXTERNAL_LZMA
+
+HRESULT MatchFinderBench(UInt32 numThreads, UInt32 dictionarySize, UInt32 bufferSize, 
+    const wchar_t *matchFinder, bool redundant, CBenchInfo &encodeInfo)
+{
+  CBaseRandomGenerator rgBase;
+  CBenchRandomGenerator rg;
+  rg.Set(&rgBase);
+  if (!rg.Alloc(bufferSize))
+    return E_OUTOFMEMORY;
+  rg.Generate();
+  if (redundant)
+  {
+    // like disk images: 64 KB chunks are repeated with rare changes, 
+    // so most matches reach the maximum length
+    const UInt32 kChunkSize = (1 << 16);
+    for (UInt32 pos = kChunkSize; pos < bufferSize; pos++)
+    {
+      Byte b = rg.Buffer[pos - kChunkSize];
+      if ((rgBase.GetRnd() & 0x3FF) == 0)
+        b++;
+      rg.Buffer[pos] = b;
+    }
+  }
+
+  CBenchmarkOutStream *outStreamSpec = new CBenchmarkOutStream;
+  CMyComPtr<ISequentialOutStream> outStream = outStreamSpec;
+  if (!outStreamSpec->Alloc(bufferSize + (bufferSize >> 3) + kAdditionalSize))
+    return E_OUTOFMEMORY;
+
+  NCompress::NLZMA::CEncoder *encoderSpec = new NCompress::NLZMA::CEncoder;
+  CMyComPtr<ICompressCoder> encoder = encoderSpec;
+  PROPID propIDs[] = 
+  { 
+    NCoderPropID::kDictionarySize, 
+    NCoderPropID::kMatchFinder, 
+    NCoderPropID::kNumThreads
+  };
+  const int kNumProps = sizeof(propIDs) / sizeof(propIDs[0]);
+  PROPVARIANT properties[kNumProps];
+  properties[0].vt = VT_UI4;
+  properties[0].ulVal = dictionarySize;
+  properties[1].vt = VT_BSTR;
+  properties[1].bstrVal = (BSTR)matchFinder;
+  properties[2].vt = VT_UI4;
+  properties[2].ulVal = numThreads;
+  RINOK(encoderSpec->SetCoderProperties(propIDs, properties, kNumProps));
+
+  CBenchmarkInStream *inStreamSpec = new CBenchmarkInStream;
+  CMyComPtr<ISequentialInStream> inStream = inStreamSpec;
+  inStreamSpec->Init(rg.Buffer, rg.BufferSize);
+  outStreamSpec->Init();
+  CBenchInfo start;
+  SetStartTime(start);
+  RINOK(encoder->Code(inStream, outStream, 0, 0, 0));
+  SetFinishTime(start, encodeInfo);
+  encodeInfo.UnpackSize = bufferSize;
+  encodeInfo.PackSize = outStreamSpec->Pos;
+  encodeInfo.NumIterations = 1;
+  return S_OK;
+}
+
+static const UInt32 kOpenHeadSize = (1 << 12);
+static const UInt32 kOpenTailSize = (1 << 16);
+static const UInt32 kOpenItemSize = 46;
+static const UInt32 kOpenLocalSize = 30;
+
+/*
+Archive handlers read small fields through ReadStream and seek between 
+the end of archive (central directory / headers) and local headers. 
+We repeat that pattern: small reads over the start of file, then small 
+records over the tail of file with a seek to some "local header" for 
+each record.
+*/
+
+static HRESULT OpenBenchOne(IInStream *stream, UInt64 &processed)
+{
+  Byte buf[kOpenItemSize];
+  UInt64 fileSize;
+  RINOK(stream->Seek(0, STREAM_SEEK_END, &fileSize));
+  RINOK(stream->Seek(0, STREAM_SEEK_SET, NULL));
+  UInt32 pos;
+  for (pos = 0; pos < kOpenHeadSize; pos += 16)
+  {
+    UInt32 size;
+    RINOK(ReadStream(stream, buf, 16, &size));
+    processed += size;
+    if (size != 16)
+      break;
+  }
+  UInt64 tailPos = (fileSize > kOpenTailSize) ? fileSize - kOpenTailSize : 0;
+  UInt32 seed = 0;
+  for (UInt64 itemPos = tailPos; itemPos + kOpenItemSize <= fileSize; itemPos += kOpenItemSize)
+  {
+    RINOK(stream->Seek(itemPos, STREAM_SEEK_SET, NULL));
+    UInt32 size;
+    RINOK(ReadStream(stream, buf, kOpenItemSize, &size));
+    processed += size;
+    for (int i = 0; i < 4; i++)
+      seed = seed * 0x9E3779B1 + buf[i] + 1;
+    UInt64 localPos = (tailPos > kOpenLocalSize) ? seed % (tailPos - kOpenLocalSize) : 0;
+    RINOK(stream->Seek(localPos, STREAM_SEEK_SET, NULL));
+    RINOK(ReadStream(stream, buf, kOpenLocalSize, &size));
+    processed += size;
+  }
+  return S_OK;
+}
+
+HRESULT OpenBench(LPCTSTR fileName, UInt32 numIterations, bool useMap, CBenchInfo &info)
+{
+  UInt64 processed = 0;
+  CBenchInfo start;
+  SetStartTime(start);
+  for (UInt32 i = 0; i < numIterations; i++)
+  {
+    CInFileStream *inStreamSpec = new CInFileStream;
+    CMyComPtr<IInStream> inStream = inStreamSpec;
+    #ifndef USE_WIN_FILE
+    inStreamSpec->UseMap = useMap;
+    #endif
+    if (!inStreamSpec->Open(fileName))
+      return E_FAIL;
+    RINOK(OpenBenchOne(inStream, processed));
+  }
+  SetFinishTime(start, info);
+  info.UnpackSize = processed;
+  info.PackSize = processed;
+  info.NumIterations = numIterations;
+  return S_OK;
+}
+
+#endif
 
 inline UInt64 GetLZMAUsage(bool multiThread, UInt32 dictionary)
 { 
@@ -954,11 +1595,30 @@ bool CrcInternalTest()
     return false;
   CBaseRandomGenerator RG;
   RandGen(buf + kBufferSize0, kBufferSize1, RG);
-  for (i = 0; i < kBufferSize0 + kBufferSize1 - kCheckSize; i++)
-    for (UInt32 j = 0; j < kCheckSize; j++)
-      if (CrcCalc1(buf + i, j) != CrcCalc(buf + i, j))
-        return false;
-  return true;
+  int implPrev = CrcGetImpl();
+  bool res = true;
+  for (int impl = 0; impl < CRC_NUM_IMPLS && res; impl++)
+  {
+    if (!CrcSetImpl(impl))
+      continue;
+    for (i = 0; i < kBufferSize0 + kBufferSize1 - kCheckSize && res; i++)
+      for (UInt32 j = 0; j < kCheckSize; j++)
+        if (CrcCalc1(buf + i, j) != CrcCalc(buf + i, j))
+        {
+          res = false;
+          break;
+        }
+    // long blocks for vector implementations
+    for (i = 0; i < 16 && res; i++)
+      for (UInt32 j = kBufferSize1 - (i + 1) * 61; j < kBufferSize1; j += 3)
+        if (CrcCalc1(buf + i, j) != CrcCalc(buf + i, j))
+        {
+          res = false;
+          break;
+        }
+  }
+  CrcSetImpl(implPrev);
+  return res;
 }
 
 HRESULT CrcBench(UInt32 numThreads, UInt32 bufferSize, UInt64 &speed)
@@ -1022,3 +1682,136 @@ HRESULT CrcBench(UInt32 numThreads, UInt32 bufferSize, UInt64 &speed)
   return S_OK;
 }
 
+#ifndef _NO_CRYPTO
+
+static const Byte kAesTestPlain[AES_BLOCK_SIZE] =
+  { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF };
+// FIPS-197 AES-256 example: key is 00 01 02 ... 1F
+static const Byte kAesTestCipher[AES_BLOCK_SIZE] =
+  { 0x8E, 0xA2, 0xB7, 0xCA, 0x51, 0x67, 0x45, 0xBF, 0xEA, 0xFC, 0x49, 0x90, 0x4B, 0x49, 0x60, 0x89 };
+
+static const unsigned kAesBenchKeySize = 32;
+
+struct CAesBenchCoder
+{
+  CAesCbc Cbc;
+  UInt32 Ctr[4];
+
+  void Init(int mode, const Byte *key, const Byte *iv)
+  {
+    if (mode == kAesBenchCbcDecode)
+      AesSetKeyDecode(&Cbc.aes, key, kAesBenchKeySize);
+    else
+      AesSetKeyEncode(&Cbc.aes, key, kAesBenchKeySize);
+    AesCbcInit(&Cbc, iv);
+    // low word is close to overflow to check carry to Ctr[1]
+    Ctr[0] = 0xFFFFFFF0;
+    Ctr[1] = Ctr[2] = Ctr[3] = 0;
+  }
+  void Code(int mode, Byte *data, UInt32 size)
+  {
+    switch (mode)
+    {
+      case kAesBenchCbcEncode: AesCbcEncode(&Cbc, data, size); break;
+      case kAesBenchCbcDecode: AesCbcDecode(&Cbc, data, size); break;
+      default: AesCtrCode(&Cbc.aes, Ctr, data, size / AES_BLOCK_SIZE);
+    }
+  }
+};
+
+bool AesInternalTest()
+{
+  AesGenTables();
+  Byte key[kAesBenchKeySize];
+  Byte iv[AES_BLOCK_SIZE];
+  unsigned i;
+  for (i = 0; i < kAesBenchKeySize; i++)
+    key[i] = (Byte)i;
+  for (i = 0; i < AES_BLOCK_SIZE; i++)
+    iv[i] = 0;
+
+  const UInt32 kBufferSize = (1 << 12);
+  CBenchBuffer buffer;
+  if (!buffer.Alloc(kBufferSize * (2 + kAesBenchNumModes)))
+    return false;
+  Byte *src = buffer.Buffer;
+  Byte *buf = src + kBufferSize;
+  Byte *refs = buf + kBufferSize;
+  CBaseRandomGenerator RG;
+  RandGen(src, kBufferSize, RG);
+
+  int implPrev = AesGetImpl();
+  bool res = true;
+  for (int impl = 0; impl < AES_NUM_IMPLS && res; impl++)
+  {
+    if (!AesSetImpl(impl))
+      continue;
+    CAesBenchCoder coder;
+    
+    // CBC with zero iv is same as ECB for first block
+    memcpy(buf, kAesTestPlain, AES_BLOCK_SIZE);
+    coder.Init(kAesBenchCbcEncode, key, iv);
+    coder.Code(kAesBenchCbcEncode, buf, AES_BLOCK_SIZE);
+    if (memcmp(buf, kAesTestCipher, AES_BLOCK_SIZE) != 0)
+      res = false;
+    coder.Init(kAesBenchCbcDecode, key, iv);
+    coder.Code(kAesBenchCbcDecode, buf, AES_BLOCK_SIZE);
+    if (memcmp(buf, kAesTestPlain, AES_BLOCK_SIZE) != 0)
+      res = false;
+
+    // calls of different sizes check the state between calls and the tails of multi-block loops
+    for (int mode = 0; mode < kAesBenchNumModes && res; mode++)
+    {
+      memcpy(buf, src, kBufferSize);
+      coder.Init(mode, key, key + AES_BLOCK_SIZE);
+      UInt32 pos = 0;
+      for (UInt32 step = 1; pos < kBufferSize; step++)
+      {
+        UInt32 size = (step % 19 + 1) * AES_BLOCK_SIZE;
+        if (size > kBufferSize - pos)
+          size = kBufferSize - pos;
+        coder.Code(mode, buf + pos, size);
+        pos += size;
+      }
+      Byte *ref = refs + mode * kBufferSize;
+      if (impl == AES_IMPL_TABLE)
+        memcpy(ref, buf, kBufferSize);
+      else if (memcmp(ref, buf, kBufferSize) != 0)
+        res = false;
+    }
+  }
+  AesSetImpl(implPrev);
+  return res;
+}
+
+HRESULT AesBench(int mode, UInt32 bufferSize, UInt64 &speed)
+{
+  bufferSize &= ~(UInt32)(AES_BLOCK_SIZE - 1);
+  if (bufferSize == 0)
+    return E_INVALIDARG;
+  CBenchBuffer buffer;
+  if (!buffer.Alloc(bufferSize))
+    return E_OUTOFMEMORY;
+  Byte *buf = buffer.Buffer;
+  CBaseRandomGenerator RG;
+  RandGen(buf, bufferSize, RG);
+  Byte key[kAesBenchKeySize];
+  RandGen(key, kAesBenchKeySize, RG);
+
+  CAesBenchCoder coder;
+  coder.Init(mode, key, key);
+  UInt32 numCycles = ((UInt32)1 << 26) / bufferSize + 1;
+  
+  UInt64 timeVal = GetTimeCount();
+  for (UInt32 i = 0; i < numCycles; i++)
+    coder.Code(mode, buf, bufferSize);
+  timeVal = GetTimeCount() - timeVal;
+  if (timeVal == 0)
+    timeVal = 1;
+
+  UInt64 size = (UInt64)numCycles * bufferSize;
+  speed = MyMultDiv64(size, timeVal, GetFreq());
+  return S_OK;
+}
+
+#endif
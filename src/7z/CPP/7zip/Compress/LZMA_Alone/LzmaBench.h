@@ -40,9 +40,65 @@ HRESULT LzmaBench(
 
 const int kBenchMinDicLogSize = 18;
 
+HRESULT LzmaBlockBench(
+  #ifdef EXTERNAL_LZMA
+  CCodecs *codecs,
+  #endif
+  UInt32 numThreads, UInt32 dictionarySize, UInt32 bufferSize, 
+  CBenchInfo &encodeInfo, CBenchInfo &decodeInfo);
+
+#ifdef EXTERNAL_LZMA
+const UInt32 kBZip2BenchBlockSize = 900000;
+
+// encodes bufferSize bytes with BZip2 and decodes them with numThreads threads
+HRESULT BZip2Bench(CCodecs *codecs, UInt32 numThreads, UInt32 bufferSize, 
+    CBenchInfo &encodeInfo, CBenchInfo &decodeInfo);
+
+const int kPPMdBenchNewCoders = 0;
+const int kPPMdBenchReusedCoders = 1;
+const int kPPMdBenchPrimedCoders = 2;
+const int kPPMdBenchSharedModel = 3;
+
+// encodes and decodes numFiles text files of fileSize bytes as separate streams.
+// kPPMdBenchPrimedCoders primes the model with primingSize bytes of similar text.
+// kPPMdBenchSharedModel creates new coders for each file, that share one primed model.
+HRESULT PPMdBench(CCodecs *codecs, int mode, UInt32 fileSize, UInt32 numFiles, UInt32 primingSize, 
+    CBenchInfo &encodeInfo, CBenchInfo &decodeInfo);
+
+// encodes bufferSize bytes to gzip archive in memory and extracts it with gzip handler
+// with index of Deflate checkpoints at (1 << indexSpanLog) bytes: decodeInfo1 is for
+// one thread that decodes whole stream, decodeInfo is for numThreads range decoders.
+HRESULT GZipRangeBench(CCodecs *codecs, UInt32 numThreads, UInt32 bufferSize, UInt32 indexSpanLog, 
+    CBenchInfo &encodeInfo, CBenchInfo &decodeInfo1, CBenchInfo &decodeInfo);
+#endif
+
+#ifndef EXTERNAL_LZMA
+HRESULT MatchFinderBench(UInt32 numThreads, UInt32 dictionarySize, UInt32 bufferSize, 
+    const wchar_t *matchFinder, bool redundant, CBenchInfo &encodeInfo);
+
+// opens the file numIterations times and reads headers like archive handlers do.
+// useMap is ignored, if the file stream can't map files.
+HRESULT OpenBench(LPCTSTR fileName, UInt32 numIterations, bool useMap, CBenchInfo &info);
+#endif
+
 UInt64 GetBenchMemoryUsage(UInt32 numThreads, UInt32 dictionary);
 
 bool CrcInternalTest();
 HRESULT CrcBench(UInt32 numThreads, UInt32 bufferSize, UInt64 &speed);
 
+#ifndef _NO_CRYPTO
+
+const int kAesBenchCbcEncode = 0;
+const int kAesBenchCbcDecode = 1;
+const int kAesBenchCtr = 2;
+const int kAesBenchNumModes = 3;
+
+// checks AES-256 test vector and compares all AES implementations with table version.
+// It calls AesGenTables.
+bool AesInternalTest();
+// speed of AES-256 in (mode) for current AES implementation
+HRESULT AesBench(int mode, UInt32 bufferSize, UInt64 &speed);
+
+#endif
+
 #endif
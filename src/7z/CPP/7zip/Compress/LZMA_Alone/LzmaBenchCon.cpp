@@ -17,6 +17,27 @@
 #endif
 #include "../../../Common/MyCom.h"
 
+extern "C" 
+{ 
+#include "../../../../C/7zCrc.h"
+#ifndef _NO_CRYPTO
+#include "../../../../C/Crypto/Aes.h"
+#endif
+#ifndef EXTERNAL_LZMA
+#include "../../../../C/Compress/Lz/MatchFinder.h"
+#endif
+#ifdef _7ZIP_LARGE_PAGES
+#include "../../../../C/Alloc.h"
+#endif
+}
+
+#if defined(_7ZIP_LARGE_PAGES) && defined(_WIN32)
+extern "C" 
+{
+  extern SIZE_T g_LargePageSize;
+}
+#endif
+
 struct CTotalBenchRes
 {
   UInt64 NumIterations;
@@ -152,6 +173,27 @@ HRESULT CBenchCallback::SetDecodeResult(const CBenchInfo &info, bool final)
   return S_OK;
 }
 
+#ifdef _7ZIP_LARGE_PAGES_SUPPORTED
+static void PrintLargePages(FILE *f)
+{
+  fprintf(f, "\nLarge pages: ");
+  if (g_LargePageSize == 0)
+  {
+    fprintf(f, "-");
+    return;
+  }
+  fprintf(f, "%u KB", (unsigned int)(g_LargePageSize >> 10));
+  #ifndef _WIN32
+  switch (g_LargePageMode)
+  {
+    case LARGE_PAGE_MODE_HUGETLB: fprintf(f, " (hugetlb)"); break;
+    case LARGE_PAGE_MODE_MADVISE: fprintf(f, " (madvise)"); break;
+    default: fprintf(f, " (not used)"); break;
+  }
+  #endif
+}
+#endif
+
 static void PrintRequirements(FILE *f, const char *sizeString, UInt64 size, const char *threadsString, UInt32 numThreads)
 {
   fprintf(f, "\nRAM %s ", sizeString);
@@ -239,34 +281,328 @@ HRESULT LzmaBenchCon(
   CTotalBenchRes midRes;
   midRes.SetMid(callback.EncodeRes, callback.DecodeRes);
   PrintTotals(f, midRes);
+  #ifdef _7ZIP_LARGE_PAGES_SUPPORTED
+  PrintLargePages(f);
+  #endif
   fprintf(f, "\n");
   return S_OK;
 }
 
-struct CTempValues
+HRESULT LzmaBlockBenchCon(
+  #ifdef EXTERNAL_LZMA
+  CCodecs *codecs,
+  #endif
+  FILE *f, UInt32 numIterations, UInt32 numThreads, UInt32 dictionary)
 {
-  UInt64 *Values;
-  CTempValues(UInt32 num) { Values = new UInt64[num]; }
-  ~CTempValues() { delete []Values; }
-};
+  #ifdef COMPRESS_MT
+  UInt32 numCPUs = NWindows::NSystem::GetNumberOfProcessors();
+  if (numThreads == (UInt32)-1)
+    numThreads = numCPUs;
+  #else
+  numThreads = 1;
+  #endif
+  if (dictionary == (UInt32)-1)
+    dictionary = (1 << 20);
+  
+  // same data for all rows: every thread gets at least 2 blocks
+  UInt32 numBlocks = numThreads * 2;
+  if (numBlocks < 8)
+    numBlocks = 8;
+  UInt64 bufferSize = (UInt64)dictionary * numBlocks;
+  if (bufferSize > ((UInt32)1 << 30))
+    return E_INVALIDARG;
 
-HRESULT CrcBenchCon(FILE *f, UInt32 numIterations, UInt32 numThreads, UInt32 dictionary)
-{
-  if (!CrcInternalTest())
-    return S_FALSE;
+  fprintf(f, "\nLZMABlock: block size = dictionary = %u KB, data size = %u MB\n\n", 
+      (unsigned int)(dictionary >> 10), (unsigned int)(bufferSize >> 20));
+  fprintf(f, "Threads  Compressing  Decompressing  Ratio\n");
+  fprintf(f, "                KB/s           KB/s      %%\n\n");
 
-  #ifdef BENCH_MT
-  UInt64 ramSize = NWindows::NSystem::GetRamSize();
+  for (UInt32 i = 0; i < numIterations; i++)
+  {
+    for (UInt32 t = 1; t <= numThreads; t++)
+    {
+      #ifdef BREAK_HANDLER
+      if (NConsoleClose::TestBreakSignal())
+        return E_ABORT;
+      #endif
+      CBenchInfo encodeInfo, decodeInfo;
+      RINOK(LzmaBlockBench(
+        #ifdef EXTERNAL_LZMA
+        codecs,
+        #endif
+        t, dictionary, (UInt32)bufferSize, encodeInfo, decodeInfo));
+      fprintf(f, "%4u:  ", (unsigned int)t);
+      PrintNumber(f, MyMultDiv64(encodeInfo.UnpackSize, encodeInfo.GlobalTime, encodeInfo.GlobalFreq) / 1024, 11);
+      PrintNumber(f, MyMultDiv64(decodeInfo.UnpackSize, decodeInfo.GlobalTime, decodeInfo.GlobalFreq) / 1024, 14);
+      PrintNumber(f, encodeInfo.PackSize * 100 / encodeInfo.UnpackSize, 6);
+      fprintf(f, "\n");
+    }
+  }
+  return S_OK;
+}
+
+#ifdef EXTERNAL_LZMA
+
+HRESULT BZip2BenchCon(CCodecs *codecs, FILE *f, UInt32 numIterations, UInt32 numThreads, UInt32 dictionary)
+{
+  #ifdef COMPRESS_MT
   UInt32 numCPUs = NWindows::NSystem::GetNumberOfProcessors();
-  PrintRequirements(f, "size: ", ramSize, "CPU hardware threads:", numCPUs);
   if (numThreads == (UInt32)-1)
     numThreads = numCPUs;
   #else
   numThreads = 1;
   #endif
+  
+  // same data for all rows: every thread gets at least 2 blocks
+  UInt32 numBlocks = numThreads * 2;
+  if (numBlocks < 8)
+    numBlocks = 8;
+  UInt64 bufferSize = (UInt64)kBZip2BenchBlockSize * numBlocks;
+  if (dictionary != (UInt32)-1 && dictionary > bufferSize)
+    bufferSize = dictionary;
+  if (bufferSize > ((UInt32)1 << 30))
+    return E_INVALIDARG;
+
+  fprintf(f, "\nBZip2: block size = %u KB, data size = %u MB\n\n", 
+      (unsigned int)(kBZip2BenchBlockSize / 1000), (unsigned int)(bufferSize >> 20));
+  fprintf(f, "Threads  Compressing  Decompressing  Scaling  Ratio\n");
+  fprintf(f, "                KB/s           KB/s        %%      %%\n\n");
+
+  for (UInt32 i = 0; i < numIterations; i++)
+  {
+    UInt64 decodeSpeed1 = 0;
+    for (UInt32 t = 1; t <= numThreads; t++)
+    {
+      #ifdef BREAK_HANDLER
+      if (NConsoleClose::TestBreakSignal())
+        return E_ABORT;
+      #endif
+      CBenchInfo encodeInfo, decodeInfo;
+      RINOK(BZip2Bench(codecs, t, (UInt32)bufferSize, encodeInfo, decodeInfo));
+      UInt64 decodeSpeed = MyMultDiv64(decodeInfo.UnpackSize, decodeInfo.GlobalTime, decodeInfo.GlobalFreq);
+      if (t == 1)
+        decodeSpeed1 = decodeSpeed;
+      fprintf(f, "%4u:  ", (unsigned int)t);
+      PrintNumber(f, MyMultDiv64(encodeInfo.UnpackSize, encodeInfo.GlobalTime, encodeInfo.GlobalFreq) / 1024, 11);
+      PrintNumber(f, decodeSpeed / 1024, 14);
+      PrintNumber(f, (decodeSpeed1 == 0) ? 0 : decodeSpeed * 100 / decodeSpeed1, 8);
+      PrintNumber(f, encodeInfo.PackSize * 100 / encodeInfo.UnpackSize, 6);
+      fprintf(f, "\n");
+    }
+  }
+  return S_OK;
+}
+
+HRESULT PPMdBenchCon(CCodecs *codecs, FILE *f, UInt32 numIterations, UInt32 /* numThreads */, UInt32 dictionary)
+{
+  const UInt32 kNumFiles = 256;
+  const UInt32 kPrimingSize = (1 << 16);
+  UInt32 fileSize = (1 << 12);
+  if (dictionary != (UInt32)-1)
+    fileSize = dictionary;
+  if (fileSize == 0 || fileSize > ((UInt32)1 << 20))
+    return E_INVALIDARG;
+
+  fprintf(f, "\nPPMd: %u files of %u bytes, priming sample = %u KB\n\n", 
+      (unsigned int)kNumFiles, (unsigned int)fileSize, (unsigned int)(kPrimingSize >> 10));
+  fprintf(f, "Coders  Compressing  Decompressing  Ratio\n");
+  fprintf(f, "               KB/s           KB/s      %%\n\n");
+
+  static const char *kModeNames[] = { "New   ", "Reused", "Primed", "Shared" };
+  for (UInt32 i = 0; i < numIterations; i++)
+  {
+    for (int mode = kPPMdBenchNewCoders; mode <= kPPMdBenchSharedModel; mode++)
+    {
+      #ifdef BREAK_HANDLER
+      if (NConsoleClose::TestBreakSignal())
+        return E_ABORT;
+      #endif
+      CBenchInfo encodeInfo, decodeInfo;
+      RINOK(PPMdBench(codecs, mode, fileSize, kNumFiles, kPrimingSize, encodeInfo, decodeInfo));
+      fprintf(f, "%s", kModeNames[mode]);
+      PrintNumber(f, MyMultDiv64(encodeInfo.UnpackSize, encodeInfo.GlobalTime, encodeInfo.GlobalFreq) / 1024, 12);
+      PrintNumber(f, MyMultDiv64(decodeInfo.UnpackSize, decodeInfo.GlobalTime, decodeInfo.GlobalFreq) / 1024, 14);
+      PrintNumber(f, encodeInfo.PackSize * 100 / encodeInfo.UnpackSize, 6);
+      fprintf(f, "\n");
+    }
+  }
+  return S_OK;
+}
+
+HRESULT GZipBenchCon(CCodecs *codecs, FILE *f, UInt32 numIterations, UInt32 numThreads, UInt32 dictionary)
+{
+  #ifdef COMPRESS_MT
+  if (numThreads == (UInt32)-1)
+    numThreads = NWindows::NSystem::GetNumberOfProcessors();
+  #else
+  numThreads = 1;
+  #endif
+  
+  // every thread gets at least 4 ranges of index
+  const UInt32 kIndexSpanLog = 20;
+  UInt64 bufferSize = (UInt64)numThreads << (kIndexSpanLog + 2);
+  if (bufferSize < ((UInt32)1 << 25))
+    bufferSize = ((UInt32)1 << 25);
+  if (dictionary != (UInt32)-1)
+    bufferSize = dictionary;
+  if (bufferSize < ((UInt32)1 << kIndexSpanLog) || bufferSize > ((UInt32)1 << 30))
+    return E_INVALIDARG;
+
+  fprintf(f, "\nGZip: index span = %u KB, data size = %u MB\n\n", 
+      (unsigned int)(1 << (kIndexSpanLog - 10)), (unsigned int)(bufferSize >> 20));
+  fprintf(f, "Threads  Compressing  Decompressing  Scaling  Ratio\n");
+  fprintf(f, "                KB/s           KB/s        %%      %%\n\n");
+
+  for (UInt32 i = 0; i < numIterations; i++)
+  {
+    #ifdef BREAK_HANDLER
+    if (NConsoleClose::TestBreakSignal())
+      return E_ABORT;
+    #endif
+    CBenchInfo encodeInfo, decodeInfo1, decodeInfo;
+    RINOK(GZipRangeBench(codecs, numThreads, (UInt32)bufferSize, kIndexSpanLog, encodeInfo, decodeInfo1, decodeInfo));
+    UInt64 encodeSpeed = MyMultDiv64(encodeInfo.UnpackSize, encodeInfo.GlobalTime, encodeInfo.GlobalFreq);
+    UInt64 decodeSpeed1 = MyMultDiv64(decodeInfo1.UnpackSize, decodeInfo1.GlobalTime, decodeInfo1.GlobalFreq);
+    UInt64 decodeSpeed = MyMultDiv64(decodeInfo.UnpackSize, decodeInfo.GlobalTime, decodeInfo.GlobalFreq);
+    fprintf(f, "%4u:  ", (unsigned int)1);
+    PrintNumber(f, encodeSpeed / 1024, 11);
+    PrintNumber(f, decodeSpeed1 / 1024, 14);
+    PrintNumber(f, 100, 8);
+    PrintNumber(f, encodeInfo.PackSize * 100 / encodeInfo.UnpackSize, 6);
+    fprintf(f, "\n");
+    fprintf(f, "%4u:  ", (unsigned int)numThreads);
+    PrintNumber(f, encodeSpeed / 1024, 11);
+    PrintNumber(f, decodeSpeed / 1024, 14);
+    PrintNumber(f, (decodeSpeed1 == 0) ? 0 : decodeSpeed * 100 / decodeSpeed1, 8);
+    PrintNumber(f, encodeInfo.PackSize * 100 / encodeInfo.UnpackSize, 6);
+    fprintf(f, "\n");
+  }
+  return S_OK;
+}
+
+#endif
+
+#ifndef EXTERNAL_LZMA
+
+static const char *kMatchLenImplNames[MF_MATCH_LEN_NUM_IMPLS] = 
+{
+  "BYTE",
+  "WORD",
+  "SSE2"
+};
+
+HRESULT MatchFinderBenchCon(FILE *f, UInt32 numIterations, UInt32 numThreads, UInt32 dictionary)
+{
+  #ifdef BENCH_MT
+  if (numThreads == (UInt32)-1)
+    numThreads = 1;
+  #else
+  numThreads = 1;
+  #endif
   if (dictionary == (UInt32)-1)
-    dictionary = (1 << 24);
+    dictionary = (1 << 22);
+  if (dictionary < (1 << kBenchMinDicLogSize))
+    return E_INVALIDARG;
+  
+  static const wchar_t *kMatchFinders[] = { L"BT4", L"HC4" };
+  static const char *kMatchFinderNames[] = { "BT4", "HC4" };
+  const int kNumMatchFinders = sizeof(kMatchFinders) / sizeof(kMatchFinders[0]);
+
+  fprintf(f, "\nMatch finder: dictionary = data size = %u KB, threads = %u\n\n", 
+      (unsigned int)(dictionary >> 10), (unsigned int)numThreads);
+  fprintf(f, "MF   Data       Length  Compressing   Ratio\n");
+  fprintf(f, "                               KB/s       %%\n\n");
+
+  int implPrev = MatchFinder_GetMatchLenImpl();
+  HRESULT res = S_OK;
+  for (UInt32 i = 0; i < numIterations && res == S_OK; i++)
+    for (int mf = 0; mf < kNumMatchFinders && res == S_OK; mf++)
+      for (int redundant = 0; redundant < 2 && res == S_OK; redundant++)
+      {
+        UInt64 packSizePrev = 0;
+        for (int impl = 0; impl < MF_MATCH_LEN_NUM_IMPLS; impl++)
+        {
+          if (!MatchFinder_SetMatchLenImpl(impl))
+            continue;
+          #ifdef BREAK_HANDLER
+          if (NConsoleClose::TestBreakSignal())
+          {
+            res = E_ABORT;
+            break;
+          }
+          #endif
+          CBenchInfo info;
+          res = MatchFinderBench(numThreads, dictionary, dictionary, kMatchFinders[mf], redundant != 0, info);
+          if (res != S_OK)
+            break;
+          // all match length implementations must give the same stream
+          if (packSizePrev != 0 && info.PackSize != packSizePrev)
+          {
+            res = S_FALSE;
+            break;
+          }
+          packSizePrev = info.PackSize;
+          UInt64 ratio = info.PackSize * 10000 / info.UnpackSize;
+          fprintf(f, "%-4s %-10s %-6s", kMatchFinderNames[mf], redundant ? "redundant" : "bench", kMatchLenImplNames[impl]);
+          PrintNumber(f, MyMultDiv64(info.UnpackSize, info.GlobalTime, info.GlobalFreq) / 1024, 13);
+          fprintf(f, " %4u.%02u\n", (unsigned int)(ratio / 100), (unsigned int)(ratio % 100));
+        }
+      }
+  MatchFinder_SetMatchLenImpl(implPrev);
+  return res;
+}
 
+HRESULT OpenBenchCon(FILE *f, LPCTSTR fileName, UInt32 numIterations)
+{
+  if (numIterations == 0)
+    numIterations = 1;
+  #ifdef _WIN32
+  const int kNumModes = 1;
+  static const char *kModeNames[] = { "read" };
+  #else
+  const int kNumModes = 2;
+  static const char *kModeNames[] = { "read", "mmap" };
+  #endif
+
+  fprintf(f, "\nOpen: %u times\n\n", (unsigned int)numIterations);
+  fprintf(f, "Mode      Time      Opens         Speed\n");
+  fprintf(f, "            ms        1/s          KB/s\n\n");
+
+  for (int mode = 0; mode < kNumModes; mode++)
+  {
+    #ifdef BREAK_HANDLER
+    if (NConsoleClose::TestBreakSignal())
+      return E_ABORT;
+    #endif
+    CBenchInfo info;
+    RINOK(OpenBench(fileName, numIterations, mode != 0, info));
+    fprintf(f, "%-6s", kModeNames[mode]);
+    PrintNumber(f, info.GlobalTime * 1000 / info.GlobalFreq, 8);
+    PrintNumber(f, MyMultDiv64(numIterations, info.GlobalTime, info.GlobalFreq), 11);
+    PrintNumber(f, MyMultDiv64(info.UnpackSize, info.GlobalTime, info.GlobalFreq) / 1024, 14);
+    fprintf(f, "\n");
+  }
+  return S_OK;
+}
+
+#endif
+
+struct CTempValues
+{
+  UInt64 *Values;
+  CTempValues(UInt32 num) { Values = new UInt64[num]; }
+  ~CTempValues() { delete []Values; }
+};
+
+static const char *kCrcImplNames[CRC_NUM_IMPLS] = 
+{
+  "T1",
+  "T8",
+  "PCLMUL"
+};
+
+static HRESULT CrcBenchCon2(FILE *f, UInt32 numIterations, UInt32 numThreads, UInt32 dictionary)
+{
   CTempValues speedTotals(numThreads);
   fprintf(f, "\n\nSize");
   for (UInt32 ti = 0; ti < numThreads; ti++)
@@ -309,3 +645,109 @@ HRESULT CrcBenchCon(FILE *f, UInt32 numIterations, UInt32 numThreads, UInt32 dic
   }
   return S_OK;
 }
+
+HRESULT CrcBenchCon(FILE *f, UInt32 numIterations, UInt32 numThreads, UInt32 dictionary)
+{
+  if (!CrcInternalTest())
+    return S_FALSE;
+
+  #ifdef BENCH_MT
+  UInt64 ramSize = NWindows::NSystem::GetRamSize();
+  UInt32 numCPUs = NWindows::NSystem::GetNumberOfProcessors();
+  PrintRequirements(f, "size: ", ramSize, "CPU hardware threads:", numCPUs);
+  if (numThreads == (UInt32)-1)
+    numThreads = numCPUs;
+  #else
+  numThreads = 1;
+  #endif
+  if (dictionary == (UInt32)-1)
+    dictionary = (1 << 24);
+
+  int implPrev = CrcGetImpl();
+  HRESULT res = S_OK;
+  for (int impl = 0; impl < CRC_NUM_IMPLS; impl++)
+  {
+    if (!CrcSetImpl(impl))
+      continue;
+    fprintf(f, "\n\nCRC: %s", kCrcImplNames[impl]);
+    res = CrcBenchCon2(f, numIterations, numThreads, dictionary);
+    if (res != S_OK)
+      break;
+  }
+  CrcSetImpl(implPrev);
+  return res;
+}
+
+#ifndef _NO_CRYPTO
+
+static const char *kAesImplNames[AES_NUM_IMPLS] = 
+{
+  "Table",
+  "AES-NI"
+};
+
+static HRESULT AesBenchCon2(FILE *f, UInt32 numIterations, UInt32 dictionary)
+{
+  UInt64 speedTotals[kAesBenchNumModes];
+  int mode;
+  fprintf(f, "\n\nSize  CBC-Enc CBC-Dec     CTR\n\n");
+  for (mode = 0; mode < kAesBenchNumModes; mode++)
+    speedTotals[mode] = 0;
+
+  UInt64 numSteps = 0;
+  for (UInt32 i = 0; i < numIterations; i++)
+  {
+    for (int pow = 10; pow < 32; pow++)
+    {
+      UInt32 bufSize = (UInt32)1 << pow;
+      if (bufSize > dictionary)
+        break;
+      fprintf(f, "%2d: ", pow);
+      for (mode = 0; mode < kAesBenchNumModes; mode++)
+      {
+        #ifdef BREAK_HANDLER
+        if (NConsoleClose::TestBreakSignal())
+          return E_ABORT;
+        #endif
+        UInt64 speed;
+        RINOK(AesBench(mode, bufSize, speed));
+        PrintNumber(f, (speed >> 20), 8);
+        speedTotals[mode] += speed;
+      }
+      fprintf(f, "\n");
+      numSteps++;
+    }
+  }
+  if (numSteps != 0)
+  {
+    fprintf(f, "\nAvg:");
+    for (mode = 0; mode < kAesBenchNumModes; mode++)
+      PrintNumber(f, ((speedTotals[mode] / numSteps) >> 20), 8);
+    fprintf(f, "\n");
+  }
+  return S_OK;
+}
+
+HRESULT AesBenchCon(FILE *f, UInt32 numIterations, UInt32 /* numThreads */, UInt32 dictionary)
+{
+  if (!AesInternalTest())
+    return S_FALSE;
+  if (dictionary == (UInt32)-1)
+    dictionary = (1 << 20);
+
+  int implPrev = AesGetImpl();
+  HRESULT res = S_OK;
+  for (int impl = 0; impl < AES_NUM_IMPLS; impl++)
+  {
+    if (!AesSetImpl(impl))
+      continue;
+    fprintf(f, "\n\nAES-256: %s", kAesImplNames[impl]);
+    res = AesBenchCon2(f, numIterations, dictionary);
+    if (res != S_OK)
+      break;
+  }
+  AesSetImpl(implPrev);
+  return res;
+}
+
+#endif
@@ -14,7 +14,32 @@ HRESULT LzmaBenchCon(
   #endif
   FILE *f, UInt32 numIterations, UInt32 numThreads, UInt32 dictionary);
 
+HRESULT LzmaBlockBenchCon(
+  #ifdef EXTERNAL_LZMA
+  CCodecs *codecs,
+  #endif
+  FILE *f, UInt32 numIterations, UInt32 numThreads, UInt32 dictionary);
+
 HRESULT CrcBenchCon(FILE *f, UInt32 numIterations, UInt32 numThreads, UInt32 dictionary);
 
+#ifndef _NO_CRYPTO
+// AES-256 CBC and CTR speed for each AES implementation; dictionary sets maximum buffer size
+HRESULT AesBenchCon(FILE *f, UInt32 numIterations, UInt32 numThreads, UInt32 dictionary);
+#endif
+
+#ifdef EXTERNAL_LZMA
+// BZip2 speed for each number of threads from 1 to numThreads
+HRESULT BZip2BenchCon(CCodecs *codecs, FILE *f, UInt32 numIterations, UInt32 numThreads, UInt32 dictionary);
+// PPMd on many small files with new, reused and primed coders; dictionary sets the file size
+HRESULT PPMdBenchCon(CCodecs *codecs, FILE *f, UInt32 numIterations, UInt32 numThreads, UInt32 dictionary);
+// gzip extracting with one thread and with numThreads decoders of index ranges; dictionary sets data size
+HRESULT GZipBenchCon(CCodecs *codecs, FILE *f, UInt32 numIterations, UInt32 numThreads, UInt32 dictionary);
+#endif
+
+#ifndef EXTERNAL_LZMA
+HRESULT MatchFinderBenchCon(FILE *f, UInt32 numIterations, UInt32 numThreads, UInt32 dictionary);
+HRESULT OpenBenchCon(FILE *f, LPCTSTR fileName, UInt32 numIterations);
+#endif
+
 #endif
 
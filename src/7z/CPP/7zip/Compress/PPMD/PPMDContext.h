@@ -135,6 +135,32 @@ struct CInfo
             SEE2Cont[i][k].init(5*i+10);
   }
 
+  // Continues from the model state of a, that uses the same memory size.
+  void CopyModel(const CInfo &a)
+  {
+    SubAllocator.CopyFrom(a.SubAllocator);
+    memcpy(SEE2Cont, a.SEE2Cont, sizeof(SEE2Cont));
+    DummySEE2Cont = a.DummySEE2Cont;
+    MinContext = GetContext(a.SubAllocator.GetOffset(a.MinContext));
+    MaxContext = GetContext(a.SubAllocator.GetOffset(a.MaxContext));
+    FoundState = GetState(a.SubAllocator.GetOffset(a.FoundState));
+    NumMasked = a.NumMasked;
+    InitEsc = a.InitEsc;
+    OrderFall = a.OrderFall;
+    RunLength = a.RunLength;
+    InitRL = a.InitRL;
+    MaxOrder = a.MaxOrder;
+    memcpy(CharMask, a.CharMask, sizeof(CharMask));
+    memcpy(NS2Indx, a.NS2Indx, sizeof(NS2Indx));
+    memcpy(NS2BSIndx, a.NS2BSIndx, sizeof(NS2BSIndx));
+    memcpy(HB2Flag, a.HB2Flag, sizeof(HB2Flag));
+    EscCount = a.EscCount;
+    PrintCount = a.PrintCount;
+    PrevSuccess = a.PrevSuccess;
+    HiBitsFlag = a.HiBitsFlag;
+    memcpy(BinSumm, a.BinSumm, sizeof(BinSumm));
+  }
+
   void StartModelRare(int maxOrder)
   {
     int i, k, m ,Step;
@@ -19,8 +19,13 @@ STDMETHODIMP CDecoder::SetDecoderProperties2(const Byte *properties, UInt32 size
     return E_INVALIDARG;
   _order = properties[0];
   _usedMemorySize = 0;
+  _primingSize = 0;
   for (int i = 0; i < 4; i++)
+  {
     _usedMemorySize += ((UInt32)(properties[1 + i])) << (i * 8);
+    if (size >= 9)
+      _primingSize += ((UInt32)(properties[5 + i])) << (i * 8);
+  }
 
   if (_usedMemorySize > kMaxMemBlockSize)
     return E_NOTIMPL;
@@ -33,6 +38,25 @@ STDMETHODIMP CDecoder::SetDecoderProperties2(const Byte *properties, UInt32 size
   return S_OK;
 }
 
+STDMETHODIMP CDecoder::SetPrimingData(const Byte *data, UInt32 size)
+{
+  _priming.SetData(data, size);
+  return S_OK;
+}
+
+STDMETHODIMP CDecoder::GetPrimingModel(IUnknown **model)
+{
+  *model = 0;
+  if (_usedMemorySize == 0)
+    return E_FAIL; // SetDecoderProperties2 was not called
+  return _priming.GetModel(_usedMemorySize, _order, model);
+}
+
+STDMETHODIMP CDecoder::SetPrimingModel(IUnknown *model)
+{
+  return _priming.SetModel(model);
+}
+
 class CDecoderFlusher
 {
   CDecoder *_coder;
@@ -61,10 +85,21 @@ HRESULT CDecoder::CodeSpec(UInt32 size, Byte *memStream)
     return S_OK;
   if (_remainLen == kLenIdNeedInit)
   {
+    // stream was primed with other data or without data
+    if (_priming.GetDataSize() != _primingSize)
+      return E_NOTIMPL;
     _rangeDecoder.Init();
     _remainLen = 0;
-    _info.MaxOrder = 0;
-    _info.StartModelRare(_order);
+    if (_priming.IsEnabled())
+    {
+      if (!_priming.Restore(_info, _usedMemorySize, _order))
+        return E_OUTOFMEMORY;
+    }
+    else
+    {
+      _info.MaxOrder = 0;
+      _info.StartModelRare(_order);
+    }
   }
   while (size != 0)
   {
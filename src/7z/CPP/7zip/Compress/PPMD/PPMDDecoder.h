@@ -10,6 +10,7 @@
 #include "../RangeCoder/RangeCoder.h"
 
 #include "PPMDDecode.h"
+#include "PPMDEncode.h"
 
 namespace NCompress {
 namespace NPPMD {
@@ -17,6 +18,7 @@ namespace NPPMD {
 class CDecoder : 
   public ICompressCoder,
   public ICompressSetDecoderProperties2,
+  public ICompressSetPrimingData,
   #ifndef NO_READ_FROM_CODER
   public ICompressSetInStream,
   public ICompressSetOutStreamSize,
@@ -29,9 +31,11 @@ class CDecoder :
   COutBuffer _outStream;
 
   CDecodeInfo _info;
+  CModelPriming _priming;
 
   Byte _order;
   UInt32 _usedMemorySize;
+  UInt32 _primingSize;
 
   int _remainLen;
   UInt64 _outSize;
@@ -42,14 +46,16 @@ class CDecoder :
 public:
 
   #ifndef NO_READ_FROM_CODER
-  MY_UNKNOWN_IMP4(
+  MY_UNKNOWN_IMP5(
       ICompressSetDecoderProperties2, 
+      ICompressSetPrimingData, 
       ICompressSetInStream, 
       ICompressSetOutStreamSize, 
       ISequentialInStream)
   #else
-  MY_UNKNOWN_IMP1(
-      ICompressSetDecoderProperties2)
+  MY_UNKNOWN_IMP2(
+      ICompressSetDecoderProperties2,
+      ICompressSetPrimingData)
   #endif
 
   void ReleaseStreams()
@@ -71,6 +77,9 @@ public:
 
 
   STDMETHOD(SetDecoderProperties2)(const Byte *data, UInt32 size);
+  STDMETHOD(SetPrimingData)(const Byte *data, UInt32 size);
+  STDMETHOD(GetPrimingModel)(IUnknown **model);
+  STDMETHOD(SetPrimingModel)(IUnknown *model);
 
   STDMETHOD(SetInStream)(ISequentialInStream *inStream);
   STDMETHOD(ReleaseInStream)();
@@ -80,7 +89,7 @@ public:
   STDMETHOD(Read)(void *data, UInt32 size, UInt32 *processedSize);
   #endif
 
-  CDecoder(): _outSizeDefined(false) {}
+  CDecoder(): _usedMemorySize(0), _primingSize(0), _outSizeDefined(false) {}
 
 };
 
@@ -4,6 +4,11 @@
 #ifndef __COMPRESS_PPMD_ENCODE_H
 #define __COMPRESS_PPMD_ENCODE_H
 
+#include "../../../Common/Buffer.h"
+#include "../../../Common/MyCom.h"
+
+#include "../../ICoder.h"
+
 #include "PPMDContext.h"
 
 namespace NCompress {
@@ -136,7 +141,160 @@ SYMBOL_FOUND:
     NextContext();
   }
 
+  // Updates the model with data like EncodeSymbol does, but drops the output.
+  bool Prime(const Byte *data, UInt32 size)
+  {
+    NRangeCoder::CEncoder rangeEncoder;
+    if (!rangeEncoder.Create(1 << 16))
+      return false;
+    rangeEncoder.SetStream(0);
+    rangeEncoder.Init();
+    for (UInt32 i = 0; i < size; i++)
+      EncodeSymbol(data[i], &rangeEncoder);
+    return true;
+  }
+};
+
+const UInt64 kMethodId = 0x030401;
+
+// Model trained on a sample that both the encoder and the decoder know.
+// Every stream starts from a copy of it instead of an empty model, so
+// small streams don't pay for the model warm-up. 
+// The model is not changed after training, so any number of coders can 
+// share it. AddRef and Release are not atomic, so coders that share 
+// the model must be created and released in one thread.
+
+class CModelSnapshot:
+  public ICompressPrimingModel,
+  public CMyUnknownImp
+{
+  CEncodeInfo _info;
+  CByteBuffer _data;
+  UInt32 _dataSize;
+  UInt32 _memSize;
+  int _order;
+public:
+  MY_UNKNOWN_IMP1(ICompressPrimingModel)
+
+  STDMETHOD(GetMethodId)(UInt64 *methodId)
+  {
+    *methodId = kMethodId;
+    return S_OK;
+  }
+
+  CModelSnapshot(): _dataSize(0), _memSize(0), _order(0) {}
+  const Byte *GetData() const { return _data; }
+  UInt32 GetDataSize() const { return _dataSize; }
+  bool IsSuitable(UInt32 memSize, int order) const 
+    { return _memSize == memSize && _order == order; }
+
+  bool Train(const Byte *data, UInt32 size, UInt32 memSize, int order)
+  {
+    _data.SetCapacity(size);
+    memcpy(_data, data, size);
+    _dataSize = size;
+    if (!_info.SubAllocator.StartSubAllocator(memSize))
+      return false;
+    _info.MaxOrder = 0;
+    _info.StartModelRare(order);
+    if (!_info.Prime(_data, _dataSize))
+      return false;
+    _memSize = memSize;
+    _order = order;
+    return true;
+  }
+
+  void CopyTo(CInfo &info) const { info.CopyModel(_info); }
+};
+
+// Priming state of one coder: data from SetPrimingData or shared model.
+// The data is trained at first stream. New model is trained from the data
+// of current model, if memory size or order are changed.
+
+class CModelPriming
+{
+  CByteBuffer _data;
+  UInt32 _dataSize;
+  CMyComPtr<ICompressPrimingModel> _model;
+  CModelSnapshot *_snapshot;
+
+  bool Prepare(UInt32 memSize, int order)
+  {
+    if (_dataSize == 0 && _snapshot->IsSuitable(memSize, order))
+      return true;
+    CModelSnapshot *snapshot = new CModelSnapshot;
+    CMyComPtr<ICompressPrimingModel> model = snapshot;
+    bool res;
+    if (_dataSize != 0)
+      res = snapshot->Train(_data, _dataSize, memSize, order);
+    else
+      res = snapshot->Train(_snapshot->GetData(), _snapshot->GetDataSize(), memSize, order);
+    if (!res)
+      return false;
+    _data.Free();
+    _dataSize = 0;
+    _model = model;
+    _snapshot = snapshot;
+    return true;
+  }
+public:
+  CModelPriming(): _dataSize(0), _snapshot(0) {}
+  bool IsEnabled() const { return _dataSize != 0 || _snapshot != 0; }
+  UInt32 GetDataSize() const { return (_snapshot != 0) ? _snapshot->GetDataSize() : _dataSize; }
+  
+  void SetData(const Byte *data, UInt32 size)
+  {
+    _model.Release();
+    _snapshot = 0;
+    _data.SetCapacity(size);
+    memcpy(_data, data, size);
+    _dataSize = size;
+  }
+
+  HRESULT SetModel(IUnknown *model)
+  {
+    _model.Release();
+    _snapshot = 0;
+    _data.Free();
+    _dataSize = 0;
+    if (model == 0)
+      return S_OK;
+    CMyComPtr<ICompressPrimingModel> primingModel;
+    model->QueryInterface(IID_ICompressPrimingModel, (void **)&primingModel);
+    if (!primingModel)
+      return E_INVALIDARG;
+    UInt64 methodId;
+    RINOK(primingModel->GetMethodId(&methodId));
+    if (methodId != kMethodId)
+      return E_INVALIDARG;
+    _model = primingModel;
+    _snapshot = static_cast<CModelSnapshot *>((ICompressPrimingModel *)primingModel);
+    return S_OK;
+  }
+
+  HRESULT GetModel(UInt32 memSize, int order, IUnknown **model)
+  {
+    *model = 0;
+    if (!IsEnabled())
+      return S_FALSE;
+    if (!Prepare(memSize, order))
+      return E_OUTOFMEMORY;
+    _model->AddRef();
+    *model = _model;
+    return S_OK;
+  }
+
+  bool Restore(CInfo &info, UInt32 memSize, int order)
+  {
+    if (!Prepare(memSize, order))
+      return false;
+    if (!info.SubAllocator.StartSubAllocator(memSize))
+      return false;
+    _snapshot->CopyTo(info);
+    return true;
+  }
 };
+
 }}
 
 #endif
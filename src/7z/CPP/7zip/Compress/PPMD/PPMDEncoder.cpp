@@ -74,14 +74,39 @@ STDMETHODIMP CEncoder::SetCoderProperties(const PROPID *propIDs,
   return S_OK;
 }
 
+// Primed stream has the size of priming data after usual properties,
+// so the decoder can detect that it didn't get the same data.
+
 STDMETHODIMP CEncoder::WriteCoderProperties(ISequentialOutStream *outStream)
 { 
   const UInt32 kPropSize = 5;
-  Byte properties[kPropSize];
+  const UInt32 kPrimedPropSize = 9;
+  Byte properties[kPrimedPropSize];
   properties[0] = _order;
+  const UInt32 primingSize = _priming.GetDataSize();
   for (int i = 0; i < 4; i++)
+  {
     properties[1 + i] = Byte(_usedMemorySize >> (8 * i));
-  return WriteStream(outStream, properties, kPropSize, NULL);
+    properties[5 + i] = Byte(primingSize >> (8 * i));
+  }
+  return WriteStream(outStream, properties, 
+      (primingSize != 0) ? kPrimedPropSize : kPropSize, NULL);
+}
+
+STDMETHODIMP CEncoder::SetPrimingData(const Byte *data, UInt32 size)
+{
+  _priming.SetData(data, size);
+  return S_OK;
+}
+
+STDMETHODIMP CEncoder::GetPrimingModel(IUnknown **model)
+{
+  return _priming.GetModel(_usedMemorySize, _order, model);
+}
+
+STDMETHODIMP CEncoder::SetPrimingModel(IUnknown *model)
+{
+  return _priming.SetModel(model);
 }
 
 const UInt32 kUsedMemorySizeDefault = (1 << 24);
@@ -103,8 +128,18 @@ HRESULT CEncoder::CodeReal(ISequentialInStream *inStream,
     return E_OUTOFMEMORY;
   if (!_rangeEncoder.Create(1 << 20))
     return E_OUTOFMEMORY;
-  if (!_info.SubAllocator.StartSubAllocator(_usedMemorySize)) 
-    return E_OUTOFMEMORY;
+  if (_priming.IsEnabled())
+  {
+    if (!_priming.Restore(_info, _usedMemorySize, _order))
+      return E_OUTOFMEMORY;
+  }
+  else
+  {
+    if (!_info.SubAllocator.StartSubAllocator(_usedMemorySize)) 
+      return E_OUTOFMEMORY;
+    _info.MaxOrder = 0;
+    _info.StartModelRare(_order);
+  }
 
   _inStream.SetStream(inStream);
   _inStream.Init();
@@ -114,9 +149,6 @@ HRESULT CEncoder::CodeReal(ISequentialInStream *inStream,
 
   CEncoderFlusher flusher(this);
 
-  _info.MaxOrder = 0;
-  _info.StartModelRare(_order);
-
   for (;;)
   {
     UInt32 size = (1 << 18);
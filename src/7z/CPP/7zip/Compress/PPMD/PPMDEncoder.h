@@ -18,6 +18,7 @@ class CEncoder :
   public ICompressCoder,
   public ICompressSetCoderProperties,
   public ICompressWriteCoderProperties,
+  public ICompressSetPrimingData,
   public CMyUnknownImp
 {
 public:
@@ -26,6 +27,7 @@ public:
   NRangeCoder::CEncoder _rangeEncoder;
 
   CEncodeInfo _info;
+  CModelPriming _priming;
   UInt32 _usedMemorySize;
   Byte _order;
 
@@ -59,9 +61,10 @@ public:
 
 public:
 
-  MY_UNKNOWN_IMP2(
+  MY_UNKNOWN_IMP3(
       ICompressSetCoderProperties,
-      ICompressWriteCoderProperties)
+      ICompressWriteCoderProperties,
+      ICompressSetPrimingData)
 
   STDMETHOD(Code)(ISequentialInStream *inStream,
       ISequentialOutStream *outStream, const UInt64 *inSize, const UInt64 *outSize,
@@ -72,6 +75,10 @@ public:
 
   STDMETHOD(WriteCoderProperties)(ISequentialOutStream *outStream);
 
+  STDMETHOD(SetPrimingData)(const Byte *data, UInt32 size);
+  STDMETHOD(GetPrimingModel)(IUnknown **model);
+  STDMETHOD(SetPrimingModel)(IUnknown *model);
+
   CEncoder();
 
 };
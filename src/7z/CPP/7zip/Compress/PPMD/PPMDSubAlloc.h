@@ -138,6 +138,23 @@ public:
     return true;
   }
 
+  // Copies the allocator state and the used parts of the heap (text area,
+  // units and contexts) from a with the same size. The free gaps are not copied.
+  void CopyFrom(const CSubAllocator &a)
+  {
+    memcpy(Indx2Units, a.Indx2Units, sizeof(Indx2Units));
+    memcpy(Units2Indx, a.Units2Indx, sizeof(Units2Indx));
+    memcpy(FreeList, a.FreeList, sizeof(FreeList));
+    GlueCount = a.GlueCount;
+    pText = HeapStart + (a.pText - a.HeapStart);
+    UnitsStart = HeapStart + (a.UnitsStart - a.HeapStart);
+    LoUnit = HeapStart + (a.LoUnit - a.HeapStart);
+    HiUnit = HeapStart + (a.HiUnit - a.HeapStart);
+    memcpy(HeapStart, a.HeapStart, (size_t)(pText - HeapStart));
+    memcpy(UnitsStart, a.UnitsStart, (size_t)(LoUnit - UnitsStart));
+    memcpy(HiUnit, a.HiUnit, (size_t)(HeapStart + SubAllocatorSize - HiUnit));
+  }
+
   void InitSubAllocator()
   {
     int i, k;
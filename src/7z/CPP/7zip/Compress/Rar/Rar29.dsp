@@ -314,6 +314,15 @@ SOURCE=..\..\..\..\C\Alloc.c
 
 SOURCE=..\..\..\..\C\Alloc.h
 # End Source File
+# Begin Source File
+
+SOURCE=..\..\..\..\C\CpuArch.c
+# SUBTRACT CPP /YX /Yc /Yu
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\..\..\C\CpuArch.h
+# End Source File
 # End Group
 # End Target
 # End Project
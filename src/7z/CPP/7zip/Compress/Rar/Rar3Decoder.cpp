@@ -88,14 +88,16 @@ HRESULT CDecoder::WriteArea(UInt32 startPtr, UInt32 endPtr)
   return WriteData(_window, endPtr);
 }
 
-void CDecoder::ExecuteFilter(int tempFilterIndex, NVm::CBlockRef &outBlockRef)
+// (inData == NULL) means that input data is in VM memory already.
+
+void CDecoder::ExecuteFilter(int tempFilterIndex, const Byte *inData, UInt32 inSize, NVm::CBlockRef &outBlockRef)
 {
   CTempFilter *tempFilter = _tempFilters[tempFilterIndex];
   tempFilter->InitR[6] = (UInt32)_writtenFileSize;
   NVm::SetValue32(&tempFilter->GlobalData[0x24], (UInt32)_writtenFileSize);
   NVm::SetValue32(&tempFilter->GlobalData[0x28], (UInt32)(_writtenFileSize >> 32));
   CFilter *filter = _filters[tempFilter->FilterIndex];
-  _vm.Execute(filter, tempFilter, outBlockRef, filter->GlobalData);
+  _vm.Execute(filter, tempFilter, inData, inSize, outBlockRef, filter->GlobalData);
   delete tempFilter;
   _tempFilters[tempFilterIndex] = 0;
 }
@@ -127,8 +129,9 @@ HRESULT CDecoder::WriteBuf()
       if (blockSize <= writeSize)
       {
         UInt32 blockEnd = (blockStart + blockSize) & kWindowMask;
+        const Byte *inData = NULL;
         if (blockStart < blockEnd || blockEnd == 0)
-          _vm.SetMemory(0, _window + blockStart, blockSize);
+          inData = _window + blockStart;
         else
         {
           UInt32 tailSize = kWindowSize - blockStart;
@@ -136,7 +139,7 @@ HRESULT CDecoder::WriteBuf()
           _vm.SetMemory(tailSize, _window, blockEnd);
         }
         NVm::CBlockRef outBlockRef;
-        ExecuteFilter(i, outBlockRef);
+        ExecuteFilter(i, inData, blockSize, outBlockRef);
         while (i + 1 < _tempFilters.Size())
         {
           CTempFilter *nextFilter = _tempFilters[i + 1];
@@ -144,7 +147,7 @@ HRESULT CDecoder::WriteBuf()
               nextFilter->BlockSize != outBlockRef.Size || nextFilter->NextWindow)
             break;
           _vm.SetMemory(0, _vm.GetDataPointer(outBlockRef.Offset), outBlockRef.Size);
-          ExecuteFilter(++i, outBlockRef);
+          ExecuteFilter(++i, NULL, 0, outBlockRef);
         }
         WriteDataToStream(_vm.GetDataPointer(outBlockRef.Offset), outBlockRef.Size);
         _writtenFileSize += outBlockRef.Size;
@@ -225,7 +225,7 @@ class CDecoder:
   HRESULT WriteDataToStream(const Byte *data, UInt32 size);
   HRESULT WriteData(const Byte *data, UInt32 size);
   HRESULT WriteArea(UInt32 startPtr, UInt32 endPtr);
-  void ExecuteFilter(int tempFilterIndex, NVm::CBlockRef &outBlockRef);
+  void ExecuteFilter(int tempFilterIndex, const Byte *inData, UInt32 inSize, NVm::CBlockRef &outBlockRef);
   HRESULT WriteBuf();
 
   void InitFilters();
@@ -20,6 +20,11 @@ extern "C"
 #include "../../../../C/7zCrc.h" 
 }
 
+#if defined(RARVM_STANDARD_FILTERS) && defined(MY_CPU_X86_OR_AMD64) && defined(MY_CPU_INTRINSICS_TARGET)
+#define RARVM_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace NCompress {
 namespace NRar3 {
 
@@ -111,6 +116,13 @@ bool CVm::Create()
 {
   if (Mem == NULL)
     Mem = (Byte *)::MyAlloc(kSpaceSize + 4);
+  #ifdef RARVM_STANDARD_FILTERS
+  #ifdef RARVM_USE_SSE2
+  _useSse2 = (CPU_Is_Sse2_Supported() != 0);
+  #else
+  _useSse2 = false;
+  #endif
+  #endif
   return (Mem != NULL);
 }
 
@@ -123,12 +135,30 @@ CVm::~CVm()
 
 bool CVm::Execute(CProgram *prg, const CProgramInitState *initState, 
     CBlockRef &outBlockRef, CRecordVector<Byte> &outGlobalData)
+{
+  return Execute(prg, initState, NULL, 0, outBlockRef, outGlobalData);
+}
+
+bool CVm::Execute(CProgram *prg, const CProgramInitState *initState, 
+    const Byte *inData, UInt32 inSize,
+    CBlockRef &outBlockRef, CRecordVector<Byte> &outGlobalData)
 {
   memcpy(R, initState->InitR, sizeof(initState->InitR));
   R[kStackRegIndex] = kSpaceSize;
   R[kNumRegs] = 0;
   Flags = 0;
 
+  const Byte *src = Mem;
+  if (inData != NULL)
+  {
+    #ifdef RARVM_STANDARD_FILTERS
+    if (prg->StandardFilterIndex >= 0 && CanReadInput(prg->StandardFilterIndex, inSize))
+      src = inData;
+    else
+    #endif
+      SetMemory(0, inData, inSize);
+  }
+
   UInt32 globalSize = MyMin((UInt32)initState->GlobalData.Size(), kGlobalSize);
   if (globalSize != 0)
     memcpy(Mem + kGlobalOffset, &initState->GlobalData[0], globalSize);
@@ -139,7 +169,7 @@ bool CVm::Execute(CProgram *prg, const CProgramInitState *initState,
   bool res = true;
   #ifdef RARVM_STANDARD_FILTERS
   if (prg->StandardFilterIndex >= 0)
-    ExecuteStandardFilter(prg->StandardFilterIndex);
+    ExecuteStandardFilter(prg->StandardFilterIndex, src);
   else
   #endif
   {
@@ -910,21 +940,139 @@ static void ItaniumDecode(Byte *data, UInt32 dataSize, UInt32 fileOffset)
   }
 }
 
-static void DeltaDecode(Byte *data, UInt32 dataSize, UInt32 numChannels)
+/*
+DELTA, RGB and AUDIO filters read (dataSize) bytes from (srcData) and
+write (dataSize) bytes to (destData). (srcData) can be outside of VM memory.
+*/
+
+#ifdef RARVM_USE_SSE2
+
+/* Each channel is stored as contiguous block in source data, so DELTA
+   output of channel is (0 - prefix sum) of that block. We get 16 prefix
+   sums with 4 shifts and adds, and interleave the channels with unpacks. */
+
+MY_CPU_TARGET("sse2")
+static inline __m128i DeltaDecode16(__m128i x, __m128i *prev)
+{
+  x = _mm_add_epi8(x, _mm_slli_si128(x, 1));
+  x = _mm_add_epi8(x, _mm_slli_si128(x, 2));
+  x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+  x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+  x = _mm_sub_epi8(*prev, x);
+  __m128i t = _mm_shufflehi_epi16(_mm_unpackhi_epi8(x, x), 0xFF);
+  *prev = _mm_unpackhi_epi64(t, t);
+  return x;
+}
+
+// It supports 1, 2 and 4 channels and returns the number of decoded rows.
+
+MY_CPU_TARGET("sse2")
+static UInt32 DeltaDecodeSse2(const Byte *srcData, Byte *destData, UInt32 dataSize,
+    UInt32 numChannels, Byte *prevBytes)
+{
+  UInt32 numBlocks = dataSize / numChannels / 16;
+  const Byte *src[4];
+  __m128i prev[4];
+  UInt32 i;
+  for (i = 0; i < numChannels; i++)
+  {
+    src[i] = srcData;
+    srcData += (dataSize - i + numChannels - 1) / numChannels;
+    prev[i] = _mm_setzero_si128();
+  }
+  __m128i *dest = (__m128i *)destData;
+  for (UInt32 pos = 0; pos < numBlocks * 16; pos += 16)
+  {
+    __m128i y0 = DeltaDecode16(_mm_loadu_si128((const __m128i *)(src[0] + pos)), &prev[0]);
+    if (numChannels == 1)
+    {
+      _mm_storeu_si128(dest++, y0);
+      continue;
+    }
+    __m128i y1 = DeltaDecode16(_mm_loadu_si128((const __m128i *)(src[1] + pos)), &prev[1]);
+    if (numChannels == 2)
+    {
+      _mm_storeu_si128(dest++, _mm_unpacklo_epi8(y0, y1));
+      _mm_storeu_si128(dest++, _mm_unpackhi_epi8(y0, y1));
+      continue;
+    }
+    __m128i y2 = DeltaDecode16(_mm_loadu_si128((const __m128i *)(src[2] + pos)), &prev[2]);
+    __m128i y3 = DeltaDecode16(_mm_loadu_si128((const __m128i *)(src[3] + pos)), &prev[3]);
+    __m128i a = _mm_unpacklo_epi8(y0, y1);
+    __m128i b = _mm_unpackhi_epi8(y0, y1);
+    __m128i c = _mm_unpacklo_epi8(y2, y3);
+    __m128i d = _mm_unpackhi_epi8(y2, y3);
+    _mm_storeu_si128(dest++, _mm_unpacklo_epi16(a, c));
+    _mm_storeu_si128(dest++, _mm_unpackhi_epi16(a, c));
+    _mm_storeu_si128(dest++, _mm_unpacklo_epi16(b, d));
+    _mm_storeu_si128(dest++, _mm_unpackhi_epi16(b, d));
+  }
+  for (i = 0; i < numChannels; i++)
+    prevBytes[i] = (Byte)_mm_cvtsi128_si32(prev[i]);
+  return numBlocks * 16;
+}
+
+#endif
+
+static void DeltaDecode(const Byte *srcData, Byte *destData, UInt32 dataSize,
+    UInt32 numChannels, bool useSse2)
 {
-  UInt32 srcPos = 0;
-  UInt32 border = dataSize * 2;
+  // channels starting after the end of data are empty
+  if (numChannels > dataSize)
+    numChannels = dataSize;
+  Byte prevBytes[4] = { 0, 0, 0, 0 };
+  UInt32 numRows = 0;
+  #ifdef RARVM_USE_SSE2
+  if (useSse2 && (numChannels == 1 || numChannels == 2 || numChannels == 4))
+    numRows = DeltaDecodeSse2(srcData, destData, dataSize, numChannels, prevBytes);
+  #endif
   for (UInt32 curChannel = 0; curChannel < numChannels; curChannel++)
   {
-    Byte prevByte = 0;
-    for (UInt32 destPos = dataSize + curChannel; destPos < border; destPos += numChannels)
-      data[destPos] = (prevByte = prevByte - data[srcPos++]);
+    Byte prevByte = (curChannel < 4 ? prevBytes[curChannel] : 0);
+    srcData += numRows;
+    for (UInt32 i = curChannel + numRows * numChannels; i < dataSize; i += numChannels)
+      destData[i] = (prevByte = prevByte - *srcData++);
   }
 }
 
-static void RgbDecode(Byte *srcData, UInt32 dataSize, UInt32 width, UInt32 posR)
+#ifdef RARVM_USE_SSE2
+
+// (kRgbMaskR + 1) is mask for B bytes
+
+static const Byte kRgbMaskR[48 + 1] =
+{
+  0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF,
+  0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0,
+  0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0,
+  0xFF
+};
+
+// It adds G to R and B in 48-byte blocks (16 pixels) and returns the number of processed bytes.
+// Only G bytes are read from neighbour positions, and they are not changed.
+
+MY_CPU_TARGET("sse2")
+static UInt32 RgbAddGreenSse2(Byte *data, UInt32 size)
+{
+  UInt32 pos;
+  for (pos = 0; pos + 48 <= size; pos += 48)
+    for (int k = 0; k < 3; k++)
+    {
+      Byte *p = data + pos + k * 16;
+      __m128i v = _mm_loadu_si128((const __m128i *)p);
+      __m128i next = _mm_loadu_si128((const __m128i *)(p + 1));
+      __m128i prev = _mm_loadu_si128((const __m128i *)(p - 1));
+      // R bytes get next byte, B bytes get previous byte
+      v = _mm_add_epi8(v, _mm_and_si128(next, _mm_loadu_si128((const __m128i *)(kRgbMaskR + k * 16))));
+      v = _mm_add_epi8(v, _mm_and_si128(prev, _mm_loadu_si128((const __m128i *)(kRgbMaskR + k * 16 + 1))));
+      _mm_storeu_si128((__m128i *)p, v);
+    }
+  return pos;
+}
+
+#endif
+
+static void RgbDecode(const Byte *srcData, Byte *destData, UInt32 dataSize, UInt32 width, UInt32 posR, bool useSse2)
 {
-  Byte *destData = srcData + dataSize;
   const UInt32 numChannels = 3;
   for (UInt32 curChannel = 0; curChannel < numChannels; curChannel++)
   {
@@ -956,7 +1104,13 @@ static void RgbDecode(Byte *srcData, UInt32 dataSize, UInt32 width, UInt32 posR)
   }
   if (dataSize < 3)
     return;
-  for (UInt32 i = posR, border = dataSize - 2; i < border; i += 3)
+  UInt32 i = posR, border = dataSize - 2;
+  #ifdef RARVM_USE_SSE2
+  // (destData - 1) is in VM memory too, since dataSize >= 3.
+  if (useSse2 && i < border)
+    i += RgbAddGreenSse2(destData + i, (border - i + 2) / 3 * 3);
+  #endif
+  for (; i < border; i += 3)
   {
     Byte g = destData[i + 1];
     destData[i] = destData[i] + g;
@@ -964,9 +1118,10 @@ static void RgbDecode(Byte *srcData, UInt32 dataSize, UInt32 width, UInt32 posR)
   }
 }
 
-static void AudioDecode(Byte *srcData, UInt32 dataSize, UInt32 numChannels)
+static void AudioDecode(const Byte *srcData, Byte *destData, UInt32 dataSize, UInt32 numChannels)
 {
-  Byte *destData = srcData + dataSize;
+  if (numChannels > dataSize)
+    numChannels = dataSize;
   for (UInt32 curChannel = 0; curChannel < numChannels; curChannel++)
   {
     UInt32 prevByte = 0, prevDelta = 0, dif[7];
@@ -1040,7 +1195,23 @@ static UInt32 UpCaseDecode(Byte *data, UInt32 dataSize)
   return destPos - dataSize;
 }
 
-void CVm::ExecuteStandardFilter(int filterIndex)
+bool CVm::CanReadInput(int filterIndex, UInt32 inSize) const
+{
+  if (R[4] != inSize || inSize >= kGlobalOffset / 2)
+    return false;
+  switch (kStdFilters[filterIndex].Type)
+  {
+    case SF_DELTA:
+    case SF_AUDIO:
+      return (R[0] != 0);
+    case SF_RGB:
+      return (R[0] > 3);
+    default:
+      return false;
+  }
+}
+
+void CVm::ExecuteStandardFilter(int filterIndex, const Byte *src)
 {
   UInt32 dataSize = R[4];
   if (dataSize >= kGlobalOffset)
@@ -1060,7 +1231,7 @@ void CVm::ExecuteStandardFilter(int filterIndex)
       if (dataSize >= kGlobalOffset / 2)
         break;
       SetBlockPos(dataSize);
-      DeltaDecode(Mem, dataSize, R[0]);
+      DeltaDecode(src, Mem + dataSize, dataSize, R[0], _useSse2);
       break;
     case SF_RGB:
       if (dataSize >= kGlobalOffset / 2)
@@ -1070,14 +1241,14 @@ void CVm::ExecuteStandardFilter(int filterIndex)
         if (width <= 3)
           break;
         SetBlockPos(dataSize);
-        RgbDecode(Mem, dataSize, width, R[1]);
+        RgbDecode(src, Mem + dataSize, dataSize, width, R[1], _useSse2);
       }
       break;
     case SF_AUDIO:
       if (dataSize >= kGlobalOffset / 2)
         break;
       SetBlockPos(dataSize);
-      AudioDecode(Mem, dataSize, R[0]);
+      AudioDecode(src, Mem + dataSize, dataSize, R[0]);
       break;
     case SF_UPCASE:
       if (dataSize >= kGlobalOffset / 2)
@@ -2,13 +2,16 @@
 // According to unRAR license, this code may not be used to develop 
 // a program that creates RAR archives
 
-#ifndef __RAR3VM_H
-#define __RAR3VM_H
+#ifndef __RAR3VM_H
+#define __RAR3VM_H
 
 #include "Common/Types.h"
 #include "Common/MyVector.h"
 
+extern "C"
+{
 #include "../../../../C/CpuArch.h"
+}
 
 #define RARVM_STANDARD_FILTERS
 #ifdef LITTLE_ENDIAN_UNALIGN
@@ -60,7 +63,7 @@ inline void SetValue32(void *addr, UInt32 value)
 }
 
 UInt32 ReadEncodedUInt32(CMemBitDecoder &inp);
-
+
 const int kNumRegBits = 3;
 const UInt32 kNumRegs = 1 << kNumRegBits;
 const UInt32 kNumGpRegs = kNumRegs - 1;
@@ -193,10 +196,14 @@ private:
   bool ExecuteCode(const CProgram *prg);
   
   #ifdef RARVM_STANDARD_FILTERS
-  void ExecuteStandardFilter(int filterIndex);
+  bool CanReadInput(int filterIndex, UInt32 inSize) const;
+  void ExecuteStandardFilter(int filterIndex, const Byte *src);
   #endif
   
   Byte *Mem;
+  #ifdef RARVM_STANDARD_FILTERS
+  bool _useSse2;
+  #endif
   UInt32 R[kNumRegs + 1]; // R[kNumRegs] = 0 always (speed optimization)
   UInt32 Flags;
   void ReadVmProgram(const Byte *code, UInt32 codeSize, CProgram *prg);
@@ -208,10 +215,17 @@ public:
   void SetMemory(UInt32 pos, const Byte *data, UInt32 dataSize);
   bool Execute(CProgram *prg, const CProgramInitState *initState, 
       CBlockRef &outBlockRef, CRecordVector<Byte> &outGlobalData);
+  
+  // (inData) must not point to VM memory. DELTA, RGB and AUDIO filters
+  // read it from there and write their output to VM memory; for other
+  // programs it's copied to VM memory at offset 0, as SetMemory does.
+  bool Execute(CProgram *prg, const CProgramInitState *initState, 
+      const Byte *inData, UInt32 inSize,
+      CBlockRef &outBlockRef, CRecordVector<Byte> &outGlobalData);
   const Byte *GetDataPointer(UInt32 offset) const { return Mem + offset; }
 
 };
-
+
 #endif
 
 }}}
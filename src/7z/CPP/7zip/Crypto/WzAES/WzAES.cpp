@@ -35,27 +35,25 @@ STDMETHODIMP CBaseCoder::CryptoSetPassword(const Byte *data, UInt32 size)
   return S_OK;
 }
 
-#define SetUi32(p, d) { UInt32 x = (d); (p)[0] = (Byte)x; (p)[1] = (Byte)(x >> 8); \
-    (p)[2] = (Byte)(x >> 16); (p)[3] = (Byte)(x >> 24); }
-
 void CBaseCoder::EncryptData(Byte *data, UInt32 size)
 {   
   unsigned int pos = _blockPos;
-  for (; size > 0; size--)
-  {
-    if (pos == AES_BLOCK_SIZE)
-    {   
-      if (++_counter[0] == 0)
-        _counter[1]++;
-      UInt32 outBuf[4];
-      AesEncode32(_counter, outBuf, Aes.rkey, Aes.numRounds2);
-      SetUi32(_buffer,      outBuf[0]);
-      SetUi32(_buffer + 4,  outBuf[1]);
-      SetUi32(_buffer + 8,  outBuf[2]);
-      SetUi32(_buffer + 12, outBuf[3]);
-      pos = 0;
-    }
+  for (; size > 0 && pos != AES_BLOCK_SIZE; size--)
     *data++ ^= _buffer[pos++];
+  UInt32 numBlocks = size / AES_BLOCK_SIZE;
+  if (numBlocks != 0)
+  {
+    AesCtrCode(&Aes, _counter, data, numBlocks);
+    data += numBlocks * AES_BLOCK_SIZE;
+    size -= numBlocks * AES_BLOCK_SIZE;
+  }
+  if (size > 0)
+  {
+    // _buffer gets key stream block for the tail and next call
+    memset(_buffer, 0, AES_BLOCK_SIZE);
+    AesCtrCode(&Aes, _counter, _buffer, 1);
+    for (pos = 0; pos < size; pos++)
+      data[pos] ^= _buffer[pos];
   }
   _blockPos = pos;
 }
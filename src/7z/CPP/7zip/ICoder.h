@@ -49,7 +49,8 @@ namespace NCoderPropID
     kAlgorithm = 0x470,
     kMultiThread = 0x480,
     kNumThreads,
-    kEndMarker = 0x490
+    kEndMarker = 0x490,
+    kBlockSize = 0x4A0
   };
 }
 
@@ -86,6 +87,26 @@ CODER_INTERFACE(ICompressSetCoderMt, 0x25)
   STDMETHOD(SetNumberOfThreads)(UInt32 numThreads) PURE;
 };
 
+// data is used to train the model before each stream; 
+// the decoder must get the same data as the encoder. size = 0 disables it.
+// GetPrimingModel returns the trained model (ICompressPrimingModel).
+// SetPrimingModel makes the coder use the model of other coder of the
+// same method instead of its data, so the model is trained only once.
+// Coders that share one model must be created, used and released in 
+// one thread. Coders in different threads must get the data instead.
+CODER_INTERFACE(ICompressSetPrimingData, 0x26)
+{
+  STDMETHOD(SetPrimingData)(const Byte *data, UInt32 size) PURE;
+  STDMETHOD(GetPrimingModel)(IUnknown **model) PURE;
+  STDMETHOD(SetPrimingModel)(IUnknown *model) PURE;
+};
+
+// Trained model is read-only, but its reference counter is not atomic.
+CODER_INTERFACE(ICompressPrimingModel, 0x27)
+{
+  STDMETHOD(GetMethodId)(UInt64 *methodId) PURE;
+};
+
 CODER_INTERFACE(ICompressGetSubStreamSize, 0x30)
 {
   STDMETHOD(GetSubStreamSize)(UInt64 subStream, UInt64 *value) PURE;
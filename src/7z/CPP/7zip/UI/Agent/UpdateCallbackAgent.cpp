@@ -102,3 +102,10 @@ HRESULT CUpdateCallbackAgent::CryptoGetTextPassword2(Int32 *passwordIsDefined, B
   }
   return _cryptoGetTextPassword->CryptoGetTextPassword2(passwordIsDefined, password);
 }
+
+HRESULT CUpdateCallbackAgent::SetThreadStat(Int32 /* threadIndex */, UInt32 /* numItems */, 
+    UInt64 /* unpackSize */, UInt64 /* packSize */, UInt64 /* spillSize */,
+    UInt32 /* busyTime */, UInt32 /* totalTime */)
+{
+  return S_OK;
+}
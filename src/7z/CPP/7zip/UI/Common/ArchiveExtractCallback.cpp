@@ -465,6 +465,18 @@ STDMETHODIMP CArchiveExtractCallback::GetInStream(
 }
 */
 
+STDMETHODIMP CArchiveExtractCallback::SetPipeStat(UInt32 numFolders, 
+    UInt32 readWait, UInt32 decodeInWait, 
+    UInt32 decodeOutWait, UInt32 writeWait)
+{
+  COM_TRY_BEGIN
+  if (CallbackUI == NULL)
+    return S_OK;
+  return CallbackUI->SetPipeStat(numFolders, 
+      readWait, decodeInWait, decodeOutWait, writeWait);
+  COM_TRY_END
+}
+
 STDMETHODIMP CArchiveExtractCallback::CryptoGetTextPassword(BSTR *password)
 {
   COM_TRY_BEGIN
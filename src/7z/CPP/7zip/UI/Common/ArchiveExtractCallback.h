@@ -17,13 +17,14 @@
 
 class CArchiveExtractCallback: 
   public IArchiveExtractCallback,
+  public IArchiveExtractCallbackMt,
   // public IArchiveVolumeExtractCallback,
   public ICryptoGetTextPassword,
   public ICompressProgressInfo,
   public CMyUnknownImp
 {
 public:
-  MY_UNKNOWN_IMP2(ICryptoGetTextPassword, ICompressProgressInfo)
+  MY_UNKNOWN_IMP3(IArchiveExtractCallbackMt, ICryptoGetTextPassword, ICompressProgressInfo)
   // COM_INTERFACE_ENTRY(IArchiveVolumeExtractCallback)
 
   // IProgress
@@ -36,6 +37,11 @@ public:
   STDMETHOD(PrepareOperation)(Int32 askExtractMode);
   STDMETHOD(SetOperationResult)(Int32 resultEOperationResult);
 
+  // IArchiveExtractCallbackMt
+  STDMETHOD(SetPipeStat)(UInt32 numFolders, 
+      UInt32 readWait, UInt32 decodeInWait, 
+      UInt32 decodeOutWait, UInt32 writeWait);
+
   // IArchiveVolumeExtractCallback
   // STDMETHOD(GetInStream)(const wchar_t *name, ISequentialInStream **inStream);
 
@@ -97,7 +103,8 @@ public:
       WriteModified(true),
       WriteCreated(false),
       WriteAccessed(false),
-      _multiArchives(false)
+      _multiArchives(false),
+      CallbackUI(NULL)
   {
     LocalProgressSpec = new CLocalProgress();
     _localProgress = LocalProgressSpec;
@@ -109,6 +116,7 @@ public:
   UInt64 _unpTotal;
 
   bool _multiArchives;
+  IExtractCallbackUI *CallbackUI; // it receives statistics of handler, if it's set
   UInt64 NumFolders;
   UInt64 NumFiles;
   UInt64 UnpackSize;
@@ -112,6 +112,9 @@ STDMETHODIMP COpenCallbackImp::GetStream(const wchar_t *name, IInStream **inStre
     return S_FALSE;
   CInFileStreamVol *inFile = new CInFileStreamVol;
   CMyComPtr<IInStream> inStreamTemp = inFile;
+  #ifndef USE_WIN_FILE
+  inFile->UseMap = true;
+  #endif
   if (!inFile->Open(fullPath))
     return ::GetLastError();
   *inStream = inStreamTemp.Detach();
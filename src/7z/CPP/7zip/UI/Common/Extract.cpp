@@ -7,6 +7,8 @@
 #include "Windows/Defs.h"
 #include "Windows/FileDir.h"
 
+#include "../../Common/FileStreams.h"
+
 #include "OpenArchive.h"
 #include "SetProperties.h"
 
@@ -66,6 +68,7 @@ HRESULT DecompressArchive(
       options.ArchiveFileInfo.LastWriteTime,
       options.ArchiveFileInfo.Attributes,
       packSize);
+  extractCallbackSpec->CallbackUI = callback;
 
   #ifdef COMPRESS_MT
   RINOK(SetProperties(archive, options.Properties));
@@ -77,6 +80,34 @@ HRESULT DecompressArchive(
   return callback->ExtractResult(result);
 }
 
+// Side index is optional, so we ignore all errors here.
+// Existing file is overwritten only if handler has recognized it
+// as its own stale index: other file with such name can be user's file.
+// Partially written index file is deleted.
+
+static void SaveArchiveIndex(IInArchive *archive, const UString &archivePath)
+{
+  CMyComPtr<IInArchiveIndex> archiveIndex;
+  archive->QueryInterface(IID_IInArchiveIndex, (void **)&archiveIndex);
+  if (!archiveIndex)
+    return;
+  Int32 changed = NArchive::NIndexChange::kNone;
+  if (archiveIndex->IndexWasChanged(&changed) != S_OK || 
+      changed == NArchive::NIndexChange::kNone)
+    return;
+  UString indexPath = archivePath + NArchive::kIndexExtension;
+  HRESULT res;
+  {
+    COutFileStream *outStreamSpec = new COutFileStream;
+    CMyComPtr<ISequentialOutStream> outStream(outStreamSpec);
+    if (!outStreamSpec->Create(indexPath, changed == NArchive::NIndexChange::kReplace))
+      return;
+    res = archiveIndex->WriteIndex(outStream);
+  }
+  if (res != S_OK)
+    NFile::NDirectory::DeleteFileAlways(indexPath);
+}
+
 HRESULT DecompressArchives(
     CCodecs *codecs,
     UStringVector &archivePaths, UStringVector &archivePathsFull,    
@@ -172,6 +203,8 @@ HRESULT DecompressArchives(
         archiveFileInfo.Size + archiveLink.VolumesSize,
         archiveLink.GetDefaultItemName(),
         wildcardCensor, options, extractCallback, extractCallbackSpec, errorMessage));
+    if (archiveLink.GetNumLevels() == 1)
+      SaveArchiveIndex(archiveLink.Archive0, archivePath);
     extractCallbackSpec->LocalProgressSpec->InSize += archiveFileInfo.Size + 
         archiveLink.VolumesSize;
     extractCallbackSpec->LocalProgressSpec->OutSize = extractCallbackSpec->UnpackSize;
@@ -38,6 +38,9 @@ struct IExtractCallbackUI: IFolderArchiveExtractCallback
   virtual HRESULT ThereAreNoFiles() = 0;
   virtual HRESULT ExtractResult(HRESULT result) = 0;
   virtual HRESULT SetPassword(const UString &password) = 0;
+  virtual HRESULT SetPipeStat(UInt32 numFolders, 
+      UInt32 readWait, UInt32 decodeInWait, 
+      UInt32 decodeOutWait, UInt32 writeWait) = 0;
 };
 
 #endif
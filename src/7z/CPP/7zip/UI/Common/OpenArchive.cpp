@@ -4,6 +4,7 @@
 
 #include "OpenArchive.h"
 
+#include "Common/Defs.h"
 #include "Common/Wildcard.h"
 
 #include "Windows/FileName.h"
@@ -85,6 +86,9 @@ HRESULT ReOpenArchive(IInArchive *archive, const UString &fileName, IArchiveOpen
 {
   CInFileStream *inStreamSpec = new CInFileStream;
   CMyComPtr<IInStream> inStream(inStreamSpec);
+  #ifndef USE_WIN_FILE
+  inStreamSpec->UseMap = true;
+  #endif
   inStreamSpec->Open(fileName);
   return archive->Open(inStream, &kMaxCheckStartPosition, openArchiveCallback);
 }
@@ -97,6 +101,109 @@ static inline bool TestSignature(const Byte *p1, const Byte *p2, size_t size)
       return false;
   return true;
 }
+
+// Start of stream is read to memory once. Then all handlers that try
+// to open the stream (and search SFX stub) read that part from memory.
+
+class CPrefixInStream: 
+  public IInStream,
+  public CMyUnknownImp
+{
+  CMyComPtr<IInStream> _stream;
+  CByteBuffer _prefix;
+  UInt32 _prefixSize;
+  UInt64 _size;
+  UInt64 _virtPos;
+  UInt64 _physPos;
+public:
+  HRESULT Init(IInStream *stream, UInt32 prefixSizeMax);
+  const Byte *GetPrefix() const { return _prefix; }
+  UInt32 GetPrefixSize() const { return _prefixSize; }
+
+  MY_UNKNOWN_IMP1(IInStream)
+
+  STDMETHOD(Read)(void *data, UInt32 size, UInt32 *processedSize);
+  STDMETHOD(Seek)(Int64 offset, UInt32 seekOrigin, UInt64 *newPosition);
+};
+
+HRESULT CPrefixInStream::Init(IInStream *stream, UInt32 prefixSizeMax)
+{
+  _stream = stream;
+  _prefix.SetCapacity(prefixSizeMax);
+  _virtPos = 0;
+  RINOK(_stream->Seek(0, STREAM_SEEK_SET, NULL));
+  RINOK(ReadStream(_stream, _prefix, prefixSizeMax, &_prefixSize));
+  RINOK(_stream->Seek(0, STREAM_SEEK_END, &_size));
+  _physPos = _size;
+  return S_OK;
+}
+
+STDMETHODIMP CPrefixInStream::Read(void *data, UInt32 size, UInt32 *processedSize)
+{
+  if (processedSize != NULL)
+    *processedSize = 0;
+  if (_virtPos >= _size)
+    return S_OK;
+  {
+    UInt64 rem = _size - _virtPos;
+    if (size > rem)
+      size = (UInt32)rem;
+  }
+  UInt32 realProcessedSize = 0;
+  if (_virtPos < _prefixSize)
+  {
+    UInt32 cur = _prefixSize - (UInt32)_virtPos;
+    if (cur > size)
+      cur = size;
+    memcpy(data, (const Byte *)_prefix + (UInt32)_virtPos, cur);
+    _virtPos += cur;
+    data = (Byte *)data + cur;
+    size -= cur;
+    realProcessedSize = cur;
+  }
+  HRESULT res = S_OK;
+  if (size != 0)
+  {
+    if (_physPos != _virtPos)
+    {
+      RINOK(_stream->Seek(_virtPos, STREAM_SEEK_SET, &_physPos));
+    }
+    UInt32 cur = 0;
+    res = _stream->Read(data, size, &cur);
+    _physPos += cur;
+    _virtPos += cur;
+    realProcessedSize += cur;
+  }
+  if (processedSize != NULL)
+    *processedSize = realProcessedSize;
+  return res;
+}
+
+STDMETHODIMP CPrefixInStream::Seek(Int64 offset, UInt32 seekOrigin, UInt64 *newPosition)
+{
+  switch(seekOrigin)
+  {
+    case STREAM_SEEK_SET: break;
+    case STREAM_SEEK_CUR: offset += _virtPos; break;
+    case STREAM_SEEK_END: offset += _size; break;
+    default: return STG_E_INVALIDFUNCTION;
+  }
+  if (offset < 0)
+    return STG_E_INVALIDFUNCTION;
+  _virtPos = offset;
+  if (newPosition != NULL)
+    *newPosition = offset;
+  return S_OK;
+}
+
+// Start signatures of all formats are searched in one pass:
+// formats are chained in hash table by first two bytes of signature.
+
+#define SIGNATURE_HASH(p) ((UInt32)(p)[0] | ((UInt32)(p)[1] << 8))
+
+static const UInt32 kSignatureHashSize = 1 << 16;
+static const int kNumHashedFormatsMax = 0xFF;
+static const UInt32 kSignatureScanSize = 1 << 20;
 #endif
 
 HRESULT OpenArchive(
@@ -125,35 +232,55 @@ HRESULT OpenArchive(
       orderIndices.Add(i);
   
   #ifndef _SFX
+  CMyComPtr<IInStream> prefixStream;
   if (numFinded != 1)
   {
+    CPrefixInStream *prefixStreamSpec = new CPrefixInStream;
+    prefixStream = prefixStreamSpec;
+    RINOK(prefixStreamSpec->Init(inStream, kSignatureScanSize));
+    inStream = prefixStream;
+    const Byte *buffer = prefixStreamSpec->GetPrefix();
+    UInt32 processedSize = prefixStreamSpec->GetPrefixSize();
+
+    // formats are ordered by position of signature in stream
+    // (and by previous order for same position).
+    int numFormats = MyMin(orderIndices.Size(), kNumHashedFormatsMax);
+    CByteBuffer hashBuffer;
+    hashBuffer.SetCapacity(kSignatureHashSize);
+    Byte *hash = hashBuffer;
+    memset(hash, 0xFF, kSignatureHashSize);
+    Byte prevs[kNumHashedFormatsMax];
+    bool isFound[kNumHashedFormatsMax];
+    for (i = numFormats - 1; i >= 0; i--)
+    {
+      const CByteBuffer &sig = codecs->Formats[orderIndices[i]].StartSignature;
+      isFound[i] = false;
+      if (sig.GetCapacity() < 2)
+        continue;
+      UInt32 hashValue = SIGNATURE_HASH((const Byte *)sig);
+      prevs[i] = hash[hashValue];
+      hash[hashValue] = (Byte)i;
+    }
     CIntVector orderIndices2;
-    CByteBuffer byteBuffer;
-    const UInt32 kBufferSize = (200 << 10);
-    byteBuffer.SetCapacity(kBufferSize);
-    Byte *buffer = byteBuffer;
-    RINOK(inStream->Seek(0, STREAM_SEEK_SET, NULL));
-    UInt32 processedSize;
-    RINOK(ReadStream(inStream, buffer, kBufferSize, &processedSize));
-    for (UInt32 pos = 0; pos < processedSize; pos++)
+    for (UInt32 pos = 0; pos + 1 < processedSize; pos++)
     {
-      for (int i = 0; i < orderIndices.Size(); i++)
+      for (int k = hash[SIGNATURE_HASH(buffer + pos)]; k != 0xFF; k = prevs[k])
       {
-        int index = orderIndices[i];
-        const CArcInfoEx &ai = codecs->Formats[index];
-        const CByteBuffer &sig = ai.StartSignature;
-        if (sig.GetCapacity() == 0)
+        if (isFound[k])
           continue;
+        const CByteBuffer &sig = codecs->Formats[orderIndices[k]].StartSignature;
         if (pos + sig.GetCapacity() > processedSize)
           continue;
         if (TestSignature(buffer + pos, sig, sig.GetCapacity()))
         {
-          orderIndices2.Add(index);
-          orderIndices.Delete(i--);
+          isFound[k] = true;
+          orderIndices2.Add(orderIndices[k]);
         }
       }
     }
-    orderIndices2 += orderIndices;
+    for (i = 0; i < orderIndices.Size(); i++)
+      if (i >= numFormats || !isFound[i])
+        orderIndices2.Add(orderIndices[i]);
     orderIndices = orderIndices2;
   }
   else if (extension == L"000" || extension == L"001")
@@ -250,6 +377,9 @@ HRESULT OpenArchive(
 {
   CInFileStream *inStreamSpec = new CInFileStream;
   CMyComPtr<IInStream> inStream(inStreamSpec);
+  #ifndef USE_WIN_FILE
+  inStreamSpec->UseMap = true;
+  #endif
   if (!inStreamSpec->Open(filePath))
     return GetLastError();
   return OpenArchive(codecs, inStream, ExtractFileNameFromPath(filePath),
@@ -301,6 +301,7 @@ static HRESULT Compress(
     bool sfxMode,
     const UString &sfxModule,
     const CRecordVector<UInt64> &volumesSizes,
+    const UString &workDir,
     CTempFiles &tempFiles,
     CUpdateErrorInfo &errorInfo,
     IUpdateCallbackUI *callback)
@@ -366,6 +367,7 @@ static HRESULT Compress(
   updateCallbackSpec->ShareForWrite = shareForWrite;
   updateCallbackSpec->StdInMode = stdInMode;
   updateCallbackSpec->Callback = callback;
+  updateCallbackSpec->WorkDir = workDir;
   updateCallbackSpec->DirItems = &dirItems;
   updateCallbackSpec->ArchiveItems = &archiveItems;
   updateCallbackSpec->UpdatePairs = &updatePairs2;
@@ -565,6 +567,7 @@ static HRESULT UpdateWithItemLists(
         dirItems, 
         options.SfxMode, options.SfxModule, 
         options.VolumesSizes,
+        options.WorkingDir,
         tempFiles,
         errorInfo, callback));
 
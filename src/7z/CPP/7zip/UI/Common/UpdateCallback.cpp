@@ -259,6 +259,25 @@ STDMETHODIMP CArchiveUpdateCallback::GetVolumeStream(UInt32 index, ISequentialOu
   COM_TRY_END
 }
 
+STDMETHODIMP CArchiveUpdateCallback::GetWorkDir(BSTR *path)
+{
+  COM_TRY_BEGIN
+  CMyComBSTR tempName(WorkDir);
+  *path = tempName.Detach();
+  return S_OK;
+  COM_TRY_END
+}
+
+STDMETHODIMP CArchiveUpdateCallback::SetThreadStat(Int32 threadIndex, UInt32 numItems, 
+    UInt64 unpackSize, UInt64 packSize, UInt64 spillSize,
+    UInt32 busyTime, UInt32 totalTime)
+{
+  COM_TRY_BEGIN
+  return Callback->SetThreadStat(threadIndex, numItems, 
+      unpackSize, packSize, spillSize, busyTime, totalTime);
+  COM_TRY_END
+}
+
 STDMETHODIMP CArchiveUpdateCallback::CryptoGetTextPassword2(Int32 *passwordIsDefined, BSTR *password)
 {
   COM_TRY_BEGIN
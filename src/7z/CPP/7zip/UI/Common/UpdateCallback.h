@@ -23,6 +23,9 @@
   virtual HRESULT OpenFileError(const wchar_t *name, DWORD systemError) x; \
   virtual HRESULT SetOperationResult(Int32 operationResult) x; \
   virtual HRESULT CryptoGetTextPassword2(Int32 *passwordIsDefined, BSTR *password) x; \
+  virtual HRESULT SetThreadStat(Int32 threadIndex, UInt32 numItems, \
+      UInt64 unpackSize, UInt64 packSize, UInt64 spillSize, \
+      UInt32 busyTime, UInt32 totalTime) x; \
 
   // virtual HRESULT CloseProgress() { return S_OK; };
 
@@ -33,13 +36,15 @@ struct IUpdateCallbackUI
 
 class CArchiveUpdateCallback: 
   public IArchiveUpdateCallback2,
+  public IArchiveUpdateCallbackMt,
   public ICryptoGetTextPassword2,
   public ICompressProgressInfo,
   public CMyUnknownImp
 {
 public:
-  MY_UNKNOWN_IMP3(
+  MY_UNKNOWN_IMP4(
       IArchiveUpdateCallback2, 
+      IArchiveUpdateCallbackMt,
       ICryptoGetTextPassword2,
       ICompressProgressInfo)
 
@@ -59,6 +64,11 @@ public:
   STDMETHOD(GetVolumeSize)(UInt32 index, UInt64 *size);
   STDMETHOD(GetVolumeStream)(UInt32 index, ISequentialOutStream **volumeStream);
 
+  STDMETHOD(GetWorkDir)(BSTR *path);
+  STDMETHOD(SetThreadStat)(Int32 threadIndex, UInt32 numItems, 
+      UInt64 unpackSize, UInt64 packSize, UInt64 spillSize,
+      UInt32 busyTime, UInt32 totalTime);
+
   STDMETHOD(CryptoGetTextPassword2)(Int32 *passwordIsDefined, BSTR *password);
 
 public:
@@ -69,6 +79,7 @@ public:
   IUpdateCallbackUI *Callback;
 
   UString DirPrefix;
+  UString WorkDir; // folder for temp files of handler (-w switch)
   bool ShareForWrite;
   bool StdInMode;
   const CObjectVector<CDirItem> *DirItems;
@@ -233,3 +233,15 @@ HRESULT CExtractCallbackConsole::SetPassword(const UString &password)
   Password = password;
   return S_OK;
 }
+
+HRESULT CExtractCallbackConsole::SetPipeStat(UInt32 numFolders, 
+    UInt32 readWait, UInt32 decodeInWait, 
+    UInt32 decodeOutWait, UInt32 writeWait)
+{
+  (*OutStream) << endl << "Pipeline: folders = " << (UInt64)numFolders << 
+      ", waiting: read = " << (UInt64)readWait << 
+      " ms, decode input = " << (UInt64)decodeInWait << 
+      " ms, decode output = " << (UInt64)decodeOutWait << 
+      " ms, write = " << (UInt64)writeWait << " ms" << endl;
+  return S_OK;
+}
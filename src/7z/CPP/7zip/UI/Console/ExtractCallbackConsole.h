@@ -40,6 +40,9 @@ public:
   HRESULT ExtractResult(HRESULT result);
 
   HRESULT SetPassword(const UString &password);
+  HRESULT SetPipeStat(UInt32 numFolders, 
+      UInt32 readWait, UInt32 decodeInWait, 
+      UInt32 decodeOutWait, UInt32 writeWait);
 
 public:
   bool PasswordIsDefined;
@@ -39,7 +39,7 @@
 
 #include "../../MyVersion.h"
 
-#if defined( _WIN32) && defined( _7ZIP_LARGE_PAGES)
+#ifdef _7ZIP_LARGE_PAGES
 extern "C" 
 { 
 #include "../../../../C/Alloc.h"
@@ -211,11 +211,13 @@ int Main2(
     return 0;
   }
 
-  #if defined(_WIN32) && defined(_7ZIP_LARGE_PAGES)
+  #ifdef _7ZIP_LARGE_PAGES_SUPPORTED
   if (options.LargePages)
   {
     SetLargePageSize();
+    #ifdef _WIN32
     NSecurity::EnableLockMemoryPrivilege();
+    #endif
   }
   #endif
 
@@ -347,6 +349,62 @@ int Main2(
         throw CSystemException(res);
       }
     }
+    #ifndef _NO_CRYPTO
+    else if (options.Method.CompareNoCase(L"AES") == 0)
+    {
+      HRESULT res = AesBenchCon((FILE *)stdStream, options.NumIterations, options.NumThreads, options.DictionarySize);
+      if (res != S_OK)
+      {
+        if (res == S_FALSE)
+        {
+          stdStream << "\nAES Error\n";
+          return NExitCode::kFatalError;
+        }
+        throw CSystemException(res);
+      }
+    }
+    #endif
+    #ifdef EXTERNAL_LZMA
+    else if (options.Method.CompareNoCase(L"BZip2") == 0)
+    {
+      HRESULT res = BZip2BenchCon(codecs, (FILE *)stdStream, options.NumIterations, options.NumThreads, options.DictionarySize);
+      if (res != S_OK)
+      {
+        if (res == S_FALSE)
+        {
+          stdStream << "\nDecoding Error\n";
+          return NExitCode::kFatalError;
+        }
+        throw CSystemException(res);
+      }
+    }
+    else if (options.Method.CompareNoCase(L"PPMd") == 0)
+    {
+      HRESULT res = PPMdBenchCon(codecs, (FILE *)stdStream, options.NumIterations, options.NumThreads, options.DictionarySize);
+      if (res != S_OK)
+      {
+        if (res == S_FALSE)
+        {
+          stdStream << "\nDecoding Error\n";
+          return NExitCode::kFatalError;
+        }
+        throw CSystemException(res);
+      }
+    }
+    else if (options.Method.CompareNoCase(L"GZip") == 0)
+    {
+      HRESULT res = GZipBenchCon(codecs, (FILE *)stdStream, options.NumIterations, options.NumThreads, options.DictionarySize);
+      if (res != S_OK)
+      {
+        if (res == S_FALSE)
+        {
+          stdStream << "\nDecoding Error\n";
+          return NExitCode::kFatalError;
+        }
+        throw CSystemException(res);
+      }
+    }
+    #endif
     else
     {
       HRESULT res = LzmaBenchCon(
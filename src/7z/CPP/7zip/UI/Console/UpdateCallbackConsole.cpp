@@ -206,3 +206,22 @@ HRESULT CUpdateCallbackConsole::CryptoGetTextPassword2(Int32 *passwordIsDefined,
   *password = tempName.Detach();
   return S_OK;
 }
+
+HRESULT CUpdateCallbackConsole::SetThreadStat(Int32 threadIndex, UInt32 numItems, 
+    UInt64 unpackSize, UInt64 packSize, UInt64 spillSize,
+    UInt32 busyTime, UInt32 totalTime)
+{
+  if (StdOutMode)
+    return S_OK;
+  Finilize();
+  MT_LOCK
+  if (threadIndex < 0)
+    (*OutStream) << "Main thread:";
+  else
+    (*OutStream) << "Thread " << (int)threadIndex << ":";
+  (*OutStream) << " items = " << (UInt64)numItems << 
+      ", unpack = " << (unpackSize >> 10) << " KB, pack = " << (packSize >> 10) << 
+      " KB, spill = " << (spillSize >> 10) << " KB, busy = " << (UInt64)busyTime << 
+      " of " << (UInt64)totalTime << " ms" << endl;
+  return S_OK;
+}
@@ -312,6 +312,13 @@ HRESULT CExtractCallbackImp::SetPassword(const UString &password)
   return S_OK;
 }
 
+HRESULT CExtractCallbackImp::SetPipeStat(UInt32 /* numFolders */, 
+    UInt32 /* readWait */, UInt32 /* decodeInWait */, 
+    UInt32 /* decodeOutWait */, UInt32 /* writeWait */)
+{
+  return S_OK;
+}
+
 STDMETHODIMP CExtractCallbackImp::CryptoGetTextPassword(BSTR *password)
 {
   if (!PasswordIsDefined)
@@ -78,6 +78,9 @@ public:
   #ifndef _NO_CRYPTO
   HRESULT SetPassword(const UString &password);
   #endif
+  HRESULT SetPipeStat(UInt32 numFolders, 
+      UInt32 readWait, UInt32 decodeInWait, 
+      UInt32 decodeOutWait, UInt32 writeWait);
 
   // IFolderOperationsExtractCallback
   STDMETHOD(AskWrite)(
@@ -173,6 +173,13 @@ HRESULT CUpdateCallbackGUI::CryptoGetTextPassword2(Int32 *passwordIsDefined, BST
   return S_OK;
 }
 
+HRESULT CUpdateCallbackGUI::SetThreadStat(Int32 /* threadIndex */, UInt32 /* numItems */, 
+    UInt64 /* unpackSize */, UInt64 /* packSize */, UInt64 /* spillSize */,
+    UInt32 /* busyTime */, UInt32 /* totalTime */)
+{
+  return S_OK;
+}
+
 /*
 It doesn't work, since main stream waits Dialog
 HRESULT CUpdateCallbackGUI::CloseProgress() 
@@ -28,7 +28,7 @@ BSTR SysAllocStringByteLen(LPCSTR psz, UINT len)
   BSTR bstr = (BSTR)((UINT *)p + 1);
   memmove(bstr, psz, len);
   Byte *pb = ((Byte *)bstr) + len;
-  for (int i = 0; i < sizeof(OLECHAR) * 2; i++)
+  for (unsigned i = 0; i < sizeof(OLECHAR) * 2; i++)
     pb[i] = 0;
   return bstr;
 }
@@ -42,7 +42,7 @@ BSTR SysAllocString(const OLECHAR *sz)
   void *p = AllocateForBSTR(len + sizeof(UINT));
   if (p == 0)
     return 0;
-  *(UINT *)p = strLen;
+  *(UINT *)p = strLen * sizeof(OLECHAR);
   BSTR bstr = (BSTR)((UINT *)p + 1);
   memmove(bstr, sz, len);
   return bstr;
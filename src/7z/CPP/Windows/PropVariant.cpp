@@ -221,7 +221,7 @@ HRESULT CPropVariant::Attach(PROPVARIANT* pSrc)
   HRESULT hr = Clear();
   if (FAILED(hr))
     return hr;
-  memcpy(this, pSrc, sizeof(PROPVARIANT));
+  memcpy((PROPVARIANT *)this, pSrc, sizeof(PROPVARIANT));
   pSrc->vt = VT_EMPTY;
   return S_OK;
 }
@@ -3717,6 +3717,55 @@ static struct builtin builtin_debug =
   "Turn on/off or display/set the debug level."
 };
 
+
+#ifdef DISK_CACHE
+/* diskcache */
+static int
+diskcache_func (char *arg, int flags)
+{
+  unsigned long long tmp_entries;
+
+  if (! *arg || grub_memcmp (arg, "status", 6) == 0)
+  {
+    grub_printf (" Disk cache: %d of %d entries, %d hits, %d misses\n",
+		 (unsigned long)disk_cache_entries, (unsigned long)DISK_CACHE_MAX_ENTRIES,
+		 (unsigned long)disk_cache_hits, (unsigned long)disk_cache_misses);
+    return disk_cache_entries;
+  }
+  else if (grub_memcmp (arg, "flush", 5) == 0)
+  {
+    disk_cache_flush ();
+    disk_cache_hits = disk_cache_misses = 0;
+    return 1;
+  }
+  else if (grub_memcmp (arg, "on", 2) == 0)
+    tmp_entries = DISK_CACHE_DEFAULT_ENTRIES;
+  else if (grub_memcmp (arg, "off", 3) == 0)
+    tmp_entries = 0;
+  else if (! safe_parse_maxint (&arg, &tmp_entries) || tmp_entries > DISK_CACHE_MAX_ENTRIES)
+  {
+    if (errnum == 0)
+      errnum = ERR_BAD_ARGUMENT;
+    return 0;
+  }
+
+  disk_cache_flush ();
+  disk_cache_entries = tmp_entries;
+  return 1;
+}
+
+static struct builtin builtin_diskcache =
+{
+  "diskcache",
+  diskcache_func,
+  BUILTIN_MENU | BUILTIN_CMDLINE | BUILTIN_SCRIPT | BUILTIN_HELP_LIST,
+  "diskcache [on | off | flush | status | INTEGER]",
+  "Turn on/off, flush or display the disk track cache, or set the number"
+  " of 32K-byte entries it uses (at most 62). Status shows the number of"
+  " cache hits and misses since the last flush."
+};
+#endif /* DISK_CACHE */
+
 
 /* default */
 static int
@@ -13524,6 +13573,9 @@ struct builtin *builtin_table[] =
 #ifdef SUPPORT_NETBOOT
   &builtin_dhcp,
 #endif /* SUPPORT_NETBOOT */
+#ifdef DISK_CACHE
+  &builtin_diskcache,
+#endif
 //  &builtin_displayapm,
   &builtin_displaymem,
 #ifdef GRUB_UTIL
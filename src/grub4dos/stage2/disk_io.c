@@ -289,6 +289,168 @@ unicode_to_utf8 (unsigned short *filename, unsigned char *utf8, unsigned long n)
 	utf8[k] = 0;
 }
 
+#ifdef DISK_CACHE
+/* The multi-track disk cache. The raw device buffer at BUFFERADDR holds only
+ * one track, so filesystem drivers that bounce between metadata and data
+ * (FAT chains, ext2 indirect blocks, NTFS MFT records) would read the same
+ * sectors from the BIOS again and again. Whole tracks are therefore also
+ * kept in DISK_CACHE_BUF and replaced in LRU order.
+ */
+struct disk_cache_entry
+{
+  unsigned long drive;
+  unsigned long track;		/* starting sector of the track */
+  unsigned long nsect;		/* 0 for an empty entry */
+  unsigned long removable;	/* floppy or cdrom */
+  unsigned long stamp;		/* time of last use */
+};
+
+/* Things which decide what disk a drive number refers to. If any of them
+ * changes (map --hook, map --unhook, cdrom --init, ...), all cached tracks
+ * are dropped.
+ */
+struct disk_cache_state
+{
+  unsigned long int13_vector;
+  unsigned long ram_drive;
+  unsigned long long rd_base;
+  unsigned long cdrom_drive;
+  unsigned long atapi_dev_count;
+  struct drive_map_slot map[DRIVE_MAP_SIZE + 1];
+};
+
+static struct disk_cache_entry disk_cache[DISK_CACHE_MAX_ENTRIES];
+static struct disk_cache_state disk_cache_state;
+static unsigned long disk_cache_clock;
+
+unsigned long disk_cache_entries = DISK_CACHE_DEFAULT_ENTRIES;
+unsigned long disk_cache_hits;
+unsigned long disk_cache_misses;
+
+void
+disk_cache_flush (void)
+{
+  grub_memset ((char *) disk_cache, 0, sizeof (disk_cache));
+}
+
+/* Called when buf_drive has been invalidated. The user may have exchanged
+ * removable disks, so drop their tracks. Tracks of fixed disks are kept
+ * unless the drive mapping has changed.
+ */
+static void
+disk_cache_check (void)
+{
+  struct disk_cache_state state;
+  unsigned long i;
+
+  grub_memset ((char *) &state, 0, sizeof (state));
+  state.int13_vector = *((unsigned long *)0x4C);
+  state.ram_drive = ram_drive;
+  state.rd_base = rd_base;
+  state.cdrom_drive = cdrom_drive;
+  state.atapi_dev_count = atapi_dev_count;
+  grub_memmove ((char *) state.map, (char *) hooked_drive_map, sizeof (state.map));
+
+  if (grub_memcmp ((char *) &state, (char *) &disk_cache_state, sizeof (state)))
+  {
+	grub_memmove ((char *) &disk_cache_state, (char *) &state, sizeof (state));
+	disk_cache_flush ();
+	return;
+  }
+
+  for (i = 0; i < DISK_CACHE_MAX_ENTRIES; i++)
+	if (disk_cache[i].removable)
+	    disk_cache[i].nsect = 0;
+}
+
+/* Drop the cached tracks made stale by writing COUNT sectors at SECTOR of
+ * DRIVE. Other drives may be mapped onto the same data (disk images, memory
+ * drives), so their tracks are dropped as well.
+ */
+static void
+disk_cache_invalidate (unsigned long drive, unsigned long sector, unsigned long count)
+{
+  unsigned long i;
+
+  for (i = 0; i < DISK_CACHE_MAX_ENTRIES; i++)
+  {
+	struct disk_cache_entry *e = &disk_cache[i];
+
+	if (e->nsect && (e->drive != drive
+		|| (sector < e->track + e->nsect && e->track < sector + count)))
+	    e->nsect = 0;
+  }
+}
+
+static int
+disk_cache_usable (unsigned long drive)
+{
+  /* (md) and (rd) are memory already, and the cache needs RAM up to 16M. */
+  return (disk_cache_entries && drive != 0xFFFF && drive != ram_drive
+	  && saved_mem_upper >= ((DISK_CACHE_BUF + DISK_CACHE_BUFLEN) >> 10) - 0x400);
+}
+
+/* Copy the track of NSECT sectors at TRACK of DRIVE from the cache into the
+ * raw device buffer. Return 1 on a hit, 0 on a miss.
+ */
+static int
+disk_cache_read (unsigned long drive, unsigned long track, unsigned long nsect, unsigned long sector_size_bits)
+{
+  unsigned long i;
+
+  if (! disk_cache_usable (drive))
+	return 0;
+
+  for (i = 0; i < disk_cache_entries; i++)
+  {
+	struct disk_cache_entry *e = &disk_cache[i];
+
+	if (e->nsect == nsect && e->track == track && e->drive == drive)
+	{
+	    e->stamp = ++disk_cache_clock;
+	    grub_memmove ((char *) BUFFERADDR, (char *) DISK_CACHE_BUF + i * DISK_CACHE_SLOTLEN, nsect << sector_size_bits);
+	    disk_cache_hits++;
+	    return 1;
+	}
+  }
+
+  disk_cache_misses++;
+  return 0;
+}
+
+/* Save the track just read into the raw device buffer, replacing an empty
+ * or the least recently used entry.
+ */
+static void
+disk_cache_write (unsigned long drive, unsigned long track, unsigned long nsect, unsigned long sector_size_bits)
+{
+  unsigned long i, victim = 0;
+  struct disk_cache_entry *e;
+
+  if (! disk_cache_usable (drive))
+	return;
+
+  for (i = 0; i < disk_cache_entries; i++)
+  {
+	if (! disk_cache[i].nsect)
+	{
+	    victim = i;
+	    break;
+	}
+	if (disk_cache[i].stamp < disk_cache[victim].stamp)
+	    victim = i;
+  }
+
+  e = &disk_cache[victim];
+  e->drive = drive;
+  e->track = track;
+  e->nsect = nsect;
+  e->removable = (drive < 0x80 || (buf_geom.flags & BIOSDISK_FLAG_CDROM));
+  e->stamp = ++disk_cache_clock;
+  grub_memmove ((char *) DISK_CACHE_BUF + victim * DISK_CACHE_SLOTLEN, (char *) BUFFERADDR, nsect << sector_size_bits);
+}
+#endif /* DISK_CACHE */
+
 /* Read bytes from DRIVE to BUF. The bytes start at BYTE_OFFSET in absolute
  * sector number SECTOR and with BYTE_LEN bytes long.
  */
@@ -309,6 +471,10 @@ rawread (unsigned long drive, unsigned long sector, unsigned long byte_offset, u
   /* Reset geometry and invalidate track buffer if the disk is wrong. */
   if (buf_drive != drive)
   {
+#ifdef DISK_CACHE
+	if (buf_drive == -1)
+	    disk_cache_check ();
+#endif
 	if (get_diskinfo (drive, &buf_geom))
 	    return !(errnum = ERR_NO_DISK);
 	buf_drive = drive;
@@ -389,6 +555,11 @@ rawread (unsigned long drive, unsigned long sector, unsigned long byte_offset, u
 	      bufseg = BUFFERSEG + (soff << (sector_size_bits - 4));
 	  }
 
+#ifdef DISK_CACHE
+	  if (buf_track == track && disk_cache_read (drive, track, read_len, sector_size_bits))
+		;	/* the whole track came from the cache */
+	  else
+#endif
 	  if (biosdisk (BIOSDISK_READ, drive, &buf_geom, read_start, read_len, bufseg))
 	  {
 	      buf_track = -1;		/* invalidate the buffer */
@@ -402,6 +573,10 @@ rawread (unsigned long drive, unsigned long sector, unsigned long byte_offset, u
 	      /* slen <= num_sect && slen < sectors_per_vtrack */
 	      num_sect = slen;
 	  }
+#ifdef DISK_CACHE
+	  else if (buf_track == track)
+		disk_cache_write (drive, track, read_len, sector_size_bits);
+#endif
       } /* if (track != buf_track) */
 
       /* num_sect is sectors that has been read at BUFADDR and will be used. */
@@ -413,6 +588,9 @@ rawread (unsigned long drive, unsigned long sector, unsigned long byte_offset, u
 	  if (grub_memcmp64 (buf, (unsigned long long)(unsigned int)bufaddr, size) == 0)
 		goto next;		/* no need to write */
 	  buf_track = -1;		/* invalidate the buffer */
+#ifdef DISK_CACHE
+	  disk_cache_invalidate (drive, sector, num_sect);
+#endif
 	  grub_memmove64 ((unsigned long long)(unsigned int)bufaddr, buf, size);	/* update data at bufaddr */
 	  /* write it! */
 	  bufseg = BUFFERSEG + (soff << (sector_size_bits - 4));
@@ -514,6 +692,9 @@ rawwrite (unsigned long drive, unsigned long sector, char *buf)
 	return 1;
 
   memmove ((char *) SCRATCHADDR, buf, SECTOR_SIZE);
+#ifdef DISK_CACHE
+  disk_cache_invalidate (drive, sector, 1);
+#endif
   if (biosdisk (BIOSDISK_WRITE, drive, &buf_geom, sector, 1, SCRATCHSEG))
     {
       errnum = ERR_WRITE;
@@ -103,6 +103,21 @@ extern char *grub_scratch_mem;
 #define FSYS_BUF RAW_ADDR (0x3E0000)
 #endif
 
+/*
+ *  This is the multi-track disk cache used by rawread().  Each entry holds
+ *  one virtual track copied from the raw device buffer.  The area between
+ *  page_map_end(14M) and the paging tables is otherwise unused.
+ */
+
+#if !defined(STAGE1_5) && !defined(GRUB_UTIL)
+#define DISK_CACHE
+#define DISK_CACHE_BUF		RAW_ADDR (0xE00000)
+#define DISK_CACHE_BUFLEN	0x1F0000
+#define DISK_CACHE_SLOTLEN	0x8000	/* >= BUFFERLEN */
+#define DISK_CACHE_MAX_ENTRIES	(DISK_CACHE_BUFLEN / DISK_CACHE_SLOTLEN)
+#define DISK_CACHE_DEFAULT_ENTRIES	16
+#endif
+
 /* Paging structure : PML4, PDPT, PD  4096-bytes each */
 /* Memory area from 0x50000 to the end of low memory is used by gfxmenu. So we
  * should not use 0x60000 for page tables. And all other free room in the low
@@ -919,6 +934,12 @@ extern struct geometry tmp_geom;
 extern struct geometry fd_geom[4];
 extern struct geometry hd_geom[8];
 
+#ifdef DISK_CACHE
+extern unsigned long disk_cache_entries;
+extern unsigned long disk_cache_hits;
+extern unsigned long disk_cache_misses;
+#endif
+
 /* these are the current file position and maximum file position */
 extern unsigned long long filepos;
 extern unsigned long long filemax;
@@ -1294,6 +1315,9 @@ unsigned long long gunzip_read (unsigned long long buf, unsigned long long len);
 int rawread (unsigned long drive, unsigned long sector, unsigned long byte_offset, unsigned long long byte_len, unsigned long long buf, unsigned long write);
 int devread (unsigned long sector, unsigned long byte_offset, unsigned long long byte_len, unsigned long long buf, unsigned long write);
 int rawwrite (unsigned long drive, unsigned long sector, char *buf);
+#ifdef DISK_CACHE
+void disk_cache_flush (void);
+#endif
 int devwrite (unsigned long sector, unsigned long sector_len, char *buf);
 
 /* Parse a device string and initialize the global parameters. */